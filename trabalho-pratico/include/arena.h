@@ -0,0 +1,73 @@
+#pragma once
+#ifndef LI3_ARENA_H
+#define LI3_ARENA_H
+
+#include <glib.h>
+
+/**
+ * This file implements an arena (bump) allocator.
+ *
+ * Objects are carved one after the other out of big chunks of memory and are never freed individually:
+ * the whole arena is freed at once, in O(number of chunks).
+ * This removes the per-object malloc header and keeps objects allocated together next to each other in memory.
+ *
+ * Arenas are not thread-safe. Threads that allocate in parallel use their own arena,
+ * which can then be merged into another one with `arena_merge`.
+ *
+ * If the program is compiled with ARENA_USE_HUGE_PAGES (`make HUGE_PAGES=1`),
+ * chunks are aligned to 2 MiB and the kernel is advised to back them with transparent huge pages.
+ */
+
+/**
+ * Size of each chunk of memory of an arena (2 MiB, the size of a huge page).
+ */
+#define ARENA_CHUNK_SIZE (2 * 1024 * 1024)
+
+/**
+ * Alignment of the objects allocated with `arena_alloc` (enough for every entity, whose largest fields are 64 bits).
+ */
+#define ARENA_ALIGNMENT 8
+
+/**
+ * Struct that represents an arena.
+ */
+typedef struct Arena Arena;
+
+/**
+ * Creates a new empty arena. No memory is allocated until the first allocation.
+ */
+Arena *create_arena(void);
+
+/**
+ * Allocates `size` bytes aligned to ARENA_ALIGNMENT. The memory is not initialized.
+ * The memory lives until the arena is freed.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * Copies the string into the arena.
+ */
+char *arena_strdup(Arena *arena, const char *string);
+
+/**
+ * Moves every chunk of `other` into `arena` and frees `other`.
+ * The memory allocated in `other` lives until `arena` is freed.
+ */
+void arena_merge(Arena *arena, Arena *other);
+
+/**
+ * Returns the number of bytes reserved by the arena (the sum of the size of its chunks).
+ */
+size_t arena_get_reserved_size(Arena *arena);
+
+/**
+ * Returns the number of chunks of the arena.
+ */
+guint arena_get_chunk_count(Arena *arena);
+
+/**
+ * Frees the arena and every object allocated in it.
+ */
+void free_arena(Arena *arena);
+
+#endif //LI3_ARENA_H
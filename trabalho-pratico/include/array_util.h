@@ -3,6 +3,7 @@
 #define LI3_ARRAY_UTIL_H
 
 #include <glib.h>
+#include <stdint.h>
 
 /**
  * Sorts an array of pointers given a comparison function.
@@ -10,6 +11,89 @@
  */
 void sort_array(GPtrArray *array, GCompareFunc compare_func);
 
+/**
+ * Function that maps an element of an array to an unsigned integer that orders it (see `radix_sort_array`).
+ * Receives the data given to the sort.
+ */
+typedef uint64_t (*SortKeyFunction)(gconstpointer element, gpointer data);
+
+/**
+ * Sorts an array of pointers by the key of each element, in ascending order.
+ * Elements with the same key keep their relative order (the sort is stable).
+ *
+ * Unlike `sort_array`, the key function is called once per element instead of a comparison per pair:
+ * the keys are sorted with an LSD radix sort, one pass per byte, skipping the bytes that are the same in every key.
+ * Needs buffers of twice the size of the array (for the keys and a copy of the elements).
+ */
+void radix_sort_array(GPtrArray *array, SortKeyFunction key_func, gpointer data);
+
+/**
+ * Sorts an array of pointers like `radix_sort_array` and then sorts the elements with the same key with a comparison function,
+ * for orders that the key doesn't fully decide. Only the ties are compared.
+ * Both functions receive the given data.
+ */
+void radix_sort_array_with_tie_breaker(GPtrArray *array, SortKeyFunction key_func, GCompareDataFunc compare_func, gpointer data);
+
+/**
+ * Function that maps an element of an array to its bucket (see `counting_sort_array`).
+ */
+typedef guint (*BucketFunction)(gconstpointer element);
+
+/**
+ * Sorts an array of pointers by the bucket of each element, in ascending order.
+ * Elements in the same bucket keep their relative order (the sort is stable).
+ *
+ * `bucket_counts` has the number of elements in each of the `bucket_count` buckets, counted as the elements were added,
+ * so each element is placed in its final position in a single pass, without comparisons. The counts are overwritten.
+ */
+void counting_sort_array(GPtrArray *array, guint *bucket_counts, guint bucket_count, BucketFunction bucket_func);
+
+/**
+ * Maximum number of threads of `parallel_sort` (including the calling thread).
+ */
+#define PARALLEL_SORT_MAX_THREADS 8
+
+/**
+ * Arrays with fewer elements than this are sorted by `parallel_sort` in the calling thread,
+ * where starting threads would cost more than they save.
+ */
+#define PARALLEL_SORT_THRESHOLD (1 << 15)
+
+/**
+ * Function that sorts a chunk of an array for `parallel_sort`, in the order of its comparison function.
+ * Receives the data given to the sort.
+ */
+typedef void (*ChunkSortFunction)(void *items, size_t length, gpointer data);
+
+/**
+ * Number of threads wanted by the parallel sorts of the catalog: the number of processors, up to `PARALLEL_SORT_MAX_THREADS`.
+ * A sort only gets the spare threads that aren't in use by other threads of the program (see `parallel_sort`).
+ */
+int parallel_sort_thread_budget(void);
+
+/**
+ * Sorts an array of `length` elements of `element_size` bytes with up to `threads` threads:
+ * the array is split in a chunk per thread, the chunks are sorted in parallel with `chunk_sort_func`
+ * and the sorted chunks are merged in pairs, each merge round split in equal parts of the output, one per thread.
+ * Below `PARALLEL_SORT_THRESHOLD` elements or with a single thread, the array is sorted by `chunk_sort_func` alone.
+ * The threads besides the calling one are reserved from the spare threads of the program (see thread_budget.h),
+ * so a sort in a worker thread or concurrent sorts only use the processors that are left (possibly none).
+ *
+ * `compare_func` receives pointers to two elements and the data. If `chunk_sort_func` is NULL, the chunks are sorted with
+ * `g_qsort_with_data`. The merges are stable, so if the chunk sort is stable (or the comparison never returns 0),
+ * the result doesn't depend on the number of threads and is the same of sorting the whole array in one thread.
+ * Needs a buffer of the size of the array.
+ * Returns the number of threads that sorted the array (including the calling thread).
+ */
+int parallel_sort(void *items, size_t length, size_t element_size, GCompareDataFunc compare_func, ChunkSortFunction chunk_sort_func,
+                   gpointer data, int threads);
+
+/**
+ * Sorts an array of pointers given a comparison function (like `sort_array`) with `parallel_sort`,
+ * using `parallel_sort_thread_budget` threads. The sort is stable.
+ */
+void parallel_sort_array(GPtrArray *array, GCompareFunc compare_func);
+
 /**
  * Sets the element at the given index to the given data.
  * If the index is greater than the array's length, the array is resized to fit the index.
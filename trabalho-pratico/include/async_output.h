@@ -0,0 +1,56 @@
+#pragma once
+#ifndef LI3_ASYNC_OUTPUT_H
+#define LI3_ASYNC_OUTPUT_H
+
+#include "output_container.h"
+#include "output_writer.h"
+
+/**
+ * This file implements the asynchronous output of the commands of an input file.
+ *
+ * Queries write their output into chunks that are handed over a bounded queue to a writer thread,
+ * which creates the `commandN_output.txt` files and writes each chunk with a single write.
+ * Queries don't wait for the disk, unless the writer thread falls behind by more than
+ * `ASYNC_OUTPUT_MAX_PENDING_CHUNKS` chunks, which caps the memory used by pending output.
+ *
+ * The files have the same content as the ones written with `create_semicolon_file_output_writer`.
+ * Alternatively, the writer thread can append the output of every command to a container file.
+ */
+
+/**
+ * Size of the chunks in which the output of a command is handed over to the writer thread.
+ */
+#define ASYNC_OUTPUT_CHUNK_SIZE (64 * 1024)
+
+/**
+ * Maximum number of chunks waiting to be written before the writers of the commands wait for the writer thread.
+ */
+#define ASYNC_OUTPUT_MAX_PENDING_CHUNKS 64
+
+/**
+ * Struct that represents the asynchronous output of the commands.
+ */
+typedef struct AsyncOutput AsyncOutput;
+
+/**
+ * Creates the asynchronous output and starts its writer thread.
+ * If `container_writer` is not NULL, the output is appended to it instead of written to a file for each command
+ * (it must only be closed after the asynchronous output is freed).
+ */
+AsyncOutput *create_async_output(OutputContainerWriter *container_writer);
+
+/**
+ * Creates an output writer for the output of the command with the given number.
+ * The output file is complete (and closed) some time after close_output_writer is called.
+ *
+ * Writers of different commands may be used by different threads at the same time.
+ */
+OutputWriter *async_output_create_command_writer(AsyncOutput *async_output, int command_number);
+
+/**
+ * Waits for the output of every closed writer to be written, stops the writer thread and frees the asynchronous output.
+ * Every writer must have been closed before.
+ */
+void free_async_output(AsyncOutput *async_output);
+
+#endif //LI3_ASYNC_OUTPUT_H
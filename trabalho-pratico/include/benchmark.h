@@ -20,4 +20,12 @@
     g_timer_stop(timer_name);                 \
     BENCHMARK_LOG(log_string, g_timer_elapsed(timer_name, NULL))
 
+/**
+ * Same as BENCHMARK_END but also logs the throughput in MB/s of processing the given amount of bytes.
+ * The log string receives the elapsed seconds and the throughput, in this order.
+ */
+#define BENCHMARK_END_THROUGHPUT(timer_name, log_string, bytes) \
+    g_timer_stop(timer_name);                                   \
+    BENCHMARK_LOG(log_string, g_timer_elapsed(timer_name, NULL), (double) (bytes) / 1e6 / g_timer_elapsed(timer_name, NULL))
+
 #endif //LI3_BENCHMARK_H
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef LI3_BOUNDED_QUEUE_H
+#define LI3_BOUNDED_QUEUE_H
+
+#include <glib.h>
+
+/**
+ * This file implements a bounded, lock-free, multi-producer multi-consumer FIFO queue of pointers.
+ *
+ * It is a ring of cells, each with a sequence number that tells producers and consumers whether the cell is free
+ * or filled for the current lap (the design of Dmitry Vyukov's bounded MPMC queue),
+ * so pushing and popping only take a compare-and-swap on the shared position.
+ *
+ * The blocking push and pop only fall back to a mutex and condition to sleep while the queue is full or empty,
+ * which is what limits the memory held by the queue (backpressure).
+ */
+
+/**
+ * Struct that represents a bounded queue.
+ */
+typedef struct BoundedQueue BoundedQueue;
+
+/**
+ * Creates an empty queue for at least `capacity` items (rounded up to a power of two).
+ */
+BoundedQueue *create_bounded_queue(guint capacity);
+
+/**
+ * Adds the item to the end of the queue. Returns FALSE (without adding it) if the queue is full.
+ */
+gboolean bounded_queue_try_push(BoundedQueue *queue, gpointer item);
+
+/**
+ * Removes the item at the start of the queue into `item`. Returns FALSE if the queue is empty.
+ */
+gboolean bounded_queue_try_pop(BoundedQueue *queue, gpointer *item);
+
+/**
+ * Adds the item to the end of the queue, waiting while the queue is full.
+ */
+void bounded_queue_push(BoundedQueue *queue, gpointer item);
+
+/**
+ * Removes and returns the item at the start of the queue, waiting while the queue is empty.
+ */
+gpointer bounded_queue_pop(BoundedQueue *queue);
+
+/**
+ * Frees the queue. The items still in it are not freed.
+ */
+void free_bounded_queue(BoundedQueue *queue);
+
+#endif //LI3_BOUNDED_QUEUE_H
@@ -8,6 +8,8 @@
 #include "ride.h"
 #include "user.h"
 #include "driver_city_info.h"
+#include "parser.h"
+#include "snapshot.h"
 
 /**
  * Struct that represents a catalog.
@@ -24,12 +26,29 @@ Catalog *create_catalog(void);
  */
 void free_catalog(Catalog *catalog);
 
+/**
+ * Transfers the ownership of an arena to the catalog.
+ * Used when rides are parsed by other threads into their own arenas before being registered with `catalog_register_parsed_ride`.
+ */
+void catalog_retain_ride_arena(Catalog *catalog, Arena *arena);
+
+/**
+ * Makes space for the expected number of users before they are registered (it is only a hint).
+ */
+void catalog_reserve_users(Catalog *catalog, guint expected_users);
+
 /**
  * Returns the city name associated with the given city id.
  * If the city is not registered, returns NULL.
  */
 char *catalog_get_city_name(Catalog *catalog, int city_id);
 
+/**
+ * Same as `catalog_get_city_name` but returns the name owned by the catalog instead of a copy.
+ * The string must not be modified or freed and lives as long as the catalog.
+ */
+const char *catalog_get_city_name_view(Catalog *catalog, int city_id);
+
 /**
  * Returns the city id associated with the given city name.
  * If the city is not registered, returns -1.
@@ -48,14 +67,54 @@ void parse_and_register_user(void *catalog, TokenIterator *line_iterator);
  */
 void parse_and_register_driver(void *catalog, TokenIterator *line_iterator);
 
+/**
+ * Number of rides registered together, see `catalog_register_parsed_rides`.
+ */
+#define CATALOG_RIDE_BATCH_SIZE 64
+
+/**
+ * Struct that holds a ride parsed with `parse_line_ride_detailed` and the strings returned by the parser.
+ */
+typedef struct {
+    Ride *ride;
+    char *city;
+    char *user_username;
+} ParsedRide;
+
 /**
  * Registers a ride in the catalog.
  * The user and driver linked to the ride must be already registered in the catalog
  * as it updates the user and driver information related to this ride.
+ * Rides are registered in batches (see `catalog_register_parsed_rides`), so after the last line the caller must call
+ * `catalog_flush_pending_rides` before anything reads the catalog (lookups, queries, indexing and snapshots).
+ * The result is the same as registering each ride right away.
  * Receives a catalog as void pointer to be used as a generic function.
  */
 void parse_and_register_ride(void *catalog, TokenIterator *line_iterator);
 
+/**
+ * Registers the rides parsed by `parse_and_register_ride` that are still waiting for their batch to fill.
+ * Must be called once all rides are parsed, reading the catalog with rides still pending is a programming error.
+ */
+void catalog_flush_pending_rides(Catalog *catalog);
+
+/**
+ * Registers a ride that was already parsed with `parse_line_ride_detailed`.
+ * city and user_username are the strings returned by the parser.
+ * The ride must be allocated in an arena retained by the catalog (see `catalog_retain_ride_arena`).
+ * Same as `parse_and_register_ride` but allows the parsing to be done elsewhere (e.g. in other threads).
+ * Registering the same rides in the same order always produces the same catalog.
+ */
+void catalog_register_parsed_ride(Catalog *catalog, Ride *ride, char *city, char *user_username);
+
+/**
+ * Registers `count` parsed rides, in order, like calling `catalog_register_parsed_ride` for each one.
+ * The rides are processed in batches of CATALOG_RIDE_BATCH_SIZE: the users and drivers of the whole batch are
+ * resolved and prefetched before any of them is updated, so the cache misses of the rides overlap
+ * instead of each ride waiting for its own.
+ */
+void catalog_register_parsed_rides(Catalog *catalog, ParsedRide *parsed_rides, guint count);
+
 /**
  * Notifies the catalog that the program won't register any more data.
  * This will allow the catalog to optimize its internal data structures.
@@ -63,6 +122,33 @@ void parse_and_register_ride(void *catalog, TokenIterator *line_iterator);
  */
 void catalog_force_eager_indexing(Catalog *catalog);
 
+/**
+ * Notifies the catalog that the program won't register any more data, like `catalog_force_eager_indexing`,
+ * but builds the indexes in the given number of background threads and returns immediately.
+ * Queries can run meanwhile: a query that needs an index that isn't built yet only waits for that index
+ * (or builds it, if no thread started it yet).
+ */
+void catalog_start_background_indexing(Catalog *catalog, int threads);
+
+/**
+ * Waits for the indexes started by `catalog_start_background_indexing` to be built.
+ * Does nothing if there is no background indexing. Called by `free_catalog`.
+ */
+void catalog_wait_background_indexing(Catalog *catalog);
+
+/**
+ * Writes the whole catalog (fully indexed) to the snapshot.
+ * No more data can be registered in the catalog after this.
+ */
+void catalog_write_snapshot(Catalog *catalog, SnapshotWriter *writer);
+
+/**
+ * Restores a catalog written by `catalog_write_snapshot` into an empty catalog.
+ * The catalog takes the ownership of the reader.
+ * Returns FALSE if the snapshot is inconsistent, in which case the catalog must be discarded.
+ */
+gboolean catalog_read_snapshot(Catalog *catalog, SnapshotReader *reader);
+
 /**
  * Returns the user associated with the given user id.
  */
@@ -80,6 +166,29 @@ User *catalog_get_user_by_username(Catalog *catalog, char *username);
  */
 Driver *catalog_get_driver(Catalog *catalog, int id);
 
+/**
+ * Returns the username of a registered user.
+ * The string is owned by the catalog, must not be modified or freed, and is valid until more users are registered.
+ */
+const char *catalog_get_user_username(Catalog *catalog, User *user);
+
+/**
+ * Returns the name of a user, interned in the string pool of the catalog.
+ * The string is owned by the catalog, must not be modified or freed, and is valid until more users or drivers are registered.
+ */
+const char *catalog_get_user_name(Catalog *catalog, User *user);
+
+/**
+ * Returns the name of a driver, interned in the string pool of the catalog.
+ * The string is owned by the catalog, must not be modified or freed, and is valid until more users or drivers are registered.
+ */
+const char *catalog_get_driver_name(Catalog *catalog, Driver *driver);
+
+/**
+ * Logs how much memory the entities and strings of the catalog use.
+ */
+void catalog_log_memory_breakdown(Catalog *catalog);
+
 /**
  * Inserts the top N drivers in the given GPtrArray.
  * Drivers are sorted by their score, date of last ride and id.
@@ -99,15 +208,15 @@ int query_2_catalog_get_top_drivers_with_best_score(Catalog *catalog, int n, GPt
 int query_3_catalog_get_top_users_with_longest_total_distance(Catalog *catalog, int n, GPtrArray *result);
 
 /**
- * Returns the average price of rides in the given city.
+ * Returns the average price of rides in the given city, rounded to the nearest thousandth.
  */
-double query_4_catalog_get_average_price_in_city(Catalog *catalog, int city_id);
+Money query_4_catalog_get_average_price_in_city(Catalog *catalog, int city_id);
 
 /**
- * Returns the average price of rides between the given dates.
+ * Returns the average price of rides between the given dates, rounded to the nearest thousandth.
  * If there are no rides between the given dates, returns -1.
  */
-double query_5_catalog_get_average_price_in_date_range(Catalog *catalog, Date start_date, Date end_date);
+Money query_5_catalog_get_average_price_in_date_range(Catalog *catalog, Date start_date, Date end_date);
 
 /**
  * Returns the average distance of rides in the given city between the given dates.
@@ -4,6 +4,8 @@
 
 #include <glib.h>
 
+#include "snapshot.h"
+
 /**
  * Struct that represents a catalog of cities.
  */
@@ -25,6 +27,12 @@ void free_catalog_city(CatalogCity *catalog_city);
  */
 char *catalog_city_get_city_name(CatalogCity *catalog, int city_id);
 
+/**
+ * Same as `catalog_city_get_city_name` but returns the name owned by the catalog instead of a copy.
+ * The string must not be modified or freed and lives as long as the catalog.
+ */
+const char *catalog_city_get_city_name_view(CatalogCity *catalog, int city_id);
+
 /**
  * Returns the city id associated with the given city name.
  * If the city is not registered, returns -1.
@@ -37,4 +45,15 @@ int catalog_city_get_city_id(CatalogCity *catalog, char *city);
  */
 int catalog_city_get_or_register_city_id(CatalogCity *catalog, char *city);
 
+/**
+ * Writes the city names in id order to the snapshot.
+ */
+void catalog_city_write_snapshot(CatalogCity *catalog, SnapshotWriter *writer);
+
+/**
+ * Registers the cities written by `catalog_city_write_snapshot` in an empty catalog, keeping their ids.
+ * Returns FALSE if the snapshot is inconsistent.
+ */
+gboolean catalog_city_read_snapshot(CatalogCity *catalog, SnapshotReader *reader);
+
 #endif //LI3_CATALOG_CITY_H
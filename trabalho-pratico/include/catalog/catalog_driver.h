@@ -20,8 +20,15 @@ CatalogDriver *create_catalog_driver(void);
  */
 void free_catalog_driver(CatalogDriver *catalog_driver);
 
+/**
+ * Returns the arena where the drivers of the catalog are allocated.
+ * The drivers are freed with the catalog.
+ */
+Arena *catalog_driver_get_arena(CatalogDriver *catalog_driver);
+
 /**
  * Registers a driver in the catalog.
+ * The driver must have been allocated in the arena of the catalog.
  */
 void catalog_driver_register_driver(CatalogDriver *catalog_driver, Driver *driver);
 
@@ -53,4 +60,22 @@ int catalog_driver_get_top_n_drivers_with_best_score_by_city(CatalogDriver *cata
  */
 void catalog_driver_force_eager_indexing(CatalogDriver *catalog_driver);
 
+/**
+ * Adds the lazies applied by `catalog_driver_force_eager_indexing` to the array.
+ */
+void catalog_driver_collect_lazy_indexes(CatalogDriver *catalog_driver, GPtrArray *lazies);
+
+/**
+ * Writes every driver (in score order) and the drivers by city information to the snapshot.
+ * The names of the drivers must have been written from the given pool just before.
+ */
+void catalog_driver_write_snapshot(CatalogDriver *catalog_driver, SnapshotWriter *writer, StringPool *name_pool);
+
+/**
+ * Registers the drivers written by `catalog_driver_write_snapshot` in an empty catalog.
+ * Every array is restored already sorted. Their names must have been restored to the given pool.
+ * Returns FALSE if the snapshot is inconsistent.
+ */
+gboolean catalog_driver_read_snapshot(CatalogDriver *catalog_driver, SnapshotReader *reader, StringPool *name_pool);
+
 #endif //LI3_CATALOG_DRIVER_H
@@ -32,6 +32,22 @@ void catalog_driver_city_info_register(CatalogDriverCityInfo *catalog, int drive
  */
 void catalog_driver_city_info_force_eager_indexing(CatalogDriverCityInfo *catalog);
 
+/**
+ * Adds the lazies applied by `catalog_driver_city_info_force_eager_indexing` to the array.
+ */
+void catalog_driver_city_info_collect_lazy_indexes(CatalogDriverCityInfo *catalog, GPtrArray *lazies);
+
+/**
+ * Writes the sorted driver city infos of every city to the snapshot.
+ */
+void catalog_driver_city_info_write_snapshot(CatalogDriverCityInfo *catalog, SnapshotWriter *writer);
+
+/**
+ * Restores the driver city infos written by `catalog_driver_city_info_write_snapshot` in an empty catalog.
+ * The arrays are restored already sorted, so no rides can be registered afterwards.
+ */
+gboolean catalog_driver_city_info_read_snapshot(CatalogDriverCityInfo *catalog, SnapshotReader *reader);
+
 /**
  * Retrieves the top n driver city info with the best score in the given city (using `compare_driver_city_infos_by_average_score`).
  * The result is stored in the given GPtrArray.
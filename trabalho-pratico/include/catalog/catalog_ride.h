@@ -21,25 +21,38 @@ CatalogRide *create_catalog_ride(void);
  */
 void free_catalog_ride(CatalogRide *catalog_ride);
 
+/**
+ * Returns the arena where the rides of the catalog are allocated.
+ * The rides are freed with the catalog.
+ */
+Arena *catalog_ride_get_arena(CatalogRide *catalog_ride);
+
+/**
+ * Transfers the ownership of an arena with rides (e.g. allocated by another thread) to the catalog.
+ */
+void catalog_ride_adopt_arena(CatalogRide *catalog_ride, Arena *arena);
+
 /**
  * Registers a ride in the catalog.
+ * The ride must have been allocated in an arena owned by the catalog.
  */
 void catalog_ride_register_ride(CatalogRide *catalog_ride, Ride *ride);
 
 /**
- * Registers a ride in the catalog whose driver and user have the same gender.
+ * Registers a ride in the catalog whose driver and user have the same gender, with their account creation dates.
  */
-void catalog_ride_register_ride_same_gender(CatalogRide *catalog_ride, Gender gender, Ride *ride);
+void catalog_ride_register_ride_same_gender(CatalogRide *catalog_ride, Gender gender, Ride *ride, Date driver_account_creation_date, Date user_account_creation_date);
 
 /**
- * Returns the average price of rides in the given city.
+ * Returns the average price of rides in the given city, rounded to the nearest thousandth.
  */
-double catalog_ride_get_average_price_in_city(CatalogRide *catalog_ride, int city_id);
+Money catalog_ride_get_average_price_in_city(CatalogRide *catalog_ride, int city_id);
 
 /**
- * Returns the average distance in the given date range.
+ * Returns the average price in the given date range, rounded to the nearest thousandth.
+ * Returns -1 if there are no rides in the date range.
  */
-double catalog_ride_get_average_distance_in_date_range(CatalogRide *catalog_ride, Date start_date, Date end_date);
+Money catalog_ride_get_average_distance_in_date_range(CatalogRide *catalog_ride, Date start_date, Date end_date);
 
 /**
  * Returns the average distance in the given city and date range.
@@ -62,4 +75,22 @@ int catalog_ride_get_rides_with_user_and_driver_with_same_age_above_acc_age(Cata
  */
 void catalog_ride_force_eager_indexing(CatalogRide *catalog_ride);
 
+/**
+ * Adds the lazies applied by `catalog_ride_force_eager_indexing` to the array, the most expensive first.
+ */
+void catalog_ride_collect_lazy_indexes(CatalogRide *catalog_ride, GPtrArray *lazies);
+
+/**
+ * Writes every ride (in date order) to the snapshot,
+ * followed by the rides in each city and with same gender as indexes into the rides array.
+ */
+void catalog_ride_write_snapshot(CatalogRide *catalog_ride, SnapshotWriter *writer);
+
+/**
+ * Registers the rides written by `catalog_ride_write_snapshot` in an empty catalog.
+ * Every array is restored already sorted.
+ * Returns FALSE if the snapshot is inconsistent.
+ */
+gboolean catalog_ride_read_snapshot(CatalogRide *catalog_ride, SnapshotReader *reader);
+
 #endif //LI3_CATALOG_RIDE_H
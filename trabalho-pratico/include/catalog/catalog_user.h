@@ -22,9 +22,32 @@ CatalogUser *create_catalog_user(void);
 void free_catalog_user(CatalogUser *catalog_user);
 
 /**
- * Registers a user in the catalog.
+ * Returns the arena where the users of the catalog are allocated.
+ * The users are freed with the catalog.
  */
-void catalog_user_register_user(CatalogUser *catalog_user, User *user);
+Arena *catalog_user_get_arena(CatalogUser *catalog_user);
+
+/**
+ * Makes space for `expected_users` users in the username index, so it doesn't grow while they are registered.
+ */
+void catalog_user_reserve(CatalogUser *catalog_user, guint expected_users);
+
+/**
+ * Registers a user in the catalog, copying its username to the username heap of the catalog.
+ * The user must have been allocated in the arena of the catalog.
+ */
+void catalog_user_register_user(CatalogUser *catalog_user, User *user, const char *username);
+
+/**
+ * Returns the username of a registered user, a pointer into the username heap of the catalog.
+ * The string must not be modified or freed and is valid until the next user is registered.
+ */
+const char *catalog_user_get_username(CatalogUser *catalog_user, User *user);
+
+/**
+ * Returns the number of bytes used by the usernames in the username heap.
+ */
+size_t catalog_user_get_usernames_size(CatalogUser *catalog_user);
 
 /**
  * Returns the user with the given id.
@@ -37,15 +60,41 @@ User *catalog_user_get_user_by_user_id(CatalogUser *catalog_user, int user_id);
  */
 User *catalog_user_get_user_by_username(CatalogUser *catalog_user, char *username);
 
+/**
+ * Stores in `users[i]` the user with the username `usernames[i]` (or NULL), for `count` usernames.
+ * Same as calling `catalog_user_get_user_by_username` for each one, but every step of the lookups is done for
+ * the whole batch before the next one, with prefetches, so the cache misses of the different lookups overlap.
+ * The users are prefetched too, as they are usually updated right after.
+ */
+void catalog_user_get_users_by_usernames(CatalogUser *catalog_user, char **usernames, User **users, guint count);
+
 /**
  * Forces the catalog to index all the users.
  */
 void catalog_user_force_eager_indexing(CatalogUser *catalog_user);
 
+/**
+ * Adds the lazies applied by `catalog_user_force_eager_indexing` to the array.
+ */
+void catalog_user_collect_lazy_indexes(CatalogUser *catalog_user, GPtrArray *lazies);
+
 /**
  * Retrieves the top n users with the most distance travelled (using `compare_users_by_total_distance`).
  * The result is stored in the given GPtrArray.
  */
 int catalog_user_get_top_n_users(CatalogUser *catalog_user, int n, GPtrArray *result);
 
+/**
+ * Writes every user (in id order) with its username and the order of the sorted users array to the snapshot.
+ * The names of the users must have been written from the given pool just before.
+ */
+void catalog_user_write_snapshot(CatalogUser *catalog_user, SnapshotWriter *writer, StringPool *name_pool);
+
+/**
+ * Registers the users written by `catalog_user_write_snapshot` in an empty catalog.
+ * The users array is restored already sorted. Their names must have been restored to the given pool.
+ * Returns FALSE if the snapshot is inconsistent.
+ */
+gboolean catalog_user_read_snapshot(CatalogUser *catalog_user, SnapshotReader *reader, StringPool *name_pool);
+
 #endif //LI3_CATALOG_USER_H
@@ -6,6 +6,42 @@
 
 #include "catalog.h"
 
+/**
+ * Enum that represents how the dataset files are read.
+ */
+typedef enum CatalogLoaderIOMode {
+    /**
+     * Reads the files line by line with stdio into a fixed size buffer.
+     */
+    CATALOG_LOADER_IO_STDIO,
+    /**
+     * Maps the files into memory and parses the lines in place.
+     * The files are unmapped after loading, the strings the catalog keeps are copied to its string heaps.
+     */
+    CATALOG_LOADER_IO_MMAP,
+} CatalogLoaderIOMode;
+
+/**
+ * Struct that holds the options used when loading a dataset.
+ */
+typedef struct CatalogLoaderOptions {
+    CatalogLoaderIOMode io_mode;
+    /**
+     * Number of threads used to parse the rides file.
+     * Values higher than 1 split the rides file into newline-aligned chunks that are parsed in parallel
+     * and then registered in file order, producing the same catalog as the serial loader.
+     * They also enable the pipelined loader: users and drivers are loaded concurrently by their own threads
+     * while the rides are parsed, and the rides are only registered once both tables are complete.
+     * As chunks need random access to the file, this implies CATALOG_LOADER_IO_MMAP.
+     */
+    int threads;
+} CatalogLoaderOptions;
+
+/**
+ * Returns the default loader options (stdio reading with a single thread).
+ */
+CatalogLoaderOptions catalog_loader_default_options(void);
+
 /**
  * Loads the dataset from the given folder path.
  * Returns true if the dataset was loaded successfully.
@@ -13,4 +49,32 @@
  */
 gboolean catalog_load_csv_dataset(Catalog *catalog, const char *dataset_folder_path);
 
+/**
+ * Same as `catalog_load_csv_dataset` but with the given loader options.
+ */
+gboolean catalog_load_csv_dataset_with_options(Catalog *catalog, const char *dataset_folder_path, CatalogLoaderOptions options);
+
+/**
+ * Computes the fingerprint of the dataset in the given folder, stored in snapshots to detect when it changes.
+ * The fingerprint covers the inode, modification time and size of every file and samples of its start, middle and end,
+ * so it is cheap to compute even for large datasets. Editing, replacing or touching a file changes it.
+ * Returns FALSE if any file of the dataset could not be read.
+ */
+gboolean compute_dataset_fingerprint(const char *dataset_folder_path, uint64_t *fingerprint);
+
+/**
+ * Saves the catalog loaded from the given dataset folder to a snapshot file.
+ * The catalog is fully indexed before being saved.
+ * Returns FALSE (and logs a warning) if the snapshot could not be written.
+ */
+gboolean catalog_save_snapshot(Catalog *catalog, const char *snapshot_path, const char *dataset_folder_path);
+
+/**
+ * Loads the catalog from a snapshot file saved by `catalog_save_snapshot` instead of parsing the dataset.
+ * The file is memory-mapped and the entities are restored already indexed.
+ * Returns FALSE (and logs a warning) if the snapshot is missing, corrupted, from another format version
+ * or was saved from a different dataset. In that case the catalog must be discarded and the dataset loaded from the csv files.
+ */
+gboolean catalog_load_snapshot(Catalog *catalog, const char *snapshot_path, const char *dataset_folder_path);
+
 #endif //LI3_CATALOG_LOADER_H
@@ -0,0 +1,97 @@
+#pragma once
+#ifndef LI3_DELIMITER_SCANNER_H
+#define LI3_DELIMITER_SCANNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <glib.h>
+
+/**
+ * This file implements vectorized scanning of CSV delimiters.
+ *
+ * Instead of walking every line byte by byte looking for ';' (and then again for '\n'),
+ * the scanner compares whole blocks of bytes at once and builds bitmasks with the positions of every ';' and '\n'.
+ * The positions are collected into a per-line table of token ends that is handed to the TokenIterator,
+ * so splitting a line into tokens becomes a table lookup.
+ *
+ * There are three implementations: a portable scalar fallback, SSE2 (always available on x86-64)
+ * and AVX2, which is picked at runtime if the CPU supports it.
+ */
+
+/**
+ * Maximum number of token ends stored for a single line.
+ * Lines with more tokens have a truncated table and the remaining tokens are found by `next_token`.
+ */
+#define DELIMITER_SCANNER_MAX_TOKENS 32
+
+/**
+ * `scan_csv_line` reads a line in aligned chunks of this many bytes, so the buffer of the line must be readable
+ * up to the end of the aligned chunk with the terminator. Buffers aligned to DELIMITER_SCANNER_ALIGNMENT bytes
+ * whose size is a multiple of it (see `DELIMITER_SCANNER_PADDED_SIZE`) are always safe.
+ */
+#define DELIMITER_SCANNER_ALIGNMENT 16
+
+/**
+ * Rounds the size of a buffer up to a multiple of DELIMITER_SCANNER_ALIGNMENT.
+ */
+#define DELIMITER_SCANNER_PADDED_SIZE(size) \
+    (((size) + DELIMITER_SCANNER_ALIGNMENT - 1) & ~(size_t) (DELIMITER_SCANNER_ALIGNMENT - 1))
+
+/**
+ * Enum that represents the available scanner implementations.
+ */
+typedef enum DelimiterScannerImplementation {
+    DELIMITER_SCANNER_SCALAR,
+    DELIMITER_SCANNER_SSE2,
+    DELIMITER_SCANNER_AVX2,
+} DelimiterScannerImplementation;
+
+/**
+ * Function definition that is called for every line found by `scan_csv_lines`.
+ * void *arg: the argument given to `scan_csv_lines`
+ * const char *line: the start of the line (not NUL terminated, the line ends with '\n' at line[length])
+ * size_t length: the length of the line without the '\n'
+ * const uint32_t *token_ends: offsets from the start of the line of every ';' followed by the offset of the line end
+ * int token_count: number of entries in token_ends (the table is truncated at DELIMITER_SCANNER_MAX_TOKENS entries)
+ */
+typedef void(ScannedLineFunction)(void *arg, const char *line, size_t length, const uint32_t *token_ends, int token_count);
+
+/**
+ * Returns the fastest scanner implementation supported by the running CPU.
+ */
+DelimiterScannerImplementation get_best_delimiter_scanner_implementation(void);
+
+/**
+ * Returns TRUE if the given implementation can run in the current CPU.
+ */
+gboolean is_delimiter_scanner_implementation_supported(DelimiterScannerImplementation implementation);
+
+/**
+ * Scans the given data for ';' and '\n' and calls scanned_line_function for every complete line (ending with '\n').
+ * The data is not modified.
+ * Returns the number of bytes consumed, that is, the offset of the first byte after the last '\n'.
+ * Uses the best implementation for the running CPU.
+ */
+size_t scan_csv_lines(const char *data, size_t length, ScannedLineFunction *scanned_line_function, void *arg);
+
+/**
+ * Same as `scan_csv_lines` but with the given implementation.
+ * The implementation must be supported by the CPU (see `is_delimiter_scanner_implementation_supported`).
+ */
+size_t scan_csv_lines_with_implementation(DelimiterScannerImplementation implementation, const char *data, size_t length,
+                                          ScannedLineFunction *scanned_line_function, void *arg);
+
+/**
+ * Scans a single line that ends with '\0' or '\n' for ';'.
+ * Fills token_ends (which must have space for DELIMITER_SCANNER_MAX_TOKENS entries) like `ScannedLineFunction`
+ * and returns the number of entries. The length of the line is the last entry (unless the table was truncated).
+ * The line may start anywhere, but must be padded after the terminator (see DELIMITER_SCANNER_ALIGNMENT).
+ */
+int scan_csv_line(const char *line, uint32_t *token_ends);
+
+/**
+ * Returns a pointer to the first occurrence of delimiter or of the '\0' terminator in the given string.
+ */
+char *find_delimiter_or_end(char *string, char delimiter);
+
+#endif //LI3_DELIMITER_SCANNER_H
@@ -4,6 +4,9 @@
 
 #include "struct_util.h"
 #include "token_iterator.h"
+#include "snapshot.h"
+#include "arena.h"
+#include "string_pool.h"
 
 /**
  * Struct that represents a driver.
@@ -12,37 +15,53 @@ typedef struct Driver Driver;
 
 /**
  * Creates a new Driver.
+ * The name is referenced by its id in the string pool of the catalog (see `catalog_get_driver_name`).
+ * If arena is not NULL, the Driver is allocated in the arena and lives until it is freed.
+ * Otherwise it is allocated in the heap memory and must be freed with `free_driver`.
  */
-Driver *create_driver(int id, char *name, Date birth_date, Gender gender, CarClass car_class, const char *license_plate,
-                      Date account_creation_date, AccountStatus account_status);
+Driver *create_driver(int id, uint32_t name_id, Date birth_date, Gender gender, CarClass car_class, const char *license_plate,
+                      Date account_creation_date, AccountStatus account_status, Arena *arena);
 
 /**
  * Parses a line of the CSV to a driver
  * parsed_city is used to return the city name of the ride because
  * the driver saves a city id and not a city name
+ * The name is interned in the given string pool (if NULL, the name is not kept).
+ * The Driver is allocated in the given arena (if not NULL), see `create_driver`.
  */
-Driver *parse_line_driver_detailed(TokenIterator *line_iterator, char **parsed_city);
+Driver *parse_line_driver_detailed(TokenIterator *line_iterator, char **parsed_city, StringPool *name_pool, Arena *arena);
 
 /**
  + Parses a line of the CSV to a driver   
  */
-Driver *parse_line_driver(TokenIterator *line_iterator);
+Driver *parse_line_driver(TokenIterator *line_iterator, Arena *arena);
 
 /**
  * Frees the memory allocated for the Driver.
+ * Must not be called for drivers allocated in an arena.
  */
 void free_driver(void *driver);
 
+/**
+ * Writes every field of the Driver to the snapshot, with the snapshot id of its name (see `string_pool_write_snapshot`).
+ */
+void driver_write_snapshot(Driver *driver, SnapshotWriter *writer, StringPool *name_pool);
+
+/**
+ * Reads a Driver written by `driver_write_snapshot`, whose names were restored to the given pool.
+ * Returns NULL if the name id isn't the id of a name of the pool.
+ */
+Driver *driver_read_snapshot(SnapshotReader *reader, Arena *arena, StringPool *name_pool);
+
 /**
  * Returns the id of the Driver
  */
 int driver_get_id(Driver *driver);
 
 /**
- * Returns a copy of the name of the Driver
- * The caller is responsible for freeing the memory allocated for the name
+ * Returns the id of the name of the Driver in the string pool of the catalog.
  */
-char *driver_get_name(Driver *driver);
+uint32_t driver_get_name_id(Driver *driver);
 
 /**
  * Sets the city id of the Driver
@@ -98,7 +117,7 @@ void driver_add_score(Driver *driver, int score);
 /**
  * Increments the total money earned by the Driver
  */
-void driver_add_earned(Driver *driver, double earned);
+void driver_add_earned(Driver *driver, Money earned);
 
 /**
  * Returns the average score of the Driver
@@ -113,7 +132,7 @@ int driver_get_number_of_rides(Driver *driver);
 /**
  * Returns the total money earned by the Driver
  */
-double driver_get_total_earned(Driver *driver);
+Money driver_get_total_earned(Driver *driver);
 
 /**
  * Sets a new last ride if the new ride is more recent than the current saved one
@@ -127,4 +146,15 @@ void driver_register_ride_date(Driver *driver, Date date);
  */
 int compare_drivers_by_score(const void *a_driver, const void *b_driver);
 
+/**
+ * Key that orders drivers like `compare_drivers_by_score`, but without the id, for `radix_sort_array`.
+ * Packs the account status, the exact average score as an integer and the last ride date.
+ */
+uint64_t driver_get_score_sort_key(gconstpointer driver, gpointer data);
+
+/**
+ * Key that orders drivers by id, for `radix_sort_array`.
+ */
+uint64_t driver_get_id_sort_key(gconstpointer driver, gpointer data);
+
 #endif //LI3_DRIVER_H
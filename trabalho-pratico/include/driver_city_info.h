@@ -2,6 +2,9 @@
 #ifndef LI3_DRIVER_CITY_INFO_H
 #define LI3_DRIVER_CITY_INFO_H
 
+#include "snapshot.h"
+#include "arena.h"
+
 /**
  * Struct that represents a driver city info. A driver city info contains information about a driver in a particular city.
  */
@@ -9,8 +12,9 @@ typedef struct DriverCityInfo DriverCityInfo;
 
 /**
  * Creates a new DriverCityInfo with the given id.
+ * If arena is not NULL, the DriverCityInfo is allocated in the arena and lives until it is freed.
  */
-DriverCityInfo *create_driver_city_info(int id);
+DriverCityInfo *create_driver_city_info(int id, Arena *arena);
 
 /**
  * Returns the id of the driver associated with the DriverCityInfo.
@@ -30,9 +34,20 @@ double driver_city_info_get_average_score(DriverCityInfo *driver_city_info);
 
 /**
  * Frees the memory allocated for the DriverCityInfo.
+ * Must not be called for driver city infos allocated in an arena.
  */
 void free_driver_city_info_voidp(void *driver_city_info);
 
+/**
+ * Writes every field of the DriverCityInfo to the snapshot.
+ */
+void driver_city_info_write_snapshot(DriverCityInfo *driver_city_info, SnapshotWriter *writer);
+
+/**
+ * Reads a DriverCityInfo written by `driver_city_info_write_snapshot`.
+ */
+DriverCityInfo *driver_city_info_read_snapshot(SnapshotReader *reader, Arena *arena);
+
 /**
  * Function that compares DriverCityInfos by average score and id.
  * This function receives gconstpointers to be used as comparison functions.
@@ -3,6 +3,7 @@
 #define LI3_FILE_UTIL_H
 
 #include <stdio.h>
+#include <stdint.h>
 
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
 #define PATH_SEPARATOR "\\"
@@ -45,4 +46,15 @@ void create_output_folder_if_not_exists(void);
  */
 FILE *create_command_output_file(int command_number);
 
+/**
+ * Writes the data directly to the file descriptor of the file, bypassing its stdio buffer
+ * (anything in that buffer must have been flushed before).
+ */
+void write_all_to_file(FILE *file, const char *data, size_t size);
+
+/**
+ * Returns the last modification time of the file, in nanoseconds since the epoch, or -1 if the file doesn't exist.
+ */
+int64_t get_file_modification_time(const char *file_path);
+
 #endif //LI3_FILE_UTIL_H
@@ -16,6 +16,10 @@
  *
  * Lazies are used in the program to only sort some arrays when they are needed,
  * thus reducing the loading time of the program.
+ *
+ * Values can be requested from multiple threads at the same time (e.g. by queries running in parallel):
+ * the function is applied by the first thread and the others wait for it to finish.
+ * Once applied, getting the value only costs an atomic load with acquire ordering (no locks).
  */
 
 /**
@@ -52,12 +56,24 @@ void *lazy_get_raw_value(Lazy *lazy);
  */
 void *lazy_get_value(Lazy *lazy);
 
+/**
+ * Sets `value` to the value saved in the lazy struct and returns TRUE if the apply function was already executed.
+ * Returns FALSE without waiting otherwise (including while another thread is executing it).
+ */
+gboolean lazy_try_get(Lazy *lazy, void **value);
+
 /**
  * Applies the apply function to the value in the lazy struct.
- * The apply function is only executed once.
+ * The apply function is only executed once. If another thread is executing it, waits for it to finish.
  */
 void lazy_apply_function(Lazy *lazy);
 
+/**
+ * Marks the apply function as already executed without executing it.
+ * Used when the value is restored already in its final state (e.g. from a snapshot).
+ */
+void lazy_mark_as_applied(Lazy *lazy);
+
 /**
  * Frees the memory allocated for the Lazy.
  * The value should be freed by the free function.
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef LI3_OUTPUT_CONTAINER_H
+#define LI3_OUTPUT_CONTAINER_H
+
+#include <glib.h>
+
+#include "file_util.h"
+#include "output_writer.h"
+
+/**
+ * This file implements the container output file, which holds the output of every command of an input file
+ * instead of one `commandN_output.txt` file per command (for input files with a huge number of commands).
+ *
+ * A container file is:
+ * - magic ("LI3OUTC\n")
+ * - the output of the commands, one after the other
+ * - an index of segments: command number (int32), padding (uint32), offset (uint64) and size (uint64) of each
+ * - a trailer: offset of the index (uint64), number of segments (uint64) and the magic again
+ *
+ * The output of a command is the concatenation of its segments, in index order.
+ * Each command usually has one segment, but the output of commands written at the same time may be interleaved.
+ * Commands with no output have a single empty segment.
+ *
+ * Like snapshots, the numbers are in host byte order.
+ */
+
+/**
+ * Name of the container file in the output folder.
+ */
+#define OUTPUT_CONTAINER_FILE_NAME "commands_output.container"
+
+/**
+ * Path of the container file written by the program with `--output=container`.
+ */
+#define OUTPUT_CONTAINER_FILE_PATH OUTPUT_FOLDER PATH_SEPARATOR OUTPUT_CONTAINER_FILE_NAME
+
+/**
+ * Struct that represents a container file being written.
+ */
+typedef struct OutputContainerWriter OutputContainerWriter;
+
+/**
+ * Creates the container file with the given path (e.g. `OUTPUT_CONTAINER_FILE_PATH`), replacing any existing one.
+ * The folder of the file must exist.
+ * Returns NULL (and logs a warning) if the file can't be created.
+ */
+OutputContainerWriter *create_output_container_writer(const char *file_path);
+
+/**
+ * Appends output of the command to the container.
+ * Appending empty output still records the command, so commands with no output can be told apart from missing ones.
+ */
+void output_container_append(OutputContainerWriter *container_writer, int command_number, const char *data, size_t size);
+
+/**
+ * Creates an output writer that appends the output of the command to the container.
+ */
+OutputWriter *output_container_create_command_writer(OutputContainerWriter *container_writer, int command_number);
+
+/**
+ * Writes the index and the trailer, closes the container file and frees the writer.
+ * Returns FALSE (and logs a warning) if any write to the file failed, in which case the file is removed.
+ */
+gboolean close_output_container_writer(OutputContainerWriter *container_writer);
+
+/**
+ * Reads the output of the command from the container file with the given path.
+ * `output` is set to a buffer allocated with malloc, with a null terminator after `size` bytes.
+ * Returns FALSE (and logs a warning) if the file is not a valid container, or FALSE if it doesn't have the command.
+ */
+gboolean read_output_container_command(const char *file_path, int command_number, char **output, size_t *size);
+
+#endif //LI3_OUTPUT_CONTAINER_H
@@ -2,19 +2,29 @@
 #ifndef LI3_OUTPUT_WRITER_H
 #define LI3_OUTPUT_WRITER_H
 
+#include <glib.h>
+#include <stdio.h>
+
+#include "struct_util.h"
+
 /**
  * Struct that represents an output writer.
  *
  * This module provides a way to write output to different targets.
  * The output writer can be used to write output to a semicolon separated file, to an array of strings, or to a null target.
+ *
+ * Tokens are separated by semicolons and lines end with a newline.
+ * Besides the printf-style functions, there are typed functions that format the most common tokens
+ * (strings, integers, "%.3f" doubles, money and dates) without parsing a format string,
+ * with the same output as the equivalent printf format.
  */
 typedef struct OutputWriter OutputWriter;
 
 /**
  * Creates an output writer that writes to the file.
  *
- * The output writer will write to the file directly with no overhead,
- * separating tokens with semicolons and ending lines with newlines.
+ * The output is buffered in a large buffer of the writer and written to the file descriptor in big writes,
+ * bypassing the stdio buffer of the file. Anything still buffered is written by close_output_writer.
  *
  * The output writer will not close the file when close_output_writer is called.
  */
@@ -30,6 +40,20 @@ OutputWriter *create_semicolon_file_output_writer(FILE *file);
  */
 OutputWriter *create_array_of_semicolon_strings_output_writer(GPtrArray *array);
 
+/**
+ * Function that receives the chunks of a chunked output writer.
+ * It takes ownership of the chunk (allocated with malloc), which holds `size` bytes of output.
+ * `is_last` is TRUE for the chunk handed over by close_output_writer, which may be empty.
+ */
+typedef void (*OutputWriterChunkFunction)(void *target, char *chunk, size_t size, gboolean is_last);
+
+/**
+ * Creates an output writer that buffers the output in chunks of about `chunk_size` bytes
+ * and hands each full chunk over to `hand_off_chunk`, which owns it from then on.
+ * Used to pass the output to another thread without copying it.
+ */
+OutputWriter *create_chunked_output_writer(void *target, OutputWriterChunkFunction hand_off_chunk, size_t chunk_size);
+
 /**
  * Creates an output writer that writes to a null target.
  * The output writer will simply ignore write calls.
@@ -49,7 +73,38 @@ void writer_write_output_token(OutputWriter *output_writer, const char *format,
 void writer_write_output_token_end(OutputWriter *output_writer, const char *format, ...);
 
 /**
- * Frees the allocated memory of the output writer.
+ * Writes the string as a token, like `writer_write_output_token(output_writer, "%s", string)`.
+ */
+void writer_write_string_token(OutputWriter *output_writer, const char *string);
+
+/**
+ * Writes the integer as a token, zero-padded to the given width (0 for no padding),
+ * like `writer_write_output_token(output_writer, "%0*d", width, value)`.
+ */
+void writer_write_int_token(OutputWriter *output_writer, int value, int width);
+
+/**
+ * Writes the double with 3 decimal places as a token, like `writer_write_output_token(output_writer, "%.3f", value)`.
+ */
+void writer_write_fixed_3_token(OutputWriter *output_writer, double value);
+
+/**
+ * Writes the amount as a token, formatted by `format_money`.
+ */
+void writer_write_money_token(OutputWriter *output_writer, Money money);
+
+/**
+ * Writes the date as a token, formatted by `format_date`.
+ */
+void writer_write_date_token(OutputWriter *output_writer, Date date);
+
+/**
+ * Terminates the line of the tokens written by the typed functions.
+ */
+void writer_end_line(OutputWriter *output_writer);
+
+/**
+ * Writes anything still buffered and frees the allocated memory of the output writer.
  */
 void close_output_writer(OutputWriter *output_writer);
 
@@ -19,4 +19,41 @@ typedef void(ApplyLineFunction)(void *, TokenIterator *);
  */
 void read_csv_file(FILE *stream, ApplyLineFunction *apply_line_function, void *apply_function_first_arg);
 
+/**
+ * Struct that represents a CSV file mapped into memory.
+ * Lines are read without any line size limit, and the file is never modified.
+ */
+typedef struct MappedCsvFile MappedCsvFile;
+
+/**
+ * Maps the CSV file with the given path into memory.
+ * Returns NULL if the file could not be opened.
+ */
+MappedCsvFile *map_csv_file(const char *file_path);
+
+/**
+ * Returns the size in bytes of the mapped file.
+ */
+size_t mapped_csv_file_get_size(MappedCsvFile *file);
+
+/**
+ * Same as `read_csv_file` but reads the lines directly from the mapped file.
+ * The mapping is never modified: each line is copied to a buffer before being split into tokens,
+ * so, as with `read_csv_file`, the tokens are only valid until apply_line_function returns.
+ */
+void read_mapped_csv_file(MappedCsvFile *file, ApplyLineFunction *apply_line_function, void *apply_function_first_arg);
+
+/**
+ * Splits the lines of the mapped file into `chunk_count` newline-aligned chunks and reads each chunk in its own thread.
+ * Chunk i is read in file order and its lines are applied with `apply_function_first_args[i]` as first argument,
+ * so apply_line_function only needs to be thread-safe across different first arguments.
+ * Returns after every chunk has been read.
+ */
+void read_mapped_csv_file_in_parallel(MappedCsvFile *file, int chunk_count, ApplyLineFunction *apply_line_function, void **apply_function_first_args);
+
+/**
+ * Unmaps the file and frees the memory allocated for it.
+ */
+void free_mapped_csv_file(MappedCsvFile *file);
+
 #endif //LI3_PARSER_H
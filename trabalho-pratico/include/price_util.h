@@ -10,7 +10,24 @@
  * - If the car class is "Basic", the price is 3.25 + 0.62 * distance
  * - If the car class is "Green", the price is 4.00 + 0.79 * distance
  * - If the car class is "Premium", the price is 5.20 + 0.94 * distance
+ * The price is exact, as it is computed in fixed-point (see `Money`).
  */
-double compute_price(int distance, CarClass car_class);
+Money compute_price(int distance, CarClass car_class);
+
+/**
+ * Number of valid car classes.
+ */
+#define CAR_CLASS_COUNT 3
+
+/**
+ * Largest distance in the price table (the largest distance a ride can store).
+ */
+#define PRICE_TABLE_MAX_DISTANCE 255
+
+/**
+ * Table with the price of every (car class, distance) pair, the same value `compute_price` returns.
+ * Indexed as `price_table[car_class][distance]`, with a valid car class and 0 <= distance <= PRICE_TABLE_MAX_DISTANCE.
+ */
+extern const int32_t price_table[CAR_CLASS_COUNT][PRICE_TABLE_MAX_DISTANCE + 1];
 
 #endif //LI3_PRICE_UTIL_H
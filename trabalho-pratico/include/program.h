@@ -57,6 +57,21 @@ void free_program(Program *program);
  * Available flags:
  * - `--lazy-loading=true` (default): Only index/sort catalog when needed (when a query is run).
  * - `--lazy-loading=false`: Index/sort everything after loading the dataset.
+ * - `--lazy-loading=background`: Index/sort everything in background threads (one per processor) after loading the dataset,
+ *   while queries already run. A query only waits for the indexes it uses.
+ * - `--io=stdio` (default): Read the dataset files line by line.
+ * - `--io=mmap`: Map the dataset files into memory and parse them in place.
+ * - `--threads=N` (default: 1): Parse the rides file with N threads (implies `--io=mmap`).
+ * - `--async-output=auto` (default): Same as `--async-output=true` if there is more than one processor, `false` otherwise.
+ * - `--async-output=true`: Write the output files of the queries of an input file in a separate thread.
+ * - `--async-output=false`: Write the output file of each query before running the next one.
+ * - `--output=files` (default): Write the output of each query of an input file to its own `commandN_output.txt` file.
+ * - `--output=container`: Write the output of every query of an input file to a single container file
+ *   with an index (`Resultados/commands_output.container`), which the `cat` command can read.
+ * - `--query-threads=N` (default: 1): Run the queries of an input file on N threads, the most expensive queries first.
+ * - `--save-snapshot=<file>`: After loading the dataset from the csv files, save the indexed catalog to a binary snapshot.
+ * - `--load-snapshot=<file>`: Restore the catalog from a snapshot instead of parsing the csv files.
+ *   Falls back to the csv files if the snapshot is invalid or was saved from a different dataset.
  */
 int start_program(Program *program, GPtrArray *program_args);
 
@@ -18,4 +18,26 @@ void parse_and_run_query(Catalog *catalog, OutputWriter *output, char *query);
  */
 void run_query(Catalog *catalog, OutputWriter *output, int query_id, char **args);
 
+/**
+ * Returns the expected cost of the query in the raw string format, relative to the other queries
+ * (0 for invalid queries). Used to schedule the most expensive queries first.
+ */
+int get_query_expected_cost(const char *query);
+
+/**
+ * Function that runs a query of an input file, where `query_number` is its position in the file (starting at 1).
+ */
+typedef void (*QueryRunner)(void *data, char *query, int query_number);
+
+/**
+ * Runs each query in the raw string format of the array (the query at index i has number i + 1) with the runner,
+ * on the given number of threads (including the calling one).
+ *
+ * Queries are started in descending order of expected cost, so the longest ones don't end up running last
+ * while the other threads are idle. Returns once every query has run.
+ *
+ * The runner must be safe to call from multiple threads, and the catalog must not be modified meanwhile.
+ */
+void run_queries_longest_first(GPtrArray *queries, int threads, QueryRunner runner, void *data);
+
 #endif //LI3_QUERY_MANAGER_H
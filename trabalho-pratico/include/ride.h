@@ -4,34 +4,78 @@
 
 #include "struct_util.h"
 #include "token_iterator.h"
+#include "snapshot.h"
+#include "arena.h"
 
 /**
- * Struct that represents a user.
+ * Struct that represents a ride.
+ * Rides are the most numerous entity, so they are packed in 16 bytes, which fits the values in the ranges below.
+ * A ride with a value outside them keeps it in a larger extension of the ride, so every valid ride is kept with its exact values.
  */
 typedef struct Ride Ride;
 
+/**
+ * Largest ride id (24 bits).
+ */
+#define RIDE_MAX_ID ((1 << 24) - 1)
+
+/**
+ * Largest driver id (and user id, generated by the catalog) of a ride (24 bits).
+ */
+#define RIDE_MAX_PERSON_ID ((1 << 24) - 1)
+
+/**
+ * Largest city id of a ride (8 bits).
+ */
+#define RIDE_MAX_CITY_ID 255
+
+/**
+ * Largest distance of a ride (8 bits).
+ */
+#define RIDE_MAX_DISTANCE 255
+
+/**
+ * Largest score of a ride (3 bits).
+ */
+#define RIDE_MAX_SCORE 7
+
+/**
+ * Largest tip of a ride (16 bits of Money, 65.535).
+ */
+#define RIDE_MAX_TIP ((1 << 16) - 1)
+
+/**
+ * Range of years of the date of a ride (7 bits).
+ */
+#define RIDE_MIN_YEAR 1970
+#define RIDE_MAX_YEAR (RIDE_MIN_YEAR + 127)
+
 /**
  * Creates a new Ride.
+ * If arena is not NULL, the Ride is allocated in the arena and lives until it is freed.
+ * Otherwise it is allocated in the heap memory and must be freed with `free_ride`.
  */
-Ride *create_ride(int id, Date date, int driver_id, int city_id, int distance, int score_user, int score_driver, double tip);
+Ride *create_ride(int id, Date date, int driver_id, int city_id, int distance, int score_user, int score_driver, Money tip, Arena *arena);
 
 /**
  * Parses a line of the CSV to a ride
  */
-Ride *parse_line_ride(TokenIterator *line_iterator);
+Ride *parse_line_ride(TokenIterator *line_iterator, Arena *arena);
 
 /**
  * Parses a line of the CSV to a ride
  * parsed_city and parsed_user_username are used to return the strings city and user_username of the ride
  * to avoid having to strdup them again when registering the ride in the catalog
+ * The Ride is allocated in the given arena (if not NULL), see `create_ride`.
  */
-Ride *parse_line_ride_detailed(TokenIterator *line_iterator, char **parsed_city, char **parsed_user_username);
+Ride *parse_line_ride_detailed(TokenIterator *line_iterator, char **parsed_city, char **parsed_user_username, Arena *arena);
 
 /**
  * Sets the city id of the ride
  * The city id is set when the ride is registered in the catalog
+ * If the id doesn't fit in the packed ride, the ride is extended in the given arena (or in the heap if it is NULL).
  */
-void ride_set_city_id(Ride *ride, int city_id);
+void ride_set_city_id(Ride *ride, int city_id, Arena *arena);
 
 /**
  * Returns the driver id of the ride
@@ -57,8 +101,9 @@ int ride_get_user_id(Ride *ride);
 /**
  * Sets the user id of the ride
  * The user id is set when the ride is registered in the catalog
+ * If the id doesn't fit in the packed ride, the ride is extended in the given arena (or in the heap if it is NULL).
  */
-void ride_set_user_id(Ride *ride, int user_id);
+void ride_set_user_id(Ride *ride, int user_id, Arena *arena);
 
 /**
  * Returns the distance of the ride
@@ -78,71 +123,86 @@ int ride_get_score_driver(Ride *ride);
 /**
  * Returns the tip given by the user to the driver
  */
-double ride_get_tip(Ride *ride);
+Money ride_get_tip(Ride *ride);
 
 /**
  * Frees the memory allocated for the Ride.
+ * Must not be called for rides allocated in an arena.
  */
 void free_ride(Ride *ride);
 
+/**
+ * Writes every field of the Ride to the snapshot.
+ */
+void ride_write_snapshot(Ride *ride, SnapshotWriter *writer);
+
+/**
+ * Reads a Ride written by `ride_write_snapshot`.
+ * Fails the reader (see `snapshot_reader_fail`) if the values can't belong to a valid ride.
+ */
+Ride *ride_read_snapshot(SnapshotReader *reader, Arena *arena);
+
 /**
  * Returns the city of the Ride.
  */
 int ride_get_city_id(Ride *ride);
 
 /**
- * Sets the price of the ride
- * The price is calculated by the function `compute_price` when the ride is registered in the catalog
+ * Sets the car class of the driver of the ride, used to derive its price.
+ * The car class is set when the ride is registered in the catalog
  */
-void ride_set_price(Ride *ride, double price);
+void ride_set_car_class(Ride *ride, CarClass car_class);
 
 /**
  * Returns the price of the ride
- * The price is calculated and set when the ride is registered in the catalog
+ * The price is not stored, it is read from the `price_table` with the car class and the distance of the ride
+ * (or computed, for distances past the table).
  */
-double ride_get_price(Ride *ride);
+Money ride_get_price(Ride *ride);
 
 /**
- * Sets the user account creation date of the ride
- * The date is set when the ride is registered in the catalog
+ * Function that compares rides by date.
+ * This function receives const pointers to be used as comparison functions.
+ * The rides indexes are placed in date order with `ride_get_date_bucket` instead, without comparisons.
  */
-void ride_set_user_account_creation_date(Ride *ride, Date date);
+int compare_rides_by_date(const void *a_ride, const void *b_ride);
 
 /**
- * Returns the user account creation date of the ride
+ * Key that orders rides by date and then by id, for `radix_sort_array`.
  */
-Date ride_get_user_account_creation_date(Ride *ride);
+uint64_t ride_get_date_sort_key(gconstpointer ride, gpointer data);
 
 /**
- * Sets the driver account creation date of the ride
- * The date is set when the ride is registered in the catalog
+ * Number of buckets of `ride_get_date_bucket` (a bucket for each packed ride date).
  */
-void ride_set_driver_account_creation_date(Ride *ride, Date date);
+#define RIDE_DATE_BUCKETS (1 << 16)
 
 /**
- * Returns the driver account creation date of the ride
+ * Buckets of the rides with a year before `RIDE_MIN_YEAR` and after `RIDE_MAX_YEAR`, no packed date falls in them.
  */
-Date ride_get_driver_account_creation_date(Ride *ride);
+#define RIDE_DATE_BUCKET_BEFORE_RANGE 0
+#define RIDE_DATE_BUCKET_AFTER_RANGE (RIDE_DATE_BUCKETS - 1)
 
 /**
- * Function that compares rides by date.
- * This function receives const pointers to be used as comparison functions.
- * Used to sort the rides array for fast resolution of the query 5 and 6.
+ * Bucket of the date of the ride for `counting_sort_array`, lower than `RIDE_DATE_BUCKETS`.
+ * Rides with the same date have the same bucket, and buckets of later dates are greater.
+ * Rides with years out of the packed range share `RIDE_DATE_BUCKET_BEFORE_RANGE` or `RIDE_DATE_BUCKET_AFTER_RANGE`,
+ * which must then be sorted with `compare_rides_by_date`.
  */
-int compare_rides_by_date(const void *a_ride, const void *b_ride);
+guint ride_get_date_bucket(gconstpointer ride);
 
 /**
- * Function that compares RideDriverAndUserInfos by driver account creation date, user account creation date and then ride id.
+ * Function that compares rides by total distance, date, and then id.
  * This function receives const pointers to be used as comparison functions.
- * Used to sort the rides array for fast resolution of the query 8.
+ * The query 9 sorts its rides with `sort_rides_by_distance` instead, which has the same order.
  */
-int compare_ride_by_driver_and_user_account_creation_date(const void *a_ride, const void *b_ride);
+int compare_rides_by_distance(const void *a_ride, const void *b_ride);
 
 /**
- * Function that compares rides by total distance, date, and then id.
- * This function receives const pointers to be used as comparison functions.
- * Used to sort the rides array for fast resolution of the query 9.
+ * Sorts an array of rides by distance, date and then id, like `compare_rides_by_distance`.
+ * The rides are sorted as (packed key, ride) values, with the key comparison inlined into the sort
+ * (or with `compare_rides_by_distance` if any ride is extended).
  */
-int compare_rides_by_distance(const void *a_ride, const void *b_ride);
+void sort_rides_by_distance(GPtrArray *rides);
 
 #endif //LI3_RIDE_H
@@ -0,0 +1,111 @@
+#pragma once
+#ifndef LI3_RIDE_COLUMNS_H
+#define LI3_RIDE_COLUMNS_H
+
+#include <glib.h>
+#include <stdint.h>
+
+#include "ride.h"
+
+/**
+ * This file implements a columnar (struct of arrays) store of rides.
+ *
+ * Each field of the rides is copied into its own contiguous array, all in the same order (by date).
+ * Rides are then addressed by their row index and a query only reads the columns it needs,
+ * instead of dereferencing a pointer per ride and loading the whole Ride struct to read a single field.
+ * Some columns are narrower than the fields of an extended ride: the few values that don't fit are kept aside,
+ * so every value read (and every sum) is still exact.
+ */
+
+/**
+ * Flags that select which columns are stored.
+ */
+typedef enum RideColumnSet {
+    RIDE_COLUMN_DATE = 1 << 0,
+    RIDE_COLUMN_PRICE = 1 << 1,
+    RIDE_COLUMN_TIP = 1 << 2,
+    RIDE_COLUMN_DISTANCE = 1 << 3,
+    RIDE_COLUMN_CITY_ID = 1 << 4,
+    RIDE_COLUMN_USER_ID = 1 << 5,
+    RIDE_COLUMN_DRIVER_ID = 1 << 6,
+    RIDE_COLUMNS_ALL = (1 << 7) - 1,
+} RideColumnSet;
+
+/**
+ * Struct that represents a columnar store of rides.
+ */
+typedef struct RideColumns RideColumns;
+
+/**
+ * Creates a columnar store with the selected columns of the given rides.
+ * The rides must be sorted by date (the date column is used for binary searches).
+ * Reading a column that was not selected is undefined behaviour.
+ */
+RideColumns *create_ride_columns(GPtrArray *rides, RideColumnSet columns);
+
+/**
+ * Returns the number of rows (rides) in the store.
+ */
+guint ride_columns_get_length(RideColumns *ride_columns);
+
+/**
+ * Returns the date of the ride in the given row.
+ */
+Date ride_columns_get_date(RideColumns *ride_columns, guint row);
+
+/**
+ * Returns the price of the ride in the given row.
+ */
+Money ride_columns_get_price(RideColumns *ride_columns, guint row);
+
+/**
+ * Returns the tip of the ride in the given row.
+ */
+Money ride_columns_get_tip(RideColumns *ride_columns, guint row);
+
+/**
+ * Returns the distance of the ride in the given row.
+ */
+int ride_columns_get_distance(RideColumns *ride_columns, guint row);
+
+/**
+ * Returns the city id of the ride in the given row.
+ */
+int ride_columns_get_city_id(RideColumns *ride_columns, guint row);
+
+/**
+ * Returns the user id of the ride in the given row.
+ */
+int ride_columns_get_user_id(RideColumns *ride_columns, guint row);
+
+/**
+ * Returns the driver id of the ride in the given row.
+ */
+int ride_columns_get_driver_id(RideColumns *ride_columns, guint row);
+
+/**
+ * Returns the first row whose date is greater than or equal to the given date.
+ */
+guint ride_columns_find_date_lower_bound(RideColumns *ride_columns, Date date);
+
+/**
+ * Returns the first row whose date is greater than the given date.
+ */
+guint ride_columns_find_date_upper_bound(RideColumns *ride_columns, Date date);
+
+/**
+ * Returns the sum of the prices of the rows in [from, to).
+ */
+Money ride_columns_sum_prices(RideColumns *ride_columns, guint from, guint to);
+
+/**
+ * Returns the sum of the distances of the rows in [from, to).
+ */
+int64_t ride_columns_sum_distances(RideColumns *ride_columns, guint from, guint to);
+
+/**
+ * Frees the columnar store.
+ */
+void free_ride_columns(RideColumns *ride_columns);
+
+#endif //LI3_RIDE_COLUMNS_H
@@ -0,0 +1,142 @@
+#pragma once
+#ifndef LI3_SNAPSHOT_H
+#define LI3_SNAPSHOT_H
+
+#include <glib.h>
+#include <stdint.h>
+
+/**
+ * This file implements the binary snapshot format used to save and restore the catalog.
+ *
+ * A snapshot file is a header followed by a payload:
+ * - magic ("LI3SNAP\n"), format version and a byte order mark
+ * - fingerprint of the dataset the snapshot was built from
+ * - payload size and checksum
+ *
+ * The payload is a pointer-free sequence of fixed-size integers and length-prefixed strings
+ * written in host byte order (snapshots are not meant to be moved between machines, the byte order mark rejects them).
+ * Every module writes and reads its own fields in the same order, so the format is defined by those functions.
+ */
+
+/**
+ * Version of the snapshot format. Must be incremented whenever any module changes what it writes.
+ */
+#define SNAPSHOT_FORMAT_VERSION 5
+
+/**
+ * Struct that accumulates the payload of a snapshot in memory.
+ */
+typedef struct SnapshotWriter SnapshotWriter;
+
+/**
+ * Struct that reads the payload of a memory-mapped snapshot file.
+ * Strings read from the snapshot point into the mapping, so it must outlive everything that borrows them.
+ */
+typedef struct SnapshotReader SnapshotReader;
+
+/**
+ * Creates a new empty SnapshotWriter.
+ */
+SnapshotWriter *create_snapshot_writer(void);
+
+/**
+ * Appends a uint8_t to the payload.
+ */
+void snapshot_write_uint8(SnapshotWriter *writer, uint8_t value);
+
+/**
+ * Appends a uint16_t to the payload.
+ */
+void snapshot_write_uint16(SnapshotWriter *writer, uint16_t value);
+
+/**
+ * Appends a uint32_t to the payload.
+ */
+void snapshot_write_uint32(SnapshotWriter *writer, uint32_t value);
+
+/**
+ * Appends a int32_t to the payload.
+ */
+void snapshot_write_int32(SnapshotWriter *writer, int32_t value);
+
+/**
+ * Appends a int64_t to the payload.
+ */
+void snapshot_write_int64(SnapshotWriter *writer, int64_t value);
+
+/**
+ * Writes a NUL terminated string (its length followed by its bytes and the terminator).
+ */
+void snapshot_write_string(SnapshotWriter *writer, const char *string);
+
+/**
+ * Writes the header and the payload to the file with the given path.
+ * Returns FALSE (and logs a warning) if the file could not be written.
+ */
+gboolean snapshot_writer_save(SnapshotWriter *writer, const char *file_path, uint64_t dataset_fingerprint);
+
+/**
+ * Frees the writer and its payload.
+ */
+void free_snapshot_writer(SnapshotWriter *writer);
+
+/**
+ * Maps the snapshot file with the given path and validates its header and checksum.
+ * Returns NULL (and logs a warning) if the file can't be opened, is corrupted, was written by another format version
+ * or doesn't match the given dataset fingerprint.
+ */
+SnapshotReader *open_snapshot_reader(const char *file_path, uint64_t dataset_fingerprint);
+
+/**
+ * Reads the next uint8_t of the payload.
+ */
+uint8_t snapshot_read_uint8(SnapshotReader *reader);
+
+/**
+ * Reads the next uint16_t of the payload.
+ */
+uint16_t snapshot_read_uint16(SnapshotReader *reader);
+
+/**
+ * Reads the next uint32_t of the payload.
+ */
+uint32_t snapshot_read_uint32(SnapshotReader *reader);
+
+/**
+ * Reads the next int32_t of the payload.
+ */
+int32_t snapshot_read_int32(SnapshotReader *reader);
+
+/**
+ * Reads the next int64_t of the payload.
+ */
+int64_t snapshot_read_int64(SnapshotReader *reader);
+
+/**
+ * Returns a pointer to a string inside the mapping. The string must not be freed.
+ */
+char *snapshot_read_string(SnapshotReader *reader);
+
+/**
+ * Marks the snapshot as invalid, for values that were read but can't be loaded (e.g. out of range).
+ * The error is reported by `snapshot_reader_has_error`, like a read past the end of the payload.
+ */
+void snapshot_reader_fail(SnapshotReader *reader);
+
+/**
+ * Returns TRUE if a read went past the end of the payload (the values read after that are 0 or empty strings)
+ * or if `snapshot_reader_fail` was called.
+ */
+gboolean snapshot_reader_has_error(SnapshotReader *reader);
+
+/**
+ * Unmaps the snapshot file and frees the reader.
+ */
+void free_snapshot_reader(SnapshotReader *reader);
+
+/**
+ * Computes a 64 bit checksum of the given bytes. Not cryptographic, only meant to detect corruption.
+ */
+uint64_t compute_snapshot_checksum(const void *data, size_t size, uint64_t seed);
+
+#endif //LI3_SNAPSHOT_H
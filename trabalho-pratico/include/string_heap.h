@@ -0,0 +1,48 @@
+#pragma once
+#ifndef LI3_STRING_HEAP_H
+#define LI3_STRING_HEAP_H
+
+#include <glib.h>
+#include <stdint.h>
+
+/**
+ * This file implements a string heap: one contiguous, append-only buffer of null terminated strings.
+ *
+ * Strings are referenced by their 32-bit offset in the buffer instead of by pointer, which is half the size
+ * and stays valid when the buffer grows (and is moved by realloc).
+ * Pointers returned by `string_heap_get` are only valid until the next append.
+ */
+
+/**
+ * Struct that represents a string heap.
+ */
+typedef struct StringHeap StringHeap;
+
+/**
+ * Creates an empty string heap with space for `reserved_size` bytes.
+ */
+StringHeap *create_string_heap(size_t reserved_size);
+
+/**
+ * Copies the string with the given length (without the null terminator) to the end of the heap.
+ * Returns the offset of the copy.
+ */
+uint32_t string_heap_append(StringHeap *string_heap, const char *string, size_t length);
+
+/**
+ * Returns the string at the given offset.
+ * The pointer is only valid until the next append.
+ */
+const char *string_heap_get(StringHeap *string_heap, uint32_t offset);
+
+/**
+ * Returns the number of bytes used by the strings of the heap (including the null terminators).
+ */
+size_t string_heap_get_size(StringHeap *string_heap);
+
+/**
+ * Frees the string heap and every string in it.
+ */
+void free_string_heap(StringHeap *string_heap);
+
+#endif //LI3_STRING_HEAP_H
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef LI3_STRING_INDEX_H
+#define LI3_STRING_INDEX_H
+
+#include <glib.h>
+
+#include "string_heap.h"
+
+/**
+ * This file implements a hash index from strings to dense integer ids (e.g. usernames to user ids).
+ *
+ * It is an open addressing table with linear probing and Robin Hood insertion (an entry takes the slot of any entry
+ * that is closer to its home slot), so probe sequences stay short even at high load factors.
+ * Each slot stores the 32-bit hash of its key, which is compared before the key itself,
+ * and the key as an offset into a string heap, so the keys are not separate allocations.
+ *
+ * The index is not thread-safe.
+ */
+
+/**
+ * Returned by lookups of keys that are not in the index.
+ */
+#define STRING_INDEX_NOT_FOUND (-1)
+
+/**
+ * Struct that represents a string index.
+ */
+typedef struct StringIndex StringIndex;
+
+/**
+ * Creates an empty index with space for `expected_count` keys before growing.
+ * Keys are copied to the given string heap, which must outlive the index.
+ */
+StringIndex *create_string_index(StringHeap *string_heap, guint expected_count);
+
+/**
+ * Grows the index (if needed) to fit `expected_count` keys without growing again.
+ * Used when the number of keys is only estimated after the index is created.
+ */
+void string_index_reserve(StringIndex *string_index, guint expected_count);
+
+/**
+ * Maps the key to the id (the id must not be negative).
+ * If the key was already in the index its id is replaced and the key is not copied again.
+ * Returns the offset of the key in the string heap, so the heap copy can be referenced instead of copying it again.
+ */
+uint32_t string_index_insert(StringIndex *string_index, const char *key, int id);
+
+/**
+ * Returns the id of the key or STRING_INDEX_NOT_FOUND if it is not in the index.
+ */
+int string_index_lookup(StringIndex *string_index, const char *key);
+
+/**
+ * Returns the hash of the key used by the index.
+ * Together with `string_index_prefetch` and `string_index_lookup_with_hash` it splits a lookup in steps,
+ * so the lookups of a batch of keys can overlap their cache misses.
+ */
+uint32_t string_index_hash(const char *key);
+
+/**
+ * Starts loading the home slot of the hash into the cache.
+ */
+void string_index_prefetch(StringIndex *string_index, uint32_t hash);
+
+/**
+ * Same as `string_index_lookup` with the hash of the key already computed by `string_index_hash`.
+ */
+int string_index_lookup_with_hash(StringIndex *string_index, const char *key, uint32_t hash);
+
+/**
+ * Returns the number of keys in the index.
+ */
+guint string_index_get_size(StringIndex *string_index);
+
+/**
+ * Returns the number of slots of the index.
+ */
+guint string_index_get_capacity(StringIndex *string_index);
+
+/**
+ * Frees the index. The keys are owned by the string heap.
+ */
+void free_string_index(StringIndex *string_index);
+
+#endif //LI3_STRING_INDEX_H
@@ -0,0 +1,93 @@
+#pragma once
+#ifndef LI3_STRING_POOL_H
+#define LI3_STRING_POOL_H
+
+#include <glib.h>
+#include <stdint.h>
+
+#include "snapshot.h"
+
+/**
+ * This file implements a string pool that interns strings: every distinct string is stored once in a string heap
+ * and referenced by a 32-bit id (its offset in the heap), however many times it is interned.
+ *
+ * The datasets repeat a small set of names many times, so the catalog interns the names of users and drivers
+ * instead of keeping a copy for each of them.
+ *
+ * Interning is thread-safe (users and drivers may be loaded by different threads).
+ * Pointers returned by `string_pool_get` are only valid until the next string is interned,
+ * which in the catalog means while queries run, after loading.
+ */
+
+/**
+ * Struct that represents a string pool.
+ */
+typedef struct StringPool StringPool;
+
+/**
+ * Creates an empty string pool.
+ */
+StringPool *create_string_pool(void);
+
+/**
+ * Returns the id of the string, adding it to the pool if it isn't there yet.
+ */
+uint32_t string_pool_intern(StringPool *string_pool, const char *string);
+
+/**
+ * Returns the string with the given id.
+ * The pointer is only valid until the next string is interned.
+ */
+const char *string_pool_get(StringPool *string_pool, uint32_t string_id);
+
+/**
+ * Returns the number of distinct strings in the pool.
+ */
+guint string_pool_get_unique_count(StringPool *string_pool);
+
+/**
+ * Returns the number of bytes used by the distinct strings (including the null terminators).
+ */
+size_t string_pool_get_size(StringPool *string_pool);
+
+/**
+ * Returns the number of times a string was interned (strings restored from a snapshot don't count).
+ */
+guint string_pool_get_reference_count(StringPool *string_pool);
+
+/**
+ * Returns the number of bytes that a copy of the string for each reference would use (including the null terminators).
+ */
+size_t string_pool_get_referenced_size(StringPool *string_pool);
+
+/**
+ * Returns TRUE if the id is the id of a string of the pool (e.g. an id read from a snapshot).
+ */
+gboolean string_pool_is_valid_id(StringPool *string_pool, uint32_t string_id);
+
+/**
+ * Writes the distinct strings to the snapshot in byte order, instead of in the order they were interned
+ * (which depends on the order of the threads that interned them), so the same strings always give the same snapshot.
+ * The ids of the strings in the snapshot are given by `string_pool_get_snapshot_id`.
+ */
+void string_pool_write_snapshot(StringPool *string_pool, SnapshotWriter *writer);
+
+/**
+ * Returns the id that the string with the given id has in the last snapshot written by `string_pool_write_snapshot`,
+ * which is the id to write to that snapshot and the id the string has once the snapshot is restored.
+ */
+uint32_t string_pool_get_snapshot_id(StringPool *string_pool, uint32_t string_id);
+
+/**
+ * Interns the strings written by `string_pool_write_snapshot` in an empty pool,
+ * which gives them the ids returned by `string_pool_get_snapshot_id`.
+ * Returns FALSE if the snapshot is inconsistent.
+ */
+gboolean string_pool_read_snapshot(StringPool *string_pool, SnapshotReader *reader);
+
+/**
+ * Frees the string pool and every string in it.
+ */
+void free_string_pool(StringPool *string_pool);
+
+#endif //LI3_STRING_POOL_H
@@ -19,6 +19,27 @@ typedef struct date {
     uint32_t encoded_date;
 } Date;
 
+/**
+ * Fixed-point amount of money in thousandths (e.g. 4.25 is 4250).
+ * Sums of money are exact integer additions and are formatted without going through floating point.
+ */
+typedef int64_t Money;
+
+/**
+ * Number of Money units in one unit of currency.
+ */
+#define MONEY_SCALE 1000
+
+/**
+ * Size of a buffer that fits any Money formatted by `format_money`.
+ */
+#define MONEY_STRING_BUFFER_SIZE 24
+
+/**
+ * Size of a buffer that fits any Date formatted by `format_date`.
+ */
+#define DATE_STRING_BUFFER_SIZE 12
+
 /**
  * Struct that represents a payment method (Cash, Debit and Credit)
  */
@@ -65,28 +86,60 @@ int date_compare(Date date_1, Date date_2);
 /**
  * Parses a string into an int
  * Returns the int value of the string
- * Sets error to 1 if the string is not a valid int
+ * Sets error to 1 if the string is not a valid int or doesn't fit in an int
+ * Strings with up to 7 digits are parsed at once with a SWAR (SIMD within a register) kernel.
  */
 int parse_int_safe(char *string, int *error);
 
+/**
+ * Scalar reference implementation of `parse_int_safe`, used as fallback and in tests.
+ */
+int parse_int_safe_reference(char *string, int *error);
+
 /**
  * Parses a string into an int assuming it is a valid int
  */
 int parse_int_unsafe(char *string);
 
 /**
- * Parses a string into an int
- * Returns the int value of the string
- * Sets error to 1 if the string is not a valid int
+ * Parses a string into a double
+ * Returns the double value of the string
+ * Sets error to 1 if the string is not a valid double
  */
 double parse_double_safe(char *string, int *error);
 
+/**
+ * Parses a decimal string (e.g. "12.5") into Money
+ * Returns the amount rounded to the nearest thousandth
+ * Sets error to 1 if the string is not a valid number (the same strings `parse_double_safe` rejects)
+ */
+Money parse_money_safe(char *string, int *error);
+
+/**
+ * Writes the amount with 3 decimal places (like printf's "%.3f") into buffer, which must have at least MONEY_STRING_BUFFER_SIZE bytes.
+ * Returns buffer.
+ */
+char *format_money(Money money, char *buffer);
+
+/**
+ * Returns the average of count amounts that sum to sum, rounded half up to the nearest thousandth.
+ * sum must not be negative and count must be positive.
+ */
+Money money_average(Money sum, int count);
+
 /**
  * Returns a string representation of the date in the format dd/mm/yyyy
  * The string is allocated in the heap and must be freed
  */
 char *convert_date_to_string(Date date);
 
+/**
+ * Writes the date in the format dd/mm/yyyy (like `convert_date_to_string`) into buffer,
+ * which must have at least DATE_STRING_BUFFER_SIZE bytes, so it can be formatted on the stack.
+ * Returns buffer.
+ */
+char *format_date(Date date, char *buffer);
+
 /**
  * Returns 1 if the date is valid, 0 otherwise
  */
@@ -95,10 +148,17 @@ int is_date_valid(Date date);
 /**
  * Parses a string into a date struct
  * Returns an invalid date if the string is not a valid date
- * The date is considered valid if it is in the format dd/mm/yyyy (1<=dd<=12 && 1<=mm<=31)
+ * The date is considered valid if it is in the format dd/mm/yyyy (1<=dd<=31 && 1<=mm<=12)
+ * The digits are validated and converted with two word loads (SWAR), the string is not modified.
  */
 Date parse_date(char *string);
 
+/**
+ * Scalar reference implementation of `parse_date`, used as fallback and in tests.
+ * This one writes '\0' over the slashes of the string.
+ */
+Date parse_date_reference(char *string);
+
 /**
  * Creates a date struct from the given day, month and year
  */
@@ -134,19 +194,31 @@ char *convert_gender_to_string(Gender gender);
 Gender parse_gender(const char *string);
 
 /**
- * Parses a string into a car class struct
+ * Parses a string into a car class struct (case insensitive)
  * Returns INVALID_CAR_CLASS if the string is not a valid car class
- * This will modify the string to be all uppercase
+ * The string is compared as a single lowercased word, it is not modified.
  */
 CarClass parse_car_class(char *string);
 
 /**
- * Parses a string into an account status struct
- * Returns INVALID_ACCOUNT_STATUS if the string is not a valid account status
+ * Scalar reference implementation of `parse_car_class`, used in tests.
  * This will modify the string to be all uppercase
  */
+CarClass parse_car_class_reference(char *string);
+
+/**
+ * Parses a string into an account status struct (case insensitive)
+ * Returns INVALID_ACCOUNT_STATUS if the string is not a valid account status
+ * The string is compared as a single lowercased word, it is not modified.
+ */
 AccountStatus parse_acc_status(char *string);
 
+/**
+ * Scalar reference implementation of `parse_acc_status`, used in tests.
+ * This will modify the string to be all uppercase
+ */
+AccountStatus parse_acc_status_reference(char *string);
+
 /**
  * Parses a string into a payment method struct
  */
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef LI3_THREAD_BUDGET_H
+#define LI3_THREAD_BUDGET_H
+
+#include <glib.h>
+
+/**
+ * This file implements the budget of threads shared by the whole program.
+ *
+ * Besides the main thread, the program may have as many threads running at the same time as there are processors
+ * minus one (the spare threads). Thread pools (background indexing, query workers) reserve the spare threads they use,
+ * and a parallel sort only starts the spare threads that are left, so a sort started inside a worker
+ * (e.g. by a lazy index) doesn't multiply the number of threads by its own.
+ *
+ * Reservations never block: a caller that gets fewer threads than it wanted does the work with fewer threads.
+ */
+
+/**
+ * Returns the number of spare threads of the program: by default, the number of processors minus one.
+ */
+int get_spare_thread_count(void);
+
+/**
+ * Changes the number of spare threads of the program (e.g. to run parallel code on a machine with a single processor).
+ * A negative count restores the default. Must not be called while spare threads are reserved.
+ */
+void set_spare_thread_count(int spare_threads);
+
+/**
+ * Reserves up to `wanted` spare threads that aren't reserved yet.
+ * Returns the number of threads reserved (possibly 0), which must be given back with `release_spare_threads`.
+ */
+int reserve_spare_threads(int wanted);
+
+/**
+ * Gives back spare threads reserved with `reserve_spare_threads`.
+ */
+void release_spare_threads(int threads);
+
+#endif //LI3_THREAD_BUDGET_H
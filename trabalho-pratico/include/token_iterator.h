@@ -2,6 +2,9 @@
 #ifndef LI3_TOKEN_ITERATOR_H
 #define LI3_TOKEN_ITERATOR_H
 
+#include <glib.h>
+#include <stdint.h>
+
 /**
  * Abstraction of a token iterator.
  */
@@ -24,6 +27,18 @@ char *token_iterator_current(TokenIterator *iterator);
  */
 void token_iterator_set_current(TokenIterator *iterator, char *string);
 
+/**
+ * Sets the current line of the iterator, finding all its token boundaries at once with the delimiter scanner.
+ * The line must end with '\0' or '\n', a trailing '\n' is removed.
+ */
+void token_iterator_set_current_line(TokenIterator *iterator, char *line);
+
+/**
+ * Sets the current line of the iterator with an already computed table of token ends (see `ScannedLineFunction`).
+ * The table must stay valid until the iterator moves to another line.
+ */
+void token_iterator_set_current_tokens(TokenIterator *iterator, char *line, const uint32_t *token_ends, int token_count);
+
 /**
  * Advances the iterator to the next token in the line.
  * Returns the next token.
@@ -0,0 +1,175 @@
+#pragma once
+#ifndef LI3_TYPED_ARRAY_H
+#define LI3_TYPED_ARRAY_H
+
+#include <glib.h>
+#include <stdlib.h>
+
+/**
+ * This file implements macros that generate code specialized for an element type:
+ * - `DEFINE_TYPED_ARRAY`: a dynamic array that stores the elements by value (unlike GPtrArray, without a pointer per element)
+ * - `DEFINE_TYPED_SORT`: an introsort of an array of elements
+ * - `DEFINE_TYPED_LOWER_BOUND`: a branchless binary search in a sorted array of elements
+ *
+ * The elements are compared by a function given by name, so the compiler inlines it into the generated code,
+ * instead of calling a function pointer for every comparison (like qsort, GArray and GPtrArray sorts do).
+ * The generated functions are static, so each file generates the specializations it uses.
+ */
+
+/**
+ * Generates a dynamic array of elements of the given type, named `ArrayType`, with the functions:
+ * - `ArrayType *create_<prefix>(guint reserved_size)`
+ * - `void <prefix>_append(ArrayType *array, ElementType element)`
+ * - `ElementType *<prefix>_get(ArrayType *array, guint index)`
+ * - `void free_<prefix>(ArrayType *array)`
+ *
+ * The elements are in `array->data` and there are `array->len` of them.
+ */
+#define DEFINE_TYPED_ARRAY(ArrayType, prefix, ElementType)                                      \
+    typedef struct {                                                                            \
+        ElementType *data;                                                                      \
+        guint len;                                                                              \
+        guint capacity;                                                                         \
+    } ArrayType;                                                                                \
+                                                                                                \
+    static inline ArrayType *create_##prefix(guint reserved_size) {                             \
+        ArrayType *array = malloc(sizeof(ArrayType));                                           \
+        array->data = reserved_size > 0 ? malloc(sizeof(ElementType) * reserved_size) : NULL;   \
+        array->len = 0;                                                                         \
+        array->capacity = reserved_size;                                                        \
+        return array;                                                                           \
+    }                                                                                           \
+                                                                                                \
+    static inline void prefix##_append(ArrayType *array, ElementType element) {                 \
+        if (array->len == array->capacity) {                                                    \
+            array->capacity = MAX(array->capacity * 2, 16);                                     \
+            array->data = realloc(array->data, sizeof(ElementType) * array->capacity);          \
+        }                                                                                       \
+        array->data[array->len++] = element;                                                    \
+    }                                                                                           \
+                                                                                                \
+    static inline ElementType *prefix##_get(ArrayType *array, guint index) {                    \
+        return &array->data[index];                                                             \
+    }                                                                                           \
+                                                                                                \
+    static inline void free_##prefix(ArrayType *array) {                                        \
+        free(array->data);                                                                      \
+        free(array);                                                                            \
+    }
+
+/**
+ * Partitions smaller than this are left to the insertion sort at the end of `DEFINE_TYPED_SORT` sorts.
+ */
+#define TYPED_SORT_INSERTION_THRESHOLD 16
+
+/**
+ * Generates `void <prefix>_sort(ElementType *items, size_t length)`, which sorts the items in ascending order.
+ * `is_less` is the name of a function `gboolean is_less(const ElementType *a, const ElementType *b)`.
+ *
+ * The sort is an introsort: a quicksort with the median of three as pivot, that falls back to a heapsort
+ * if it recurses too deep (so it is O(n log n) in the worst case), followed by an insertion sort of the small partitions.
+ * Like qsort, it is not stable.
+ */
+#define DEFINE_TYPED_SORT(prefix, ElementType, is_less)                                           \
+    static inline void prefix##_swap(ElementType *a, ElementType *b) {                            \
+        ElementType temporary = *a;                                                               \
+        *a = *b;                                                                                  \
+        *b = temporary;                                                                           \
+    }                                                                                             \
+                                                                                                  \
+    static inline void prefix##_insertion_sort(ElementType *items, size_t length) {               \
+        for (size_t i = 1; i < length; i++) {                                                     \
+            ElementType item = items[i];                                                          \
+            size_t j = i;                                                                         \
+            for (; j > 0 && is_less(&item, &items[j - 1]); j--) items[j] = items[j - 1];          \
+            items[j] = item;                                                                      \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    static inline void prefix##_sift_down(ElementType *items, size_t root, size_t length) {       \
+        for (size_t child; (child = 2 * root + 1) < length; root = child) {                       \
+            if (child + 1 < length && is_less(&items[child], &items[child + 1])) child++;         \
+            if (!is_less(&items[root], &items[child])) return;                                    \
+            prefix##_swap(&items[root], &items[child]);                                           \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    static inline void prefix##_heap_sort(ElementType *items, size_t length) {                    \
+        for (size_t root = length / 2; root-- > 0;) prefix##_sift_down(items, root, length);      \
+        for (size_t end = length; end-- > 1;) {                                                   \
+            prefix##_swap(&items[0], &items[end]);                                                \
+            prefix##_sift_down(items, 0, end);                                                    \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    static void prefix##_introsort(ElementType *items, size_t length, int depth_limit) {          \
+        while (length > TYPED_SORT_INSERTION_THRESHOLD) {                                         \
+            if (depth_limit-- == 0) {                                                             \
+                prefix##_heap_sort(items, length);                                                \
+                return;                                                                           \
+            }                                                                                     \
+                                                                                                  \
+            /* Orders the first, middle and last items, so the scans below stop inside the array */ \
+            size_t middle = length / 2;                                                           \
+            if (is_less(&items[middle], &items[0])) prefix##_swap(&items[middle], &items[0]);     \
+            if (is_less(&items[length - 1], &items[middle])) {                                    \
+                prefix##_swap(&items[length - 1], &items[middle]);                                \
+                if (is_less(&items[middle], &items[0])) prefix##_swap(&items[middle], &items[0]); \
+            }                                                                                     \
+            ElementType pivot = items[middle];                                                    \
+                                                                                                  \
+            size_t i = 0;                                                                         \
+            size_t j = length - 1;                                                                \
+            while (TRUE) {                                                                        \
+                while (is_less(&items[i], &pivot)) i++;                                           \
+                while (is_less(&pivot, &items[j])) j--;                                           \
+                if (i >= j) break;                                                                \
+                prefix##_swap(&items[i], &items[j]);                                              \
+                i++;                                                                              \
+                j--;                                                                              \
+            }                                                                                     \
+                                                                                                  \
+            /* Recurses into the smaller side and loops on the larger one */                      \
+            if (i < length - i) {                                                                 \
+                prefix##_introsort(items, i, depth_limit);                                        \
+                items += i;                                                                       \
+                length -= i;                                                                      \
+            } else {                                                                              \
+                prefix##_introsort(items + i, length - i, depth_limit);                           \
+                length = i;                                                                       \
+            }                                                                                     \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    static inline void prefix##_sort(ElementType *items, size_t length) {                         \
+        int depth_limit = 0;                                                                      \
+        for (size_t remaining = length; remaining > 1; remaining /= 2) depth_limit += 2;          \
+                                                                                                  \
+        prefix##_introsort(items, length, depth_limit);                                           \
+        prefix##_insertion_sort(items, length);                                                   \
+    }
+
+/**
+ * Generates `size_t <name>(const ElementType *items, size_t length, KeyType key)`, which returns the index of the first item
+ * for which `is_before_key` is FALSE (or `length` if there is none), in items where it is TRUE for a prefix and FALSE after.
+ * `is_before_key` is the name of a function `gboolean is_before_key(const ElementType *item, KeyType key)`:
+ * with `*item < key` it finds the lower bound of the key and with `*item <= key` the upper bound.
+ *
+ * The search halves the range without branching on the comparison, which the compiler turns into a conditional move,
+ * so it doesn't pay for mispredicted branches.
+ */
+#define DEFINE_TYPED_LOWER_BOUND(name, ElementType, KeyType, is_before_key)           \
+    static inline size_t name(const ElementType *items, size_t length, KeyType key) { \
+        if (length == 0) return 0;                                                    \
+                                                                                      \
+        const ElementType *base = items;                                              \
+        while (length > 1) {                                                          \
+            size_t half = length / 2;                                                 \
+            base = is_before_key(&base[half], key) ? base + half : base;              \
+            length -= half;                                                           \
+        }                                                                             \
+                                                                                      \
+        return (size_t) (base - items) + (is_before_key(base, key) ? 1 : 0);          \
+    }
+
+#endif //LI3_TYPED_ARRAY_H
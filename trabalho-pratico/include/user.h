@@ -4,6 +4,10 @@
 
 #include "struct_util.h"
 #include "token_iterator.h"
+#include "snapshot.h"
+#include "arena.h"
+#include "string_heap.h"
+#include "string_pool.h"
 
 /**
  * Struct that represents a user.
@@ -11,27 +15,49 @@
 typedef struct User User;
 
 /**
- * Creates a new User allocated in the heap memory with the given parameters.
+ * Creates a new User with the given parameters.
+ * The name is referenced by its id in the string pool of the catalog (see `catalog_get_user_name`)
+ * and the username is only set when the User is registered (see `user_set_username_offset`).
  * Sets number of rides, total distance, total price, accumulated score and last ride date to 0.
+ * If arena is not NULL, the User is allocated in the arena and lives until it is freed.
+ * Otherwise it is allocated in the heap memory and must be freed with `free_user`.
  */
-User *create_user(char *username, char *name, Gender gender, Date birthdate, Date acc_creation, PaymentMethod pay_method, AccountStatus acc_status);
+User *create_user(uint32_t name_id, Gender gender, Date birthdate, Date acc_creation, PaymentMethod pay_method, AccountStatus acc_status, Arena *arena);
 
 /**
  * Frees the memory allocated for the User.
+ * Must not be called for users allocated in an arena.
  */
 void free_user(User *user);
 
 /**
- * Returns a copy of the username of the User
- * The caller is responsible for freeing the memory allocated for the username
+ * Writes every field of the User to the snapshot, except the username (which is in the heap of the catalog),
+ * with the snapshot id of its name (see `string_pool_write_snapshot`).
  */
-char *user_get_username(User *user);
+void user_write_snapshot(User *user, SnapshotWriter *writer, StringPool *name_pool);
 
 /**
- * Returns a copy of the name of the User
- * The caller is responsible for freeing the memory allocated for the name
+ * Reads a User written by `user_write_snapshot`, whose names were restored to the given pool.
+ * The username offset is set when the User is registered again.
+ * Returns NULL if the name id isn't the id of a name of the pool.
  */
-char *user_get_name(User *user);
+User *user_read_snapshot(SnapshotReader *reader, Arena *arena, StringPool *name_pool);
+
+/**
+ * Returns the offset of the username of the User in the username heap of the catalog.
+ */
+uint32_t user_get_username_offset(User *user);
+
+/**
+ * Sets the offset of the username of the User in the username heap of the catalog.
+ * Used when the User is added to the catalog
+ */
+void user_set_username_offset(User *user, uint32_t username_offset);
+
+/**
+ * Returns the id of the name of the User in the string pool of the catalog.
+ */
+uint32_t user_get_name_id(User *user);
 
 /**
  * Returns the id associated with the User
@@ -79,12 +105,12 @@ void user_add_score(User *user, int score);
 /**
  * Increments the total money spent of the User
  */
-void user_add_spent(User *user, double spent);
+void user_add_spent(User *user, Money spent);
 
 /**
  * Returns the total money spent of the User
  */
-double user_get_total_spent(User *user);
+Money user_get_total_spent(User *user);
 
 /**
  * Returns the number of rides of the User
@@ -119,14 +145,29 @@ void user_register_ride_date(User *user, Date date);
 
 /**
  * Parses a string of the User File. 
+ * parsed_username is used to return the username, which is only stored when the User is registered.
+ * The name is interned in the given string pool (if NULL, the name is not kept).
+ * The User is allocated in the given arena (if not NULL), see `create_user`.
+ */
+User *parse_line_user_detailed(TokenIterator *line_iterator, char **parsed_username, StringPool *name_pool, Arena *arena);
+
+/**
+ * Parses a string of the User File without keeping its username and name.
  */
-User *parse_line_user(TokenIterator *line_iterator);
+User *parse_line_user(TokenIterator *line_iterator, Arena *arena);
 
 /**
  * Function that compares users by activeness, total distance, last ride and username.
- * This function receives gconstpointers to be used as comparison functions.
+ * This function receives gconstpointers and the username heap to be used as a GCompareDataFunc.
  * Used to sort the users array for fast resolution of the query 3.
  */
-int compare_users_by_total_distance(const void *a_user, const void *b_user);
+int compare_users_by_total_distance(const void *a_user, const void *b_user, void *username_heap);
+
+/**
+ * Key that orders users like `compare_users_by_total_distance` for `radix_sort_array`, given the username heap.
+ * Packs the account status, the total distance, the most recent ride date and the first bytes of the username,
+ * so only users whose usernames start the same have the same key.
+ */
+uint64_t user_get_total_distance_sort_key(gconstpointer user, gpointer username_heap);
 
 #endif //LI3_USER_H
@@ -0,0 +1,114 @@
+#if defined(ARENA_USE_HUGE_PAGES) && defined(__linux__)
+#define _DEFAULT_SOURCE // madvise is not part of C11
+#include <sys/mman.h>
+#define ARENA_HUGE_PAGES 1
+#else
+#define ARENA_HUGE_PAGES 0
+#endif
+
+#include "arena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Struct that represents an arena.
+ */
+struct Arena {
+    GPtrArray *chunks;
+    char *current; // Next free byte of the current chunk
+    char *end; // End of the current chunk
+    size_t reserved_size;
+};
+
+/**
+ * Function that wraps free to be used in GLib g_ptr_array free func.
+ */
+static void free_arena_chunk(gpointer chunk) {
+    free(chunk);
+}
+
+Arena *create_arena(void) {
+    Arena *arena = malloc(sizeof(Arena));
+    arena->chunks = g_ptr_array_new_with_free_func(free_arena_chunk);
+    arena->current = NULL;
+    arena->end = NULL;
+    arena->reserved_size = 0;
+    return arena;
+}
+
+/**
+ * Allocates a new chunk with at least `size` bytes and registers it in the arena.
+ */
+static char *arena_allocate_chunk(Arena *arena, size_t size) {
+    char *chunk;
+
+#if ARENA_HUGE_PAGES
+    size = (size + ARENA_CHUNK_SIZE - 1) / ARENA_CHUNK_SIZE * ARENA_CHUNK_SIZE;
+    chunk = aligned_alloc(ARENA_CHUNK_SIZE, size);
+    if (chunk != NULL) madvise(chunk, size, MADV_HUGEPAGE); // Only a hint, it's fine if the kernel ignores it
+#else
+    chunk = malloc(size);
+#endif
+
+    g_ptr_array_add(arena->chunks, chunk);
+    arena->reserved_size += size;
+
+    return chunk;
+}
+
+/**
+ * Allocates `size` bytes aligned to `alignment` (a power of two).
+ */
+static inline void *arena_alloc_aligned(Arena *arena, size_t size, size_t alignment) {
+    uintptr_t current = ((uintptr_t) arena->current + alignment - 1) & ~(uintptr_t) (alignment - 1);
+
+    if (G_UNLIKELY(arena->current == NULL || current + size > (uintptr_t) arena->end)) {
+        if (size > ARENA_CHUNK_SIZE / 4) {
+            // Big objects get their own chunk, so the rest of the current chunk is not wasted
+            return arena_allocate_chunk(arena, size);
+        }
+
+        arena->current = arena_allocate_chunk(arena, ARENA_CHUNK_SIZE);
+        arena->end = arena->current + ARENA_CHUNK_SIZE;
+        current = (uintptr_t) arena->current; // Chunks are aligned for any type
+    }
+
+    arena->current = (char *) (current + size);
+    return (void *) current;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    return arena_alloc_aligned(arena, size, ARENA_ALIGNMENT);
+}
+
+char *arena_strdup(Arena *arena, const char *string) {
+    size_t size = strlen(string) + 1;
+    char *copy = arena_alloc_aligned(arena, size, 1);
+    memcpy(copy, string, size);
+    return copy;
+}
+
+void arena_merge(Arena *arena, Arena *other) {
+    for (guint i = 0; i < other->chunks->len; i++) {
+        g_ptr_array_add(arena->chunks, g_ptr_array_index(other->chunks, i));
+    }
+    arena->reserved_size += other->reserved_size;
+
+    // The chunks are now owned by the arena
+    g_ptr_array_set_free_func(other->chunks, NULL);
+    free_arena(other);
+}
+
+size_t arena_get_reserved_size(Arena *arena) {
+    return arena->reserved_size;
+}
+
+guint arena_get_chunk_count(Arena *arena) {
+    return arena->chunks->len;
+}
+
+void free_arena(Arena *arena) {
+    g_ptr_array_free(arena->chunks, TRUE);
+    free(arena);
+}
@@ -1,9 +1,334 @@
 #include "array_util.h"
+#include "thread_budget.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 void sort_array(GPtrArray *array, GCompareFunc compare_func) {
     qsort(array->pdata, array->len, sizeof(gpointer), compare_func);
 }
 
+/**
+ * Number of bits sorted by each pass of `radix_sort_array`.
+ */
+#define RADIX_SORT_DIGIT_BITS 8
+#define RADIX_SORT_BUCKETS (1 << RADIX_SORT_DIGIT_BITS)
+#define RADIX_SORT_DIGITS (64 / RADIX_SORT_DIGIT_BITS)
+
+/**
+ * Sorts the array like `radix_sort_array` and, if `compare_func` is not NULL,
+ * sorts each run of elements with the same key with it (using the sorted keys, without calling `key_func` again).
+ */
+static void radix_sort_array_and_ties(GPtrArray *array, SortKeyFunction key_func, GCompareDataFunc compare_func, gpointer data) {
+    guint length = array->len;
+    if (length < 2) return;
+
+    // Keys and elements are moved together between the array (and its keys) and the buffers
+    uint64_t *keys = malloc(sizeof(uint64_t) * length);
+    uint64_t *keys_buffer = malloc(sizeof(uint64_t) * length);
+    gpointer *elements = array->pdata;
+    gpointer *elements_buffer = malloc(sizeof(gpointer) * length);
+
+    // The histograms of every digit are counted in a single pass over the keys
+    guint(*counts)[RADIX_SORT_BUCKETS] = calloc(RADIX_SORT_DIGITS, sizeof(*counts));
+    for (guint i = 0; i < length; i++) {
+        uint64_t key = key_func(elements[i], data);
+        keys[i] = key;
+
+        for (int digit = 0; digit < RADIX_SORT_DIGITS; digit++)
+            counts[digit][(key >> (digit * RADIX_SORT_DIGIT_BITS)) & (RADIX_SORT_BUCKETS - 1)]++;
+    }
+
+    for (int digit = 0; digit < RADIX_SORT_DIGITS; digit++) {
+        int shift = digit * RADIX_SORT_DIGIT_BITS;
+
+        // A digit that is the same in every key doesn't change the order
+        if (counts[digit][(keys[0] >> shift) & (RADIX_SORT_BUCKETS - 1)] == length) continue;
+
+        guint offsets[RADIX_SORT_BUCKETS];
+        guint offset = 0;
+        for (int bucket = 0; bucket < RADIX_SORT_BUCKETS; bucket++) {
+            offsets[bucket] = offset;
+            offset += counts[digit][bucket];
+        }
+
+        for (guint i = 0; i < length; i++) {
+            guint position = offsets[(keys[i] >> shift) & (RADIX_SORT_BUCKETS - 1)]++;
+            keys_buffer[position] = keys[i];
+            elements_buffer[position] = elements[i];
+        }
+
+        uint64_t *sorted_keys = keys_buffer;
+        keys_buffer = keys;
+        keys = sorted_keys;
+
+        gpointer *sorted_elements = elements_buffer;
+        elements_buffer = elements;
+        elements = sorted_elements;
+    }
+
+    // After an odd number of passes the sorted elements are in the buffer
+    if (elements != array->pdata) {
+        memcpy(array->pdata, elements, sizeof(gpointer) * length);
+        elements_buffer = elements;
+    }
+
+    for (guint run_start = 0, i = 1; compare_func != NULL && i <= length; i++) {
+        if (i < length && keys[i] == keys[run_start]) continue;
+
+        if (i - run_start > 1) g_qsort_with_data(array->pdata + run_start, (gint) (i - run_start), sizeof(gpointer), compare_func, data);
+        run_start = i;
+    }
+
+    free(counts);
+    free(elements_buffer);
+    free(keys_buffer);
+    free(keys);
+}
+
+void radix_sort_array(GPtrArray *array, SortKeyFunction key_func, gpointer data) {
+    radix_sort_array_and_ties(array, key_func, NULL, data);
+}
+
+void radix_sort_array_with_tie_breaker(GPtrArray *array, SortKeyFunction key_func, GCompareDataFunc compare_func, gpointer data) {
+    radix_sort_array_and_ties(array, key_func, compare_func, data);
+}
+
+void counting_sort_array(GPtrArray *array, guint *bucket_counts, guint bucket_count, BucketFunction bucket_func) {
+    guint length = array->len;
+    if (length < 2) return;
+
+    // The counts become the position of the first element of each bucket
+    guint offset = 0;
+    for (guint bucket = 0; bucket < bucket_count; bucket++) {
+        guint count = bucket_counts[bucket];
+        bucket_counts[bucket] = offset;
+        offset += count;
+    }
+    g_assert(offset == length);
+
+    gpointer *sorted = malloc(sizeof(gpointer) * length);
+    for (guint i = 0; i < length; i++) {
+        gpointer element = array->pdata[i];
+        sorted[bucket_counts[bucket_func(element)]++] = element;
+    }
+
+    memcpy(array->pdata, sorted, sizeof(gpointer) * length);
+    free(sorted);
+}
+
+int parallel_sort_thread_budget(void) {
+    return (int) MIN(g_get_num_processors(), PARALLEL_SORT_MAX_THREADS);
+}
+
+/**
+ * Struct that represents the state of a `parallel_sort` shared by its threads.
+ */
+typedef struct {
+    size_t element_size;
+    GCompareDataFunc compare_func;
+    ChunkSortFunction chunk_sort_func;
+    gpointer data;
+    int threads;
+
+    size_t length;
+    char *source; // Holds the sorted runs (the array itself before the first merge round)
+    char *destination; // Receives the runs merged by the current round
+    size_t run_starts[PARALLEL_SORT_MAX_THREADS + 1]; // Run i is [run_starts[i], run_starts[i + 1]) of source
+    int run_count;
+} ParallelSort;
+
+/**
+ * Struct that represents a thread of a `parallel_sort`, that does the part of each phase with its index.
+ */
+typedef struct {
+    ParallelSort *sort;
+    int thread_index;
+} ParallelSortWorker;
+
+/**
+ * Sorts a chunk of the array with `g_qsort_with_data`, when the parallel sort has no chunk sort function.
+ */
+static void sort_chunk_with_compare_func(ParallelSort *sort, char *items, size_t length) {
+    if (sort->chunk_sort_func != NULL) {
+        sort->chunk_sort_func(items, length, sort->data);
+    } else {
+        g_qsort_with_data(items, (gint) length, sort->element_size, sort->compare_func, sort->data);
+    }
+}
+
+/**
+ * Sorts the run (chunk) of the worker.
+ */
+static gpointer parallel_sort_chunk_worker(gpointer data) {
+    ParallelSortWorker *worker = data;
+    ParallelSort *sort = worker->sort;
+
+    size_t start = sort->run_starts[worker->thread_index];
+    size_t end = sort->run_starts[worker->thread_index + 1];
+    sort_chunk_with_compare_func(sort, sort->source + start * sort->element_size, end - start);
+
+    return NULL;
+}
+
+/**
+ * Returns how many elements of `a` are in the first `k` elements of the stable merge of the sorted runs `a` and `b`
+ * (the rest are from `b`), with a binary search.
+ */
+static size_t parallel_sort_co_rank(ParallelSort *sort, const char *a, size_t a_length, const char *b, size_t b_length, size_t k) {
+    size_t element_size = sort->element_size;
+    size_t low = k > b_length ? k - b_length : 0;
+    size_t high = MIN(k, a_length);
+
+    // The merge takes b[j - 1] before a[i] only if it is strictly less, so ties go to a
+    while (low < high) {
+        size_t i = low + (high - low) / 2;
+        size_t j = k - i;
+
+        if (sort->compare_func(b + (j - 1) * element_size, a + i * element_size, sort->data) < 0) {
+            high = i;
+        } else {
+            low = i + 1;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Writes the elements in `[output_start, output_end)` of the stable merge of the sorted runs `a` and `b` to `output`.
+ */
+static void parallel_sort_merge_range(ParallelSort *sort, const char *a, size_t a_length, const char *b, size_t b_length,
+                                      size_t output_start, size_t output_end, char *output) {
+    size_t element_size = sort->element_size;
+
+    size_t i = parallel_sort_co_rank(sort, a, a_length, b, b_length, output_start);
+    size_t j = output_start - i;
+    size_t i_end = parallel_sort_co_rank(sort, a, a_length, b, b_length, output_end);
+    size_t j_end = output_end - i_end;
+
+    char *destination = output + output_start * element_size;
+    while (i < i_end && j < j_end) {
+        if (sort->compare_func(b + j * element_size, a + i * element_size, sort->data) < 0) {
+            memcpy(destination, b + j++ * element_size, element_size);
+        } else {
+            memcpy(destination, a + i++ * element_size, element_size);
+        }
+        destination += element_size;
+    }
+
+    memcpy(destination, a + i * element_size, (i_end - i) * element_size);
+    destination += (i_end - i) * element_size;
+    memcpy(destination, b + j * element_size, (j_end - j) * element_size);
+}
+
+/**
+ * Merges the part of the worker of the current round: the output is split in equal parts, one per thread,
+ * so a worker may write the end of a merge and the start of the next, and a large merge is shared by many workers.
+ */
+static gpointer parallel_sort_merge_worker(gpointer data) {
+    ParallelSortWorker *worker = data;
+    ParallelSort *sort = worker->sort;
+    size_t element_size = sort->element_size;
+
+    size_t part_start = sort->length * worker->thread_index / sort->threads;
+    size_t part_end = sort->length * (worker->thread_index + 1) / sort->threads;
+
+    // Runs 2p and 2p + 1 are merged into [run_starts[2p], run_starts[2p + 2]), a last run without a pair is copied
+    for (int run = 0; run < sort->run_count; run += 2) {
+        size_t merge_start = sort->run_starts[run];
+        size_t middle = sort->run_starts[run + 1];
+        size_t merge_end = run + 1 < sort->run_count ? sort->run_starts[run + 2] : middle;
+        if (merge_end <= part_start) continue;
+        if (merge_start >= part_end) break;
+
+        const char *a = sort->source + merge_start * element_size;
+        const char *b = sort->source + middle * element_size;
+        parallel_sort_merge_range(sort, a, middle - merge_start, b, merge_end - middle,
+                                  MAX(part_start, merge_start) - merge_start, MIN(part_end, merge_end) - merge_start,
+                                  sort->destination + merge_start * element_size);
+    }
+
+    return NULL;
+}
+
+/**
+ * Runs the worker function in `sort->threads` threads (the calling thread being one of them) and waits for all of them.
+ */
+static void parallel_sort_run_workers(ParallelSort *sort, GThreadFunc worker_func) {
+    ParallelSortWorker workers[PARALLEL_SORT_MAX_THREADS];
+    GThread *threads[PARALLEL_SORT_MAX_THREADS];
+
+    for (int i = 0; i < sort->threads; i++) {
+        workers[i] = (ParallelSortWorker) {sort, i};
+        if (i > 0) threads[i] = g_thread_new("parallel-sort", worker_func, &workers[i]);
+    }
+
+    worker_func(&workers[0]);
+    for (int i = 1; i < sort->threads; i++) g_thread_join(threads[i]);
+}
+
+int parallel_sort(void *items, size_t length, size_t element_size, GCompareDataFunc compare_func, ChunkSortFunction chunk_sort_func,
+                  gpointer data, int threads) {
+    ParallelSort sort = {
+            .element_size = element_size,
+            .compare_func = compare_func,
+            .chunk_sort_func = chunk_sort_func,
+            .data = data,
+            .threads = CLAMP(threads, 1, PARALLEL_SORT_MAX_THREADS),
+            .length = length,
+            .source = items,
+    };
+
+    // The calling thread is already running, only the other threads are taken from the budget
+    int reserved_threads = length < PARALLEL_SORT_THRESHOLD ? 0 : reserve_spare_threads(sort.threads - 1);
+    sort.threads = reserved_threads + 1;
+
+    if (sort.threads == 1) {
+        sort_chunk_with_compare_func(&sort, items, length);
+        return 1;
+    }
+
+    sort.run_count = sort.threads;
+    for (int i = 0; i <= sort.run_count; i++) sort.run_starts[i] = length * i / sort.run_count;
+    parallel_sort_run_workers(&sort, parallel_sort_chunk_worker);
+
+    char *buffer = malloc(length * element_size);
+    sort.destination = buffer;
+    while (sort.run_count > 1) {
+        parallel_sort_run_workers(&sort, parallel_sort_merge_worker);
+
+        // Each merged pair becomes a run of the next round
+        int merged_run_count = (sort.run_count + 1) / 2;
+        for (int i = 0; i < merged_run_count; i++) sort.run_starts[i] = sort.run_starts[2 * i];
+        sort.run_starts[merged_run_count] = length;
+        sort.run_count = merged_run_count;
+
+        char *merged = sort.destination;
+        sort.destination = sort.source;
+        sort.source = merged;
+    }
+
+    if (sort.source != items) memcpy(items, sort.source, length * element_size);
+    free(buffer);
+
+    release_spare_threads(reserved_threads);
+
+    return sort.threads;
+}
+
+/**
+ * Compares two elements of an array of pointers with the GCompareFunc given as data.
+ */
+static gint compare_with_compare_func(gconstpointer a, gconstpointer b, gpointer compare_func) {
+    return (*(GCompareFunc *) compare_func)(a, b);
+}
+
+void parallel_sort_array(GPtrArray *array, GCompareFunc compare_func) {
+    parallel_sort(array->pdata, array->len, sizeof(gpointer), compare_with_compare_func, NULL, &compare_func,
+                  parallel_sort_thread_budget());
+}
+
 void g_ptr_array_set_at_index_safe(GPtrArray *array, int index, gpointer data) {
     g_assert(index >= 0);
 
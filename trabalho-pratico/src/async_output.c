@@ -0,0 +1,135 @@
+#include "async_output.h"
+
+#include <stdlib.h>
+
+#include "bounded_queue.h"
+#include "file_util.h"
+
+/**
+ * Struct that represents a chunk of the output of a command.
+ */
+typedef struct {
+    int command_number;
+    char *data;
+    size_t size;
+    gboolean is_last; // The file of the command is closed after this chunk
+} AsyncOutputChunk;
+
+/**
+ * Struct that represents the asynchronous output of the commands.
+ */
+struct AsyncOutput {
+    BoundedQueue *chunks;
+    OutputContainerWriter *container_writer; // NULL to write a file for each command
+    GThread *writer_thread;
+};
+
+/**
+ * Struct that represents the target of the output writer of a command.
+ */
+typedef struct {
+    AsyncOutput *async_output;
+    int command_number;
+} AsyncCommandOutput;
+
+/**
+ * Pushed to the queue to stop the writer thread, after every chunk.
+ */
+static AsyncOutputChunk stop_chunk;
+
+/**
+ * Writes the chunk to the file of its command, creating the file on its first chunk and closing it on its last.
+ */
+static void write_async_output_chunk(GHashTable *open_files, AsyncOutputChunk *chunk) {
+    gpointer key = GINT_TO_POINTER(chunk->command_number);
+    FILE *file = g_hash_table_lookup(open_files, key);
+
+    if (file == NULL) {
+        file = create_command_output_file(chunk->command_number);
+        if (file != NULL) g_hash_table_insert(open_files, key, file);
+    }
+
+    if (file != NULL) {
+        write_all_to_file(file, chunk->data, chunk->size);
+
+        if (chunk->is_last) {
+            g_hash_table_remove(open_files, key);
+            fclose(file);
+        }
+    }
+}
+
+/**
+ * Writes the chunks in the queue until the stop chunk is found.
+ */
+static gpointer async_output_writer_thread(gpointer data) {
+    AsyncOutput *async_output = data;
+    GHashTable *open_files = g_hash_table_new(g_direct_hash, g_direct_equal); // Command number -> FILE
+
+    if (async_output->container_writer == NULL) create_output_folder_if_not_exists();
+
+    while (TRUE) {
+        AsyncOutputChunk *chunk = bounded_queue_pop(async_output->chunks);
+        if (chunk == &stop_chunk) break;
+
+        if (async_output->container_writer != NULL) {
+            output_container_append(async_output->container_writer, chunk->command_number, chunk->data, chunk->size);
+        } else {
+            write_async_output_chunk(open_files, chunk);
+        }
+
+        free(chunk->data);
+        free(chunk);
+    }
+
+    // Only writers that were never closed leave files open
+    GHashTableIter iter;
+    gpointer file;
+    g_hash_table_iter_init(&iter, open_files);
+    while (g_hash_table_iter_next(&iter, NULL, &file)) fclose(file);
+
+    g_hash_table_destroy(open_files);
+
+    return NULL;
+}
+
+AsyncOutput *create_async_output(OutputContainerWriter *container_writer) {
+    AsyncOutput *async_output = malloc(sizeof(AsyncOutput));
+    async_output->chunks = create_bounded_queue(ASYNC_OUTPUT_MAX_PENDING_CHUNKS);
+    async_output->container_writer = container_writer;
+    async_output->writer_thread = g_thread_new("async-output", async_output_writer_thread, async_output);
+    return async_output;
+}
+
+/**
+ * Queues a chunk of the output of a command, waiting if there are too many chunks queued.
+ */
+static void hand_off_async_output_chunk(void *target, char *data, size_t size, gboolean is_last) {
+    AsyncCommandOutput *command_output = target;
+
+    AsyncOutputChunk *chunk = malloc(sizeof(AsyncOutputChunk));
+    chunk->command_number = command_output->command_number;
+    chunk->data = data;
+    chunk->size = size;
+    chunk->is_last = is_last;
+
+    bounded_queue_push(command_output->async_output->chunks, chunk);
+
+    if (is_last) free(command_output);
+}
+
+OutputWriter *async_output_create_command_writer(AsyncOutput *async_output, int command_number) {
+    AsyncCommandOutput *command_output = malloc(sizeof(AsyncCommandOutput));
+    command_output->async_output = async_output;
+    command_output->command_number = command_number;
+
+    return create_chunked_output_writer(command_output, hand_off_async_output_chunk, ASYNC_OUTPUT_CHUNK_SIZE);
+}
+
+void free_async_output(AsyncOutput *async_output) {
+    bounded_queue_push(async_output->chunks, &stop_chunk);
+    g_thread_join(async_output->writer_thread);
+
+    free_bounded_queue(async_output->chunks);
+    free(async_output);
+}
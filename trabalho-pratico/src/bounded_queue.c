@@ -0,0 +1,161 @@
+#include "bounded_queue.h"
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Size of a cache line, so the positions of producers and consumers don't share one.
+ */
+#define BOUNDED_QUEUE_CACHE_LINE_SIZE 64
+
+/**
+ * Struct that represents a cell of the queue.
+ * A cell at position p is free for the producer of p when its sequence is p,
+ * and filled for the consumer of p when its sequence is p + 1.
+ */
+typedef struct {
+    atomic_size_t sequence;
+    gpointer item;
+} BoundedQueueCell;
+
+/**
+ * Struct that represents a bounded queue.
+ */
+struct BoundedQueue {
+    BoundedQueueCell *cells;
+    size_t mask; // capacity - 1
+
+    alignas(BOUNDED_QUEUE_CACHE_LINE_SIZE) atomic_size_t push_position;
+    alignas(BOUNDED_QUEUE_CACHE_LINE_SIZE) atomic_size_t pop_position;
+
+    alignas(BOUNDED_QUEUE_CACHE_LINE_SIZE) atomic_int sleepers; // Threads waiting in the condition
+    GMutex mutex;
+    GCond condition;
+};
+
+BoundedQueue *create_bounded_queue(guint capacity) {
+    size_t rounded_capacity = 2;
+    while (rounded_capacity < capacity) rounded_capacity *= 2;
+
+    BoundedQueue *queue = aligned_alloc(alignof(BoundedQueue), sizeof(BoundedQueue));
+    queue->cells = malloc(sizeof(BoundedQueueCell) * rounded_capacity);
+    queue->mask = rounded_capacity - 1;
+
+    for (size_t i = 0; i < rounded_capacity; i++) {
+        atomic_init(&queue->cells[i].sequence, i);
+        queue->cells[i].item = NULL;
+    }
+    atomic_init(&queue->push_position, 0);
+    atomic_init(&queue->pop_position, 0);
+
+    atomic_init(&queue->sleepers, 0);
+    g_mutex_init(&queue->mutex);
+    g_cond_init(&queue->condition);
+
+    return queue;
+}
+
+gboolean bounded_queue_try_push(BoundedQueue *queue, gpointer item) {
+    size_t position = atomic_load_explicit(&queue->push_position, memory_order_relaxed);
+    BoundedQueueCell *cell;
+
+    while (TRUE) {
+        cell = &queue->cells[position & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+        if (difference == 0) {
+            // The cell is free, claim the position
+            if (atomic_compare_exchange_weak_explicit(&queue->push_position, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (difference < 0) {
+            return FALSE; // The cell still holds the item of the previous lap
+        } else {
+            position = atomic_load_explicit(&queue->push_position, memory_order_relaxed); // Another producer claimed it
+        }
+    }
+
+    cell->item = item;
+    atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+    return TRUE;
+}
+
+gboolean bounded_queue_try_pop(BoundedQueue *queue, gpointer *item) {
+    size_t position = atomic_load_explicit(&queue->pop_position, memory_order_relaxed);
+    BoundedQueueCell *cell;
+
+    while (TRUE) {
+        cell = &queue->cells[position & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) (position + 1);
+
+        if (difference == 0) {
+            // The cell is filled, claim the position
+            if (atomic_compare_exchange_weak_explicit(&queue->pop_position, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (difference < 0) {
+            return FALSE; // The cell wasn't filled yet
+        } else {
+            position = atomic_load_explicit(&queue->pop_position, memory_order_relaxed); // Another consumer claimed it
+        }
+    }
+
+    *item = cell->item;
+    atomic_store_explicit(&cell->sequence, position + queue->mask + 1, memory_order_release); // Free for the next lap
+    return TRUE;
+}
+
+/**
+ * Wakes the threads waiting for the queue to change, if there are any.
+ */
+static void bounded_queue_wake_sleepers(BoundedQueue *queue) {
+    // Pairs with the fence of the sleepers: either they see this change when trying again, or this sees them
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&queue->sleepers, memory_order_relaxed) == 0) return;
+
+    g_mutex_lock(&queue->mutex);
+    g_cond_broadcast(&queue->condition);
+    g_mutex_unlock(&queue->mutex);
+}
+
+/**
+ * Marks the calling thread as a sleeper, it must hold the mutex.
+ */
+static void bounded_queue_add_sleeper(BoundedQueue *queue, int count) {
+    atomic_fetch_add_explicit(&queue->sleepers, count, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void bounded_queue_push(BoundedQueue *queue, gpointer item) {
+    if (!bounded_queue_try_push(queue, item)) {
+        g_mutex_lock(&queue->mutex);
+        bounded_queue_add_sleeper(queue, 1);
+        while (!bounded_queue_try_push(queue, item)) g_cond_wait(&queue->condition, &queue->mutex);
+        bounded_queue_add_sleeper(queue, -1);
+        g_mutex_unlock(&queue->mutex);
+    }
+
+    bounded_queue_wake_sleepers(queue);
+}
+
+gpointer bounded_queue_pop(BoundedQueue *queue) {
+    gpointer item;
+
+    if (!bounded_queue_try_pop(queue, &item)) {
+        g_mutex_lock(&queue->mutex);
+        bounded_queue_add_sleeper(queue, 1);
+        while (!bounded_queue_try_pop(queue, &item)) g_cond_wait(&queue->condition, &queue->mutex);
+        bounded_queue_add_sleeper(queue, -1);
+        g_mutex_unlock(&queue->mutex);
+    }
+
+    bounded_queue_wake_sleepers(queue);
+    return item;
+}
+
+void free_bounded_queue(BoundedQueue *queue) {
+    g_mutex_clear(&queue->mutex);
+    g_cond_clear(&queue->condition);
+    free(queue->cells);
+    free(queue);
+}
@@ -5,7 +5,38 @@
 #include "catalog/catalog_city.h"
 
 #include "benchmark.h"
-#include "price_util.h"
+#include "lazy.h"
+#include "string_pool.h"
+#include "thread_budget.h"
+
+#include <string.h>
+
+/**
+ * Size of the buffer for the strings of the pending rides (enough for the city and username of a full batch).
+ */
+#define PENDING_RIDES_STRINGS_SIZE (CATALOG_RIDE_BATCH_SIZE * 128)
+
+/**
+ * Struct that holds the rides parsed by `parse_and_register_ride` that wait for their batch to be registered.
+ */
+typedef struct {
+    ParsedRide rides[CATALOG_RIDE_BATCH_SIZE];
+    guint count;
+    char strings[PENDING_RIDES_STRINGS_SIZE]; // Copies of the strings of lines whose tokens don't outlive the line
+    size_t strings_size;
+} PendingRides;
+
+/**
+ * Struct that holds the indexes built by the threads started by `catalog_start_background_indexing`.
+ */
+typedef struct {
+    GPtrArray *lazies; // Lazies to apply, the most expensive first
+    gint next_lazy; // Index of the next lazy to apply, taken atomically
+    GPtrArray *threads;
+    gint running_threads; // The last thread to finish logs the indexing time
+    gint reserved_threads; // Spare threads of the budget still reserved, each thread gives back one when it finishes
+    GTimer *timer;
+} BackgroundIndexing;
 
 /**
  * Struct that represents a catalog.
@@ -16,8 +47,25 @@ struct Catalog {
     CatalogRide *catalog_ride;
 
     CatalogCity *catalog_city;
+
+    StringPool *name_pool; // Names of the users and drivers
+
+    SnapshotReader *snapshot_reader; // Snapshot the catalog was restored from (or NULL)
+
+    PendingRides *pending_rides; // NULL until the first ride is parsed by `parse_and_register_ride`
+
+    BackgroundIndexing *background_indexing; // NULL unless the indexes are being built in the background
 };
 
+/**
+ * Checks that no ride parsed by `parse_and_register_ride` is still waiting for its batch.
+ * Everything that reads the catalog must run after the loader called `catalog_flush_pending_rides`,
+ * reads never register rides themselves.
+ */
+static inline void assert_no_pending_rides(Catalog *catalog) {
+    g_assert(catalog->pending_rides == NULL || catalog->pending_rides->count == 0);
+}
+
 Catalog *create_catalog(void) {
     Catalog *catalog = malloc(sizeof(struct Catalog));
 
@@ -27,24 +75,52 @@ Catalog *create_catalog(void) {
 
     catalog->catalog_city = create_catalog_city();
 
+    catalog->name_pool = create_string_pool();
+
+    catalog->snapshot_reader = NULL;
+    catalog->pending_rides = NULL;
+    catalog->background_indexing = NULL;
+
     return catalog;
 }
 
 void free_catalog(Catalog *catalog) {
+    catalog_wait_background_indexing(catalog);
+
     free_catalog_user(catalog->catalog_user);
     free_catalog_driver(catalog->catalog_driver);
     free_catalog_ride(catalog->catalog_ride);
 
     free_catalog_city(catalog->catalog_city);
 
+    free_string_pool(catalog->name_pool);
+
+    if (catalog->snapshot_reader != NULL) free_snapshot_reader(catalog->snapshot_reader);
+    free(catalog->pending_rides);
+
     free(catalog);
 }
 
+void catalog_reserve_users(Catalog *catalog, guint expected_users) {
+    catalog_user_reserve(catalog->catalog_user, expected_users);
+}
+
+void catalog_retain_ride_arena(Catalog *catalog, Arena *arena) {
+    catalog_ride_adopt_arena(catalog->catalog_ride, arena);
+}
+
 char *catalog_get_city_name(Catalog *catalog, int city_id) {
+    assert_no_pending_rides(catalog);
     return catalog_city_get_city_name(catalog->catalog_city, city_id);
 }
 
+const char *catalog_get_city_name_view(Catalog *catalog, int city_id) {
+    assert_no_pending_rides(catalog);
+    return catalog_city_get_city_name_view(catalog->catalog_city, city_id);
+}
+
 int catalog_get_city_id(Catalog *catalog, char *city) {
+    assert_no_pending_rides(catalog);
     return catalog_city_get_city_id(catalog->catalog_city, city);
 }
 
@@ -52,10 +128,11 @@ int catalog_get_city_id(Catalog *catalog, char *city) {
  * Internal function that parses a line and registers the parsed user.
  */
 static inline void internal_parse_and_register_user(Catalog *catalog, TokenIterator *line_iterator) {
-    User *user = parse_line_user(line_iterator);
+    char *username;
+    User *user = parse_line_user_detailed(line_iterator, &username, catalog->name_pool, catalog_user_get_arena(catalog->catalog_user));
     if (user == NULL) return;
 
-    catalog_user_register_user(catalog->catalog_user, user);
+    catalog_user_register_user(catalog->catalog_user, user, username);
 }
 
 void parse_and_register_user(void *catalog, TokenIterator *line_iterator) {
@@ -67,7 +144,7 @@ void parse_and_register_user(void *catalog, TokenIterator *line_iterator) {
  */
 static inline void internal_parse_and_register_driver(Catalog *catalog, TokenIterator *line_iterator) {
     char *city;
-    Driver *driver = parse_line_driver_detailed(line_iterator, &city);
+    Driver *driver = parse_line_driver_detailed(line_iterator, &city, catalog->name_pool, catalog_driver_get_arena(catalog->catalog_driver));
     if (driver == NULL) return;
 
     int city_id = catalog_city_get_or_register_city_id(catalog->catalog_city, city);
@@ -81,23 +158,16 @@ void parse_and_register_driver(void *catalog, TokenIterator *line_iterator) {
 }
 
 /**
- * Internal function that parses a line and registers the parsed ride.
+ * Internal function that registers an already parsed ride whose user and driver were already resolved.
  */
-static inline void internal_parse_and_register_ride(Catalog *catalog, TokenIterator *line_iterator) {
-    char *city;
-    char *user_username;
-
-    Ride *ride = parse_line_ride_detailed(line_iterator, &city, &user_username);
-    if (ride == NULL) return;
+static inline void internal_register_resolved_ride(Catalog *catalog, Ride *ride, char *city, User *user, Driver *driver) {
     int city_id = catalog_city_get_or_register_city_id(catalog->catalog_city, city);
-    ride_set_city_id(ride, city_id);
+    ride_set_city_id(ride, city_id, catalog_ride_get_arena(catalog->catalog_ride));
 
-    int driver_id = ride_get_driver_id(ride);
-    Driver *driver = catalog_get_driver(catalog, driver_id);
-    double price = compute_price(ride_get_distance(ride), driver_get_car_class(driver));
-    ride_set_price(ride, price);
+    ride_set_car_class(ride, driver_get_car_class(driver));
+    Money price = ride_get_price(ride);
 
-    double total_price = ride_get_tip(ride) + price;
+    Money total_price = ride_get_tip(ride) + price;
 
     driver_increment_number_of_rides(driver);
     int driver_score = ride_get_score_driver(ride);
@@ -105,7 +175,6 @@ static inline void internal_parse_and_register_ride(Catalog *catalog, TokenItera
     driver_add_earned(driver, total_price);
     driver_register_ride_date(driver, ride_get_date(ride));
 
-    User *user = catalog_get_user_by_username(catalog, user_username);
     user_increment_number_of_rides(user);
     user_add_score(user, ride_get_score_user(ride));
     user_add_spent(user, total_price);
@@ -114,7 +183,7 @@ static inline void internal_parse_and_register_ride(Catalog *catalog, TokenItera
 
     // The user id has already been generated by the user's catalog
     int user_id = user_get_id(user);
-    ride_set_user_id(ride, user_id);
+    ride_set_user_id(ride, user_id, catalog_ride_get_arena(catalog->catalog_ride));
 
     catalog_ride_register_ride(catalog->catalog_ride, ride);
 
@@ -132,63 +201,194 @@ static inline void internal_parse_and_register_ride(Catalog *catalog, TokenItera
             Date user_account_creation_date = user_get_account_creation_date(user);
             Date driver_account_creation_date = driver_get_account_creation_date(driver);
 
-            ride_set_user_account_creation_date(ride, user_account_creation_date);
-            ride_set_driver_account_creation_date(ride, driver_account_creation_date);
-
-            catalog_ride_register_ride_same_gender(catalog->catalog_ride, user_gender, ride);
+            catalog_ride_register_ride_same_gender(catalog->catalog_ride, user_gender, ride, driver_account_creation_date, user_account_creation_date);
         }
     }
 }
 
+/**
+ * Internal function that registers an already parsed ride.
+ */
+static inline void internal_register_parsed_ride(Catalog *catalog, Ride *ride, char *city, char *user_username) {
+    Driver *driver = catalog_driver_get_driver(catalog->catalog_driver, ride_get_driver_id(ride));
+    User *user = catalog_user_get_user_by_username(catalog->catalog_user, user_username);
+
+    internal_register_resolved_ride(catalog, ride, city, user, driver);
+}
+
+/**
+ * Registers a batch of at most CATALOG_RIDE_BATCH_SIZE parsed rides.
+ */
+static void register_parsed_rides_batch(Catalog *catalog, ParsedRide *parsed_rides, guint count) {
+    char *usernames[CATALOG_RIDE_BATCH_SIZE];
+    User *users[CATALOG_RIDE_BATCH_SIZE];
+    Driver *drivers[CATALOG_RIDE_BATCH_SIZE];
+
+    // Drivers are in a small array indexed by id, only the drivers themselves are likely to miss the cache
+    for (guint i = 0; i < count; i++) {
+        usernames[i] = parsed_rides[i].user_username;
+        drivers[i] = catalog_driver_get_driver(catalog->catalog_driver, ride_get_driver_id(parsed_rides[i].ride));
+        __builtin_prefetch(drivers[i], 1);
+    }
+
+    catalog_user_get_users_by_usernames(catalog->catalog_user, usernames, users, count);
+
+    for (guint i = 0; i < count; i++) {
+        internal_register_resolved_ride(catalog, parsed_rides[i].ride, parsed_rides[i].city, users[i], drivers[i]);
+    }
+}
+
+/**
+ * Registers the rides parsed by `parse_and_register_ride` that are still waiting for their batch to fill, if any.
+ * Called before registering rides some other way, so rides are always registered in parsing order.
+ */
+static inline void register_pending_rides(Catalog *catalog) {
+    PendingRides *pending_rides = catalog->pending_rides;
+    if (pending_rides == NULL || pending_rides->count == 0) return;
+
+    register_parsed_rides_batch(catalog, pending_rides->rides, pending_rides->count);
+    pending_rides->count = 0;
+    pending_rides->strings_size = 0;
+}
+
+void catalog_register_parsed_rides(Catalog *catalog, ParsedRide *parsed_rides, guint count) {
+    register_pending_rides(catalog);
+
+    for (guint i = 0; i < count; i += CATALOG_RIDE_BATCH_SIZE) {
+        register_parsed_rides_batch(catalog, parsed_rides + i, MIN(CATALOG_RIDE_BATCH_SIZE, count - i));
+    }
+}
+
+void catalog_flush_pending_rides(Catalog *catalog) {
+    register_pending_rides(catalog);
+}
+
+/**
+ * Copies the string to the strings buffer of the pending rides.
+ * Returns NULL if it doesn't fit.
+ */
+static char *pending_rides_copy_string(PendingRides *pending_rides, const char *string) {
+    size_t size = strlen(string) + 1;
+    if (pending_rides->strings_size + size > PENDING_RIDES_STRINGS_SIZE) return NULL;
+
+    char *copy = pending_rides->strings + pending_rides->strings_size;
+    memcpy(copy, string, size);
+    pending_rides->strings_size += size;
+
+    return copy;
+}
+
+/**
+ * Internal function that parses a line and adds the parsed ride to the pending rides, registering them when the batch is full.
+ */
+static inline void internal_parse_and_register_ride(Catalog *catalog, TokenIterator *line_iterator) {
+    char *city;
+    char *user_username;
+
+    Ride *ride = parse_line_ride_detailed(line_iterator, &city, &user_username, catalog_ride_get_arena(catalog->catalog_ride));
+    if (ride == NULL) return;
+
+    if (catalog->pending_rides == NULL) {
+        catalog->pending_rides = malloc(sizeof(PendingRides));
+        catalog->pending_rides->count = 0;
+        catalog->pending_rides->strings_size = 0;
+    }
+    PendingRides *pending_rides = catalog->pending_rides;
+
+    // The tokens are overwritten by the next line
+    char *city_copy = pending_rides_copy_string(pending_rides, city);
+    char *user_username_copy = pending_rides_copy_string(pending_rides, user_username);
+
+    if (city_copy == NULL || user_username_copy == NULL) {
+        // Unusually long strings, register what is pending and this ride right away
+        register_pending_rides(catalog);
+        internal_register_parsed_ride(catalog, ride, city, user_username);
+        return;
+    }
+
+    pending_rides->rides[pending_rides->count++] = (ParsedRide){ride, city_copy, user_username_copy};
+    if (pending_rides->count == CATALOG_RIDE_BATCH_SIZE) register_pending_rides(catalog);
+}
+
 void parse_and_register_ride(void *catalog, TokenIterator *line_iterator) {
     internal_parse_and_register_ride(catalog, line_iterator);
 }
 
+void catalog_register_parsed_ride(Catalog *catalog, Ride *ride, char *city, char *user_username) {
+    register_pending_rides(catalog);
+    internal_register_parsed_ride(catalog, ride, city, user_username);
+}
+
 User *catalog_get_user_by_user_id(Catalog *catalog, int user_id) {
+    assert_no_pending_rides(catalog);
     return catalog_user_get_user_by_user_id(catalog->catalog_user, user_id);
 }
 
 User *catalog_get_user_by_username(Catalog *catalog, char *username) {
+    assert_no_pending_rides(catalog);
     return catalog_user_get_user_by_username(catalog->catalog_user, username);
 }
 
 Driver *catalog_get_driver(Catalog *catalog, int id) {
+    assert_no_pending_rides(catalog);
     return catalog_driver_get_driver(catalog->catalog_driver, id);
 }
 
+const char *catalog_get_user_username(Catalog *catalog, User *user) {
+    return catalog_user_get_username(catalog->catalog_user, user);
+}
+
+const char *catalog_get_user_name(Catalog *catalog, User *user) {
+    return string_pool_get(catalog->name_pool, user_get_name_id(user));
+}
+
+const char *catalog_get_driver_name(Catalog *catalog, Driver *driver) {
+    return string_pool_get(catalog->name_pool, driver_get_name_id(driver));
+}
+
 int query_2_catalog_get_top_drivers_with_best_score(Catalog *catalog, int n, GPtrArray *result) {
+    assert_no_pending_rides(catalog);
     return catalog_driver_get_top_n_drivers_with_best_score(catalog->catalog_driver, n, result);
 }
 
 int query_3_catalog_get_top_users_with_longest_total_distance(Catalog *catalog, int n, GPtrArray *result) {
+    assert_no_pending_rides(catalog);
     return catalog_user_get_top_n_users(catalog->catalog_user, n, result);
 }
 
-double query_4_catalog_get_average_price_in_city(Catalog *catalog, int city_id) {
+Money query_4_catalog_get_average_price_in_city(Catalog *catalog, int city_id) {
+    assert_no_pending_rides(catalog);
     return catalog_ride_get_average_price_in_city(catalog->catalog_ride, city_id);
 }
 
-double query_5_catalog_get_average_price_in_date_range(Catalog *catalog, Date start_date, Date end_date) {
+Money query_5_catalog_get_average_price_in_date_range(Catalog *catalog, Date start_date, Date end_date) {
+    assert_no_pending_rides(catalog);
     return catalog_ride_get_average_distance_in_date_range(catalog->catalog_ride, start_date, end_date);
 }
 
 double query_6_catalog_get_average_distance_in_city_by_date(Catalog *catalog, Date start_date, Date end_date, int city_id) {
+    assert_no_pending_rides(catalog);
     return catalog_ride_get_average_distance_in_city_and_date_range(catalog->catalog_ride, start_date, end_date, city_id);
 }
 
 int query_7_catalog_get_top_n_drivers_in_city(Catalog *catalog, int n, int city_id, GPtrArray *result) {
+    assert_no_pending_rides(catalog);
     return catalog_driver_get_top_n_drivers_with_best_score_by_city(catalog->catalog_driver, city_id, n, result);
 }
 
 int query_8_catalog_get_rides_with_user_and_driver_with_same_gender_above_acc_age(Catalog *catalog, GPtrArray *result, Gender gender, int min_account_age) {
+    assert_no_pending_rides(catalog);
     return catalog_ride_get_rides_with_user_and_driver_with_same_age_above_acc_age(catalog->catalog_ride, result, gender, min_account_age);
 }
 
 void query_9_catalog_get_passengers_that_gave_tip_in_date_range(Catalog *catalog, GPtrArray *result, Date start_date, Date end_date) {
+    assert_no_pending_rides(catalog);
     catalog_ride_get_passengers_that_gave_tip_in_date_range(catalog->catalog_ride, start_date, end_date, result);
 }
 
 void catalog_force_eager_indexing(Catalog *catalog) {
+    assert_no_pending_rides(catalog);
+
     BENCHMARK_START(load_timer);
 
     catalog_driver_force_eager_indexing(catalog->catalog_driver);
@@ -197,3 +397,107 @@ void catalog_force_eager_indexing(Catalog *catalog) {
 
     BENCHMARK_END(load_timer, "Final indexing time:    %f seconds\n");
 }
+
+/**
+ * Applies lazies of the background indexing until there are none left.
+ */
+static gpointer background_indexing_thread(gpointer data) {
+    BackgroundIndexing *background_indexing = data;
+
+    int index;
+    while ((index = g_atomic_int_add(&background_indexing->next_lazy, 1)) < (int) background_indexing->lazies->len) {
+        lazy_apply_function(g_ptr_array_index(background_indexing->lazies, index));
+    }
+
+    if (g_atomic_int_add(&background_indexing->reserved_threads, -1) > 0) release_spare_threads(1);
+
+    if (g_atomic_int_dec_and_test(&background_indexing->running_threads)) {
+        BENCHMARK_LOG("Background indexing time: %f seconds\n", g_timer_elapsed(background_indexing->timer, NULL));
+    }
+
+    return NULL;
+}
+
+void catalog_start_background_indexing(Catalog *catalog, int threads) {
+    assert_no_pending_rides(catalog);
+
+    BackgroundIndexing *background_indexing = malloc(sizeof(BackgroundIndexing));
+    background_indexing->lazies = g_ptr_array_new();
+    background_indexing->next_lazy = 0;
+    background_indexing->threads = g_ptr_array_new();
+    background_indexing->timer = g_timer_new();
+
+    // The rides by date are the largest index and the most used by the queries
+    catalog_ride_collect_lazy_indexes(catalog->catalog_ride, background_indexing->lazies);
+    catalog_user_collect_lazy_indexes(catalog->catalog_user, background_indexing->lazies);
+    catalog_driver_collect_lazy_indexes(catalog->catalog_driver, background_indexing->lazies);
+
+    int thread_count = CLAMP(threads, 1, (int) MAX(background_indexing->lazies->len, 1));
+    background_indexing->running_threads = thread_count;
+    background_indexing->reserved_threads = reserve_spare_threads(thread_count);
+    for (int i = 0; i < thread_count; i++)
+        g_ptr_array_add(background_indexing->threads, g_thread_new("background-indexing", background_indexing_thread, background_indexing));
+
+    catalog->background_indexing = background_indexing;
+}
+
+void catalog_wait_background_indexing(Catalog *catalog) {
+    BackgroundIndexing *background_indexing = catalog->background_indexing;
+    if (background_indexing == NULL) return;
+
+    for (guint i = 0; i < background_indexing->threads->len; i++) g_thread_join(g_ptr_array_index(background_indexing->threads, i));
+
+    g_timer_destroy(background_indexing->timer);
+    g_ptr_array_free(background_indexing->threads, TRUE);
+    g_ptr_array_free(background_indexing->lazies, TRUE);
+    free(background_indexing);
+    catalog->background_indexing = NULL;
+}
+
+/**
+ * Converts bytes to MiB for the logs.
+ */
+#define TO_MIB(bytes) ((double) (bytes) / (1024.0 * 1024.0))
+
+void catalog_log_memory_breakdown(Catalog *catalog) {
+    assert_no_pending_rides(catalog);
+
+    BENCHMARK_LOG("Memory of the entities: users %.2f MiB, drivers %.2f MiB, rides %.2f MiB\n",
+                  TO_MIB(arena_get_reserved_size(catalog_user_get_arena(catalog->catalog_user))),
+                  TO_MIB(arena_get_reserved_size(catalog_driver_get_arena(catalog->catalog_driver))),
+                  TO_MIB(arena_get_reserved_size(catalog_ride_get_arena(catalog->catalog_ride))));
+
+    BENCHMARK_LOG("Memory of the strings: usernames %.2f MiB, names %.2f MiB (%u distinct of %u, %.2f MiB saved by interning)\n",
+                  TO_MIB(catalog_user_get_usernames_size(catalog->catalog_user)),
+                  TO_MIB(string_pool_get_size(catalog->name_pool)),
+                  string_pool_get_unique_count(catalog->name_pool),
+                  string_pool_get_reference_count(catalog->name_pool),
+                  TO_MIB(string_pool_get_referenced_size(catalog->name_pool) - string_pool_get_size(catalog->name_pool)));
+
+    (void) catalog; // Unused without benchmark logging
+}
+
+void catalog_write_snapshot(Catalog *catalog, SnapshotWriter *writer) {
+    assert_no_pending_rides(catalog);
+
+    // Cities and names first, every other entity refers to them by id
+    catalog_city_write_snapshot(catalog->catalog_city, writer);
+    string_pool_write_snapshot(catalog->name_pool, writer);
+    catalog_user_write_snapshot(catalog->catalog_user, writer, catalog->name_pool);
+    catalog_driver_write_snapshot(catalog->catalog_driver, writer, catalog->name_pool);
+    catalog_ride_write_snapshot(catalog->catalog_ride, writer);
+}
+
+gboolean catalog_read_snapshot(Catalog *catalog, SnapshotReader *reader) {
+    catalog->snapshot_reader = reader;
+
+    BENCHMARK_START(restore_timer);
+    gboolean restored = catalog_city_read_snapshot(catalog->catalog_city, reader) &&
+                        string_pool_read_snapshot(catalog->name_pool, reader) &&
+                        catalog_user_read_snapshot(catalog->catalog_user, reader, catalog->name_pool) &&
+                        catalog_driver_read_snapshot(catalog->catalog_driver, reader, catalog->name_pool) &&
+                        catalog_ride_read_snapshot(catalog->catalog_ride, reader);
+    BENCHMARK_END(restore_timer, "Restore snapshot time: %f seconds\n");
+
+    return restored;
+}
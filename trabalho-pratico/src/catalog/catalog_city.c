@@ -27,10 +27,14 @@ void free_catalog_city(CatalogCity *catalog_city) {
 }
 
 char *catalog_city_get_city_name(CatalogCity *catalog, int city_id) {
-    char *city_name = g_ptr_array_get_at_index_safe(catalog->city_id_to_city_name_array, city_id);
+    const char *city_name = catalog_city_get_city_name_view(catalog, city_id);
     return city_name ? g_strdup(city_name) : NULL;
 }
 
+const char *catalog_city_get_city_name_view(CatalogCity *catalog, int city_id) {
+    return g_ptr_array_get_at_index_safe(catalog->city_id_to_city_name_array, city_id);
+}
+
 int catalog_city_get_city_id(CatalogCity *catalog, char *city) {
     if (!city) return -1;
 
@@ -52,3 +56,23 @@ int catalog_city_get_or_register_city_id(CatalogCity *catalog, char *city) {
 
     return city_id;
 }
+
+void catalog_city_write_snapshot(CatalogCity *catalog, SnapshotWriter *writer) {
+    GPtrArray *city_id_to_city_name_array = catalog->city_id_to_city_name_array;
+
+    snapshot_write_uint32(writer, city_id_to_city_name_array->len);
+    for (guint i = 0; i < city_id_to_city_name_array->len; i++) {
+        snapshot_write_string(writer, g_ptr_array_index(city_id_to_city_name_array, i));
+    }
+}
+
+gboolean catalog_city_read_snapshot(CatalogCity *catalog, SnapshotReader *reader) {
+    guint cities_count = snapshot_read_uint32(reader);
+
+    for (guint i = 0; i < cities_count && !snapshot_reader_has_error(reader); i++) {
+        // Cities are written in id order, a repeated name would shift every following id
+        if (catalog_city_get_or_register_city_id(catalog, snapshot_read_string(reader)) != (int) i) return FALSE;
+    }
+
+    return !snapshot_reader_has_error(reader);
+}
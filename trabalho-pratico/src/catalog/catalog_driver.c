@@ -9,6 +9,7 @@
  * Struct that holds all the drivers and their information.
  */
 struct CatalogDriver {
+    Arena *arena; // Owns every driver
     Lazy *lazy_drivers_array;
     GPtrArray *driver_from_id_array; // Index is driver id, value is driver pointer
 
@@ -20,13 +21,16 @@ struct CatalogDriver {
  */
 static void sort_array_by_driver_score(void *drivers_array) {
     BENCHMARK_START(sort_drivers_array);
-    sort_array(drivers_array, compare_drivers_by_score);
+    // The sorts are stable: sorting by id and then by the rest of the ranking orders by both
+    radix_sort_array(drivers_array, driver_get_id_sort_key, NULL);
+    radix_sort_array(drivers_array, driver_get_score_sort_key, NULL);
     BENCHMARK_END(sort_drivers_array, "sort_drivers_array: %lf seconds\n");
 }
 
 CatalogDriver *create_catalog_driver(void) {
     CatalogDriver *catalog_driver = malloc(sizeof(CatalogDriver));
-    GPtrArray *drivers_array = g_ptr_array_new_with_free_func(free_driver);
+    catalog_driver->arena = create_arena();
+    GPtrArray *drivers_array = g_ptr_array_new();
     catalog_driver->lazy_drivers_array = lazy_of(drivers_array, sort_array_by_driver_score);
     catalog_driver->driver_from_id_array = g_ptr_array_new();
 
@@ -45,9 +49,14 @@ void free_catalog_driver(CatalogDriver *catalog_driver) {
     free_lazy(catalog_driver->lazy_drivers_array, free_g_ptr_array);
     g_ptr_array_free(catalog_driver->driver_from_id_array, TRUE);
     free_catalog_driver_city_info(catalog_driver->catalog_driver_city_info);
+    free_arena(catalog_driver->arena);
     free(catalog_driver);
 }
 
+Arena *catalog_driver_get_arena(CatalogDriver *catalog_driver) {
+    return catalog_driver->arena;
+}
+
 void catalog_driver_register_driver(CatalogDriver *catalog_driver, Driver *driver) {
     GPtrArray *drivers_array = lazy_get_raw_value(catalog_driver->lazy_drivers_array);
     g_ptr_array_add(drivers_array, driver);
@@ -82,3 +91,36 @@ void catalog_driver_force_eager_indexing(CatalogDriver *catalog_driver) {
     lazy_apply_function(catalog_driver->lazy_drivers_array);
     catalog_driver_city_info_force_eager_indexing(catalog_driver->catalog_driver_city_info);
 }
+
+void catalog_driver_collect_lazy_indexes(CatalogDriver *catalog_driver, GPtrArray *lazies) {
+    g_ptr_array_add(lazies, catalog_driver->lazy_drivers_array);
+    catalog_driver_city_info_collect_lazy_indexes(catalog_driver->catalog_driver_city_info, lazies);
+}
+
+void catalog_driver_write_snapshot(CatalogDriver *catalog_driver, SnapshotWriter *writer, StringPool *name_pool) {
+    GPtrArray *drivers_array = lazy_get_value(catalog_driver->lazy_drivers_array);
+
+    snapshot_write_uint32(writer, drivers_array->len);
+    for (guint i = 0; i < drivers_array->len; i++) {
+        driver_write_snapshot(g_ptr_array_index(drivers_array, i), writer, name_pool);
+    }
+
+    catalog_driver_city_info_write_snapshot(catalog_driver->catalog_driver_city_info, writer);
+}
+
+gboolean catalog_driver_read_snapshot(CatalogDriver *catalog_driver, SnapshotReader *reader, StringPool *name_pool) {
+    guint drivers_count = snapshot_read_uint32(reader);
+
+    // Drivers are written in score order, so the array doesn't need to be sorted again
+    for (guint i = 0; i < drivers_count && !snapshot_reader_has_error(reader); i++) {
+        Driver *driver = driver_read_snapshot(reader, catalog_driver->arena, name_pool);
+        if (driver == NULL || driver_get_id(driver) < 0) return FALSE;
+
+        catalog_driver_register_driver(catalog_driver, driver);
+    }
+
+    lazy_mark_as_applied(catalog_driver->lazy_drivers_array);
+
+    return catalog_driver_city_info_read_snapshot(catalog_driver->catalog_driver_city_info, reader) &&
+           !snapshot_reader_has_error(reader);
+}
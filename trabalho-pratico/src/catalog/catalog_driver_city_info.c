@@ -8,6 +8,7 @@
  * Struct that holds an array of DriverCityInfoCollection for each city.
  */
 struct CatalogDriverCityInfo {
+    Arena *arena; // Owns every DriverCityInfo
     Lazy *lazy_driver_city_info_collection_array;
     //Lazy of GPtrArray<index: city_id, value: DriverCityInfoCollection>
 };
@@ -61,13 +62,14 @@ void lazy_driver_city_info_collection_array_apply_function(gpointer lazy_value)
         g_hash_table_destroy(collection->driver_city_info_hashtable);
         collection->driver_city_info_hashtable = NULL;
 
-        sort_array(collection->driver_city_info_array, compare_driver_city_infos_by_average_score);
+        parallel_sort_array(collection->driver_city_info_array, compare_driver_city_infos_by_average_score);
         BENCHMARK_LOG("driver_city_info_destroy_and_sort (%d): %lf seconds\n", i, g_timer_elapsed(driver_city_info_destroy_and_sort, NULL));
     }
 }
 
 CatalogDriverCityInfo *create_catalog_driver_city_info(void) {
     CatalogDriverCityInfo *catalog_driver_city_info = malloc(sizeof(CatalogDriverCityInfo));
+    catalog_driver_city_info->arena = create_arena();
     catalog_driver_city_info->lazy_driver_city_info_collection_array =
             lazy_of(g_ptr_array_new_with_free_func(free_driver_city_info_collection),
                     lazy_driver_city_info_collection_array_apply_function);
@@ -83,6 +85,7 @@ void free_array(gpointer value) {
 
 void free_catalog_driver_city_info(CatalogDriverCityInfo *catalog_driver_city_info) {
     free_lazy(catalog_driver_city_info->lazy_driver_city_info_collection_array, free_array);
+    free_arena(catalog_driver_city_info->arena);
     free(catalog_driver_city_info);
 }
 
@@ -93,7 +96,7 @@ void catalog_driver_city_info_register(CatalogDriverCityInfo *catalog, int drive
     DriverCityInfo *target;
     if (driver_city_collection == NULL) { // ride_city is not in the hashtable
         driver_city_collection = malloc(sizeof(DriverCityInfoCollection));
-        driver_city_collection->driver_city_info_array = g_ptr_array_new_with_free_func(free_driver_city_info_voidp);
+        driver_city_collection->driver_city_info_array = g_ptr_array_new();
         driver_city_collection->driver_city_info_hashtable = g_hash_table_new(g_direct_hash, g_direct_equal);
 
         g_ptr_array_set_at_index_safe(driver_city_info_collection_array, city_id, driver_city_collection);
@@ -104,7 +107,7 @@ void catalog_driver_city_info_register(CatalogDriverCityInfo *catalog, int drive
 
     if (target == NULL) { // driver is not yet registered in city
     register_driver_city_info:
-        target = create_driver_city_info(driver_id);
+        target = create_driver_city_info(driver_id, catalog->arena);
 
         g_ptr_array_add(driver_city_collection->driver_city_info_array, target);
         g_hash_table_insert(driver_city_collection->driver_city_info_hashtable, GINT_TO_POINTER(driver_id), target);
@@ -117,6 +120,10 @@ void catalog_driver_city_info_force_eager_indexing(CatalogDriverCityInfo *catalo
     lazy_apply_function(catalog->lazy_driver_city_info_collection_array);
 }
 
+void catalog_driver_city_info_collect_lazy_indexes(CatalogDriverCityInfo *catalog, GPtrArray *lazies) {
+    g_ptr_array_add(lazies, catalog->lazy_driver_city_info_collection_array);
+}
+
 int catalog_driver_city_info_get_top_best_drivers_by_city(CatalogDriverCityInfo *catalog, int city_id, int n, GPtrArray *result) {
     GPtrArray *driver_city_info_array = lazy_get_value(catalog->lazy_driver_city_info_collection_array);
     DriverCityInfoCollection *driver_city_info_collection = g_ptr_array_get_at_index_safe(driver_city_info_array, city_id);
@@ -133,3 +140,48 @@ int catalog_driver_city_info_get_top_best_drivers_by_city(CatalogDriverCityInfo
 
     return size;
 }
+
+void catalog_driver_city_info_write_snapshot(CatalogDriverCityInfo *catalog, SnapshotWriter *writer) {
+    GPtrArray *driver_city_info_collection_array = lazy_get_value(catalog->lazy_driver_city_info_collection_array);
+
+    snapshot_write_uint32(writer, driver_city_info_collection_array->len);
+    for (guint i = 0; i < driver_city_info_collection_array->len; i++) {
+        DriverCityInfoCollection *collection = g_ptr_array_index(driver_city_info_collection_array, i);
+
+        // Collections are only created with a driver, so an empty one means the city has no collection
+        if (collection == NULL) {
+            snapshot_write_uint32(writer, 0);
+            continue;
+        }
+
+        GPtrArray *driver_city_info_array = collection->driver_city_info_array;
+        snapshot_write_uint32(writer, driver_city_info_array->len);
+        for (guint j = 0; j < driver_city_info_array->len; j++) {
+            driver_city_info_write_snapshot(g_ptr_array_index(driver_city_info_array, j), writer);
+        }
+    }
+}
+
+gboolean catalog_driver_city_info_read_snapshot(CatalogDriverCityInfo *catalog, SnapshotReader *reader) {
+    GPtrArray *driver_city_info_collection_array = lazy_get_raw_value(catalog->lazy_driver_city_info_collection_array);
+
+    guint cities_count = snapshot_read_uint32(reader);
+    for (guint i = 0; i < cities_count && !snapshot_reader_has_error(reader); i++) {
+        guint driver_city_infos_count = snapshot_read_uint32(reader);
+        if (driver_city_infos_count == 0) continue;
+
+        DriverCityInfoCollection *collection = malloc(sizeof(DriverCityInfoCollection));
+        collection->driver_city_info_array = g_ptr_array_sized_new(driver_city_infos_count);
+        collection->driver_city_info_hashtable = NULL; // Only needed while registering rides
+
+        g_ptr_array_set_at_index_safe(driver_city_info_collection_array, i, collection);
+
+        for (guint j = 0; j < driver_city_infos_count && !snapshot_reader_has_error(reader); j++) {
+            g_ptr_array_add(collection->driver_city_info_array, driver_city_info_read_snapshot(reader, catalog->arena));
+        }
+    }
+
+    lazy_mark_as_applied(catalog->lazy_driver_city_info_collection_array);
+
+    return !snapshot_reader_has_error(reader);
+}
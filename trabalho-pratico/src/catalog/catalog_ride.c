@@ -3,101 +3,259 @@
 #include "array_util.h"
 #include "benchmark.h"
 #include "lazy.h"
+#include "ride_columns.h"
+#include "typed_array.h"
 
 /**
  * Struct that holds all the rides and indexed information.
  */
 struct CatalogRide {
-    Lazy *lazy_rides_array;
-    GPtrArray *array_of_rides_in_city_array;
+    Arena *arena; // Owns every ride
+    Lazy *lazy_rides_array; // Lazy of RidesByDate with every ride
+    GPtrArray *array_of_rides_in_city_array; // Index is city id, value is a Lazy of RidesByDate
 
-    Lazy *lazy_ride_male_array;
-    Lazy *lazy_ride_female_array;
+    Lazy *lazy_ride_male_array; // Lazy of RideWithAccountCreationDatesArray
+    Lazy *lazy_ride_female_array; // Lazy of RideWithAccountCreationDatesArray
 };
 
 /**
- * Function that wraps free ride to be used in GLib g_ptr_array free func.
+ * Struct that holds rides sorted by date and a columnar copy of them (in the same order).
+ * The rides of each date are counted as they are registered, so applying the lazy that holds it
+ * places the rides in date order in a single pass (rides of the same date stay in the order they were registered)
+ * and builds the columns. After that the date range queries only scan the columns they need.
  */
-void glib_wrapper_free_ride(gpointer ride) {
-    free_ride(ride);
+typedef struct {
+    GPtrArray *rides;
+    guint *date_counts; // Number of rides registered with each date bucket, NULL if none were or once they are placed
+    RideColumns *columns; // NULL until the rides are sorted
+    RideColumnSet column_set;
+} RidesByDate;
+
+/**
+ * Columns stored for all the rides (only what queries 5 and 9 read).
+ */
+#define ALL_RIDES_COLUMNS (RIDE_COLUMN_DATE | RIDE_COLUMN_PRICE | RIDE_COLUMN_TIP)
+
+/**
+ * Columns stored for the rides in each city (only what queries 4 and 6 read).
+ */
+#define RIDES_IN_CITY_COLUMNS (RIDE_COLUMN_DATE | RIDE_COLUMN_PRICE | RIDE_COLUMN_DISTANCE)
+
+/**
+ * Creates an empty RidesByDate that will store the given columns.
+ */
+static RidesByDate *create_rides_by_date(RideColumnSet column_set, guint reserved_size) {
+    RidesByDate *rides_by_date = malloc(sizeof(RidesByDate));
+    rides_by_date->rides = g_ptr_array_sized_new(reserved_size);
+    rides_by_date->date_counts = NULL;
+    rides_by_date->columns = NULL;
+    rides_by_date->column_set = column_set;
+    return rides_by_date;
+}
+
+/**
+ * Frees the RidesByDate (the rides are owned by the catalog arena).
+ */
+static void free_rides_by_date(gpointer rides_by_date) {
+    RidesByDate *actual_rides_by_date = rides_by_date;
+    g_ptr_array_free(actual_rides_by_date->rides, TRUE);
+    free(actual_rides_by_date->date_counts);
+    if (actual_rides_by_date->columns != NULL) free_ride_columns(actual_rides_by_date->columns);
+    free(actual_rides_by_date);
+}
+
+/**
+ * Adds a ride to the RidesByDate, counting it in the bucket of its date.
+ */
+static inline void rides_by_date_add(RidesByDate *rides_by_date, Ride *ride) {
+    if (rides_by_date->date_counts == NULL) rides_by_date->date_counts = calloc(RIDE_DATE_BUCKETS, sizeof(guint));
+
+    g_ptr_array_add(rides_by_date->rides, ride);
+    rides_by_date->date_counts[ride_get_date_bucket(ride)]++;
+}
+
+/**
+ * Function that compares rides with `compare_rides_by_date`, for `g_qsort_with_data` (which is stable).
+ */
+static gint compare_rides_by_date_with_data(gconstpointer a_ride, gconstpointer b_ride, gpointer data) {
+    (void) data;
+    return compare_rides_by_date(a_ride, b_ride);
 }
 
 /**
- * Function that sorts the rides array by date.
+ * Places the rides in date order, using the counts of each date.
  */
-static void sort_rides_array(gpointer rides_array) {
+static void rides_by_date_place_in_date_order(RidesByDate *rides_by_date) {
+    if (rides_by_date->date_counts == NULL) return;
+
+    GPtrArray *rides = rides_by_date->rides;
+    guint before_range_count = rides_by_date->date_counts[RIDE_DATE_BUCKET_BEFORE_RANGE];
+    guint after_range_count = rides_by_date->date_counts[RIDE_DATE_BUCKET_AFTER_RANGE];
+
+    counting_sort_array(rides, rides_by_date->date_counts, RIDE_DATE_BUCKETS, ride_get_date_bucket);
+
+    // Rides with years out of the packed range share a bucket each, so they are sorted by their full dates
+    g_qsort_with_data(rides->pdata, (gint) before_range_count, sizeof(gpointer), compare_rides_by_date_with_data, NULL);
+    g_qsort_with_data(rides->pdata + rides->len - after_range_count, (gint) after_range_count, sizeof(gpointer),
+                      compare_rides_by_date_with_data, NULL);
+
+    free(rides_by_date->date_counts);
+    rides_by_date->date_counts = NULL;
+}
+
+/**
+ * Builds the columns of rides that are already sorted by date.
+ */
+static void rides_by_date_build_columns(RidesByDate *rides_by_date) {
+    rides_by_date->columns = create_ride_columns(rides_by_date->rides, rides_by_date->column_set);
+}
+
+/**
+ * Function that places the rides array in date order and builds its columns.
+ */
+static void sort_rides_array(gpointer rides_by_date) {
     BENCHMARK_START(sort_rides_array_timer);
-    sort_array(rides_array, compare_rides_by_date);
+    rides_by_date_place_in_date_order(rides_by_date);
+    rides_by_date_build_columns(rides_by_date);
     BENCHMARK_END(sort_rides_array_timer, "sort_rides_array: %lf seconds\n");
 }
 
+/**
+ * Struct that holds a ride whose user and driver have the same gender, with their account creation dates.
+ * The dates are only needed by query 8, so they are kept in this side index instead of in every ride.
+ */
+typedef struct {
+    Ride *ride;
+    Date driver_account_creation_date;
+    Date user_account_creation_date;
+} RideWithAccountCreationDates;
+
+DEFINE_TYPED_ARRAY(RideWithAccountCreationDatesArray, rides_with_account_creation_dates_array, RideWithAccountCreationDates)
+
+/**
+ * Function that compares RideWithAccountCreationDates by driver account creation date, user account creation date and then ride id.
+ */
+static inline int compare_ride_by_driver_and_user_account_creation_date(const RideWithAccountCreationDates *a_entry,
+                                                                        const RideWithAccountCreationDates *b_entry) {
+    int by_account_creation_driver = date_compare(a_entry->driver_account_creation_date, b_entry->driver_account_creation_date);
+    if (by_account_creation_driver != 0) {
+        return by_account_creation_driver;
+    }
+
+    int by_account_creation_user = date_compare(a_entry->user_account_creation_date, b_entry->user_account_creation_date);
+    if (by_account_creation_user != 0) {
+        return by_account_creation_user;
+    }
+
+    return ride_get_id(a_entry->ride) - ride_get_id(b_entry->ride);
+}
+
+/**
+ * Returns TRUE if the RideWithAccountCreationDates goes before the other by driver and user account creation date.
+ */
+static inline gboolean ride_with_account_creation_dates_is_before(const RideWithAccountCreationDates *a_entry,
+                                                                   const RideWithAccountCreationDates *b_entry) {
+    return compare_ride_by_driver_and_user_account_creation_date(a_entry, b_entry) < 0;
+}
+
+DEFINE_TYPED_SORT(rides_with_account_creation_dates, RideWithAccountCreationDates, ride_with_account_creation_dates_is_before)
+
+/**
+ * Function that compares RideWithAccountCreationDates like `compare_ride_by_driver_and_user_account_creation_date`, for `parallel_sort`.
+ */
+static gint compare_rides_with_account_creation_dates(gconstpointer a_entry, gconstpointer b_entry, gpointer data) {
+    (void) data;
+    return compare_ride_by_driver_and_user_account_creation_date(a_entry, b_entry);
+}
+
+/**
+ * Sorts a chunk of RideWithAccountCreationDates with the inlined sort, for `parallel_sort`.
+ */
+static void sort_rides_with_account_creation_dates_chunk(void *entries, size_t length, gpointer data) {
+    (void) data;
+    rides_with_account_creation_dates_sort(entries, length);
+}
+
+/**
+ * Sorts an array of RideWithAccountCreationDates by driver and user account creation date.
+ * The order is total (ties are broken by ride id), so the result doesn't depend on the number of threads.
+ */
+static void sort_rides_with_account_creation_dates(RideWithAccountCreationDatesArray *rides_with_dates) {
+    parallel_sort(rides_with_dates->data, rides_with_dates->len, sizeof(RideWithAccountCreationDates), compare_rides_with_account_creation_dates,
+                  sort_rides_with_account_creation_dates_chunk, NULL, parallel_sort_thread_budget());
+}
+
 /**
  * Function that sorts the male rides array by driver and user account creation date.
  */
 static void sort_male_rides_by_account_creation_date(gpointer male_rides_array) {
     BENCHMARK_START(sort_rduinfo_male_array_timer);
-    sort_array(male_rides_array, compare_ride_by_driver_and_user_account_creation_date);
+    sort_rides_with_account_creation_dates(male_rides_array);
     BENCHMARK_END(sort_rduinfo_male_array_timer, "sort_ride_male_array: %lf seconds\n");
 }
 
 /**
  * Function that sorts the female rides array by driver and user account creation date.
  */
-void sort_female_rides_by_account_creation_date(gpointer female_rides_array) {
+static void sort_female_rides_by_account_creation_date(gpointer female_rides_array) {
     BENCHMARK_START(sort_rduinfo_female_array_timer);
-    sort_array(female_rides_array, compare_ride_by_driver_and_user_account_creation_date);
+    sort_rides_with_account_creation_dates(female_rides_array);
     BENCHMARK_END(sort_rduinfo_female_array_timer, "sort_ride_female_array: %lf seconds\n");
 }
 
 /**
- * Frees the rides array.
+ * Frees an array of RideWithAccountCreationDates.
  */
-void free_rides_array(gpointer array) {
-    g_ptr_array_free(array, TRUE);
+static void free_rides_with_account_creation_dates(gpointer array) {
+    free_rides_with_account_creation_dates_array(array);
 }
 
 /**
- * Function that wraps free array to be used in GLib g_hash_table free func.
+ * Function that wraps free lazy to be used in GLib g_ptr_array free func.
  */
-void free_lazy_with_rides_array(gpointer lazy) {
+void free_lazy_with_rides_by_date(gpointer lazy) {
     // Lazy can be NULL if the city has no rides registered.
     if (lazy == NULL) return;
 
-    free_lazy(lazy, free_rides_array);
+    free_lazy(lazy, free_rides_by_date);
 }
 
 CatalogRide *create_catalog_ride(void) {
     CatalogRide *catalog_ride = malloc(sizeof(CatalogRide));
-    catalog_ride->lazy_rides_array = lazy_of(g_ptr_array_new_with_free_func(glib_wrapper_free_ride), sort_rides_array);
-    catalog_ride->array_of_rides_in_city_array = g_ptr_array_new_with_free_func(free_lazy_with_rides_array);
+    catalog_ride->arena = create_arena();
+    catalog_ride->lazy_rides_array = lazy_of(create_rides_by_date(ALL_RIDES_COLUMNS, 0), sort_rides_array);
+    catalog_ride->array_of_rides_in_city_array = g_ptr_array_new_with_free_func(free_lazy_with_rides_by_date);
 
-    catalog_ride->lazy_ride_male_array = lazy_of(g_ptr_array_new(), sort_male_rides_by_account_creation_date);
-    catalog_ride->lazy_ride_female_array = lazy_of(g_ptr_array_new(), sort_female_rides_by_account_creation_date);
+    catalog_ride->lazy_ride_male_array = lazy_of(create_rides_with_account_creation_dates_array(0), sort_male_rides_by_account_creation_date);
+    catalog_ride->lazy_ride_female_array = lazy_of(create_rides_with_account_creation_dates_array(0), sort_female_rides_by_account_creation_date);
 
     return catalog_ride;
 }
 
 void free_catalog_ride(CatalogRide *catalog_ride) {
-    free_lazy(catalog_ride->lazy_rides_array, free_rides_array);
+    free_lazy(catalog_ride->lazy_rides_array, free_rides_by_date);
     g_ptr_array_free(catalog_ride->array_of_rides_in_city_array, TRUE);
 
-    free_lazy(catalog_ride->lazy_ride_male_array, free_rides_array);
-    free_lazy(catalog_ride->lazy_ride_female_array, free_rides_array);
+    free_lazy(catalog_ride->lazy_ride_male_array, free_rides_with_account_creation_dates);
+    free_lazy(catalog_ride->lazy_ride_female_array, free_rides_with_account_creation_dates);
+
+    free_arena(catalog_ride->arena);
 
     free(catalog_ride);
 }
 
 /**
- * Function that sorts the rides in city array by date.
+ * Function that places the rides in city array in date order and builds its columns.
  */
-static void sort_array_rides_in_city_array(gpointer rides_array) {
+static void sort_array_rides_in_city_array(gpointer rides_by_date) {
     BENCHMARK_START(sort_rides_array_timer);
-    sort_array(rides_array, compare_rides_by_date);
+    rides_by_date_place_in_date_order(rides_by_date);
+    rides_by_date_build_columns(rides_by_date);
     BENCHMARK_END(sort_rides_array_timer, "sort_rides_in_city_array: %lf seconds\n");
 }
 
 /**
- * Returns a Lazy with an array of rides in a city.
+ * Returns a Lazy with the RidesByDate of a city.
  */
 static Lazy *catalog_ride_get_rides_in_city(CatalogRide *catalog_ride, int city_id) {
     return g_ptr_array_get_at_index_safe(catalog_ride->array_of_rides_in_city_array, city_id);
@@ -111,161 +269,118 @@ static Lazy *catalog_ride_get_rides_in_city(CatalogRide *catalog_ride, int city_
 static inline void catalog_ride_index_city(CatalogRide *catalog_ride, Ride *ride, int city_id) {
     Lazy *rides_in_city = catalog_ride_get_rides_in_city(catalog_ride, city_id);
     if (rides_in_city == NULL) {
-        rides_in_city = lazy_of(g_ptr_array_new(), sort_array_rides_in_city_array);
+        rides_in_city = lazy_of(create_rides_by_date(RIDES_IN_CITY_COLUMNS, 0), sort_array_rides_in_city_array);
 
         g_ptr_array_set_at_index_safe(catalog_ride->array_of_rides_in_city_array, city_id, rides_in_city);
     }
 
-    g_ptr_array_add(lazy_get_raw_value(rides_in_city), ride);
+    rides_by_date_add(lazy_get_raw_value(rides_in_city), ride);
+}
+
+Arena *catalog_ride_get_arena(CatalogRide *catalog_ride) {
+    return catalog_ride->arena;
+}
+
+void catalog_ride_adopt_arena(CatalogRide *catalog_ride, Arena *arena) {
+    arena_merge(catalog_ride->arena, arena);
 }
 
 void catalog_ride_register_ride(CatalogRide *catalog_ride, Ride *ride) {
-    g_ptr_array_add(lazy_get_raw_value(catalog_ride->lazy_rides_array), ride);
+    rides_by_date_add(lazy_get_raw_value(catalog_ride->lazy_rides_array), ride);
 
     catalog_ride_index_city(catalog_ride, ride, ride_get_city_id(ride));
 }
 
 void catalog_ride_register_ride_same_gender(CatalogRide *catalog_ride,
                                             Gender gender,
-                                            Ride *ride) {
-    GPtrArray *ride_same_gender_array = lazy_get_raw_value(gender == M ? catalog_ride->lazy_ride_male_array : catalog_ride->lazy_ride_female_array);
-    g_ptr_array_add(ride_same_gender_array, ride);
-}
-
-double catalog_ride_get_average_price_in_city(CatalogRide *catalog_ride, int city_id) {
-    GPtrArray *rides_in_city = lazy_get_value(catalog_ride_get_rides_in_city(catalog_ride, city_id));
-    if (rides_in_city == NULL) return 0;
-
-    double price_sum = 0;
-
-    // Performance impact of this loop is negligible, even with ~200000 rides_in_city per city.
-    // We also assume that the user won't ask this query twice for the same city, so no need to cache the average.
-
-    for (guint i = 0; i < rides_in_city->len; i++) {
-        Ride *ride = g_ptr_array_index(rides_in_city, i);
-        price_sum += ride_get_price(ride);
-    }
-
-    return price_sum / rides_in_city->len;
+                                            Ride *ride,
+                                            Date driver_account_creation_date,
+                                            Date user_account_creation_date) {
+    RideWithAccountCreationDatesArray *ride_same_gender_array =
+            lazy_get_raw_value(gender == M ? catalog_ride->lazy_ride_male_array : catalog_ride->lazy_ride_female_array);
+    RideWithAccountCreationDates ride_with_dates = {ride, driver_account_creation_date, user_account_creation_date};
+    rides_with_account_creation_dates_array_append(ride_same_gender_array, ride_with_dates);
 }
 
 /**
- * Returns the index of the lowest ride whose date is greater than the given date.
+ * Returns the columns of the rides in a city (sorting them if needed) or NULL if the city has no rides.
  */
-static guint ride_array_find_date_lower_bound(GPtrArray *array, Date date) {
-    guint mid;
-
-    guint low = 0;
-    guint high = array->len;
-
-    while (low < high) {
-        mid = low + (high - low) / 2;
-
-        if (date_compare(date, ride_get_date(g_ptr_array_index(array, mid))) <= 0) {
-            high = mid;
-        } else {
-            low = mid + 1;
-        }
-    }
-
-    // TODO: maybe stop binary search when finds a date that is equal to
-    //  the given date and then do a linear search backwards to find the lower bound
+static RideColumns *catalog_ride_get_columns_in_city(CatalogRide *catalog_ride, int city_id) {
+    Lazy *rides_in_city = catalog_ride_get_rides_in_city(catalog_ride, city_id);
+    if (rides_in_city == NULL) return NULL;
 
-    return low;
+    RidesByDate *rides_in_city_by_date = lazy_get_value(rides_in_city);
+    return rides_in_city_by_date->columns;
 }
 
-double catalog_ride_get_average_distance_in_date_range(CatalogRide *catalog_ride, Date start_date, Date end_date) {
-    GPtrArray *rides = lazy_get_value(catalog_ride->lazy_rides_array);
+Money catalog_ride_get_average_price_in_city(CatalogRide *catalog_ride, int city_id) {
+    RideColumns *columns_in_city = catalog_ride_get_columns_in_city(catalog_ride, city_id);
+    if (columns_in_city == NULL || ride_columns_get_length(columns_in_city) == 0) return 0;
 
-    long current_value_index = ride_array_find_date_lower_bound(rides, start_date);
+    // We assume that the user won't ask this query twice for the same city, so no need to cache the average.
+    guint rides_count = ride_columns_get_length(columns_in_city);
+    Money price_sum = ride_columns_sum_prices(columns_in_city, 0, rides_count);
 
-    double price_sum = 0;
-    int rides_count = 0;
+    return money_average(price_sum, (int) rides_count);
+}
 
-    while (current_value_index < rides->len) {
-        Ride *current_ride = g_ptr_array_index(rides, current_value_index);
-        Date current_ride_date = ride_get_date(current_ride);
+Money catalog_ride_get_average_distance_in_date_range(CatalogRide *catalog_ride, Date start_date, Date end_date) {
+    RidesByDate *rides_by_date = lazy_get_value(catalog_ride->lazy_rides_array);
+    RideColumns *columns = rides_by_date->columns;
 
-        if (date_compare(current_ride_date, end_date) > 0)
-            break;
-
-        price_sum += ride_get_price(current_ride);
-        rides_count++;
-
-        current_value_index++;
-    }
+    guint first_row = ride_columns_find_date_lower_bound(columns, start_date);
+    guint end_row = ride_columns_find_date_upper_bound(columns, end_date);
 
     // divide by zero check
-    return rides_count != 0 ? price_sum / rides_count : -1;
+    if (first_row >= end_row) return -1;
+
+    Money price_sum = ride_columns_sum_prices(columns, first_row, end_row);
+    return money_average(price_sum, (int) (end_row - first_row));
 }
 
 double catalog_ride_get_average_distance_in_city_and_date_range(CatalogRide *catalog_ride, Date start_date, Date end_date, int city_id) {
-    GPtrArray *rides_in_city = lazy_get_value(catalog_ride_get_rides_in_city(catalog_ride, city_id));
-    if (rides_in_city == NULL) return 0;
-
-    long current_value_index = ride_array_find_date_lower_bound(rides_in_city, start_date);
-
-    double distance_sum = 0;
-    int rides_count = 0;
-
-    while (current_value_index < rides_in_city->len) {
-        Ride *current_ride = g_ptr_array_index(rides_in_city, current_value_index);
-        Date current_ride_date = ride_get_date(current_ride);
+    RideColumns *columns_in_city = catalog_ride_get_columns_in_city(catalog_ride, city_id);
+    if (columns_in_city == NULL) return 0;
 
-        if (date_compare(current_ride_date, end_date) > 0)
-            break;
-
-        distance_sum += ride_get_distance(current_ride);
-        rides_count++;
-
-        current_value_index++;
-    }
+    guint first_row = ride_columns_find_date_lower_bound(columns_in_city, start_date);
+    guint end_row = ride_columns_find_date_upper_bound(columns_in_city, end_date);
 
-    if (rides_count == 0) return -1;
+    if (first_row >= end_row) return -1;
 
-    return distance_sum / rides_count;
+    int64_t distance_sum = ride_columns_sum_distances(columns_in_city, first_row, end_row);
+    return (double) distance_sum / (double) (end_row - first_row);
 }
 
 void catalog_ride_get_passengers_that_gave_tip_in_date_range(CatalogRide *catalog_ride, Date start_date, Date end_date, GPtrArray *result) {
-    GPtrArray *rides = lazy_get_value(catalog_ride->lazy_rides_array);
+    RidesByDate *rides_by_date = lazy_get_value(catalog_ride->lazy_rides_array);
+    RideColumns *columns = rides_by_date->columns;
 
-    long current_value_index = ride_array_find_date_lower_bound(rides, start_date);
+    guint first_row = ride_columns_find_date_lower_bound(columns, start_date);
+    guint end_row = ride_columns_find_date_upper_bound(columns, end_date);
 
-    Ride *current_ride;
-    Date current_ride_date;
-
-    while (current_value_index < rides->len) {
-        current_ride = g_ptr_array_index(rides, current_value_index);
-        current_ride_date = ride_get_date(current_ride);
-
-        if (date_compare(current_ride_date, end_date) > 0)
-            break;
-
-        if (ride_get_tip(current_ride) > 0) {
-            g_ptr_array_add(result, current_ride);
+    // Only the tip column is scanned, the rides are only touched for the rows in the result
+    for (guint row = first_row; row < end_row; row++) {
+        if (ride_columns_get_tip(columns, row) > 0) {
+            g_ptr_array_add(result, g_ptr_array_index(rides_by_date->rides, row));
         }
-
-        current_value_index++;
     }
 
-    sort_array(result, compare_rides_by_distance);
+    sort_rides_by_distance(result);
 }
 
 int catalog_ride_get_rides_with_user_and_driver_with_same_age_above_acc_age(CatalogRide *catalog_ride, GPtrArray *result, Gender gender, int min_account_age) {
-    GPtrArray *ride_same_gender_array = lazy_get_value(gender == M ? catalog_ride->lazy_ride_male_array : catalog_ride->lazy_ride_female_array);
+    RideWithAccountCreationDatesArray *ride_same_gender_array =
+            lazy_get_value(gender == M ? catalog_ride->lazy_ride_male_array : catalog_ride->lazy_ride_female_array);
 
     int i = 0;
     while (i < (int) ride_same_gender_array->len) {
-        Ride *ride = g_ptr_array_index(ride_same_gender_array, i);
+        RideWithAccountCreationDates *ride_with_dates = rides_with_account_creation_dates_array_get(ride_same_gender_array, i);
 
-        Date user_account_creation_date = ride_get_user_account_creation_date(ride);
-        Date driver_account_creation_date = ride_get_driver_account_creation_date(ride);
-
-        int user_age = get_age(user_account_creation_date);
-        int driver_age = get_age(driver_account_creation_date);
+        int user_age = get_age(ride_with_dates->user_account_creation_date);
+        int driver_age = get_age(ride_with_dates->driver_account_creation_date);
 
         if (user_age >= min_account_age && driver_age >= min_account_age) {
-            g_ptr_array_add(result, ride);
+            g_ptr_array_add(result, ride_with_dates->ride);
         }
 
         if (driver_age < min_account_age) {
@@ -292,3 +407,142 @@ void catalog_ride_force_eager_indexing(CatalogRide *catalog_ride) {
     lazy_apply_function(catalog_ride->lazy_ride_male_array);
     lazy_apply_function(catalog_ride->lazy_ride_female_array);
 }
+
+void catalog_ride_collect_lazy_indexes(CatalogRide *catalog_ride, GPtrArray *lazies) {
+    g_ptr_array_add(lazies, catalog_ride->lazy_rides_array);
+    g_ptr_array_add(lazies, catalog_ride->lazy_ride_male_array);
+    g_ptr_array_add(lazies, catalog_ride->lazy_ride_female_array);
+
+    for (guint i = 0; i < catalog_ride->array_of_rides_in_city_array->len; ++i) {
+        Lazy *lazy = catalog_ride->array_of_rides_in_city_array->pdata[i];
+        if (lazy != NULL) g_ptr_array_add(lazies, lazy);
+    }
+}
+
+/**
+ * Writes the rides of the given array as indexes into the rides array.
+ */
+static void write_ride_indexes_snapshot(GPtrArray *rides, GHashTable *ride_to_index_hashtable, SnapshotWriter *writer) {
+    snapshot_write_uint32(writer, rides->len);
+    for (guint i = 0; i < rides->len; i++) {
+        snapshot_write_uint32(writer, GPOINTER_TO_UINT(g_hash_table_lookup(ride_to_index_hashtable, g_ptr_array_index(rides, i))));
+    }
+}
+
+/**
+ * Writes an array of RideWithAccountCreationDates, with the rides as indexes into the rides array.
+ */
+static void write_rides_with_account_creation_dates_snapshot(RideWithAccountCreationDatesArray *rides_with_dates, GHashTable *ride_to_index_hashtable, SnapshotWriter *writer) {
+    snapshot_write_uint32(writer, rides_with_dates->len);
+    for (guint i = 0; i < rides_with_dates->len; i++) {
+        RideWithAccountCreationDates *ride_with_dates = rides_with_account_creation_dates_array_get(rides_with_dates, i);
+        snapshot_write_uint32(writer, GPOINTER_TO_UINT(g_hash_table_lookup(ride_to_index_hashtable, ride_with_dates->ride)));
+        snapshot_write_uint32(writer, ride_with_dates->driver_account_creation_date.encoded_date);
+        snapshot_write_uint32(writer, ride_with_dates->user_account_creation_date.encoded_date);
+    }
+}
+
+void catalog_ride_write_snapshot(CatalogRide *catalog_ride, SnapshotWriter *writer) {
+    catalog_ride_force_eager_indexing(catalog_ride);
+
+    GPtrArray *rides = ((RidesByDate *) lazy_get_raw_value(catalog_ride->lazy_rides_array))->rides;
+    GHashTable *ride_to_index_hashtable = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    snapshot_write_uint32(writer, rides->len);
+    for (guint i = 0; i < rides->len; i++) {
+        Ride *ride = g_ptr_array_index(rides, i);
+        ride_write_snapshot(ride, writer);
+        g_hash_table_insert(ride_to_index_hashtable, ride, GUINT_TO_POINTER(i));
+    }
+
+    // The other arrays are stored as indexes to keep the order they were sorted in
+    GPtrArray *array_of_rides_in_city_array = catalog_ride->array_of_rides_in_city_array;
+    snapshot_write_uint32(writer, array_of_rides_in_city_array->len);
+    for (guint i = 0; i < array_of_rides_in_city_array->len; i++) {
+        Lazy *rides_in_city = g_ptr_array_index(array_of_rides_in_city_array, i);
+
+        if (rides_in_city == NULL) {
+            snapshot_write_uint32(writer, 0);
+            continue;
+        }
+
+        RidesByDate *rides_in_city_by_date = lazy_get_raw_value(rides_in_city);
+        write_ride_indexes_snapshot(rides_in_city_by_date->rides, ride_to_index_hashtable, writer);
+    }
+
+    write_rides_with_account_creation_dates_snapshot(lazy_get_raw_value(catalog_ride->lazy_ride_male_array), ride_to_index_hashtable, writer);
+    write_rides_with_account_creation_dates_snapshot(lazy_get_raw_value(catalog_ride->lazy_ride_female_array), ride_to_index_hashtable, writer);
+
+    g_hash_table_destroy(ride_to_index_hashtable);
+}
+
+/**
+ * Reads an array written by `write_ride_indexes_snapshot` into the given array.
+ * Returns FALSE if an index is out of bounds.
+ */
+static gboolean read_ride_indexes_snapshot(GPtrArray *rides, GPtrArray *result, guint rides_count, SnapshotReader *reader) {
+    for (guint i = 0; i < rides_count && !snapshot_reader_has_error(reader); i++) {
+        guint ride_index = snapshot_read_uint32(reader);
+        if (ride_index >= rides->len) return FALSE;
+
+        g_ptr_array_add(result, g_ptr_array_index(rides, ride_index));
+    }
+
+    return !snapshot_reader_has_error(reader);
+}
+
+/**
+ * Reads an array written by `write_rides_with_account_creation_dates_snapshot` into the given array.
+ * Returns FALSE if an index is out of bounds.
+ */
+static gboolean read_rides_with_account_creation_dates_snapshot(GPtrArray *rides, RideWithAccountCreationDatesArray *result, guint rides_count,
+                                                                SnapshotReader *reader) {
+    for (guint i = 0; i < rides_count && !snapshot_reader_has_error(reader); i++) {
+        guint ride_index = snapshot_read_uint32(reader);
+        if (ride_index >= rides->len) return FALSE;
+
+        RideWithAccountCreationDates ride_with_dates;
+        ride_with_dates.ride = g_ptr_array_index(rides, ride_index);
+        ride_with_dates.driver_account_creation_date.encoded_date = snapshot_read_uint32(reader);
+        ride_with_dates.user_account_creation_date.encoded_date = snapshot_read_uint32(reader);
+        rides_with_account_creation_dates_array_append(result, ride_with_dates);
+    }
+
+    return !snapshot_reader_has_error(reader);
+}
+
+gboolean catalog_ride_read_snapshot(CatalogRide *catalog_ride, SnapshotReader *reader) {
+    RidesByDate *rides_by_date = lazy_get_raw_value(catalog_ride->lazy_rides_array);
+    GPtrArray *rides = rides_by_date->rides;
+
+    guint rides_count = snapshot_read_uint32(reader);
+    for (guint i = 0; i < rides_count && !snapshot_reader_has_error(reader); i++) {
+        g_ptr_array_add(rides, ride_read_snapshot(reader, catalog_ride->arena));
+    }
+    rides_by_date_build_columns(rides_by_date);
+    lazy_mark_as_applied(catalog_ride->lazy_rides_array);
+
+    guint cities_count = snapshot_read_uint32(reader);
+    for (guint i = 0; i < cities_count && !snapshot_reader_has_error(reader); i++) {
+        guint rides_in_city_count = snapshot_read_uint32(reader);
+        if (rides_in_city_count == 0) continue;
+
+        RidesByDate *rides_in_city_by_date = create_rides_by_date(RIDES_IN_CITY_COLUMNS, rides_in_city_count);
+        Lazy *rides_in_city = lazy_of(rides_in_city_by_date, sort_array_rides_in_city_array);
+        g_ptr_array_set_at_index_safe(catalog_ride->array_of_rides_in_city_array, (int) i, rides_in_city);
+
+        if (!read_ride_indexes_snapshot(rides, rides_in_city_by_date->rides, rides_in_city_count, reader)) return FALSE;
+
+        rides_by_date_build_columns(rides_in_city_by_date);
+        lazy_mark_as_applied(rides_in_city);
+    }
+
+    Lazy *lazy_same_gender_arrays[] = {catalog_ride->lazy_ride_male_array, catalog_ride->lazy_ride_female_array};
+    for (int i = 0; i < 2; i++) {
+        guint same_gender_count = snapshot_read_uint32(reader);
+        if (!read_rides_with_account_creation_dates_snapshot(rides, lazy_get_raw_value(lazy_same_gender_arrays[i]), same_gender_count, reader)) return FALSE;
+        lazy_mark_as_applied(lazy_same_gender_arrays[i]);
+    }
+
+    return !snapshot_reader_has_error(reader);
+}
@@ -3,68 +3,108 @@
 #include "benchmark.h"
 #include "lazy.h"
 #include "array_util.h"
+#include "string_index.h"
+
+/**
+ * Number of users the username index has space for before the catalog is told how many users to expect.
+ */
+#define DEFAULT_EXPECTED_USERS 1024
 
 /**
  * Struct that holds all the users and their indexed information.
  */
 struct CatalogUser {
-    Lazy *lazy_users_array;
-    GHashTable *user_from_username_hashtable;
+    Arena *arena; // Owns every user
+    Lazy *lazy_users_array; // Of UsersByTotalDistance
+    StringHeap *username_heap; // Keys of the username index and the usernames of the users
+    StringIndex *user_id_from_username_index;
     GPtrArray *user_from_user_id_array;
 };
 
 /**
- * Function that wraps free user to be used in GLib g_ptr_array free func.
+ * Struct that holds the users array sorted by total distance and the usernames it is sorted by.
  */
-void glib_wrapper_free_user(gpointer user) {
-    free_user(user);
-}
+typedef struct {
+    GPtrArray *users;
+    StringHeap *username_heap; // Owned by the catalog
+} UsersByTotalDistance;
 
 /**
  * Function that sorts the users array by total distance.
  */
-static void sort_array_by_total_distance(void *users_array) {
+static void sort_array_by_total_distance(void *users_by_total_distance) {
+    UsersByTotalDistance *users_by_distance = users_by_total_distance;
+
     BENCHMARK_START(sort_users_array);
-    sort_array(users_array, compare_users_by_total_distance);
+    // Only users with the same key (whose usernames start the same) are compared by username
+    radix_sort_array_with_tie_breaker(users_by_distance->users, user_get_total_distance_sort_key, compare_users_by_total_distance,
+                                      users_by_distance->username_heap);
     BENCHMARK_END(sort_users_array, "sort_users_array: %lf seconds\n");
 }
 
 CatalogUser *create_catalog_user(void) {
     CatalogUser *catalog_user = malloc(sizeof(CatalogUser));
 
-    catalog_user->lazy_users_array = lazy_of(g_ptr_array_new_with_free_func(glib_wrapper_free_user), sort_array_by_total_distance);
-    catalog_user->user_from_username_hashtable = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    catalog_user->arena = create_arena();
+    catalog_user->username_heap = create_string_heap(0);
+
+    UsersByTotalDistance *users_by_total_distance = malloc(sizeof(UsersByTotalDistance));
+    users_by_total_distance->users = g_ptr_array_new();
+    users_by_total_distance->username_heap = catalog_user->username_heap;
+    catalog_user->lazy_users_array = lazy_of(users_by_total_distance, sort_array_by_total_distance);
+
+    catalog_user->user_id_from_username_index = create_string_index(catalog_user->username_heap, DEFAULT_EXPECTED_USERS);
     catalog_user->user_from_user_id_array = g_ptr_array_new();
 
     return catalog_user;
 }
 
 /**
- * Frees the user array.
+ * Frees the users array (the users are owned by the catalog arena).
  */
-void free_users_array(gpointer array) {
-    g_ptr_array_free(array, TRUE);
+static void free_users_by_total_distance(gpointer users_by_total_distance) {
+    g_ptr_array_free(((UsersByTotalDistance *) users_by_total_distance)->users, TRUE);
+    free(users_by_total_distance);
 }
 
 void free_catalog_user(CatalogUser *catalog_user) {
-    g_hash_table_destroy(catalog_user->user_from_username_hashtable);
-    free_lazy(catalog_user->lazy_users_array, free_users_array);
+    free_string_index(catalog_user->user_id_from_username_index);
+    free_string_heap(catalog_user->username_heap);
+    free_lazy(catalog_user->lazy_users_array, free_users_by_total_distance);
     g_ptr_array_free(catalog_user->user_from_user_id_array, TRUE);
+    free_arena(catalog_user->arena);
 
     free(catalog_user);
 }
 
-void catalog_user_register_user(CatalogUser *catalog_user, User *user) {
-    g_ptr_array_add(lazy_get_raw_value(catalog_user->lazy_users_array), user);
+Arena *catalog_user_get_arena(CatalogUser *catalog_user) {
+    return catalog_user->arena;
+}
 
-    char *key = user_get_username(user);
-    // No need to free the key, it's freed by the hashtable when the user is removed
+void catalog_user_reserve(CatalogUser *catalog_user, guint expected_users) {
+    string_index_reserve(catalog_user->user_id_from_username_index, expected_users);
+}
 
-    g_hash_table_insert(catalog_user->user_from_username_hashtable, key, user);
+void catalog_user_register_user(CatalogUser *catalog_user, User *user, const char *username) {
+    UsersByTotalDistance *users_by_total_distance = lazy_get_raw_value(catalog_user->lazy_users_array);
+    g_ptr_array_add(users_by_total_distance->users, user);
 
     int user_id = catalog_user->user_from_user_id_array->len;
     user_set_id(user, user_id);
     g_ptr_array_set_at_index_safe(catalog_user->user_from_user_id_array, user_id, user);
+
+    // The user references the key of the index, so the username is only stored once.
+    // A repeated username resolves to the last user registered with it
+    uint32_t username_offset = string_index_insert(catalog_user->user_id_from_username_index, username, user_id);
+    user_set_username_offset(user, username_offset);
+}
+
+const char *catalog_user_get_username(CatalogUser *catalog_user, User *user) {
+    return string_heap_get(catalog_user->username_heap, user_get_username_offset(user));
+}
+
+size_t catalog_user_get_usernames_size(CatalogUser *catalog_user) {
+    return string_heap_get_size(catalog_user->username_heap);
 }
 
 User *catalog_user_get_user_by_user_id(CatalogUser *catalog_user, int user_id) {
@@ -72,15 +112,47 @@ User *catalog_user_get_user_by_user_id(CatalogUser *catalog_user, int user_id) {
 }
 
 User *catalog_user_get_user_by_username(CatalogUser *catalog_user, char *username) {
-    return g_hash_table_lookup(catalog_user->user_from_username_hashtable, username);
+    int user_id = string_index_lookup(catalog_user->user_id_from_username_index, username);
+    if (user_id == STRING_INDEX_NOT_FOUND) return NULL;
+
+    return g_ptr_array_index(catalog_user->user_from_user_id_array, user_id);
+}
+
+void catalog_user_get_users_by_usernames(CatalogUser *catalog_user, char **usernames, User **users, guint count) {
+    StringIndex *username_index = catalog_user->user_id_from_username_index;
+    GPtrArray *user_from_user_id_array = catalog_user->user_from_user_id_array;
+
+    // The hashes and then the ids are kept in the users output until the last step
+
+    for (guint i = 0; i < count; i++) {
+        uint32_t hash = string_index_hash(usernames[i]);
+        string_index_prefetch(username_index, hash);
+        users[i] = GUINT_TO_POINTER(hash);
+    }
+
+    for (guint i = 0; i < count; i++) {
+        int user_id = string_index_lookup_with_hash(username_index, usernames[i], GPOINTER_TO_UINT(users[i]));
+        if (user_id != STRING_INDEX_NOT_FOUND) __builtin_prefetch(&user_from_user_id_array->pdata[user_id]);
+        users[i] = GINT_TO_POINTER(user_id);
+    }
+
+    for (guint i = 0; i < count; i++) {
+        int user_id = GPOINTER_TO_INT(users[i]);
+        users[i] = user_id != STRING_INDEX_NOT_FOUND ? g_ptr_array_index(user_from_user_id_array, user_id) : NULL;
+        if (users[i] != NULL) __builtin_prefetch(users[i], 1);
+    }
 }
 
 void catalog_user_force_eager_indexing(CatalogUser *catalog_user) {
     lazy_apply_function(catalog_user->lazy_users_array);
 }
 
+void catalog_user_collect_lazy_indexes(CatalogUser *catalog_user, GPtrArray *lazies) {
+    g_ptr_array_add(lazies, catalog_user->lazy_users_array);
+}
+
 int catalog_user_get_top_n_users(CatalogUser *catalog_user, int n, GPtrArray *result) {
-    GPtrArray *users_array = (GPtrArray *) lazy_get_value(catalog_user->lazy_users_array);
+    GPtrArray *users_array = ((UsersByTotalDistance *) lazy_get_value(catalog_user->lazy_users_array))->users;
     int length = MIN(n, (int) users_array->len);
 
     for (int i = 0; i < length; i++) {
@@ -89,3 +161,56 @@ int catalog_user_get_top_n_users(CatalogUser *catalog_user, int n, GPtrArray *re
 
     return length;
 }
+
+void catalog_user_write_snapshot(CatalogUser *catalog_user, SnapshotWriter *writer, StringPool *name_pool) {
+    GPtrArray *users_array = ((UsersByTotalDistance *) lazy_get_value(catalog_user->lazy_users_array))->users;
+    GPtrArray *user_from_user_id_array = catalog_user->user_from_user_id_array;
+
+    snapshot_write_uint32(writer, user_from_user_id_array->len);
+    for (guint i = 0; i < user_from_user_id_array->len; i++) {
+        User *user = g_ptr_array_index(user_from_user_id_array, i);
+        snapshot_write_string(writer, catalog_user_get_username(catalog_user, user));
+        user_write_snapshot(user, writer, name_pool);
+    }
+
+    for (guint i = 0; i < users_array->len; i++) {
+        snapshot_write_uint32(writer, user_get_id(g_ptr_array_index(users_array, i)));
+    }
+}
+
+gboolean catalog_user_read_snapshot(CatalogUser *catalog_user, SnapshotReader *reader, StringPool *name_pool) {
+    guint users_count = snapshot_read_uint32(reader);
+
+    // Users are written in id order, so registering them generates the same ids
+    for (guint i = 0; i < users_count && !snapshot_reader_has_error(reader); i++) {
+        char *username = snapshot_read_string(reader);
+        User *user = user_read_snapshot(reader, catalog_user->arena, name_pool);
+        if (user == NULL) return FALSE;
+
+        catalog_user_register_user(catalog_user, user, username);
+    }
+
+    // The order must be a permutation of the user ids, each user exactly once
+    GPtrArray *users_array = ((UsersByTotalDistance *) lazy_get_raw_value(catalog_user->lazy_users_array))->users;
+    GPtrArray *user_from_user_id_array = catalog_user->user_from_user_id_array;
+    gboolean *seen_user_ids = calloc(MAX(user_from_user_id_array->len, 1), sizeof(gboolean));
+    gboolean valid_order = users_array->len == user_from_user_id_array->len;
+
+    for (guint i = 0; i < users_array->len && valid_order; i++) {
+        guint user_id = snapshot_read_uint32(reader);
+        if (user_id >= user_from_user_id_array->len || seen_user_ids[user_id]) {
+            valid_order = FALSE;
+            break;
+        }
+
+        seen_user_ids[user_id] = TRUE;
+        users_array->pdata[i] = g_ptr_array_index(user_from_user_id_array, user_id);
+    }
+
+    free(seen_user_ids);
+    if (!valid_order) return FALSE;
+
+    lazy_mark_as_applied(catalog_user->lazy_users_array);
+
+    return !snapshot_reader_has_error(reader);
+}
@@ -1,10 +1,51 @@
+#define _DEFAULT_SOURCE // fileno, fstat and st_mtim are not part of C11
+
 #include "catalog_loader.h"
 
+#include <string.h>
+#include <sys/stat.h>
+
 #include "file_util.h"
 #include "parser.h"
 #include "benchmark.h"
+#include "logger.h"
+
+CatalogLoaderOptions catalog_loader_default_options(void) {
+    return (CatalogLoaderOptions){.io_mode = CATALOG_LOADER_IO_STDIO, .threads = 1};
+}
 
 gboolean catalog_load_csv_dataset(Catalog *catalog, const char *dataset_folder_path) {
+    return catalog_load_csv_dataset_with_options(catalog, dataset_folder_path, catalog_loader_default_options());
+}
+
+/**
+ * Average size of a line of users.csv (our datasets average 70 bytes), used to estimate the number of users from the size of the file.
+ * Underestimating only makes the indexes reserve a bit more space.
+ */
+#define ESTIMATED_USER_LINE_SIZE 64
+
+/**
+ * Returns the size of the file, keeping the current position.
+ */
+static size_t get_file_size(FILE *file) {
+    long position = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, position, SEEK_SET);
+    return size > 0 ? (size_t) size : 0;
+}
+
+/**
+ * Tells the catalog how many users to expect from the size of the users file.
+ */
+static void reserve_users_for_file_size(Catalog *catalog, size_t users_file_size) {
+    catalog_reserve_users(catalog, (guint) (users_file_size / ESTIMATED_USER_LINE_SIZE));
+}
+
+/**
+ * Loads the dataset reading the files line by line with stdio.
+ */
+static gboolean catalog_load_csv_dataset_stdio(Catalog *catalog, const char *dataset_folder_path) {
     FILE *users_file = open_file_folder(dataset_folder_path, "users.csv");
     FILE *drivers_file = open_file_folder(dataset_folder_path, "drivers.csv");
     FILE *rides_file = open_file_folder(dataset_folder_path, "rides.csv");
@@ -13,17 +54,20 @@ gboolean catalog_load_csv_dataset(Catalog *catalog, const char *dataset_folder_p
         return FALSE;
     }
 
+    reserve_users_for_file_size(catalog, get_file_size(users_file));
+
     BENCHMARK_START(load_timer);
     read_csv_file(users_file, parse_and_register_user, catalog);
-    BENCHMARK_END(load_timer, "Load users time: %f seconds\n");
+    BENCHMARK_END_THROUGHPUT(load_timer, "Load users time: %f seconds (%.2f MB/s)\n", ftell(users_file));
 
     g_timer_start(load_timer);
     read_csv_file(drivers_file, parse_and_register_driver, catalog);
-    BENCHMARK_END(load_timer, "Load drivers time: %f seconds\n");
+    BENCHMARK_END_THROUGHPUT(load_timer, "Load drivers time: %f seconds (%.2f MB/s)\n", ftell(drivers_file));
 
     g_timer_start(load_timer);
     read_csv_file(rides_file, parse_and_register_ride, catalog);
-    BENCHMARK_END(load_timer, "Load rides time: %f seconds\n");
+    catalog_flush_pending_rides(catalog);
+    BENCHMARK_END_THROUGHPUT(load_timer, "Load rides time: %f seconds (%.2f MB/s)\n", ftell(rides_file));
 
     fclose(users_file);
     fclose(drivers_file);
@@ -31,3 +75,296 @@ gboolean catalog_load_csv_dataset(Catalog *catalog, const char *dataset_folder_p
 
     return TRUE;
 }
+
+/**
+ * Maps the file with the given name inside of the given folder.
+ * Returns NULL if the file could not be opened.
+ */
+static MappedCsvFile *map_csv_file_folder(const char *dataset_folder_path, const char *file_name) {
+    gchar *file_path = g_build_path(PATH_SEPARATOR, dataset_folder_path, file_name, NULL);
+    MappedCsvFile *file = map_csv_file(file_path);
+    g_free(file_path);
+    return file;
+}
+
+/**
+ * Struct that holds the rides parsed from a chunk of the rides file.
+ */
+typedef struct {
+    GArray *parsed_rides; // GArray of ParsedRide
+    Arena *arena; // Where the rides of the chunk are allocated (arenas can't be shared between threads)
+    Arena *strings; // Copies of the city and username of every ride, freed once the rides are registered
+} ParsedRidesChunk;
+
+/**
+ * Parses a ride line and appends it to the ParsedRidesChunk given as first argument.
+ * This doesn't touch the catalog, so it can run in parallel with other chunks.
+ */
+static void parse_ride_into_chunk(void *chunk, TokenIterator *line_iterator) {
+    ParsedRidesChunk *parsed_rides_chunk = chunk;
+
+    ParsedRide parsed_ride;
+    parsed_ride.ride = parse_line_ride_detailed(line_iterator, &parsed_ride.city, &parsed_ride.user_username, parsed_rides_chunk->arena);
+    if (parsed_ride.ride == NULL) return;
+
+    // The tokens are only valid until the next line
+    parsed_ride.city = arena_strdup(parsed_rides_chunk->strings, parsed_ride.city);
+    parsed_ride.user_username = arena_strdup(parsed_rides_chunk->strings, parsed_ride.user_username);
+
+    g_array_append_val(parsed_rides_chunk->parsed_rides, parsed_ride);
+}
+
+/**
+ * Parses the rides file in `threads` chunks in parallel.
+ * Returns an array with a ParsedRidesChunk per chunk, in file order.
+ * This doesn't touch the catalog, so it can run while users and drivers are still being loaded.
+ */
+static ParsedRidesChunk *parse_rides_in_parallel(MappedCsvFile *rides_file, int threads) {
+    ParsedRidesChunk *chunks = malloc(sizeof(ParsedRidesChunk) * threads);
+    void **chunk_pointers = malloc(sizeof(void *) * threads);
+    for (int i = 0; i < threads; i++) {
+        chunks[i].parsed_rides = g_array_new(FALSE, FALSE, sizeof(ParsedRide));
+        chunks[i].arena = create_arena();
+        chunks[i].strings = create_arena();
+        chunk_pointers[i] = &chunks[i];
+    }
+
+    BENCHMARK_START(parse_timer);
+    read_mapped_csv_file_in_parallel(rides_file, threads, parse_ride_into_chunk, chunk_pointers);
+    BENCHMARK_END(parse_timer, "Parse rides time: %f seconds\n");
+
+    free(chunk_pointers);
+
+    return chunks;
+}
+
+/**
+ * Registers every parsed ride in file order and frees the chunks (the catalog takes their arenas).
+ * Registering in file order keeps the catalog (and every query output) identical to the serial loader:
+ * city ids are assigned in the same order and the rides are stored in the same order, which breaks ties in the indexes.
+ * The accumulators are integers (Money, distances and scores), so their sums don't depend on the order.
+ * Users and drivers must be fully loaded, as rides are joined with them.
+ */
+static void register_parsed_rides(Catalog *catalog, ParsedRidesChunk *chunks, int threads) {
+    BENCHMARK_START(register_timer);
+
+    for (int i = 0; i < threads; i++) {
+        GArray *parsed_rides = chunks[i].parsed_rides;
+        catalog_register_parsed_rides(catalog, (ParsedRide *) parsed_rides->data, parsed_rides->len);
+
+        g_array_free(parsed_rides, TRUE);
+        free_arena(chunks[i].strings);
+        catalog_retain_ride_arena(catalog, chunks[i].arena);
+    }
+
+    free(chunks);
+
+    BENCHMARK_END(register_timer, "Register rides time: %f seconds\n");
+}
+
+/**
+ * Struct that holds the arguments of a thread that loads a whole file into the catalog.
+ */
+typedef struct {
+    Catalog *catalog;
+    MappedCsvFile *file;
+} FileLoaderThreadData;
+
+/**
+ * Thread function that parses and registers every user.
+ */
+static gpointer load_users_thread(gpointer data) {
+    FileLoaderThreadData *loader = data;
+
+    BENCHMARK_START(load_timer);
+    read_mapped_csv_file(loader->file, parse_and_register_user, loader->catalog);
+    BENCHMARK_END_THROUGHPUT(load_timer, "Load users time: %f seconds (%.2f MB/s)\n", mapped_csv_file_get_size(loader->file));
+
+    return NULL;
+}
+
+/**
+ * Thread function that parses and registers every driver.
+ */
+static gpointer load_drivers_thread(gpointer data) {
+    FileLoaderThreadData *loader = data;
+
+    BENCHMARK_START(load_timer);
+    read_mapped_csv_file(loader->file, parse_and_register_driver, loader->catalog);
+    BENCHMARK_END_THROUGHPUT(load_timer, "Load drivers time: %f seconds (%.2f MB/s)\n", mapped_csv_file_get_size(loader->file));
+
+    return NULL;
+}
+
+/**
+ * Loads the three files overlapped:
+ * users and drivers are loaded concurrently by two threads (they touch disjoint parts of the catalog, only drivers register cities),
+ * while the calling thread parses and validates the rides in `threads` chunks.
+ * Once both tables are sealed (the threads are joined) the buffered rides are registered in file order.
+ * The wall-clock time approaches the slowest file plus the ride registration instead of the sum of all files.
+ */
+static void load_mapped_files_pipelined(Catalog *catalog, MappedCsvFile *users_file, MappedCsvFile *drivers_file,
+                                        MappedCsvFile *rides_file, int threads) {
+    FileLoaderThreadData users_loader = {catalog, users_file};
+    FileLoaderThreadData drivers_loader = {catalog, drivers_file};
+
+    GThread *users_thread = g_thread_new("users-loader", load_users_thread, &users_loader);
+    GThread *drivers_thread = g_thread_new("drivers-loader", load_drivers_thread, &drivers_loader);
+
+    ParsedRidesChunk *parsed_rides_chunks = parse_rides_in_parallel(rides_file, threads);
+
+    g_thread_join(users_thread);
+    g_thread_join(drivers_thread);
+
+    register_parsed_rides(catalog, parsed_rides_chunks, threads);
+}
+
+/**
+ * Loads the dataset parsing the lines in place from memory-mapped files.
+ * If threads is higher than 1, the files are loaded overlapped and the rides file is parsed in parallel.
+ */
+static gboolean catalog_load_csv_dataset_mmap(Catalog *catalog, const char *dataset_folder_path, int threads) {
+    MappedCsvFile *users_file = map_csv_file_folder(dataset_folder_path, "users.csv");
+    MappedCsvFile *drivers_file = map_csv_file_folder(dataset_folder_path, "drivers.csv");
+    MappedCsvFile *rides_file = map_csv_file_folder(dataset_folder_path, "rides.csv");
+
+    if (users_file == NULL || drivers_file == NULL || rides_file == NULL) {
+        if (users_file != NULL) free_mapped_csv_file(users_file);
+        if (drivers_file != NULL) free_mapped_csv_file(drivers_file);
+        if (rides_file != NULL) free_mapped_csv_file(rides_file);
+        return FALSE;
+    }
+
+    reserve_users_for_file_size(catalog, mapped_csv_file_get_size(users_file));
+
+    if (threads > 1) {
+        BENCHMARK_START(load_timer);
+        load_mapped_files_pipelined(catalog, users_file, drivers_file, rides_file, threads);
+        BENCHMARK_END(load_timer, "Pipelined load time: %f seconds\n");
+    } else {
+        BENCHMARK_START(load_timer);
+        read_mapped_csv_file(users_file, parse_and_register_user, catalog);
+        BENCHMARK_END_THROUGHPUT(load_timer, "Load users time: %f seconds (%.2f MB/s)\n", mapped_csv_file_get_size(users_file));
+
+        g_timer_start(load_timer);
+        read_mapped_csv_file(drivers_file, parse_and_register_driver, catalog);
+        BENCHMARK_END_THROUGHPUT(load_timer, "Load drivers time: %f seconds (%.2f MB/s)\n", mapped_csv_file_get_size(drivers_file));
+
+        g_timer_start(load_timer);
+        read_mapped_csv_file(rides_file, parse_and_register_ride, catalog);
+        catalog_flush_pending_rides(catalog);
+        BENCHMARK_END_THROUGHPUT(load_timer, "Load rides time: %f seconds (%.2f MB/s)\n", mapped_csv_file_get_size(rides_file));
+    }
+
+    // Nothing borrows from the files (strings are copied to the string heaps and cities by the catalog)
+    free_mapped_csv_file(users_file);
+    free_mapped_csv_file(drivers_file);
+    free_mapped_csv_file(rides_file);
+
+    return TRUE;
+}
+
+gboolean catalog_load_csv_dataset_with_options(Catalog *catalog, const char *dataset_folder_path, CatalogLoaderOptions options) {
+    gboolean loaded;
+
+    if (options.threads > 1) {
+        loaded = catalog_load_csv_dataset_mmap(catalog, dataset_folder_path, options.threads);
+    } else if (options.io_mode == CATALOG_LOADER_IO_MMAP) {
+        loaded = catalog_load_csv_dataset_mmap(catalog, dataset_folder_path, 1);
+    } else {
+        loaded = catalog_load_csv_dataset_stdio(catalog, dataset_folder_path);
+    }
+
+    if (loaded) catalog_log_memory_breakdown(catalog);
+
+    return loaded;
+}
+
+/**
+ * Size of each sample of a dataset file hashed by the fingerprint.
+ */
+#define DATASET_FINGERPRINT_SAMPLE_SIZE (64 * 1024)
+
+/**
+ * Mixes the identity (device and inode), modification time, size and samples of the start, middle and end of the file
+ * into the fingerprint. Any write to the file updates its modification time, even if it keeps the size and the samples.
+ */
+static gboolean fingerprint_dataset_file(const char *dataset_folder_path, const char *file_name, uint64_t *fingerprint) {
+    FILE *file = open_file_folder(dataset_folder_path, file_name);
+    if (file == NULL) return FALSE;
+
+    struct stat file_status;
+    if (fstat(fileno(file), &file_status) != 0) {
+        fclose(file);
+        return FALSE;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+
+    uint64_t file_identity[] = {
+            (uint64_t) file_status.st_dev,
+            (uint64_t) file_status.st_ino,
+            (uint64_t) file_status.st_mtim.tv_sec,
+            (uint64_t) file_status.st_mtim.tv_nsec,
+    };
+
+    uint64_t hash = compute_snapshot_checksum(file_name, strlen(file_name), *fingerprint);
+    hash = compute_snapshot_checksum(file_identity, sizeof(file_identity), hash);
+    hash = compute_snapshot_checksum(&size, sizeof(size), hash);
+
+    char *sample = malloc(DATASET_FINGERPRINT_SAMPLE_SIZE);
+    long sample_offsets[] = {0, size / 2, size - DATASET_FINGERPRINT_SAMPLE_SIZE};
+
+    for (int i = 0; i < 3; i++) {
+        long offset = MAX(sample_offsets[i], 0);
+        fseek(file, offset, SEEK_SET);
+        size_t read = fread(sample, 1, DATASET_FINGERPRINT_SAMPLE_SIZE, file);
+        hash = compute_snapshot_checksum(sample, read, hash);
+    }
+
+    free(sample);
+    fclose(file);
+
+    *fingerprint = hash;
+    return size >= 0;
+}
+
+gboolean compute_dataset_fingerprint(const char *dataset_folder_path, uint64_t *fingerprint) {
+    *fingerprint = 0;
+
+    return fingerprint_dataset_file(dataset_folder_path, "users.csv", fingerprint) &&
+           fingerprint_dataset_file(dataset_folder_path, "drivers.csv", fingerprint) &&
+           fingerprint_dataset_file(dataset_folder_path, "rides.csv", fingerprint);
+}
+
+gboolean catalog_save_snapshot(Catalog *catalog, const char *snapshot_path, const char *dataset_folder_path) {
+    uint64_t fingerprint;
+    if (!compute_dataset_fingerprint(dataset_folder_path, &fingerprint)) return FALSE;
+
+    BENCHMARK_START(save_timer);
+
+    SnapshotWriter *writer = create_snapshot_writer();
+    catalog_write_snapshot(catalog, writer);
+    gboolean saved = snapshot_writer_save(writer, snapshot_path, fingerprint);
+    free_snapshot_writer(writer);
+
+    BENCHMARK_END(save_timer, "Save snapshot time: %f seconds\n");
+
+    return saved;
+}
+
+gboolean catalog_load_snapshot(Catalog *catalog, const char *snapshot_path, const char *dataset_folder_path) {
+    uint64_t fingerprint;
+    if (!compute_dataset_fingerprint(dataset_folder_path, &fingerprint)) return FALSE;
+
+    SnapshotReader *reader = open_snapshot_reader(snapshot_path, fingerprint);
+    if (reader == NULL) return FALSE;
+
+    if (!catalog_read_snapshot(catalog, reader)) {
+        LOG_WARNING_VA("Ignoring snapshot file '%s': it is inconsistent", snapshot_path);
+        return FALSE;
+    }
+
+    return TRUE;
+}
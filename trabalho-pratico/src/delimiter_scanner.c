@@ -0,0 +1,272 @@
+#include "delimiter_scanner.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DELIMITER_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+#define BLOCK_SIZE 64
+
+/**
+ * Struct that holds the bitmasks of a 64 byte block.
+ * Bit i of each mask is set if byte i of the block is the corresponding delimiter.
+ */
+typedef struct {
+    uint64_t semicolons;
+    uint64_t newlines;
+} BlockMasks;
+
+/**
+ * Portable implementation of the block masks.
+ */
+static inline BlockMasks compute_block_masks_scalar(const char *block) {
+    BlockMasks masks = {0, 0};
+
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        masks.semicolons |= (uint64_t) (block[i] == ';') << i;
+        masks.newlines |= (uint64_t) (block[i] == '\n') << i;
+    }
+
+    return masks;
+}
+
+#if DELIMITER_SCANNER_X86
+
+/**
+ * SSE2 implementation of the block masks, compares 16 bytes at a time.
+ */
+__attribute__((target("sse2")))
+static inline BlockMasks compute_block_masks_sse2(const char *block) {
+    const __m128i semicolon = _mm_set1_epi8(';');
+    const __m128i newline = _mm_set1_epi8('\n');
+    BlockMasks masks = {0, 0};
+
+    for (int i = 0; i < BLOCK_SIZE / 16; i++) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) (block + i * 16));
+        masks.semicolons |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, semicolon)) << (i * 16);
+        masks.newlines |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)) << (i * 16);
+    }
+
+    return masks;
+}
+
+/**
+ * AVX2 implementation of the block masks, compares 32 bytes at a time.
+ */
+__attribute__((target("avx2")))
+static inline BlockMasks compute_block_masks_avx2(const char *block) {
+    const __m256i semicolon = _mm256_set1_epi8(';');
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    __m256i low = _mm256_loadu_si256((const __m256i *) block);
+    __m256i high = _mm256_loadu_si256((const __m256i *) (block + 32));
+
+    BlockMasks masks;
+    masks.semicolons = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, semicolon))
+                       | (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, semicolon)) << 32;
+    masks.newlines = (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline))
+                     | (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)) << 32;
+
+    return masks;
+}
+
+#endif
+
+/**
+ * State of the line that is being scanned.
+ */
+typedef struct {
+    size_t line_start;
+    uint32_t token_ends[DELIMITER_SCANNER_MAX_TOKENS];
+    int token_count;
+} LineScanState;
+
+/**
+ * Walks the set bits of the masks of a block, filling the token table and emitting every complete line.
+ */
+static inline void process_block_masks(BlockMasks masks, const char *data, size_t block_offset, LineScanState *state,
+                                       ScannedLineFunction *scanned_line_function, void *arg) {
+    uint64_t delimiters = masks.semicolons | masks.newlines;
+
+    while (delimiters != 0) {
+        int bit = __builtin_ctzll(delimiters);
+        size_t position = block_offset + bit;
+        uint32_t offset = (uint32_t) (position - state->line_start);
+
+        if (state->token_count < DELIMITER_SCANNER_MAX_TOKENS) {
+            state->token_ends[state->token_count++] = offset;
+        }
+
+        if ((masks.newlines >> bit) & 1) {
+            scanned_line_function(arg, data + state->line_start, offset, state->token_ends, state->token_count);
+            state->line_start = position + 1;
+            state->token_count = 0;
+        }
+
+        delimiters &= delimiters - 1; // clear lowest set bit
+    }
+}
+
+/**
+ * Generic scanning loop. Always inlined so each implementation gets its own copy with the mask function inlined.
+ * The last partial block is copied into a zero padded buffer, so no byte past the end of the data is ever read.
+ */
+__attribute__((always_inline))
+static inline size_t scan_csv_lines_generic(BlockMasks (*compute_block_masks)(const char *), const char *data, size_t length,
+                                            ScannedLineFunction *scanned_line_function, void *arg) {
+    LineScanState state = {.line_start = 0, .token_count = 0};
+
+    size_t block_offset = 0;
+    for (; block_offset + BLOCK_SIZE <= length; block_offset += BLOCK_SIZE) {
+        BlockMasks masks = compute_block_masks(data + block_offset);
+        process_block_masks(masks, data, block_offset, &state, scanned_line_function, arg);
+    }
+
+    if (block_offset < length) {
+        char tail[BLOCK_SIZE] = {0};
+        memcpy(tail, data + block_offset, length - block_offset);
+
+        BlockMasks masks = compute_block_masks(tail);
+        process_block_masks(masks, data, block_offset, &state, scanned_line_function, arg);
+    }
+
+    return state.line_start;
+}
+
+static size_t scan_csv_lines_scalar(const char *data, size_t length, ScannedLineFunction *scanned_line_function, void *arg) {
+    return scan_csv_lines_generic(compute_block_masks_scalar, data, length, scanned_line_function, arg);
+}
+
+#if DELIMITER_SCANNER_X86
+
+__attribute__((target("sse2")))
+static size_t scan_csv_lines_sse2(const char *data, size_t length, ScannedLineFunction *scanned_line_function, void *arg) {
+    return scan_csv_lines_generic(compute_block_masks_sse2, data, length, scanned_line_function, arg);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_csv_lines_avx2(const char *data, size_t length, ScannedLineFunction *scanned_line_function, void *arg) {
+    return scan_csv_lines_generic(compute_block_masks_avx2, data, length, scanned_line_function, arg);
+}
+
+#endif
+
+gboolean is_delimiter_scanner_implementation_supported(DelimiterScannerImplementation implementation) {
+    switch (implementation) {
+        case DELIMITER_SCANNER_SCALAR:
+            return TRUE;
+#if DELIMITER_SCANNER_X86
+        case DELIMITER_SCANNER_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case DELIMITER_SCANNER_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return FALSE;
+    }
+}
+
+DelimiterScannerImplementation get_best_delimiter_scanner_implementation(void) {
+    // Racing threads (e.g. the chunk readers) compute and store the same value, so relaxed ordering is enough
+    static atomic_int best_implementation = -1;
+
+    int implementation = atomic_load_explicit(&best_implementation, memory_order_relaxed);
+    if (implementation == -1) {
+        if (is_delimiter_scanner_implementation_supported(DELIMITER_SCANNER_AVX2)) {
+            implementation = DELIMITER_SCANNER_AVX2;
+        } else if (is_delimiter_scanner_implementation_supported(DELIMITER_SCANNER_SSE2)) {
+            implementation = DELIMITER_SCANNER_SSE2;
+        } else {
+            implementation = DELIMITER_SCANNER_SCALAR;
+        }
+        atomic_store_explicit(&best_implementation, implementation, memory_order_relaxed);
+    }
+
+    return (DelimiterScannerImplementation) implementation;
+}
+
+size_t scan_csv_lines_with_implementation(DelimiterScannerImplementation implementation, const char *data, size_t length,
+                                          ScannedLineFunction *scanned_line_function, void *arg) {
+    switch (implementation) {
+#if DELIMITER_SCANNER_X86
+        case DELIMITER_SCANNER_SSE2:
+            return scan_csv_lines_sse2(data, length, scanned_line_function, arg);
+        case DELIMITER_SCANNER_AVX2:
+            return scan_csv_lines_avx2(data, length, scanned_line_function, arg);
+#endif
+        default:
+            return scan_csv_lines_scalar(data, length, scanned_line_function, arg);
+    }
+}
+
+size_t scan_csv_lines(const char *data, size_t length, ScannedLineFunction *scanned_line_function, void *arg) {
+    return scan_csv_lines_with_implementation(get_best_delimiter_scanner_implementation(), data, length,
+                                              scanned_line_function, arg);
+}
+
+#if DELIMITER_SCANNER_X86
+
+/**
+ * Returns the mask of the bytes of the aligned 16 byte chunk that are equal to any of the given characters.
+ */
+__attribute__((target("sse2")))
+static inline uint32_t match_aligned_chunk_sse2(const char *chunk, char first, char second, char third) {
+    __m128i bytes = _mm_load_si128((const __m128i *) chunk);
+    __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(first)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(second)),
+                                                _mm_cmpeq_epi8(bytes, _mm_set1_epi8(third))));
+    return (uint32_t) _mm_movemask_epi8(matches);
+}
+
+#endif
+
+/**
+ * Adds the delimiter found by `scan_csv_line` to the token table.
+ * Returns TRUE if the delimiter ends the line.
+ */
+static inline gboolean add_line_token_end(const char *line, const char *delimiter, uint32_t *token_ends, int *token_count) {
+    if (*token_count < DELIMITER_SCANNER_MAX_TOKENS) {
+        token_ends[(*token_count)++] = (uint32_t) (delimiter - line);
+    }
+
+    return *delimiter != ';';
+}
+
+int scan_csv_line(const char *line, uint32_t *token_ends) {
+    int token_count = 0;
+    const char *current = line;
+
+#if DELIMITER_SCANNER_X86
+    // The bytes before the first aligned chunk are checked one by one, so no byte before the line is read
+    for (; ((uintptr_t) current & (DELIMITER_SCANNER_ALIGNMENT - 1)) != 0; current++) {
+        if (*current == ';' || *current == '\n' || *current == '\0') {
+            if (add_line_token_end(line, current, token_ends, &token_count)) return token_count;
+        }
+    }
+
+    // The last chunk read is the one with the terminator, which the caller padded
+    for (;; current += DELIMITER_SCANNER_ALIGNMENT) {
+        uint32_t mask = match_aligned_chunk_sse2(current, ';', '\n', '\0');
+
+        while (mask != 0) {
+            if (add_line_token_end(line, current + __builtin_ctz(mask), token_ends, &token_count)) return token_count;
+            mask &= mask - 1;
+        }
+    }
+#else
+    for (;; current++) {
+        if (*current == ';' || *current == '\n' || *current == '\0') {
+            if (add_line_token_end(line, current, token_ends, &token_count)) return token_count;
+        }
+    }
+#endif
+}
+
+char *find_delimiter_or_end(char *string, char delimiter) {
+    // Any string can be given, so it can't be read in chunks past its terminator (strcspn is vectorized by the C library)
+    const char delimiters[] = {delimiter, '\0'};
+    return string + strcspn(string, delimiters);
+}
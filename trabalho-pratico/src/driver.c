@@ -7,13 +7,13 @@
  * Struct that represents a driver.
  */
 struct Driver {
-    char *name;
     // char *license_plate;
-    double total_earned;
+    Money total_earned;
     Date birthdate;
     Date last_ride_date;
     Date account_creation_date;
     int32_t id;
+    uint32_t name_id; // Id of the name in the string pool of the catalog
     uint16_t accumulated_score;
     uint8_t city_id;
     uint8_t rides_amount;
@@ -22,11 +22,12 @@ struct Driver {
     CarClass car_class;
 };
 
-Driver *create_driver(int id, char *name, Date birth_date, Gender gender, CarClass car_class, const char *license_plate,
-                      Date account_creation_date, AccountStatus account_status) {
-    Driver *driver = malloc(sizeof(Driver));
+Driver *create_driver(int id, uint32_t name_id, Date birth_date, Gender gender, CarClass car_class, const char *license_plate,
+                      Date account_creation_date, AccountStatus account_status, Arena *arena) {
+    Driver *driver = arena != NULL ? arena_alloc(arena, sizeof(Driver)) : malloc(sizeof(Driver));
+
     driver->id = id;
-    driver->name = g_strdup(name);
+    driver->name_id = name_id;
     driver->birthdate = birth_date;
     driver->gender = gender;
     driver->car_class = car_class;
@@ -42,11 +43,11 @@ Driver *create_driver(int id, char *name, Date birth_date, Gender gender, CarCla
     return driver;
 }
 
-Driver *parse_line_driver(TokenIterator *line_iterator) {
-    return parse_line_driver_detailed(line_iterator, NULL);
+Driver *parse_line_driver(TokenIterator *line_iterator, Arena *arena) {
+    return parse_line_driver_detailed(line_iterator, NULL, NULL, arena);
 }
 
-Driver *parse_line_driver_detailed(TokenIterator *line_iterator, char **parsed_city) {
+Driver *parse_line_driver_detailed(TokenIterator *line_iterator, char **parsed_city, StringPool *name_pool, Arena *arena) {
     char *id_string = token_iterator_next(line_iterator);
     if (IS_EMPTY(id_string)) return NULL;
 
@@ -84,7 +85,8 @@ Driver *parse_line_driver_detailed(TokenIterator *line_iterator, char **parsed_c
 
     if (parsed_city) *parsed_city = city;
 
-    return create_driver(id, name, date, gender, car_class, license_plate, creation_date, acc_status);
+    uint32_t name_id = name_pool != NULL ? string_pool_intern(name_pool, name) : 0;
+    return create_driver(id, name_id, date, gender, car_class, license_plate, creation_date, acc_status, arena);
 }
 
 void driver_set_city_id(Driver *driver, int city_id) {
@@ -95,8 +97,8 @@ int driver_get_id(Driver *driver) {
     return driver->id;
 }
 
-char *driver_get_name(Driver *driver) {
-    return g_strdup(driver->name);
+uint32_t driver_get_name_id(Driver *driver) {
+    return driver->name_id;
 }
 
 int driver_get_city_id(Driver *driver) {
@@ -135,7 +137,7 @@ void driver_add_score(Driver *driver, int score) {
     driver->accumulated_score += score;
 }
 
-void driver_add_earned(Driver *driver, double earned) {
+void driver_add_earned(Driver *driver, Money earned) {
     driver->total_earned += earned;
 }
 
@@ -147,7 +149,7 @@ double driver_get_average_score(Driver *driver) {
     return (double) driver->accumulated_score / (double) driver->rides_amount;
 }
 
-double driver_get_total_earned(Driver *driver) {
+Money driver_get_total_earned(Driver *driver) {
     return driver->total_earned;
 }
 
@@ -158,10 +160,82 @@ void driver_register_ride_date(Driver *driver, Date date) {
 }
 
 void free_driver(void *driver) {
-    Driver *actual_driver = (Driver *) driver;
-    free(actual_driver->name);
-    // free(actual_driver->license_plate);
-    free(actual_driver);
+    // free(driver->license_plate);
+    free(driver);
+}
+
+void driver_write_snapshot(Driver *driver, SnapshotWriter *writer, StringPool *name_pool) {
+    snapshot_write_uint32(writer, string_pool_get_snapshot_id(name_pool, driver->name_id));
+    snapshot_write_int64(writer, driver->total_earned);
+    snapshot_write_uint32(writer, driver->birthdate.encoded_date);
+    snapshot_write_uint32(writer, driver->last_ride_date.encoded_date);
+    snapshot_write_uint32(writer, driver->account_creation_date.encoded_date);
+    snapshot_write_int32(writer, driver->id);
+    snapshot_write_uint16(writer, driver->accumulated_score);
+    snapshot_write_uint8(writer, driver->city_id);
+    snapshot_write_uint8(writer, driver->rides_amount);
+    snapshot_write_uint8(writer, driver->account_status);
+    snapshot_write_uint8(writer, driver->gender);
+    snapshot_write_uint8(writer, driver->car_class);
+}
+
+Driver *driver_read_snapshot(SnapshotReader *reader, Arena *arena, StringPool *name_pool) {
+    uint32_t name_id = snapshot_read_uint32(reader);
+    if (!string_pool_is_valid_id(name_pool, name_id)) return NULL;
+
+    Driver *driver = arena != NULL ? arena_alloc(arena, sizeof(Driver)) : malloc(sizeof(Driver));
+
+    driver->name_id = name_id;
+    driver->total_earned = snapshot_read_int64(reader);
+    driver->birthdate.encoded_date = snapshot_read_uint32(reader);
+    driver->last_ride_date.encoded_date = snapshot_read_uint32(reader);
+    driver->account_creation_date.encoded_date = snapshot_read_uint32(reader);
+    driver->id = snapshot_read_int32(reader);
+    driver->accumulated_score = snapshot_read_uint16(reader);
+    driver->city_id = snapshot_read_uint8(reader);
+    driver->rides_amount = snapshot_read_uint8(reader);
+    driver->account_status = snapshot_read_uint8(reader);
+    driver->gender = snapshot_read_uint8(reader);
+    driver->car_class = snapshot_read_uint8(reader);
+
+    return driver;
+}
+
+/**
+ * Fraction bits of the average score in `driver_get_score_sort_key`.
+ * Averages of different fractions with at most 255 rides differ by at least 1/255², which is more than 2/2^17,
+ * so truncating them to 17 fraction bits keeps them different (and in the same order).
+ */
+#define DRIVER_SCORE_KEY_FRACTION_BITS 17
+
+/**
+ * Bits of the average score (16 integer bits of the accumulated score and the fraction bits) and of the date
+ * in `driver_get_score_sort_key`.
+ */
+#define DRIVER_SCORE_KEY_SCORE_BITS (16 + DRIVER_SCORE_KEY_FRACTION_BITS)
+#define DRIVER_SCORE_KEY_DATE_BITS 24
+
+uint64_t driver_get_score_sort_key(gconstpointer driver, gpointer data) {
+    (void) data;
+    const Driver *actual_driver = driver;
+
+    // Without rides the average is NaN, which `compare_drivers_by_score` never orders by score,
+    // but by last ride date (no date), after the drivers with rides: the lowest score does the same
+    uint64_t average_score = 0;
+    if (actual_driver->rides_amount > 0)
+        average_score = ((uint64_t) actual_driver->accumulated_score << DRIVER_SCORE_KEY_FRACTION_BITS) / actual_driver->rides_amount;
+
+    // Higher scores and later dates first, so both are inverted
+    uint64_t inverted_score = ((UINT64_C(1) << DRIVER_SCORE_KEY_SCORE_BITS) - 1) - average_score;
+    uint64_t inverted_date = ((UINT64_C(1) << DRIVER_SCORE_KEY_DATE_BITS) - 1) - actual_driver->last_ride_date.encoded_date;
+
+    return (uint64_t) actual_driver->account_status << (DRIVER_SCORE_KEY_SCORE_BITS + DRIVER_SCORE_KEY_DATE_BITS)
+           | inverted_score << DRIVER_SCORE_KEY_DATE_BITS | inverted_date;
+}
+
+uint64_t driver_get_id_sort_key(gconstpointer driver, gpointer data) {
+    (void) data;
+    return (uint64_t) ((int64_t) ((const Driver *) driver)->id - INT32_MIN);
 }
 
 int compare_drivers_by_score(const void *a, const void *b) {
@@ -11,8 +11,8 @@ struct DriverCityInfo {
     u_int16_t amount_rides;
 };
 
-DriverCityInfo *create_driver_city_info(int id) {
-    DriverCityInfo *driver_by_city = malloc(sizeof(struct DriverCityInfo));
+DriverCityInfo *create_driver_city_info(int id, Arena *arena) {
+    DriverCityInfo *driver_by_city = arena != NULL ? arena_alloc(arena, sizeof(struct DriverCityInfo)) : malloc(sizeof(struct DriverCityInfo));
     driver_by_city->id = id;
     driver_by_city->accumulated_score = 0;
     driver_by_city->amount_rides = 0;
@@ -36,6 +36,20 @@ void free_driver_city_info_voidp(void *driver_city_info) {
     free(driver_city_info);
 }
 
+void driver_city_info_write_snapshot(DriverCityInfo *driver_city_info, SnapshotWriter *writer) {
+    snapshot_write_int32(writer, driver_city_info->id);
+    snapshot_write_uint16(writer, driver_city_info->accumulated_score);
+    snapshot_write_uint16(writer, driver_city_info->amount_rides);
+}
+
+DriverCityInfo *driver_city_info_read_snapshot(SnapshotReader *reader, Arena *arena) {
+    DriverCityInfo *driver_city_info = arena != NULL ? arena_alloc(arena, sizeof(struct DriverCityInfo)) : malloc(sizeof(struct DriverCityInfo));
+    driver_city_info->id = snapshot_read_int32(reader);
+    driver_city_info->accumulated_score = snapshot_read_uint16(reader);
+    driver_city_info->amount_rides = snapshot_read_uint16(reader);
+    return driver_city_info;
+}
+
 int compare_driver_city_infos_by_average_score(const void *a_driver_city_info, const void *b_driver_city_info) {
     DriverCityInfo *a_dci = *(DriverCityInfo **) a_driver_city_info;
     DriverCityInfo *b_dci = *(DriverCityInfo **) b_driver_city_info;
@@ -1,5 +1,10 @@
+#define _DEFAULT_SOURCE // fileno, write and stat are not part of C11
+
 #include "file_util.h"
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "logger.h"
 #include "terminal_colors.h"
 #include <glib.h>
@@ -39,3 +44,21 @@ FILE *create_command_output_file(int command_number) {
     g_free(filename);
     return output;
 }
+
+void write_all_to_file(FILE *file, const char *data, size_t size) {
+    int file_descriptor = fileno(file);
+
+    size_t written = 0;
+    while (written < size) {
+        ssize_t result = write(file_descriptor, data + written, size - written);
+        if (result <= 0) break; // Nothing else can be done about a failed write
+        written += result;
+    }
+}
+
+int64_t get_file_modification_time(const char *file_path) {
+    struct stat file_stat;
+    if (stat(file_path, &file_stat) != 0) return -1;
+
+    return (int64_t) file_stat.st_mtim.tv_sec * 1000000000 + file_stat.st_mtim.tv_nsec;
+}
@@ -1,20 +1,24 @@
 #include "lazy.h"
 #include "benchmark.h"
 
+#include <stdatomic.h>
+
 /**
  * Struct that represents a lazy.
  */
 struct Lazy {
     void *value;
     ApplyFunction function_to_apply;
-    gboolean function_applied;
+    atomic_bool function_applied; // Set (with release) after the function was applied, read by the fast path
+    gsize once; // g_once_init_enter/leave location: only one thread applies the function, the others wait for it
 };
 
 Lazy *lazy_of(void *value, ApplyFunction func) {
     Lazy *lazy = malloc(sizeof(struct Lazy));
     lazy->value = value;
     lazy->function_to_apply = func;
-    lazy->function_applied = FALSE;
+    atomic_init(&lazy->function_applied, FALSE);
+    lazy->once = 0;
     return lazy;
 }
 
@@ -27,12 +31,32 @@ void *lazy_get_value(Lazy *lazy) {
     return lazy->value;
 }
 
+gboolean lazy_try_get(Lazy *lazy, void **value) {
+    if (!atomic_load_explicit(&lazy->function_applied, memory_order_acquire)) return FALSE;
+
+    *value = lazy->value;
+    return TRUE;
+}
+
 void lazy_apply_function(Lazy *lazy) {
-    if (!lazy->function_applied) {
+    // Fast path: once applied, the value is ready and visible after the acquire load
+    if (G_LIKELY(atomic_load_explicit(&lazy->function_applied, memory_order_acquire))) return;
+
+    // Slow path: the first thread applies the function, the others block in g_once_init_enter until it is done
+    // (which returns FALSE with acquire semantics, so they see the value written by the function)
+    if (g_once_init_enter(&lazy->once)) {
         if (lazy->function_to_apply != NULL) {
             lazy->function_to_apply(lazy->value);
         }
-        lazy->function_applied = TRUE;
+        atomic_store_explicit(&lazy->function_applied, TRUE, memory_order_release);
+        g_once_init_leave(&lazy->once, 1);
+    }
+}
+
+void lazy_mark_as_applied(Lazy *lazy) {
+    if (g_once_init_enter(&lazy->once)) {
+        atomic_store_explicit(&lazy->function_applied, TRUE, memory_order_release);
+        g_once_init_leave(&lazy->once, 1);
     }
 }
 
@@ -0,0 +1,248 @@
+#define _DEFAULT_SOURCE // fseeko and ftello are not part of C11
+
+#include "output_container.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file_util.h"
+#include "logger.h"
+
+/**
+ * Magic at the start and at the end of a container file.
+ */
+#define OUTPUT_CONTAINER_MAGIC "LI3OUTC\n"
+#define OUTPUT_CONTAINER_MAGIC_SIZE 8
+
+/**
+ * Size of the stdio buffer of the container file, so the output of many small commands is written in big writes.
+ */
+#define OUTPUT_CONTAINER_FILE_BUFFER_SIZE (256 * 1024)
+
+/**
+ * Size of the chunks of the output writers of the commands.
+ */
+#define OUTPUT_CONTAINER_CHUNK_SIZE (64 * 1024)
+
+/**
+ * Struct that represents a segment of the output of a command, as written in the index.
+ */
+typedef struct {
+    int32_t command_number;
+    uint32_t padding;
+    uint64_t offset;
+    uint64_t size;
+} OutputContainerSegment;
+
+/**
+ * Struct that represents the trailer at the end of a container file.
+ */
+typedef struct {
+    uint64_t index_offset;
+    uint64_t segment_count;
+    char magic[OUTPUT_CONTAINER_MAGIC_SIZE];
+} OutputContainerTrailer;
+
+/**
+ * Struct that represents a container file being written.
+ */
+struct OutputContainerWriter {
+    FILE *file;
+    char *file_path;
+    char *file_buffer;
+    gboolean write_failed; // Set when any write fails, the file is removed when the writer is closed
+    uint64_t position; // Offset where the next output is appended
+    GArray *segments; // GArray of OutputContainerSegment
+    GMutex mutex;
+};
+
+/**
+ * Struct that represents the target of the output writer of a command.
+ */
+typedef struct {
+    OutputContainerWriter *container_writer;
+    int command_number;
+} OutputContainerCommand;
+
+/**
+ * Writes data to the container file, recording the failure if not everything was written.
+ */
+static void output_container_write(OutputContainerWriter *container_writer, const void *data, size_t size, size_t count) {
+    if (fwrite(data, size, count, container_writer->file) != count) container_writer->write_failed = TRUE;
+}
+
+OutputContainerWriter *create_output_container_writer(const char *file_path) {
+    FILE *file = fopen(file_path, "wb");
+    if (file == NULL) {
+        LOG_WARNING_VA("Could not create the container file '%s'", file_path);
+        return NULL;
+    }
+
+    OutputContainerWriter *container_writer = malloc(sizeof(OutputContainerWriter));
+    container_writer->file = file;
+    container_writer->file_path = g_strdup(file_path);
+    container_writer->file_buffer = malloc(OUTPUT_CONTAINER_FILE_BUFFER_SIZE);
+    container_writer->write_failed = FALSE;
+    setvbuf(file, container_writer->file_buffer, _IOFBF, OUTPUT_CONTAINER_FILE_BUFFER_SIZE);
+
+    output_container_write(container_writer, OUTPUT_CONTAINER_MAGIC, 1, OUTPUT_CONTAINER_MAGIC_SIZE);
+    container_writer->position = OUTPUT_CONTAINER_MAGIC_SIZE;
+    container_writer->segments = g_array_new(FALSE, FALSE, sizeof(OutputContainerSegment));
+    g_mutex_init(&container_writer->mutex);
+
+    return container_writer;
+}
+
+void output_container_append(OutputContainerWriter *container_writer, int command_number, const char *data, size_t size) {
+    g_mutex_lock(&container_writer->mutex);
+
+    output_container_write(container_writer, data, 1, size);
+
+    GArray *segments = container_writer->segments;
+    OutputContainerSegment *last = segments->len > 0 ? &g_array_index(segments, OutputContainerSegment, segments->len - 1) : NULL;
+
+    if (last != NULL && last->command_number == command_number) {
+        last->size += size; // Continues the previous segment, as nothing was written in between
+    } else {
+        OutputContainerSegment segment = {command_number, 0, container_writer->position, size};
+        g_array_append_val(segments, segment);
+    }
+    container_writer->position += size;
+
+    g_mutex_unlock(&container_writer->mutex);
+}
+
+/**
+ * Appends a chunk of the output of a command to the container.
+ */
+static void hand_off_output_container_chunk(void *target, char *data, size_t size, gboolean is_last) {
+    OutputContainerCommand *command = target;
+
+    output_container_append(command->container_writer, command->command_number, data, size);
+    free(data);
+
+    if (is_last) free(command);
+}
+
+OutputWriter *output_container_create_command_writer(OutputContainerWriter *container_writer, int command_number) {
+    OutputContainerCommand *command = malloc(sizeof(OutputContainerCommand));
+    command->container_writer = container_writer;
+    command->command_number = command_number;
+
+    return create_chunked_output_writer(command, hand_off_output_container_chunk, OUTPUT_CONTAINER_CHUNK_SIZE);
+}
+
+gboolean close_output_container_writer(OutputContainerWriter *container_writer) {
+    GArray *segments = container_writer->segments;
+    output_container_write(container_writer, segments->data, sizeof(OutputContainerSegment), segments->len);
+
+    OutputContainerTrailer trailer = {container_writer->position, segments->len, {0}};
+    memcpy(trailer.magic, OUTPUT_CONTAINER_MAGIC, OUTPUT_CONTAINER_MAGIC_SIZE);
+    output_container_write(container_writer, &trailer, sizeof(OutputContainerTrailer), 1);
+
+    if (fclose(container_writer->file) != 0) container_writer->write_failed = TRUE;
+
+    if (container_writer->write_failed) {
+        // The offsets in the index no longer match the file, so don't leave a container that looks valid
+        LOG_WARNING_VA("Could not write the container file '%s'", container_writer->file_path);
+        remove(container_writer->file_path);
+    }
+
+    gboolean success = !container_writer->write_failed;
+
+    g_free(container_writer->file_path);
+    free(container_writer->file_buffer);
+    g_array_free(segments, TRUE);
+    g_mutex_clear(&container_writer->mutex);
+    free(container_writer);
+
+    return success;
+}
+
+/**
+ * Reads the index of the container file.
+ * Returns NULL (and logs a warning) if the file is not a valid container.
+ */
+static OutputContainerSegment *read_output_container_index(FILE *file, const char *file_path, uint64_t *segment_count) {
+    OutputContainerTrailer trailer;
+    off_t file_size = 0;
+
+    gboolean valid = fseeko(file, 0, SEEK_END) == 0 && (file_size = ftello(file)) >= (off_t) sizeof(OutputContainerTrailer)
+                     && fseeko(file, file_size - (off_t) sizeof(OutputContainerTrailer), SEEK_SET) == 0
+                     && fread(&trailer, sizeof(OutputContainerTrailer), 1, file) == 1
+                     && memcmp(trailer.magic, OUTPUT_CONTAINER_MAGIC, OUTPUT_CONTAINER_MAGIC_SIZE) == 0
+                     && trailer.index_offset >= OUTPUT_CONTAINER_MAGIC_SIZE
+                     && trailer.segment_count <= (uint64_t) file_size / sizeof(OutputContainerSegment)
+                     && trailer.index_offset + trailer.segment_count * sizeof(OutputContainerSegment) + sizeof(OutputContainerTrailer) == (uint64_t) file_size;
+
+    OutputContainerSegment *segments = NULL;
+    if (valid) {
+        segments = malloc(sizeof(OutputContainerSegment) * MAX(trailer.segment_count, 1));
+        valid = fseeko(file, (off_t) trailer.index_offset, SEEK_SET) == 0
+                && fread(segments, sizeof(OutputContainerSegment), trailer.segment_count, file) == trailer.segment_count;
+    }
+
+    for (uint64_t i = 0; valid && i < trailer.segment_count; i++) {
+        valid = segments[i].offset >= OUTPUT_CONTAINER_MAGIC_SIZE && segments[i].size <= trailer.index_offset
+                && segments[i].offset <= trailer.index_offset - segments[i].size;
+    }
+
+    if (!valid) {
+        LOG_WARNING_VA("'%s' is not a valid container file", file_path);
+        free(segments);
+        return NULL;
+    }
+
+    *segment_count = trailer.segment_count;
+    return segments;
+}
+
+gboolean read_output_container_command(const char *file_path, int command_number, char **output, size_t *size) {
+    FILE *file = fopen(file_path, "rb");
+    if (file == NULL) {
+        LOG_WARNING_VA("Could not open container file '%s'", file_path);
+        return FALSE;
+    }
+
+    uint64_t segment_count;
+    OutputContainerSegment *segments = read_output_container_index(file, file_path, &segment_count);
+    if (segments == NULL) {
+        fclose(file);
+        return FALSE;
+    }
+
+    gboolean found = FALSE;
+    size_t output_size = 0;
+    for (uint64_t i = 0; i < segment_count; i++) {
+        if (segments[i].command_number != command_number) continue;
+        found = TRUE;
+        output_size += segments[i].size;
+    }
+
+    char *buffer = found ? malloc(output_size + 1) : NULL;
+    size_t read = 0;
+    for (uint64_t i = 0; found && i < segment_count; i++) {
+        if (segments[i].command_number != command_number) continue;
+
+        if (fseeko(file, (off_t) segments[i].offset, SEEK_SET) != 0 || fread(buffer + read, 1, segments[i].size, file) != segments[i].size) {
+            LOG_WARNING_VA("Could not read the output of command %d from '%s'", command_number, file_path);
+            found = FALSE;
+        }
+        read += segments[i].size;
+    }
+
+    free(segments);
+    fclose(file);
+
+    if (!found) {
+        free(buffer);
+        return FALSE;
+    }
+
+    buffer[output_size] = '\0';
+    *output = buffer;
+    *size = output_size;
+    return TRUE;
+}
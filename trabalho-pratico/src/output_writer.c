@@ -1,177 +1,301 @@
+#include <math.h>
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <glib.h>
 
+#include "file_util.h"
 #include "output_writer.h"
 
 /**
- * Struct that represents a buffer.
+ * Size of the buffer of file writers, written to the file in one call when full.
  */
-typedef struct {
-    char *value;
-    size_t buffer_size;
-    size_t buffer_capacity;
-} Buffer;
+#define OUTPUT_WRITER_FILE_BUFFER_SIZE (256 * 1024)
 
 /**
- * Initializes a new buffer.
+ * Initial size of the buffer of array writers, which grows to fit the longest line.
  */
-Buffer init_buffer(void) {
-    Buffer buffer;
-    buffer.value = NULL;
-    buffer.buffer_size = 0;
-    buffer.buffer_capacity = 0;
-    return buffer;
-}
+#define OUTPUT_WRITER_ARRAY_BUFFER_SIZE 1024
 
 /**
- * Resets the buffer.
+ * Space reserved for a token formatted by the printf-style functions before its real size is known.
  */
-void reset_buffer(Buffer *buffer) {
-    if (buffer->value) {
-        buffer->value[0] = '\0';
-        buffer->buffer_size = 0;
-    }
-}
+#define OUTPUT_WRITER_FORMATTED_TOKEN_SIZE 1024
 
 /**
- * Appends the given string to the buffer.
+ * Doubles with a magnitude below this are formatted by `writer_write_fixed_3_token` without printf
+ * (their thousandths fit exactly in a double).
  */
-void append_to_buffer(Buffer *buffer, char *string) {
-    if (!buffer->value) {
-        buffer->value = malloc(1024);
-        buffer->buffer_capacity = 1024;
-        reset_buffer(buffer);
-    }
-
-    int string_size = strlen(string);
+#define OUTPUT_WRITER_MAX_FAST_DOUBLE 1e12
 
-    while (buffer->buffer_size + string_size + 1 >= buffer->buffer_capacity) {
-        buffer->buffer_capacity *= 2;
-        buffer->value = realloc(buffer->value, buffer->buffer_capacity);
-    }
+/**
+ * Struct that represents an output writer.
+ */
+struct OutputWriter {
+    void *target;
+    void (*flush)(OutputWriter *); // Empties the buffer into the target, NULL if the buffer grows instead
+    void (*end_line)(OutputWriter *); // Called after a line is ended (and its newline written), may be NULL
+    OutputWriterChunkFunction hand_off_chunk; // Takes the buffer of chunked writers, NULL for other writers
 
-    while (*string) {
-        buffer->value[buffer->buffer_size++] = *string++;
-    }
+    char *buffer;
+    size_t size;
+    size_t capacity;
 
-    buffer->value[buffer->buffer_size] = '\0';
-}
+    gboolean discards_output;
+    gboolean line_has_tokens; // Whether the next token needs a separator
+};
 
 /**
- * Frees the buffer.
+ * Makes space for `length` more bytes in the buffer, flushing or growing it.
+ * Returns where the bytes should be written.
  */
-void free_buffer(Buffer *buffer) {
-    if (buffer->value) {
-        free(buffer->value);
+static inline char *writer_reserve(OutputWriter *output_writer, size_t length) {
+    if (G_UNLIKELY(output_writer->size + length > output_writer->capacity)) {
+        if (output_writer->flush) output_writer->flush(output_writer);
+
+        if (output_writer->size + length > output_writer->capacity) {
+            output_writer->capacity = MAX(output_writer->capacity * 2, output_writer->size + length);
+            output_writer->buffer = realloc(output_writer->buffer, output_writer->capacity);
+        }
     }
+
+    return output_writer->buffer + output_writer->size;
 }
 
 /**
- * Struct that represents an output writer.
+ * Appends the bytes to the buffer.
  */
-struct OutputWriter {
-    void *target;
-    void (*write_token)(OutputWriter *, const char *, va_list);
-    void (*write_token_end)(OutputWriter *, const char *, va_list);
-
-    Buffer buffer;
-};
+static inline void writer_append(OutputWriter *output_writer, const char *bytes, size_t length) {
+    memcpy(writer_reserve(output_writer, length), bytes, length);
+    output_writer->size += length;
+}
 
 /**
- * Writes a token to the file without ending line.
+ * Writes the separator between the previous token of the line and the next.
  */
-static void write_token_semicolon_file_output_writer(OutputWriter *output_writer, const char *format, va_list args) {
-    vfprintf(output_writer->target, format, args);
-    fprintf(output_writer->target, ";");
+static inline void writer_begin_token(OutputWriter *output_writer) {
+    if (output_writer->line_has_tokens) {
+        *writer_reserve(output_writer, 1) = ';';
+        output_writer->size++;
+    }
+    output_writer->line_has_tokens = TRUE;
 }
 
 /**
- * Writes a token to the file and ends line.
+ * Writes the whole buffer to the file.
  */
-static void write_token_end_semicolon_file_output_writer(OutputWriter *output_writer, const char *format, va_list args) {
-    vfprintf(output_writer->target, format, args);
-    fprintf(output_writer->target, "\n");
+static void flush_file_output_writer(OutputWriter *output_writer) {
+    write_all_to_file(output_writer->target, output_writer->buffer, output_writer->size);
+    output_writer->size = 0;
 }
 
 /**
- * Writes a token to the buffer without ending line.
+ * Hands the full buffer over to the target and starts a new one.
  */
-static void write_token_array_of_semicolon_strings_output_writer(OutputWriter *output_writer, const char *format, va_list args) {
-    char string[1024]; // Truncate the string if it is bigger than 1024 characters by design
-    vsnprintf(string, 1024, format, args);
+static void flush_chunked_output_writer(OutputWriter *output_writer) {
+    if (output_writer->size == 0) return;
 
-    append_to_buffer(&output_writer->buffer, string);
-    append_to_buffer(&output_writer->buffer, ";");
+    output_writer->hand_off_chunk(output_writer->target, output_writer->buffer, output_writer->size, FALSE);
+    output_writer->buffer = malloc(output_writer->capacity);
+    output_writer->size = 0;
 }
 
 /**
- * Writes a token to the buffer, ends line, adds the buffer to the array and resets the buffer.
+ * Adds the line in the buffer to the array and empties the buffer.
  */
-static void write_token_end_array_of_semicolon_strings_output_writer(OutputWriter *output_writer, const char *format, va_list args) {
-    char string[1024]; // Truncate the string if it is bigger than 1024 characters by design
-    vsnprintf(string, 1024, format, args);
-
-    append_to_buffer(&output_writer->buffer, string);
-    append_to_buffer(&output_writer->buffer, "\n");
-
-    // Add the string to the array
-    GPtrArray *array = output_writer->target;
-    g_ptr_array_add(array, g_strdup(output_writer->buffer.value));
-
-    // Reset value
-    reset_buffer(&output_writer->buffer);
+static void end_line_array_of_semicolon_strings_output_writer(OutputWriter *output_writer) {
+    g_ptr_array_add(output_writer->target, g_strndup(output_writer->buffer, output_writer->size));
+    output_writer->size = 0;
 }
 
-OutputWriter *create_semicolon_file_output_writer(FILE *file) {
+/**
+ * Creates an output writer with an empty buffer of the given capacity.
+ */
+static OutputWriter *create_output_writer(void *target, void (*flush)(OutputWriter *), void (*end_line)(OutputWriter *), size_t capacity) {
     OutputWriter *output_writer = malloc(sizeof(OutputWriter));
-    output_writer->target = file;
-    output_writer->write_token = write_token_semicolon_file_output_writer;
-    output_writer->write_token_end = write_token_end_semicolon_file_output_writer;
-    output_writer->buffer = init_buffer();
+    output_writer->target = target;
+    output_writer->flush = flush;
+    output_writer->end_line = end_line;
+    output_writer->hand_off_chunk = NULL;
+    output_writer->buffer = capacity > 0 ? malloc(capacity) : NULL;
+    output_writer->size = 0;
+    output_writer->capacity = capacity;
+    output_writer->discards_output = FALSE;
+    output_writer->line_has_tokens = FALSE;
     return output_writer;
 }
 
+OutputWriter *create_semicolon_file_output_writer(FILE *file) {
+    fflush(file); // The buffer is written to the file descriptor, after anything already written with stdio
+    return create_output_writer(file, flush_file_output_writer, NULL, OUTPUT_WRITER_FILE_BUFFER_SIZE);
+}
+
 OutputWriter *create_array_of_semicolon_strings_output_writer(GPtrArray *array) {
-    OutputWriter *output_writer = malloc(sizeof(OutputWriter));
-    output_writer->target = array;
-    output_writer->write_token = write_token_array_of_semicolon_strings_output_writer;
-    output_writer->write_token_end = write_token_end_array_of_semicolon_strings_output_writer;
-    output_writer->buffer = init_buffer();
+    return create_output_writer(array, NULL, end_line_array_of_semicolon_strings_output_writer, OUTPUT_WRITER_ARRAY_BUFFER_SIZE);
+}
+
+OutputWriter *create_chunked_output_writer(void *target, OutputWriterChunkFunction hand_off_chunk, size_t chunk_size) {
+    OutputWriter *output_writer = create_output_writer(target, flush_chunked_output_writer, NULL, chunk_size);
+    output_writer->hand_off_chunk = hand_off_chunk;
     return output_writer;
 }
 
 OutputWriter *create_null_output_writer(void) {
-    OutputWriter *output_writer = malloc(sizeof(OutputWriter));
-    output_writer->target = NULL;
-    output_writer->write_token = NULL;
-    output_writer->write_token_end = NULL;
-    output_writer->buffer = init_buffer();
+    OutputWriter *output_writer = create_output_writer(NULL, NULL, NULL, 0);
+    output_writer->discards_output = TRUE;
     return output_writer;
 }
 
-void writer_write_output_token(OutputWriter *output_writer, const char *format, ...) {
-    if (output_writer->write_token) {
-        va_list args;
-        va_start(args, format);
-        output_writer->write_token(output_writer, format, args);
-        va_end(args);
+/**
+ * Formats a token with printf into the buffer.
+ */
+static void writer_write_formatted_token(OutputWriter *output_writer, const char *format, va_list args) {
+    writer_begin_token(output_writer);
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+
+    char *destination = writer_reserve(output_writer, OUTPUT_WRITER_FORMATTED_TOKEN_SIZE);
+    int length = vsnprintf(destination, OUTPUT_WRITER_FORMATTED_TOKEN_SIZE, format, args);
+    if (length >= OUTPUT_WRITER_FORMATTED_TOKEN_SIZE) {
+        // Rare, so it is simply formatted again once there is space for it
+        destination = writer_reserve(output_writer, length + 1);
+        vsnprintf(destination, length + 1, format, args_copy);
     }
+    va_end(args_copy);
+
+    if (length > 0) output_writer->size += length;
+}
+
+void writer_write_output_token(OutputWriter *output_writer, const char *format, ...) {
+    if (output_writer->discards_output) return;
+
+    va_list args;
+    va_start(args, format);
+    writer_write_formatted_token(output_writer, format, args);
+    va_end(args);
 }
 
 void writer_write_output_token_end(OutputWriter *output_writer, const char *format, ...) {
-    if (output_writer->write_token_end) {
-        va_list args;
-        va_start(args, format);
-        output_writer->write_token_end(output_writer, format, args);
-        va_end(args);
+    if (output_writer->discards_output) return;
+
+    va_list args;
+    va_start(args, format);
+    writer_write_formatted_token(output_writer, format, args);
+    va_end(args);
+
+    writer_end_line(output_writer);
+}
+
+void writer_write_string_token(OutputWriter *output_writer, const char *string) {
+    if (output_writer->discards_output) return;
+
+    writer_begin_token(output_writer);
+    writer_append(output_writer, string, strlen(string));
+}
+
+void writer_write_int_token(OutputWriter *output_writer, int value, int width) {
+    if (output_writer->discards_output) return;
+
+    char digits[16];
+    int length = 0;
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int) value : (unsigned int) value;
+    do {
+        digits[length++] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    // Like printf's "%0*d", the width includes the sign
+    int padding = MAX(width - length - (value < 0), 0);
+
+    writer_begin_token(output_writer);
+    char *current = writer_reserve(output_writer, padding + length + 1);
+    char *start = current;
+
+    if (value < 0) *current++ = '-';
+    for (int i = 0; i < padding; i++) *current++ = '0';
+    while (length > 0) *current++ = digits[--length];
+
+    output_writer->size += current - start;
+}
+
+void writer_write_fixed_3_token(OutputWriter *output_writer, double value) {
+    if (output_writer->discards_output) return;
+
+    double magnitude = fabs(value);
+    if (!(magnitude < OUTPUT_WRITER_MAX_FAST_DOUBLE)) { // Also true for NaN
+        writer_write_output_token(output_writer, "%.3f", value);
+        return;
     }
+
+    // printf rounds the exact value of the double to nearest, ties to even.
+    // The product is rounded, but scaled + error is exact, and the fraction of scaled is exactly 0.5 whenever
+    // the error could change the result, so the error only breaks the ties
+    double scaled = magnitude * 1000.0;
+    double error = fma(magnitude, 1000.0, -scaled);
+    double integral = floor(scaled);
+    double fraction = scaled - integral;
+
+    int64_t thousandths = (int64_t) integral;
+    if (fraction > 0.5 || (fraction == 0.5 && (error > 0 || (error == 0 && (thousandths & 1))))) thousandths++;
+
+    char digits[24];
+    int length = 0;
+    do {
+        digits[length++] = (char) ('0' + thousandths % 10);
+        thousandths /= 10;
+    } while (thousandths != 0 || length < 4);
+
+    writer_begin_token(output_writer);
+    char *current = writer_reserve(output_writer, length + 2);
+    char *start = current;
+
+    if (signbit(value)) *current++ = '-';
+    while (length > 3) *current++ = digits[--length];
+    *current++ = '.';
+    while (length > 0) *current++ = digits[--length];
+
+    output_writer->size += current - start;
+}
+
+void writer_write_money_token(OutputWriter *output_writer, Money money) {
+    if (output_writer->discards_output) return;
+
+    writer_begin_token(output_writer);
+    char *destination = writer_reserve(output_writer, MONEY_STRING_BUFFER_SIZE);
+    output_writer->size += strlen(format_money(money, destination));
+}
+
+void writer_write_date_token(OutputWriter *output_writer, Date date) {
+    if (output_writer->discards_output) return;
+
+    writer_begin_token(output_writer);
+    char *destination = writer_reserve(output_writer, DATE_STRING_BUFFER_SIZE);
+    output_writer->size += strlen(format_date(date, destination));
+}
+
+void writer_end_line(OutputWriter *output_writer) {
+    if (output_writer->discards_output) return;
+
+    *writer_reserve(output_writer, 1) = '\n';
+    output_writer->size++;
+    output_writer->line_has_tokens = FALSE;
+
+    if (output_writer->end_line) output_writer->end_line(output_writer);
 }
 
 void close_output_writer(OutputWriter *output_writer) {
-    free_buffer(&output_writer->buffer);
+    if (output_writer->hand_off_chunk) {
+        // The last chunk is handed over even if empty, so the target knows the output ended
+        output_writer->hand_off_chunk(output_writer->target, output_writer->buffer, output_writer->size, TRUE);
+        output_writer->buffer = NULL;
+    } else if (output_writer->flush) {
+        output_writer->flush(output_writer);
+    }
+
+    free(output_writer->buffer);
     free(output_writer);
 }
@@ -1,13 +1,17 @@
 #include "parser.h"
 
+#include "delimiter_scanner.h"
 #include "file_util.h"
+#include "logger.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define BUFFER_SIZE 8192
 
 void read_csv_file(FILE *stream, ApplyLineFunction *apply_line_function, void *apply_function_first_arg) {
-    char line_buffer[BUFFER_SIZE];
+    // Aligned and with a size multiple of the alignment, as required by `scan_csv_line`
+    _Alignas(DELIMITER_SCANNER_ALIGNMENT) char line_buffer[DELIMITER_SCANNER_PADDED_SIZE(BUFFER_SIZE)];
 
     // We use fgets to read the lines to impose a limit on the line size
     
@@ -16,11 +20,194 @@ void read_csv_file(FILE *stream, ApplyLineFunction *apply_line_function, void *a
     TokenIterator *iterator = init_semicolon_separated_token_iterator();
 
      while (fgets(line_buffer, BUFFER_SIZE, stream) != NULL) {
-        format_input_line(line_buffer);
+        token_iterator_set_current_line(iterator, line_buffer);
+        apply_line_function(apply_function_first_arg, iterator);
+    }
+
+    token_iterator_free(iterator);
+}
+
+/**
+ * Struct that represents a CSV file mapped into memory.
+ */
+struct MappedCsvFile {
+    GMappedFile *mapped_file;
+    const char *contents;
+    size_t size;
+};
+
+MappedCsvFile *map_csv_file(const char *file_path) {
+    GError *error = NULL;
+    // Read-only: writing to a private mapping would copy every page of the file into anonymous memory
+    GMappedFile *mapped_file = g_mapped_file_new(file_path, FALSE, &error);
+    if (mapped_file == NULL) {
+        LOG_WARNING_VA("Could not open file '%s'", file_path);
+        g_error_free(error);
+        return NULL;
+    }
+
+    MappedCsvFile *file = malloc(sizeof(MappedCsvFile));
+    file->mapped_file = mapped_file;
+    file->contents = g_mapped_file_get_contents(mapped_file); // NULL if the file is empty
+    file->size = g_mapped_file_get_length(mapped_file);
+
+    return file;
+}
+
+size_t mapped_csv_file_get_size(MappedCsvFile *file) {
+    return file->size;
+}
+
+/**
+ * Returns a pointer to the first line of the mapped file (skipping the CSV headers).
+ * Returns NULL if the file has no lines besides the headers.
+ */
+static const char *mapped_csv_file_get_first_line(MappedCsvFile *file) {
+    if (file->size == 0) return NULL;
+
+    const char *line_end = memchr(file->contents, '\n', file->size);
+    if (line_end == NULL) return NULL; // only CSV headers
+
+    return line_end + 1;
+}
+
+/**
+ * Initial size of the buffer where the lines of a mapped file are copied (grows for longer lines).
+ */
+#define LINE_COPY_INITIAL_SIZE 1024
+
+/**
+ * Argument of `apply_to_scanned_line`.
+ */
+typedef struct {
+    TokenIterator *iterator;
+    ApplyLineFunction *apply_line_function;
+    void *apply_function_first_arg;
+    char *line_copy; // Copy of the current line, where its tokens are terminated (aligned and padded for `scan_csv_line`)
+    size_t line_copy_size;
+} ScannedLineContext;
+
+/**
+ * Copies the line to the line buffer of the context, terminating it, and returns the copy.
+ * The mapping is read-only, and a line is small enough to stay in the cache while it is parsed.
+ */
+static char *copy_scanned_line(ScannedLineContext *context, const char *line, size_t length) {
+    if (length + 1 > context->line_copy_size) {
+        free(context->line_copy);
+        context->line_copy_size = DELIMITER_SCANNER_PADDED_SIZE(MAX(length + 1, context->line_copy_size * 2));
+        context->line_copy = aligned_alloc(DELIMITER_SCANNER_ALIGNMENT, context->line_copy_size);
+    }
+
+    memcpy(context->line_copy, line, length);
+    context->line_copy[length] = '\0';
+    return context->line_copy;
+}
+
+/**
+ * Applies the line function to a line found by the delimiter scanner, reusing its token table.
+ */
+static void apply_to_scanned_line(void *arg, const char *line, size_t length, const uint32_t *token_ends, int token_count) {
+    ScannedLineContext *context = arg;
+
+    char *line_copy = copy_scanned_line(context, line, length);
+
+    token_iterator_set_current_tokens(context->iterator, line_copy, token_ends, token_count);
+    context->apply_line_function(context->apply_function_first_arg, context->iterator);
+}
+
+/**
+ * Applies apply_line_function to every line that starts between `current` and `end`.
+ * `current` must be the start of a line and `end` must be the start of a line or the end of the file.
+ */
+static void read_mapped_csv_lines(const char *current, const char *end, ApplyLineFunction *apply_line_function, void *apply_function_first_arg) {
+    TokenIterator *iterator = init_semicolon_separated_token_iterator();
+    ScannedLineContext context = {
+        .iterator = iterator,
+        .apply_line_function = apply_line_function,
+        .apply_function_first_arg = apply_function_first_arg,
+        .line_copy = aligned_alloc(DELIMITER_SCANNER_ALIGNMENT, LINE_COPY_INITIAL_SIZE),
+        .line_copy_size = LINE_COPY_INITIAL_SIZE,
+    };
+
+    size_t consumed = scan_csv_lines(current, end - current, apply_to_scanned_line, &context);
 
-        token_iterator_set_current(iterator, line_buffer);
+    if (current + consumed < end) {
+        // Only the last line of the file can end without a newline
+        char *last_line = copy_scanned_line(&context, current + consumed, end - (current + consumed));
+        token_iterator_set_current_line(iterator, last_line);
         apply_line_function(apply_function_first_arg, iterator);
     }
 
+    free(context.line_copy);
     token_iterator_free(iterator);
 }
+
+void read_mapped_csv_file(MappedCsvFile *file, ApplyLineFunction *apply_line_function, void *apply_function_first_arg) {
+    const char *first_line = mapped_csv_file_get_first_line(file);
+    if (first_line == NULL) return;
+
+    read_mapped_csv_lines(first_line, file->contents + file->size, apply_line_function, apply_function_first_arg);
+}
+
+/**
+ * Struct that represents a newline-aligned chunk of a mapped file that is read by a single thread.
+ */
+typedef struct {
+    const char *start;
+    const char *end;
+    ApplyLineFunction *apply_line_function;
+    void *apply_function_first_arg;
+} MappedCsvFileChunk;
+
+/**
+ * Thread function that reads all the lines of a chunk.
+ */
+static gpointer read_mapped_csv_file_chunk(gpointer data) {
+    MappedCsvFileChunk *chunk = data;
+    read_mapped_csv_lines(chunk->start, chunk->end, chunk->apply_line_function, chunk->apply_function_first_arg);
+    return NULL;
+}
+
+void read_mapped_csv_file_in_parallel(MappedCsvFile *file, int chunk_count, ApplyLineFunction *apply_line_function, void **apply_function_first_args) {
+    const char *first_line = mapped_csv_file_get_first_line(file);
+    const char *end = file->contents + file->size;
+    if (first_line == NULL) first_line = end; // every chunk will be empty
+
+    MappedCsvFileChunk *chunks = malloc(sizeof(MappedCsvFileChunk) * chunk_count);
+    GThread **threads = malloc(sizeof(GThread *) * chunk_count);
+
+    size_t chunk_size = (end - first_line) / chunk_count;
+    const char *chunk_start = first_line;
+
+    for (int i = 0; i < chunk_count; i++) {
+        const char *chunk_end = end;
+
+        if (i != chunk_count - 1 && chunk_start + chunk_size < end) {
+            // Move the boundary to the start of the next line, so no line is split between chunks
+            const char *newline = memchr(chunk_start + chunk_size, '\n', end - (chunk_start + chunk_size));
+            chunk_end = newline == NULL ? end : newline + 1;
+        }
+
+        chunks[i] = (MappedCsvFileChunk){chunk_start, chunk_end, apply_line_function, apply_function_first_args[i]};
+        chunk_start = chunk_end;
+    }
+
+    // The first chunk is read by the calling thread
+    for (int i = 1; i < chunk_count; i++) {
+        threads[i] = g_thread_new("csv-chunk-reader", read_mapped_csv_file_chunk, &chunks[i]);
+    }
+
+    read_mapped_csv_file_chunk(&chunks[0]);
+
+    for (int i = 1; i < chunk_count; i++) {
+        g_thread_join(threads[i]);
+    }
+
+    free(threads);
+    free(chunks);
+}
+
+void free_mapped_csv_file(MappedCsvFile *file) {
+    g_mapped_file_unref(file->mapped_file);
+    free(file);
+}
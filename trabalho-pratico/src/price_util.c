@@ -1,14 +1,31 @@
 #include "price_util.h"
 
-double compute_price(int distance, CarClass car_class) {
+Money compute_price(int distance, CarClass car_class) {
     switch (car_class) {
         case BASIC:
-            return 3.25 + 0.62 * distance;
+            return 3250 + 620 * (Money) distance;
         case GREEN:
-            return 4.00 + 0.79 * distance;
+            return 4000 + 790 * (Money) distance;
         case PREMIUM:
-            return 5.20 + 0.94 * distance;
+            return 5200 + 940 * (Money) distance;
         default:
             return 0;
     }
 }
+
+// The table is built at compile time (the same formulas as `compute_price`), so it can be read by any thread without initialization.
+#define PRICE_1(base, per_km, distance) ((base) + (per_km) * (distance))
+#define PRICE_4(base, per_km, distance) PRICE_1(base, per_km, distance), PRICE_1(base, per_km, (distance) + 1), \
+                                        PRICE_1(base, per_km, (distance) + 2), PRICE_1(base, per_km, (distance) + 3)
+#define PRICE_16(base, per_km, distance) PRICE_4(base, per_km, distance), PRICE_4(base, per_km, (distance) + 4), \
+                                         PRICE_4(base, per_km, (distance) + 8), PRICE_4(base, per_km, (distance) + 12)
+#define PRICE_64(base, per_km, distance) PRICE_16(base, per_km, distance), PRICE_16(base, per_km, (distance) + 16), \
+                                         PRICE_16(base, per_km, (distance) + 32), PRICE_16(base, per_km, (distance) + 48)
+#define PRICE_256(base, per_km) PRICE_64(base, per_km, 0), PRICE_64(base, per_km, 64), \
+                                PRICE_64(base, per_km, 128), PRICE_64(base, per_km, 192)
+
+const int32_t price_table[CAR_CLASS_COUNT][PRICE_TABLE_MAX_DISTANCE + 1] = {
+        [BASIC] = {PRICE_256(3250, 620)},
+        [GREEN] = {PRICE_256(4000, 790)},
+        [PREMIUM] = {PRICE_256(5200, 940)},
+};
@@ -4,11 +4,13 @@
 #include <readline/readline.h>
 #include <readline/history.h>
 
+#include "async_output.h"
 #include "benchmark.h"
 #include "catalog.h"
 #include "catalog_loader.h"
 #include "file_util.h"
 #include "logger.h"
+#include "output_container.h"
 #include "query_manager.h"
 #include "string_util.h"
 #include "terminal_controller.h"
@@ -101,6 +103,18 @@ void run_query_and_save_in_output_file(Catalog *catalog, char *query, int query_
     fclose(output_file);
 }
 
+/**
+ * Function that runs a query and saves the output with the given writer (of the asynchronous output or the container),
+ * which is closed afterwards.
+ */
+void run_query_and_save_in_writer(Catalog *catalog, OutputWriter *writer, char *query) {
+    BENCHMARK_START(query_benchmark);
+    parse_and_run_query(catalog, writer, query);
+    BENCHMARK_LOG("'%s' resolved in %lfs\n", query, g_timer_elapsed(query_benchmark, NULL));
+
+    close_output_writer(writer);
+}
+
 /**
  * Function that executes a program command.
  * If the input is a number, it will execute it as a query and the output will be printed to the terminal (paginated if needed).
@@ -163,19 +177,96 @@ int start_program(Program *program, GPtrArray *program_args) {
     return EXIT_SUCCESS;
 }
 
+/**
+ * Builds the catalog loader options from the program flags.
+ */
+static CatalogLoaderOptions program_get_loader_options(Program *program) {
+    CatalogLoaderOptions options = catalog_loader_default_options();
+
+    char *io_value_string = get_program_flag_value(program->flags, "io", "stdio");
+    if (g_ascii_strcasecmp(io_value_string, "mmap") == 0) {
+        options.io_mode = CATALOG_LOADER_IO_MMAP;
+    } else if (g_ascii_strcasecmp(io_value_string, "stdio") != 0) {
+        LOG_WARNING_VA("Unknown io mode '%s', using 'stdio'", io_value_string);
+    }
+
+    char *threads_value_string = get_program_flag_value(program->flags, "threads", "1");
+    int error = 0;
+    int threads = parse_int_safe(threads_value_string, &error);
+    if (error || threads < 1) {
+        LOG_WARNING_VA("Invalid number of threads '%s', using 1", threads_value_string);
+    } else {
+        options.threads = threads;
+    }
+
+    return options;
+}
+
+/**
+ * Tries to restore the catalog from the snapshot given with `--load-snapshot`.
+ * If the snapshot can't be used, the catalog is replaced by an empty one so the dataset can be loaded from the csv files.
+ */
+static gboolean program_load_snapshot(Program *program, char *dataset_folder_path) {
+    char *snapshot_path = get_program_flag_value(program->flags, "load-snapshot", NULL);
+    if (snapshot_path == NULL) return FALSE;
+
+    if (catalog_load_snapshot(program->catalog, snapshot_path, dataset_folder_path))
+        return TRUE;
+
+    LOG_WARNING("Loading the dataset from the csv files instead");
+    free_catalog(program->catalog);
+    program->catalog = create_catalog();
+
+    return FALSE;
+}
+
 gboolean program_load_dataset(Program *program, char *dataset_folder_path) {
-    if (!catalog_load_csv_dataset(program->catalog, dataset_folder_path))
+    // A restored catalog is already fully indexed
+    if (program_load_snapshot(program, dataset_folder_path))
+        return TRUE;
+
+    if (!catalog_load_csv_dataset_with_options(program->catalog, dataset_folder_path, program_get_loader_options(program)))
         return FALSE;
 
     char *lazy_loading_value_string = get_program_flag_value(program->flags, "lazy-loading", "true");
-    if (strcmp(lazy_loading_value_string, "true") != 0)
+    if (g_ascii_strcasecmp(lazy_loading_value_string, "background") == 0)
+        catalog_start_background_indexing(program->catalog, (int) g_get_num_processors());
+    else if (g_ascii_strcasecmp(lazy_loading_value_string, "true") != 0)
         catalog_force_eager_indexing(program->catalog);
 
+    char *snapshot_path = get_program_flag_value(program->flags, "save-snapshot", NULL);
+    if (snapshot_path != NULL)
+        catalog_save_snapshot(program->catalog, snapshot_path, dataset_folder_path);
+
     return TRUE;
 }
 
 #define BUFFER_SIZE 1024
 
+/**
+ * Struct that holds where the output of the queries of an input file is saved.
+ */
+typedef struct {
+    Catalog *catalog;
+    AsyncOutput *async_output; // NULL to save the output without the writer thread
+    OutputContainerWriter *container_writer; // NULL to save the output of each query to its own file
+} ProgramQueryOutput;
+
+/**
+ * Runs a query of an input file and saves its output (a QueryRunner).
+ */
+static void program_run_query_from_file(void *data, char *query, int query_number) {
+    ProgramQueryOutput *query_output = data;
+
+    if (query_output->async_output != NULL) {
+        run_query_and_save_in_writer(query_output->catalog, async_output_create_command_writer(query_output->async_output, query_number), query);
+    } else if (query_output->container_writer != NULL) {
+        run_query_and_save_in_writer(query_output->catalog, output_container_create_command_writer(query_output->container_writer, query_number), query);
+    } else {
+        run_query_and_save_in_output_file(query_output->catalog, query, query_number);
+    }
+}
+
 gboolean program_run_queries_from_file(Program *program, char *input_file_path) {
     FILE *input_file = open_file(input_file_path);
     if (input_file == NULL) {
@@ -184,7 +275,38 @@ gboolean program_run_queries_from_file(Program *program, char *input_file_path)
 
     BENCHMARK_START(input_file_execution_timer);
 
+    char *query_threads_value_string = get_program_flag_value(program->flags, "query-threads", "1");
+    int error = 0;
+    int query_threads = parse_int_safe(query_threads_value_string, &error);
+    if (error || query_threads < 1) {
+        LOG_WARNING_VA("Invalid number of query threads '%s', using 1", query_threads_value_string);
+        query_threads = 1;
+    }
+
+    // With a single processor the writer thread can't run while the queries do, so it only adds context switches
+    char *async_output_value_string = get_program_flag_value(program->flags, "async-output", "auto");
+    gboolean use_async_output = g_ascii_strcasecmp(async_output_value_string, "auto") == 0
+                                ? g_get_num_processors() > 1
+                                : g_ascii_strcasecmp(async_output_value_string, "true") == 0;
+
+    OutputContainerWriter *container_writer = NULL;
+    char *output_value_string = get_program_flag_value(program->flags, "output", "files");
+    if (g_ascii_strcasecmp(output_value_string, "container") == 0) {
+        create_output_folder_if_not_exists();
+        container_writer = create_output_container_writer(OUTPUT_CONTAINER_FILE_PATH);
+        if (container_writer == NULL) LOG_WARNING("Writing a file for each query instead");
+    } else if (g_ascii_strcasecmp(output_value_string, "files") != 0) {
+        LOG_WARNING_VA("Unknown output mode '%s', using 'files'", output_value_string);
+    }
+
+    ProgramQueryOutput query_output = {
+            program->catalog,
+            use_async_output ? create_async_output(container_writer) : NULL,
+            container_writer
+    };
+
     int id = 0;
+    GPtrArray *queries = g_ptr_array_new_with_free_func(g_free);
 
     char line_buffer[BUFFER_SIZE];
     
@@ -192,12 +314,24 @@ gboolean program_run_queries_from_file(Program *program, char *input_file_path)
         format_input_line(line_buffer);
         if (*line_buffer == '\0' || *line_buffer == '#') continue; // Hashtag to ignore comments
 
-        run_query_and_save_in_output_file(program->catalog, line_buffer, ++id);
+        ++id;
+        if (query_threads > 1) {
+            g_ptr_array_add(queries, g_strdup(line_buffer)); // Run once every query is known
+        } else {
+            program_run_query_from_file(&query_output, line_buffer, id);
+        }
     }
 
+    if (query_threads > 1) run_queries_longest_first(queries, query_threads, program_run_query_from_file, &query_output);
+
+    // Waits for the remaining output to be written
+    if (query_output.async_output != NULL) free_async_output(query_output.async_output);
+    if (container_writer != NULL) close_output_container_writer(container_writer);
+
     g_timer_stop(input_file_execution_timer);
     BENCHMARK_LOG("%d queries from '%s' executed in %f seconds\n", id, input_file_path, g_timer_elapsed(input_file_execution_timer, NULL));
 
+    g_ptr_array_free(queries, TRUE);
     fclose(input_file);
 
     return TRUE;
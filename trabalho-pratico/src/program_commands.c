@@ -2,6 +2,7 @@
 
 #include "program.h"
 #include "logger.h"
+#include "output_container.h"
 #include "output_writer.h"
 #include "terminal_controller.h"
 #include "file_util.h"
@@ -85,23 +86,81 @@ void program_list_output_command(Program *program, char **args, int arg_size) {
     (void) r;
 }
 
+/**
+ * Prints the output of a command from the container file with the given path.
+ * Returns FALSE if the container doesn't have the command.
+ */
+static gboolean print_output_container_command(const char *container_path, int command_number) {
+    char *output;
+    size_t size;
+    if (!read_output_container_command(container_path, command_number, &output, &size)) return FALSE;
+
+    GPtrArray *lines = g_ptr_array_new_with_free_func(free);
+    for (char *line = output; line < output + size;) {
+        char *line_end = memchr(line, '\n', output + size - line);
+        line_end = line_end == NULL ? output + size : line_end + 1;
+
+        g_ptr_array_add(lines, g_strndup(line, line_end - line));
+        line = line_end;
+    }
+
+    print_content(lines);
+
+    g_ptr_array_free(lines, TRUE);
+    free(output);
+    return TRUE;
+}
+
+/**
+ * Prints the output of a command from the container file in the output folder, unless the output file of the command
+ * is newer than the container (each run writes one or the other, so the newer one has the output of the last run).
+ * Returns FALSE if the output must be read from the output file instead.
+ */
+static gboolean print_output_container_command_if_newer(int command_number) {
+    int64_t container_time = get_file_modification_time(OUTPUT_CONTAINER_FILE_PATH);
+    if (container_time < 0) return FALSE;
+
+    char *file_path = g_strdup_printf(OUTPUT_FOLDER PATH_SEPARATOR OUTPUT_FILE_NAME, command_number);
+    int64_t file_time = get_file_modification_time(file_path);
+    free(file_path);
+    if (file_time > container_time) return FALSE;
+
+    return print_output_container_command(OUTPUT_CONTAINER_FILE_PATH, command_number);
+}
+
 /**
  * `cat` command implementation.
  * Prints the content of the given file.
  * The file can be a path to a file, an output file or an output file id.
+ * The output of a command can also be read from a container file (written with `--output=container`):
+ * either the one in the output folder, when it is newer than the output file with the given id, or the given one.
  */
 void program_cat_files_command(Program *program, char **args, int arg_size) {
     (void) program;
 
     if (arg_size < 2) {
-        LOG_WARNING("Usage: 'cat <file|output_file|output_file_id>'");
+        LOG_WARNING("Usage: 'cat <file|output_file|output_file_id>' or 'cat <container_file> <output_file_id>'");
         return;
     }
 
     char *input_file_path = args[1];
 
+    if (arg_size >= 3) {
+        int parse_error = 0;
+        int command_number = parse_int_safe(args[2], &parse_error);
+
+        if (parse_error) {
+            LOG_WARNING_VA("Invalid output file id '%s'", args[2]);
+        } else if (!print_output_container_command(input_file_path, command_number)) {
+            LOG_WARNING_VA("Could not find the output of command %d in '%s'", command_number, input_file_path);
+        }
+        return;
+    }
+
     int is_not_int = 0;     //value to check if the input_file_path is an ID
-    parse_int_safe(input_file_path, &is_not_int);
+    int command_number = parse_int_safe(input_file_path, &is_not_int);
+
+    if (!is_not_int && print_output_container_command_if_newer(command_number)) return;
 
     if(is_not_int && !string_ends_with(input_file_path, ".txt")) {
         LOG_WARNING_VA("Can't open '%s' file, can only open .txt files", input_file_path);
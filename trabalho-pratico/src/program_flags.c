@@ -23,8 +23,7 @@ gboolean parse_flag(const char *complete_flag, char **flag_result, char **value_
     }
     *flag_result = g_strdup(split[0]);
     str_to_lower(*flag_result);
-    *value_result = g_strdup(split[1]);
-    str_to_lower(*value_result);
+    *value_result = g_strdup(split[1]); // Values keep their case, they can be file paths
     g_strfreev(split);
     return TRUE;
 }
@@ -35,21 +35,20 @@ void execute_query_find_user_by_name(Catalog *catalog, OutputWriter *output, cha
         return;
     }
 
-    char *name = user_get_name(user);
+    const char *name = catalog_get_user_name(catalog, user);
     const char *gender = convert_gender_to_string(user_get_gender(user));
     int age = get_age(user_get_birthdate(user));
     double average_score = user_get_average_score(user);
     int number_of_rides = user_get_number_of_rides(user);
-    double total_spent = user_get_total_spent(user);
-
-    writer_write_output_token(output, "%s", name);
-    writer_write_output_token(output, "%s", gender);
-    writer_write_output_token(output, "%d", age);
-    writer_write_output_token(output, "%.3f", average_score);
-    writer_write_output_token(output, "%d", number_of_rides);
-    writer_write_output_token_end(output, "%.3f", total_spent);
-
-    free(name);
+    Money total_spent = user_get_total_spent(user);
+
+    writer_write_string_token(output, name);
+    writer_write_string_token(output, gender);
+    writer_write_int_token(output, age, 0);
+    writer_write_fixed_3_token(output, average_score);
+    writer_write_int_token(output, number_of_rides, 0);
+    writer_write_money_token(output, total_spent);
+    writer_end_line(output);
 }
 
 /**
@@ -68,21 +67,20 @@ void execute_query_find_driver_by_id(Catalog *catalog, OutputWriter *output, int
         return;
     }
 
-    char *name = driver_get_name(driver);
+    const char *name = catalog_get_driver_name(catalog, driver);
     const char *gender = convert_gender_to_string(driver_get_gender(driver));
     int age = get_age(driver_get_birthdate(driver));
     double average_score = driver_get_average_score(driver);
     int number_of_rides = driver_get_number_of_rides(driver);
-    double total_spent = driver_get_total_earned(driver);
-
-    writer_write_output_token(output, "%s", name);
-    writer_write_output_token(output, "%s", gender);
-    writer_write_output_token(output, "%d", age);
-    writer_write_output_token(output, "%.3f", average_score);
-    writer_write_output_token(output, "%d", number_of_rides);
-    writer_write_output_token_end(output, "%.3f", total_spent);
-
-    free(name);
+    Money total_earned = driver_get_total_earned(driver);
+
+    writer_write_string_token(output, name);
+    writer_write_string_token(output, gender);
+    writer_write_int_token(output, age, 0);
+    writer_write_fixed_3_token(output, average_score);
+    writer_write_int_token(output, number_of_rides, 0);
+    writer_write_money_token(output, total_earned);
+    writer_end_line(output);
 }
 
 /**
@@ -119,14 +117,13 @@ void execute_query_top_n_drivers(Catalog *catalog, OutputWriter *output, char **
         Driver *driver = g_ptr_array_index(result, i);
 
         int id = driver_get_id(driver);
-        char *name = driver_get_name(driver);
+        const char *name = catalog_get_driver_name(catalog, driver);
         double average_score = driver_get_average_score(driver);
 
-        writer_write_output_token(output, "%012d", id);
-        writer_write_output_token(output, "%s", name);
-        writer_write_output_token_end(output, "%.3f", average_score);
-
-        free(name);
+        writer_write_int_token(output, id, 12);
+        writer_write_string_token(output, name);
+        writer_write_fixed_3_token(output, average_score);
+        writer_end_line(output);
     }
 
     g_ptr_array_free(result, TRUE);
@@ -151,16 +148,14 @@ void execute_query_longest_n_total_distance(Catalog *catalog, OutputWriter *outp
     for (int i = 0; i < result_size; i++) {
         User *user = g_ptr_array_index(result, i);
 
-        char *username = user_get_username(user);
-        char *name = user_get_name(user);
+        const char *username = catalog_get_user_username(catalog, user);
+        const char *name = catalog_get_user_name(catalog, user);
         int total_distance = user_get_total_distance(user);
 
-        writer_write_output_token(output, "%s", username);
-        writer_write_output_token(output, "%s", name);
-        writer_write_output_token_end(output, "%d", total_distance);
-
-        free(username);
-        free(name);
+        writer_write_string_token(output, username);
+        writer_write_string_token(output, name);
+        writer_write_int_token(output, total_distance, 0);
+        writer_end_line(output);
     }
 
     g_ptr_array_free(result, TRUE);
@@ -178,9 +173,10 @@ void execute_query_average_price_in_city(Catalog *catalog, OutputWriter *output,
         return;
     }
 
-    double average_price = query_4_catalog_get_average_price_in_city(catalog, city_id);
+    Money average_price = query_4_catalog_get_average_price_in_city(catalog, city_id);
 
-    writer_write_output_token_end(output, "%.3f", average_price);
+    writer_write_money_token(output, average_price);
+    writer_end_line(output);
 }
 
 /**
@@ -203,14 +199,15 @@ void execute_query_average_price_in_date_range(Catalog *catalog, OutputWriter *o
         return;
     }
 
-    double average_price = query_5_catalog_get_average_price_in_date_range(catalog, start_date, end_date);
+    Money average_price = query_5_catalog_get_average_price_in_date_range(catalog, start_date, end_date);
 
     if (average_price == -1) {
         write_output_debug(output, "No rides in date range");
         return;
     }
 
-    writer_write_output_token_end(output, "%.3f", average_price);
+    writer_write_money_token(output, average_price);
+    writer_end_line(output);
 }
 
 /**
@@ -248,7 +245,8 @@ void execute_query_average_distance_in_city_in_date_range(Catalog *catalog, Outp
         return;
     }
 
-    writer_write_output_token_end(output, "%.3f", average_distance);
+    writer_write_fixed_3_token(output, average_distance);
+    writer_end_line(output);
 }
 
 /**
@@ -278,14 +276,13 @@ void execute_query_top_drivers_in_city_by_average_score(Catalog *catalog, Output
         int id = driver_city_info_get_id(driver_city_info);
         Driver *driver = catalog_get_driver(catalog, id);
 
-        char *name = driver_get_name(driver);
+        const char *name = catalog_get_driver_name(catalog, driver);
         double average_score = driver_city_info_get_average_score(driver_city_info);
 
-        writer_write_output_token(output, "%012d", id);
-        writer_write_output_token(output, "%s", name);
-        writer_write_output_token_end(output, "%.3f", average_score);
-
-        free(name);
+        writer_write_int_token(output, id, 12);
+        writer_write_string_token(output, name);
+        writer_write_fixed_3_token(output, average_score);
+        writer_end_line(output);
     }
 
     g_ptr_array_free(result, TRUE);
@@ -313,21 +310,18 @@ void execute_query_rides_with_users_and_drivers_same_gender_by_account_creation_
 
         int driver_id = ride_get_driver_id(ride);
         Driver *driver = catalog_get_driver(catalog, driver_id);
-        char *driver_name = driver_get_name(driver);
+        const char *driver_name = catalog_get_driver_name(catalog, driver);
 
         int user_id = ride_get_user_id(ride);
         User *user = catalog_get_user_by_user_id(catalog, user_id);
-        char *user_username = user_get_username(user);
-        char *user_name = user_get_name(user);
-
-        writer_write_output_token(output, "%012d", driver_id);
-        writer_write_output_token(output, "%s", driver_name);
-        writer_write_output_token(output, "%s", user_username);
-        writer_write_output_token_end(output, "%s", user_name);
-
-        free(driver_name);
-        free(user_username);
-        free(user_name);
+        const char *user_username = catalog_get_user_username(catalog, user);
+        const char *user_name = catalog_get_user_name(catalog, user);
+
+        writer_write_int_token(output, driver_id, 12);
+        writer_write_string_token(output, driver_name);
+        writer_write_string_token(output, user_username);
+        writer_write_string_token(output, user_name);
+        writer_end_line(output);
     }
 
     g_ptr_array_free(result, TRUE);
@@ -362,19 +356,15 @@ void execute_query_passenger_that_gave_tip(Catalog *catalog, OutputWriter *outpu
         Date date = ride_get_date(ride);
         int distance = ride_get_distance(ride);
         int city_id = ride_get_city_id(ride);
-        char *city = catalog_get_city_name(catalog, city_id);
-        double tip = ride_get_tip(ride);
-
-        char *date_string = convert_date_to_string(date);
-
-        writer_write_output_token(output, "%012d", id);
-        writer_write_output_token(output, "%s", date_string);
-        writer_write_output_token(output, "%d", distance);
-        writer_write_output_token(output, "%s", city);
-        writer_write_output_token_end(output, "%.3f", tip);
-
-        free(date_string);
-        free(city);
+        const char *city = catalog_get_city_name_view(catalog, city_id);
+        Money tip = ride_get_tip(ride);
+
+        writer_write_int_token(output, id, 12);
+        writer_write_date_token(output, date);
+        writer_write_int_token(output, distance, 0);
+        writer_write_string_token(output, city);
+        writer_write_money_token(output, tip);
+        writer_end_line(output);
     }
 
     g_ptr_array_free(result, TRUE);
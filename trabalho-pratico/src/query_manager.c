@@ -1,7 +1,10 @@
 #include "query_manager.h"
 
+#include <string.h>
+
 #include "queries.h"
 #include "logger.h"
+#include "thread_budget.h"
 
 /**
  * Struct that holds information about a query command.
@@ -11,21 +14,22 @@ typedef struct {
     int min_args;
     char *usage;
     char *description;
+    int expected_cost; // Average time in tenths of milliseconds in the large dataset, once the catalog is indexed
 } QueryFunctionInfo;
 
 /**
  * Array that holds every query command.
  */
 static const QueryFunctionInfo query_functions[] = {
-        {execute_query_find_user_or_driver_by_name_or_id, 1, "1 <username|id>", "Finds a user/driver by its name/ID"},
-        {execute_query_top_n_drivers, 1, "2 <n>", "Gets the n drivers with the best score"},
-        {execute_query_longest_n_total_distance, 1, "3 <n>", "Gets the n users with the longest accumulated distance"},
-        {execute_query_average_price_in_city, 1, "4 <city>", "Gets the average price of a ride for a specific city"},
-        {execute_query_average_price_in_date_range, 2, "5 <start_date> <end_date>", "Gets the average price of a ride in a given time span"},
-        {execute_query_average_distance_in_city_in_date_range, 3, "6 <city> <start_date> <end_date>", "Gets the average distance for a ride in a give time span for a specific city"},
-        {execute_query_top_drivers_in_city_by_average_score, 2, "7 <n> <city>", "Gets the n drivers with the best score in a specific city"},
-        {execute_query_rides_with_users_and_drivers_same_gender_by_account_creation_age, 2, "8 <gender> <min_account_age>", "Gets the rides where the user and drivers have the same gender by account creation age"},
-        {execute_query_passenger_that_gave_tip, 2, "9 <start_date> <end_date>",  "Gets the users who gave a tip in a certain time span"},
+        {execute_query_find_user_or_driver_by_name_or_id, 1, "1 <username|id>", "Finds a user/driver by its name/ID", 1},
+        {execute_query_top_n_drivers, 1, "2 <n>", "Gets the n drivers with the best score", 2},
+        {execute_query_longest_n_total_distance, 1, "3 <n>", "Gets the n users with the longest accumulated distance", 11},
+        {execute_query_average_price_in_city, 1, "4 <city>", "Gets the average price of a ride for a specific city", 69},
+        {execute_query_average_price_in_date_range, 2, "5 <start_date> <end_date>", "Gets the average price of a ride in a given time span", 2},
+        {execute_query_average_distance_in_city_in_date_range, 3, "6 <city> <start_date> <end_date>", "Gets the average distance for a ride in a give time span for a specific city", 20},
+        {execute_query_top_drivers_in_city_by_average_score, 2, "7 <n> <city>", "Gets the n drivers with the best score in a specific city", 14},
+        {execute_query_rides_with_users_and_drivers_same_gender_by_account_creation_age, 2, "8 <gender> <min_account_age>", "Gets the rides where the user and drivers have the same gender by account creation age", 77},
+        {execute_query_passenger_that_gave_tip, 2, "9 <start_date> <end_date>",  "Gets the users who gave a tip in a certain time span", 194},
 };
 
 /**
@@ -66,3 +70,83 @@ void run_query(Catalog *catalog, OutputWriter *output, int query_id, char **args
 
     query_function_info.function(catalog, output, args);
 }
+
+int get_query_expected_cost(const char *query) {
+    int error = 0;
+    char *query_id_string = g_strndup(query, strcspn(query, " "));
+    int query_id = parse_int_safe(query_id_string, &error);
+    g_free(query_id_string);
+
+    if (error || query_id <= 0 || query_id > (int) query_functions_size) return 0;
+    return query_functions[query_id - 1].expected_cost;
+}
+
+/**
+ * Struct that represents a query of an input file waiting to be run.
+ */
+typedef struct {
+    char *query;
+    int query_number;
+    int expected_cost;
+} ScheduledQuery;
+
+/**
+ * Struct that holds the queries shared by the threads of `run_queries_longest_first`.
+ */
+typedef struct {
+    ScheduledQuery *queries;
+    int queries_count;
+    gint next_query; // Index of the next query to run, taken atomically
+    QueryRunner runner;
+    void *data;
+} QuerySchedule;
+
+/**
+ * Compares scheduled queries by descending expected cost, then by query number.
+ */
+static int compare_scheduled_queries_by_expected_cost(const void *a, const void *b) {
+    const ScheduledQuery *query_a = a;
+    const ScheduledQuery *query_b = b;
+
+    if (query_a->expected_cost != query_b->expected_cost) return query_b->expected_cost - query_a->expected_cost;
+    return query_a->query_number - query_b->query_number;
+}
+
+/**
+ * Runs queries of the schedule until there are none left.
+ */
+static gpointer run_scheduled_queries(gpointer data) {
+    QuerySchedule *schedule = data;
+
+    int index;
+    while ((index = g_atomic_int_add(&schedule->next_query, 1)) < schedule->queries_count) {
+        ScheduledQuery *query = &schedule->queries[index];
+        schedule->runner(schedule->data, query->query, query->query_number);
+    }
+
+    return NULL;
+}
+
+void run_queries_longest_first(GPtrArray *queries, int threads, QueryRunner runner, void *data) {
+    QuerySchedule schedule = {malloc(sizeof(ScheduledQuery) * MAX(queries->len, 1)), (int) queries->len, 0, runner, data};
+
+    for (guint i = 0; i < queries->len; i++) {
+        char *query = g_ptr_array_index(queries, i);
+        schedule.queries[i] = (ScheduledQuery) {query, (int) i + 1, get_query_expected_cost(query)};
+    }
+    qsort(schedule.queries, queries->len, sizeof(ScheduledQuery), compare_scheduled_queries_by_expected_cost);
+
+    // The calling thread is one of the workers
+    int thread_count = MIN(threads, MAX((int) queries->len, 1)) - 1;
+    GThread **workers = malloc(sizeof(GThread *) * MAX(thread_count, 1));
+    int reserved_threads = reserve_spare_threads(thread_count); // Leaves the processors that are left to the sorts of the queries
+    for (int i = 0; i < thread_count; i++) workers[i] = g_thread_new("query-worker", run_scheduled_queries, &schedule);
+
+    run_scheduled_queries(&schedule);
+
+    for (int i = 0; i < thread_count; i++) g_thread_join(workers[i]);
+    release_spare_threads(reserved_threads);
+
+    free(workers);
+    free(schedule.queries);
+}
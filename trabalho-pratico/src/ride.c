@@ -3,45 +3,152 @@
 #include <glib.h>
 #include "struct_util.h"
 #include "string_util.h"
+#include "price_util.h"
+#include "typed_array.h"
+#include "array_util.h"
 
 /**
- * Struct that represents a ride.
+ * Struct that holds the values of a ride that doesn't fit in the packed fields, at full width.
  */
-struct Ride {
-    double price;
-    double tip;
+typedef struct {
+    int id;
+    int user_id;
+    int driver_id;
+    int city_id;
+    int distance;
+    int score_user;
+    int score_driver;
+    CarClass car_class;
     Date date;
-    Date user_account_creation_date;
-    Date driver_account_creation_date;
-    int32_t user_id;
-    int32_t id;
-    int32_t driver_id;
-    u_int8_t distance;
-    u_int8_t city_id;
-    u_int8_t score_user;
-    u_int8_t score_driver;
+    Money tip;
+} RideExtension;
+
+/**
+ * Struct that represents a ride, packed in 16 bytes (see the limits in ride.h).
+ * Each group of bit fields fills exactly 32 bits, so no field straddles two words.
+ *
+ * A ride with a value outside the limits is extended instead: its distance is 0 (valid rides have a distance of at least 1)
+ * and the last 8 bytes point to a RideExtension with every value of the ride.
+ */
+struct Ride {
+    union {
+        struct {
+            uint32_t id : 24;
+            uint32_t distance : 8; // 0 if the ride is extended
+
+            uint32_t user_id : 24;
+            uint32_t city_id : 8;
+
+            uint32_t driver_id : 24;
+            uint32_t score_user : 3;
+            uint32_t score_driver : 3;
+            uint32_t car_class : 2; // Only valid car classes, the price is derived from it
+
+            uint32_t date : 16; // day | month << 5 | (year - RIDE_MIN_YEAR) << 9, compares like a Date
+            uint32_t tip : 16; // Money
+        };
+        struct {
+            uint32_t extended_header; // Overlaps the id and the distance of 0
+            uint32_t extended_unused;
+            RideExtension *extension;
+        };
+    };
 };
 
-Ride *create_ride(int id, Date date, int driver_id, int city_id, int distance, int score_user, int score_driver, double tip) {
-    Ride *ride = malloc(sizeof(Ride));
+_Static_assert(sizeof(Ride) == 16, "Ride must fit in 16 bytes");
+
+/**
+ * Returns TRUE if the values of the ride are in its RideExtension.
+ */
+static inline gboolean ride_is_extended(const Ride *ride) {
+    return ride->distance == 0;
+}
+
+/**
+ * Returns TRUE if the year of the date fits in a packed ride date.
+ */
+static inline gboolean ride_date_fits(Date date) {
+    int year = date_get_year(date);
+    return year >= RIDE_MIN_YEAR && year <= RIDE_MAX_YEAR;
+}
+
+/**
+ * Packs a date (with a year in the range of ride dates) in 16 bits.
+ */
+static inline uint32_t pack_ride_date(Date date) {
+    return (uint32_t) date_get_day(date) | (uint32_t) date_get_month(date) << 5 | (uint32_t) (date_get_year(date) - RIDE_MIN_YEAR) << 9;
+}
+
+/**
+ * Unpacks a date packed by `pack_ride_date`.
+ */
+static inline Date unpack_ride_date(uint32_t packed_date) {
+    return create_date((int) (packed_date & 0x1F), (int) (packed_date >> 5) & 0xF, (int) (packed_date >> 9) + RIDE_MIN_YEAR);
+}
+
+/**
+ * Moves the values of a packed ride to a new RideExtension, allocated in the arena (or in the heap if it is NULL).
+ * Returns the extension, whose values can then be set past the limits of the packed fields.
+ */
+static RideExtension *extend_ride(Ride *ride, Arena *arena) {
+    if (ride_is_extended(ride)) return ride->extension;
+
+    RideExtension *extension = arena != NULL ? arena_alloc(arena, sizeof(RideExtension)) : malloc(sizeof(RideExtension));
+    extension->id = ride->id;
+    extension->user_id = ride->user_id;
+    extension->driver_id = ride->driver_id;
+    extension->city_id = ride->city_id;
+    extension->distance = ride->distance;
+    extension->score_user = ride->score_user;
+    extension->score_driver = ride->score_driver;
+    extension->car_class = ride->car_class;
+    extension->date = unpack_ride_date(ride->date);
+    extension->tip = ride->tip;
+
+    ride->id = 0;
+    ride->distance = 0;
+    ride->extended_unused = 0;
+    ride->extension = extension;
+    return extension;
+}
+
+Ride *create_ride(int id, Date date, int driver_id, int city_id, int distance, int score_user, int score_driver, Money tip, Arena *arena) {
+    Ride *ride = arena != NULL ? arena_alloc(arena, sizeof(Ride)) : malloc(sizeof(Ride));
+
+    gboolean fits = id >= 0 && id <= RIDE_MAX_ID && driver_id >= 0 && driver_id <= RIDE_MAX_PERSON_ID && city_id >= 0 &&
+                    city_id <= RIDE_MAX_CITY_ID && distance >= 1 && distance <= RIDE_MAX_DISTANCE && score_user >= 0 &&
+                    score_user <= RIDE_MAX_SCORE && score_driver >= 0 && score_driver <= RIDE_MAX_SCORE && tip >= 0 &&
+                    tip <= RIDE_MAX_TIP && ride_date_fits(date);
+
+    if (G_UNLIKELY(!fits)) {
+        RideExtension *extension = arena != NULL ? arena_alloc(arena, sizeof(RideExtension)) : malloc(sizeof(RideExtension));
+        *extension = (RideExtension) {id, 0, driver_id, city_id, distance, score_user, score_driver, BASIC, date, tip};
+
+        ride->extended_header = 0;
+        ride->extended_unused = 0;
+        ride->extension = extension;
+        return ride;
+    }
 
     ride->id = id;
-    ride->date = date;
+    ride->date = pack_ride_date(date);
     ride->driver_id = driver_id;
+    ride->user_id = 0;
     ride->city_id = city_id;
     ride->distance = distance;
     ride->score_user = score_user;
     ride->score_driver = score_driver;
-    ride->tip = tip;
+    ride->tip = (uint32_t) tip;
+    ride->car_class = BASIC;
 
     return ride;
 }
 
-Ride *parse_line_ride(TokenIterator *line_iterator) {
-    return parse_line_ride_detailed(line_iterator, NULL, NULL);
+Ride *parse_line_ride(TokenIterator *line_iterator, Arena *arena) {
+    return parse_line_ride_detailed(line_iterator, NULL, NULL, arena);
 }
 
-Ride *parse_line_ride_detailed(TokenIterator *line_iterator, char **parsed_city, char **parsed_user_username) {
+Ride *parse_line_ride_detailed(TokenIterator *line_iterator, char **parsed_city, char **parsed_user_username, Arena *arena) {
     char *id_string = token_iterator_next(line_iterator);
     if (IS_EMPTY(id_string)) return NULL;
     int id = parse_int_unsafe(id_string);
@@ -77,93 +184,199 @@ Ride *parse_line_ride_detailed(TokenIterator *line_iterator, char **parsed_city,
 
     char *tip_string = token_iterator_next(line_iterator);
     if (IS_EMPTY(tip_string)) return NULL;
-    double tip = parse_double_safe(tip_string, &error);
+    Money tip = parse_money_safe(tip_string, &error);
 
-    if (error || distance < 1 || user_score < 1 || driver_score < 1 || tip < 0 || tip != tip) return NULL;
+    if (error || distance < 1 || user_score < 1 || driver_score < 1 || tip < 0) return NULL;
 
     if (parsed_city) *parsed_city = city;
     if (parsed_user_username) *parsed_user_username = user;
 
-    return create_ride(id, date, driver_id, city_id, distance, user_score, driver_score, tip);
+    // Values that don't fit in the packed ride are kept in an extension (see `create_ride`)
+    return create_ride(id, date, driver_id, city_id, distance, user_score, driver_score, tip, arena);
 }
 
 void free_ride(Ride *ride) {
+    if (ride_is_extended(ride)) free(ride->extension);
     free(ride);
 }
 
-void ride_set_city_id(Ride *ride, int city_id) {
-    ride->city_id = city_id;
+void ride_write_snapshot(Ride *ride, SnapshotWriter *writer) {
+    gboolean extended = ride_is_extended(ride);
+    snapshot_write_uint8(writer, extended);
+
+    if (G_UNLIKELY(extended)) {
+        RideExtension *extension = ride->extension;
+        snapshot_write_int32(writer, extension->id);
+        snapshot_write_int32(writer, extension->user_id);
+        snapshot_write_int32(writer, extension->driver_id);
+        snapshot_write_int32(writer, extension->city_id);
+        snapshot_write_int32(writer, extension->distance);
+        snapshot_write_int32(writer, extension->score_user);
+        snapshot_write_int32(writer, extension->score_driver);
+        snapshot_write_uint8(writer, extension->car_class);
+        snapshot_write_uint32(writer, extension->date.encoded_date);
+        snapshot_write_int64(writer, extension->tip);
+        return;
+    }
+
+    snapshot_write_uint32(writer, ride->id);
+    snapshot_write_uint32(writer, ride->user_id);
+    snapshot_write_uint32(writer, ride->driver_id);
+    snapshot_write_uint16(writer, ride->date);
+    snapshot_write_uint16(writer, ride->tip);
+    snapshot_write_uint8(writer, ride->distance);
+    snapshot_write_uint8(writer, ride->city_id);
+    snapshot_write_uint8(writer, ride->score_user);
+    snapshot_write_uint8(writer, ride->score_driver);
+    snapshot_write_uint8(writer, ride->car_class);
+}
+
+Ride *ride_read_snapshot(SnapshotReader *reader, Arena *arena) {
+    Ride *ride = arena != NULL ? arena_alloc(arena, sizeof(Ride)) : malloc(sizeof(Ride));
+
+    if (G_UNLIKELY(snapshot_read_uint8(reader))) {
+        RideExtension *extension = arena != NULL ? arena_alloc(arena, sizeof(RideExtension)) : malloc(sizeof(RideExtension));
+        extension->id = snapshot_read_int32(reader);
+        extension->user_id = snapshot_read_int32(reader);
+        extension->driver_id = snapshot_read_int32(reader);
+        extension->city_id = snapshot_read_int32(reader);
+        extension->distance = snapshot_read_int32(reader);
+        extension->score_user = snapshot_read_int32(reader);
+        extension->score_driver = snapshot_read_int32(reader);
+        uint8_t car_class = snapshot_read_uint8(reader);
+        if (G_UNLIKELY(car_class >= CAR_CLASS_COUNT)) snapshot_reader_fail(reader);
+        extension->car_class = car_class < CAR_CLASS_COUNT ? (CarClass) car_class : BASIC;
+        extension->date = (Date) {.encoded_date = snapshot_read_uint32(reader)};
+        extension->tip = snapshot_read_int64(reader);
+
+        ride->extended_header = 0;
+        ride->extended_unused = 0;
+        ride->extension = extension;
+        return ride;
+    }
+
+    ride->id = snapshot_read_uint32(reader);
+    ride->user_id = snapshot_read_uint32(reader);
+    ride->driver_id = snapshot_read_uint32(reader);
+    ride->date = snapshot_read_uint16(reader);
+    ride->tip = snapshot_read_uint16(reader);
+    ride->distance = snapshot_read_uint8(reader);
+    ride->city_id = snapshot_read_uint8(reader);
+    ride->score_user = snapshot_read_uint8(reader);
+    ride->score_driver = snapshot_read_uint8(reader);
+    uint8_t car_class = snapshot_read_uint8(reader);
+    ride->car_class = car_class;
+
+    // A distance of 0 would read as an extended ride, and the car class bit-field can hold invalid classes
+    if (G_UNLIKELY(ride->distance == 0 || car_class >= CAR_CLASS_COUNT)) {
+        snapshot_reader_fail(reader);
+        ride->distance = 1; // Only so the ride can still be freed, the snapshot is discarded
+    }
+
+    return ride;
+}
+
+void ride_set_city_id(Ride *ride, int city_id, Arena *arena) {
+    if (G_LIKELY(!ride_is_extended(ride) && city_id >= 0 && city_id <= RIDE_MAX_CITY_ID)) {
+        ride->city_id = city_id;
+    } else {
+        extend_ride(ride, arena)->city_id = city_id;
+    }
 }
 
 int ride_get_driver_id(Ride *ride) {
+    if (G_UNLIKELY(ride_is_extended(ride))) return ride->extension->driver_id;
     return ride->driver_id;
 }
 
 int ride_get_id(Ride *ride) {
+    if (G_UNLIKELY(ride_is_extended(ride))) return ride->extension->id;
     return ride->id;
 }
 
 Date ride_get_date(Ride *ride) {
-    return ride->date;
+    if (G_UNLIKELY(ride_is_extended(ride))) return ride->extension->date;
+    return unpack_ride_date(ride->date);
 }
 
 int ride_get_user_id(Ride *ride) {
+    if (G_UNLIKELY(ride_is_extended(ride))) return ride->extension->user_id;
     return ride->user_id;
 }
 
-void ride_set_user_id(Ride *ride, int user_id) {
-    ride->user_id = user_id;
+void ride_set_user_id(Ride *ride, int user_id, Arena *arena) {
+    if (G_LIKELY(!ride_is_extended(ride) && user_id >= 0 && user_id <= RIDE_MAX_PERSON_ID)) {
+        ride->user_id = user_id;
+    } else {
+        extend_ride(ride, arena)->user_id = user_id;
+    }
 }
 
 int ride_get_distance(Ride *ride) {
+    if (G_UNLIKELY(ride_is_extended(ride))) return ride->extension->distance;
     return ride->distance;
 }
 
 int ride_get_score_user(Ride *ride) {
+    if (G_UNLIKELY(ride_is_extended(ride))) return ride->extension->score_user;
     return ride->score_user;
 }
 
 int ride_get_score_driver(Ride *ride) {
+    if (G_UNLIKELY(ride_is_extended(ride))) return ride->extension->score_driver;
     return ride->score_driver;
 }
 
-double ride_get_tip(Ride *ride) {
+Money ride_get_tip(Ride *ride) {
+    if (G_UNLIKELY(ride_is_extended(ride))) return ride->extension->tip;
     return ride->tip;
 }
 
 int ride_get_city_id(Ride *ride) {
+    if (G_UNLIKELY(ride_is_extended(ride))) return ride->extension->city_id;
     return ride->city_id;
 }
 
-void ride_set_price(Ride *ride, double price) {
-    ride->price = price;
+void ride_set_car_class(Ride *ride, CarClass car_class) {
+    if (G_UNLIKELY(ride_is_extended(ride))) {
+        ride->extension->car_class = car_class;
+    } else {
+        ride->car_class = car_class;
+    }
 }
 
-double ride_get_price(Ride *ride) {
-    return ride->price;
+Money ride_get_price(Ride *ride) {
+    if (G_UNLIKELY(ride_is_extended(ride))) return compute_price(ride->extension->distance, ride->extension->car_class);
+    return price_table[ride->car_class][ride->distance];
 }
 
-void ride_set_user_account_creation_date(Ride *ride, Date date) {
-    ride->user_account_creation_date = date;
-}
+int compare_rides_by_date(const void *a, const void *b) {
+    Ride *a_ride = *(Ride **) a;
+    Ride *b_ride = *(Ride **) b;
 
-Date ride_get_user_account_creation_date(Ride *ride) {
-    return ride->user_account_creation_date;
-}
+    if (G_UNLIKELY(ride_is_extended(a_ride) || ride_is_extended(b_ride))) {
+        return date_compare(ride_get_date(a_ride), ride_get_date(b_ride));
+    }
 
-void ride_set_driver_account_creation_date(Ride *ride, Date date) {
-    ride->driver_account_creation_date = date;
+    // Packed dates compare like the dates they represent
+    return (int) a_ride->date - (int) b_ride->date;
 }
 
-Date ride_get_driver_account_creation_date(Ride *ride) {
-    return ride->driver_account_creation_date;
+uint64_t ride_get_date_sort_key(gconstpointer ride, gpointer data) {
+    (void) data;
+    Ride *actual_ride = (Ride *) ride;
+
+    // Encoded date above the id, offset so negative ids order first
+    return (uint64_t) ride_get_date(actual_ride).encoded_date << 32 | (uint32_t) ((int64_t) ride_get_id(actual_ride) - INT32_MIN);
 }
 
-int compare_rides_by_date(const void *a, const void *b) {
-    Ride *a_ride = *(Ride **) a;
-    Ride *b_ride = *(Ride **) b;
+guint ride_get_date_bucket(gconstpointer ride) {
+    const Ride *actual_ride = ride;
+    if (G_LIKELY(!ride_is_extended(actual_ride))) return actual_ride->date;
 
-    return date_compare(ride_get_date(a_ride), ride_get_date(b_ride));
+    Date date = actual_ride->extension->date;
+    if (ride_date_fits(date)) return pack_ride_date(date);
+    return date_get_year(date) < RIDE_MIN_YEAR ? RIDE_DATE_BUCKET_BEFORE_RANGE : RIDE_DATE_BUCKET_AFTER_RANGE;
 }
 
 int compare_rides_by_distance(const void *a, const void *b) {
@@ -182,25 +395,43 @@ int compare_rides_by_distance(const void *a, const void *b) {
     return ride_get_id(b_ride) - ride_get_id(a_ride);
 }
 
-int compare_ride_by_driver_and_user_account_creation_date(const void *a, const void *b) {
-    Ride *ride_a = *(Ride **) a;
-    Ride *ride_b = *(Ride **) b;
+/**
+ * Struct that represents a ride sorted by `sort_rides_by_distance`, next to its key,
+ * so the sort compares the keys without reading the rides.
+ */
+typedef struct {
+    uint64_t key; // 8 bits of distance above 16 bits of packed date above 24 bits of id
+    Ride *ride;
+} RideByDistanceSortEntry;
 
-    Date driver_a_account_creation_date = ride_get_driver_account_creation_date(ride_a);
-    Date driver_b_account_creation_date = ride_get_driver_account_creation_date(ride_b);
+/**
+ * Returns TRUE if the first entry goes before the second: the greater key (distance, date and then id) goes first.
+ */
+static inline gboolean ride_by_distance_sort_entry_is_before(const RideByDistanceSortEntry *a, const RideByDistanceSortEntry *b) {
+    return a->key > b->key;
+}
+
+DEFINE_TYPED_SORT(rides_by_distance, RideByDistanceSortEntry, ride_by_distance_sort_entry_is_before)
 
-    int by_account_creation_driver = date_compare(driver_a_account_creation_date, driver_b_account_creation_date);
-    if (by_account_creation_driver != 0) {
-        return by_account_creation_driver;
+void sort_rides_by_distance(GPtrArray *rides) {
+    // The key only holds packed values, so extended rides are compared field by field
+    for (guint i = 0; i < rides->len; i++) {
+        if (G_UNLIKELY(ride_is_extended(rides->pdata[i]))) {
+            sort_array(rides, compare_rides_by_distance);
+            return;
+        }
     }
 
-    Date user_a_account_creation_date = ride_get_user_account_creation_date(ride_a);
-    Date user_b_account_creation_date = ride_get_user_account_creation_date(ride_b);
+    RideByDistanceSortEntry *entries = malloc(sizeof(RideByDistanceSortEntry) * MAX(rides->len, 1));
 
-    int by_account_creation_user = date_compare(user_a_account_creation_date, user_b_account_creation_date);
-    if (by_account_creation_user != 0) {
-        return by_account_creation_user;
+    for (guint i = 0; i < rides->len; i++) {
+        Ride *ride = rides->pdata[i];
+        entries[i].key = (uint64_t) ride->distance << 40 | (uint64_t) ride->date << 24 | ride->id;
+        entries[i].ride = ride;
     }
 
-    return ride_get_id(ride_a) - ride_get_id(ride_b);
+    rides_by_distance_sort(entries, rides->len);
+
+    for (guint i = 0; i < rides->len; i++) rides->pdata[i] = entries[i].ride;
+    free(entries);
 }
@@ -0,0 +1,211 @@
+#include "ride_columns.h"
+
+#include "typed_array.h"
+
+/**
+ * Struct that represents a value of a row that doesn't fit in its narrow column (only extended rides have them).
+ * The column holds 0 in that row, so sums add the overflows of their rows on top of the column.
+ */
+typedef struct {
+    guint row;
+    int64_t value;
+} RideColumnOverflow;
+
+DEFINE_TYPED_ARRAY(RideColumnOverflowArray, ride_column_overflow_array, RideColumnOverflow)
+
+/**
+ * Returns TRUE if the row of the overflow is before the given row.
+ */
+static inline gboolean ride_column_overflow_is_before_row(const RideColumnOverflow *overflow, guint row) {
+    return overflow->row < row;
+}
+
+DEFINE_TYPED_LOWER_BOUND(find_ride_column_overflow, RideColumnOverflow, guint, ride_column_overflow_is_before_row)
+
+/**
+ * Struct that represents a columnar store of rides.
+ * Columns that were not selected are NULL, as are the overflows of columns where every value fits.
+ */
+struct RideColumns {
+    guint length;
+    uint32_t *date; // Encoded dates, they compare as integers
+    int32_t *price;
+    int32_t *tip;
+    uint8_t *distance;
+    uint8_t *city_id;
+    int32_t *user_id;
+    int32_t *driver_id;
+
+    RideColumnOverflowArray *price_overflows;
+    RideColumnOverflowArray *tip_overflows;
+    RideColumnOverflowArray *distance_overflows;
+    RideColumnOverflowArray *city_id_overflows;
+};
+
+/**
+ * Records the value of a row that doesn't fit in its column, in rows order.
+ */
+static void add_ride_column_overflow(RideColumnOverflowArray **overflows, guint row, int64_t value) {
+    if (*overflows == NULL) *overflows = create_ride_column_overflow_array(0);
+    ride_column_overflow_array_append(*overflows, (RideColumnOverflow) {row, value});
+}
+
+/**
+ * Returns the value of a row of a narrow column, which is in the overflows if it didn't fit.
+ */
+static inline int64_t get_ride_column_value(RideColumnOverflowArray *overflows, guint row, int64_t column_value) {
+    if (G_LIKELY(overflows == NULL)) return column_value;
+
+    size_t index = find_ride_column_overflow(overflows->data, overflows->len, row);
+    if (index < overflows->len && overflows->data[index].row == row) return overflows->data[index].value;
+    return column_value;
+}
+
+/**
+ * Returns the sum of the overflows of the rows in `[from, to)`.
+ */
+static int64_t sum_ride_column_overflows(RideColumnOverflowArray *overflows, guint from, guint to) {
+    if (G_LIKELY(overflows == NULL)) return 0;
+
+    int64_t sum = 0;
+    for (size_t i = find_ride_column_overflow(overflows->data, overflows->len, from); i < overflows->len && overflows->data[i].row < to; i++) {
+        sum += overflows->data[i].value;
+    }
+    return sum;
+}
+
+RideColumns *create_ride_columns(GPtrArray *rides, RideColumnSet columns) {
+    RideColumns *ride_columns = malloc(sizeof(RideColumns));
+    guint length = rides->len;
+
+    ride_columns->length = length;
+    ride_columns->date = columns & RIDE_COLUMN_DATE ? malloc(sizeof(uint32_t) * length) : NULL;
+    ride_columns->price = columns & RIDE_COLUMN_PRICE ? malloc(sizeof(int32_t) * length) : NULL;
+    ride_columns->tip = columns & RIDE_COLUMN_TIP ? malloc(sizeof(int32_t) * length) : NULL;
+    ride_columns->distance = columns & RIDE_COLUMN_DISTANCE ? malloc(sizeof(uint8_t) * length) : NULL;
+    ride_columns->city_id = columns & RIDE_COLUMN_CITY_ID ? malloc(sizeof(uint8_t) * length) : NULL;
+    ride_columns->user_id = columns & RIDE_COLUMN_USER_ID ? malloc(sizeof(int32_t) * length) : NULL;
+    ride_columns->driver_id = columns & RIDE_COLUMN_DRIVER_ID ? malloc(sizeof(int32_t) * length) : NULL;
+    ride_columns->price_overflows = NULL;
+    ride_columns->tip_overflows = NULL;
+    ride_columns->distance_overflows = NULL;
+    ride_columns->city_id_overflows = NULL;
+
+    for (guint row = 0; row < length; row++) {
+        Ride *ride = g_ptr_array_index(rides, row);
+
+        if (ride_columns->date) ride_columns->date[row] = ride_get_date(ride).encoded_date;
+        if (ride_columns->price) {
+            Money price = ride_get_price(ride);
+            ride_columns->price[row] = price <= INT32_MAX ? (int32_t) price : 0;
+            if (G_UNLIKELY(price > INT32_MAX)) add_ride_column_overflow(&ride_columns->price_overflows, row, price);
+        }
+        if (ride_columns->tip) {
+            Money tip = ride_get_tip(ride);
+            ride_columns->tip[row] = tip <= INT32_MAX ? (int32_t) tip : 0;
+            if (G_UNLIKELY(tip > INT32_MAX)) add_ride_column_overflow(&ride_columns->tip_overflows, row, tip);
+        }
+        if (ride_columns->distance) {
+            int distance = ride_get_distance(ride);
+            ride_columns->distance[row] = distance <= UINT8_MAX ? (uint8_t) distance : 0;
+            if (G_UNLIKELY(distance > UINT8_MAX)) add_ride_column_overflow(&ride_columns->distance_overflows, row, distance);
+        }
+        if (ride_columns->city_id) {
+            int city_id = ride_get_city_id(ride);
+            ride_columns->city_id[row] = city_id <= UINT8_MAX ? (uint8_t) city_id : 0;
+            if (G_UNLIKELY(city_id > UINT8_MAX)) add_ride_column_overflow(&ride_columns->city_id_overflows, row, city_id);
+        }
+        if (ride_columns->user_id) ride_columns->user_id[row] = ride_get_user_id(ride);
+        if (ride_columns->driver_id) ride_columns->driver_id[row] = ride_get_driver_id(ride);
+    }
+
+    return ride_columns;
+}
+
+guint ride_columns_get_length(RideColumns *ride_columns) {
+    return ride_columns->length;
+}
+
+Date ride_columns_get_date(RideColumns *ride_columns, guint row) {
+    return (Date){.encoded_date = ride_columns->date[row]};
+}
+
+Money ride_columns_get_price(RideColumns *ride_columns, guint row) {
+    return get_ride_column_value(ride_columns->price_overflows, row, ride_columns->price[row]);
+}
+
+Money ride_columns_get_tip(RideColumns *ride_columns, guint row) {
+    return get_ride_column_value(ride_columns->tip_overflows, row, ride_columns->tip[row]);
+}
+
+int ride_columns_get_distance(RideColumns *ride_columns, guint row) {
+    return (int) get_ride_column_value(ride_columns->distance_overflows, row, ride_columns->distance[row]);
+}
+
+int ride_columns_get_city_id(RideColumns *ride_columns, guint row) {
+    return (int) get_ride_column_value(ride_columns->city_id_overflows, row, ride_columns->city_id[row]);
+}
+
+int ride_columns_get_user_id(RideColumns *ride_columns, guint row) {
+    return ride_columns->user_id[row];
+}
+
+int ride_columns_get_driver_id(RideColumns *ride_columns, guint row) {
+    return ride_columns->driver_id[row];
+}
+
+/**
+ * Returns TRUE if the encoded date of a row is before the given one.
+ */
+static inline gboolean encoded_date_is_before(const uint32_t *row_date, uint32_t date) {
+    return *row_date < date;
+}
+
+/**
+ * Returns TRUE if the encoded date of a row is not after the given one.
+ */
+static inline gboolean encoded_date_is_not_after(const uint32_t *row_date, uint32_t date) {
+    return *row_date <= date;
+}
+
+DEFINE_TYPED_LOWER_BOUND(find_encoded_date_lower_bound, uint32_t, uint32_t, encoded_date_is_before)
+DEFINE_TYPED_LOWER_BOUND(find_encoded_date_upper_bound, uint32_t, uint32_t, encoded_date_is_not_after)
+
+guint ride_columns_find_date_lower_bound(RideColumns *ride_columns, Date date) {
+    return (guint) find_encoded_date_lower_bound(ride_columns->date, ride_columns->length, date.encoded_date);
+}
+
+guint ride_columns_find_date_upper_bound(RideColumns *ride_columns, Date date) {
+    return (guint) find_encoded_date_upper_bound(ride_columns->date, ride_columns->length, date.encoded_date);
+}
+
+Money ride_columns_sum_prices(RideColumns *ride_columns, guint from, guint to) {
+    Money sum = 0;
+    for (guint row = from; row < to; row++) {
+        sum += ride_columns->price[row];
+    }
+    return sum + sum_ride_column_overflows(ride_columns->price_overflows, from, to);
+}
+
+int64_t ride_columns_sum_distances(RideColumns *ride_columns, guint from, guint to) {
+    int64_t sum = 0;
+    for (guint row = from; row < to; row++) {
+        sum += ride_columns->distance[row];
+    }
+    return sum + sum_ride_column_overflows(ride_columns->distance_overflows, from, to);
+}
+
+void free_ride_columns(RideColumns *ride_columns) {
+    free(ride_columns->date);
+    free(ride_columns->price);
+    free(ride_columns->tip);
+    free(ride_columns->distance);
+    free(ride_columns->city_id);
+    free(ride_columns->user_id);
+    free(ride_columns->driver_id);
+    if (ride_columns->price_overflows != NULL) free_ride_column_overflow_array(ride_columns->price_overflows);
+    if (ride_columns->tip_overflows != NULL) free_ride_column_overflow_array(ride_columns->tip_overflows);
+    if (ride_columns->distance_overflows != NULL) free_ride_column_overflow_array(ride_columns->distance_overflows);
+    if (ride_columns->city_id_overflows != NULL) free_ride_column_overflow_array(ride_columns->city_id_overflows);
+    free(ride_columns);
+}
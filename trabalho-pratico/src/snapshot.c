@@ -0,0 +1,236 @@
+#include "snapshot.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "logger.h"
+
+#define SNAPSHOT_MAGIC "LI3SNAP\n"
+#define SNAPSHOT_BYTE_ORDER_MARK 0x01020304u
+
+/**
+ * Header at the start of every snapshot file.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint64_t dataset_fingerprint;
+    uint64_t payload_size;
+    uint64_t payload_checksum;
+} SnapshotHeader;
+
+struct SnapshotWriter {
+    GByteArray *payload;
+};
+
+struct SnapshotReader {
+    GMappedFile *mapped_file;
+    char *current;
+    char *end;
+    gboolean error;
+};
+
+uint64_t compute_snapshot_checksum(const void *data, size_t size, uint64_t seed) {
+    // FNV-1a over 8 byte words (and the remaining bytes one by one)
+    const uint64_t prime = 0x100000001b3ULL;
+    const unsigned char *bytes = data;
+    uint64_t hash = 0xcbf29ce484222325ULL ^ seed;
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(uint64_t));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ bytes[i]) * prime;
+    }
+
+    return hash;
+}
+
+SnapshotWriter *create_snapshot_writer(void) {
+    SnapshotWriter *writer = malloc(sizeof(SnapshotWriter));
+    writer->payload = g_byte_array_new();
+    return writer;
+}
+
+void snapshot_write_uint8(SnapshotWriter *writer, uint8_t value) {
+    g_byte_array_append(writer->payload, &value, sizeof(value));
+}
+
+void snapshot_write_uint16(SnapshotWriter *writer, uint16_t value) {
+    g_byte_array_append(writer->payload, (const guint8 *) &value, sizeof(value));
+}
+
+void snapshot_write_uint32(SnapshotWriter *writer, uint32_t value) {
+    g_byte_array_append(writer->payload, (const guint8 *) &value, sizeof(value));
+}
+
+void snapshot_write_int32(SnapshotWriter *writer, int32_t value) {
+    g_byte_array_append(writer->payload, (const guint8 *) &value, sizeof(value));
+}
+
+void snapshot_write_int64(SnapshotWriter *writer, int64_t value) {
+    g_byte_array_append(writer->payload, (const guint8 *) &value, sizeof(value));
+}
+
+void snapshot_write_string(SnapshotWriter *writer, const char *string) {
+    uint32_t length = (uint32_t) strlen(string);
+    snapshot_write_uint32(writer, length);
+    g_byte_array_append(writer->payload, (const guint8 *) string, length + 1);
+}
+
+gboolean snapshot_writer_save(SnapshotWriter *writer, const char *file_path, uint64_t dataset_fingerprint) {
+    FILE *file = fopen(file_path, "wb");
+    if (file == NULL) {
+        LOG_WARNING_VA("Could not create snapshot file '%s'", file_path);
+        return FALSE;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(SnapshotHeader));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_FORMAT_VERSION;
+    header.byte_order_mark = SNAPSHOT_BYTE_ORDER_MARK;
+    header.dataset_fingerprint = dataset_fingerprint;
+    header.payload_size = writer->payload->len;
+    header.payload_checksum = compute_snapshot_checksum(writer->payload->data, writer->payload->len, 0);
+
+    gboolean written = fwrite(&header, sizeof(SnapshotHeader), 1, file) == 1 &&
+                       fwrite(writer->payload->data, 1, writer->payload->len, file) == writer->payload->len;
+
+    if (fclose(file) != 0 || !written) {
+        LOG_WARNING_VA("Could not write snapshot file '%s'", file_path);
+        remove(file_path); // never leave a truncated snapshot behind
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void free_snapshot_writer(SnapshotWriter *writer) {
+    g_byte_array_free(writer->payload, TRUE);
+    free(writer);
+}
+
+SnapshotReader *open_snapshot_reader(const char *file_path, uint64_t dataset_fingerprint) {
+    GError *error = NULL;
+    // Writable mappings are private (copy-on-write), strings read from the snapshot are typed as char *
+    GMappedFile *mapped_file = g_mapped_file_new(file_path, TRUE, &error);
+    if (mapped_file == NULL) {
+        LOG_WARNING_VA("Could not open snapshot file '%s'", file_path);
+        g_error_free(error);
+        return NULL;
+    }
+
+    char *contents = g_mapped_file_get_contents(mapped_file);
+    size_t size = g_mapped_file_get_length(mapped_file);
+
+    SnapshotHeader header;
+    const char *problem = NULL;
+
+    if (size < sizeof(SnapshotHeader)) {
+        problem = "it is too small";
+    } else {
+        memcpy(&header, contents, sizeof(SnapshotHeader));
+
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+            problem = "it is not a snapshot";
+        } else if (header.version != SNAPSHOT_FORMAT_VERSION || header.byte_order_mark != SNAPSHOT_BYTE_ORDER_MARK) {
+            problem = "it was written by another version or machine";
+        } else if (header.dataset_fingerprint != dataset_fingerprint) {
+            problem = "the dataset changed";
+        } else if (header.payload_size != size - sizeof(SnapshotHeader)) {
+            problem = "it is truncated";
+        } else if (header.payload_checksum != compute_snapshot_checksum(contents + sizeof(SnapshotHeader), header.payload_size, 0)) {
+            problem = "the checksum doesn't match";
+        }
+    }
+
+    if (problem != NULL) {
+        LOG_WARNING_VA("Ignoring snapshot file '%s': %s", file_path, problem);
+        g_mapped_file_unref(mapped_file);
+        return NULL;
+    }
+
+    SnapshotReader *reader = malloc(sizeof(SnapshotReader));
+    reader->mapped_file = mapped_file;
+    reader->current = contents + sizeof(SnapshotHeader);
+    reader->end = contents + size;
+    reader->error = FALSE;
+
+    return reader;
+}
+
+/**
+ * Copies the next `size` bytes into value and advances the reader.
+ * Sets the error flag (and zeroes value) if there are not enough bytes left.
+ */
+static inline void snapshot_read_bytes(SnapshotReader *reader, void *value, size_t size) {
+    if (G_UNLIKELY((size_t) (reader->end - reader->current) < size)) {
+        reader->error = TRUE;
+        memset(value, 0, size);
+        return;
+    }
+
+    memcpy(value, reader->current, size);
+    reader->current += size;
+}
+
+uint8_t snapshot_read_uint8(SnapshotReader *reader) {
+    uint8_t value;
+    snapshot_read_bytes(reader, &value, sizeof(value));
+    return value;
+}
+
+uint16_t snapshot_read_uint16(SnapshotReader *reader) {
+    uint16_t value;
+    snapshot_read_bytes(reader, &value, sizeof(value));
+    return value;
+}
+
+uint32_t snapshot_read_uint32(SnapshotReader *reader) {
+    uint32_t value;
+    snapshot_read_bytes(reader, &value, sizeof(value));
+    return value;
+}
+
+int32_t snapshot_read_int32(SnapshotReader *reader) {
+    int32_t value;
+    snapshot_read_bytes(reader, &value, sizeof(value));
+    return value;
+}
+
+int64_t snapshot_read_int64(SnapshotReader *reader) {
+    int64_t value;
+    snapshot_read_bytes(reader, &value, sizeof(value));
+    return value;
+}
+
+char *snapshot_read_string(SnapshotReader *reader) {
+    uint32_t length = snapshot_read_uint32(reader);
+
+    if (G_UNLIKELY(reader->error || (size_t) (reader->end - reader->current) < (size_t) length + 1 || reader->current[length] != '\0')) {
+        reader->error = TRUE;
+        return "";
+    }
+
+    char *string = reader->current;
+    reader->current += length + 1;
+    return string;
+}
+
+void snapshot_reader_fail(SnapshotReader *reader) {
+    reader->error = TRUE;
+}
+
+gboolean snapshot_reader_has_error(SnapshotReader *reader) {
+    return reader->error;
+}
+
+void free_snapshot_reader(SnapshotReader *reader) {
+    g_mapped_file_unref(reader->mapped_file);
+    free(reader);
+}
@@ -0,0 +1,49 @@
+#include "string_heap.h"
+
+#include <string.h>
+
+/**
+ * Struct that represents a string heap.
+ */
+struct StringHeap {
+    char *buffer;
+    size_t size; // Bytes used
+    size_t capacity;
+};
+
+StringHeap *create_string_heap(size_t reserved_size) {
+    StringHeap *string_heap = malloc(sizeof(StringHeap));
+    string_heap->capacity = MAX(reserved_size, 64);
+    string_heap->buffer = malloc(string_heap->capacity);
+    string_heap->size = 0;
+    return string_heap;
+}
+
+uint32_t string_heap_append(StringHeap *string_heap, const char *string, size_t length) {
+    g_assert(string_heap->size + length + 1 <= UINT32_MAX); // Offsets are 32 bits
+
+    if (string_heap->size + length + 1 > string_heap->capacity) {
+        string_heap->capacity = MAX(string_heap->capacity * 2, string_heap->size + length + 1);
+        string_heap->buffer = realloc(string_heap->buffer, string_heap->capacity);
+    }
+
+    uint32_t offset = (uint32_t) string_heap->size;
+    memcpy(string_heap->buffer + offset, string, length);
+    string_heap->buffer[offset + length] = '\0';
+    string_heap->size += length + 1;
+
+    return offset;
+}
+
+const char *string_heap_get(StringHeap *string_heap, uint32_t offset) {
+    return string_heap->buffer + offset;
+}
+
+size_t string_heap_get_size(StringHeap *string_heap) {
+    return string_heap->size;
+}
+
+void free_string_heap(StringHeap *string_heap) {
+    free(string_heap->buffer);
+    free(string_heap);
+}
@@ -0,0 +1,203 @@
+#include "string_index.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Maximum load factor of the index, as a fraction of STRING_INDEX_LOAD_FACTOR_DENOMINATOR.
+ */
+#define STRING_INDEX_MAX_LOAD_FACTOR 7
+#define STRING_INDEX_LOAD_FACTOR_DENOMINATOR 8
+
+/**
+ * Struct that represents a slot of the index.
+ */
+typedef struct {
+    uint32_t hash; // 0 marks an empty slot, hashes of keys are never 0
+    uint32_t key_offset; // Offset in the string heap
+    int32_t id;
+} StringIndexSlot;
+
+/**
+ * Struct that represents a string index.
+ */
+struct StringIndex {
+    StringIndexSlot *slots;
+    guint capacity; // Always a power of two
+    guint mask; // capacity - 1
+    guint size;
+    StringHeap *string_heap;
+};
+
+/**
+ * Hashes the string 8 bytes at a time (the FxHash mixing step) and returns the well mixed high 32 bits.
+ */
+static uint32_t hash_string(const char *string, size_t length) {
+    const uint64_t multiplier = 0x517cc1b727220a95ULL;
+    uint64_t hash = length;
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, string + i, 8);
+        hash = (((hash << 5) | (hash >> 59)) ^ word) * multiplier;
+    }
+    if (i < length) {
+        // Byte by byte, a memcpy of a variable size is a library call
+        uint64_t word = 0;
+        for (size_t j = i; j < length; j++) word = (word << 8) | (uint8_t) string[j];
+        hash = (((hash << 5) | (hash >> 59)) ^ word) * multiplier;
+    }
+
+    uint32_t folded_hash = (uint32_t) (hash >> 32);
+    return folded_hash != 0 ? folded_hash : 1;
+}
+
+/**
+ * Returns the smallest power of two capacity that fits `count` keys under the maximum load factor.
+ */
+static guint compute_capacity_for(guint count) {
+    guint capacity = 16;
+    while ((guint64) capacity * STRING_INDEX_MAX_LOAD_FACTOR < (guint64) count * STRING_INDEX_LOAD_FACTOR_DENOMINATOR) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/**
+ * Returns how far the slot is from the home slot of the hash.
+ */
+static inline guint probe_distance(StringIndex *string_index, uint32_t hash, guint slot) {
+    return (slot - (hash & string_index->mask)) & string_index->mask;
+}
+
+/**
+ * Places a slot of a key that is not in the index, displacing the entries closer to their home slot.
+ */
+static void string_index_place(StringIndex *string_index, StringIndexSlot entry) {
+    guint slot = entry.hash & string_index->mask;
+    guint distance = 0;
+
+    while (string_index->slots[slot].hash != 0) {
+        guint existing_distance = probe_distance(string_index, string_index->slots[slot].hash, slot);
+        if (existing_distance < distance) {
+            StringIndexSlot displaced = string_index->slots[slot];
+            string_index->slots[slot] = entry;
+            entry = displaced;
+            distance = existing_distance;
+        }
+
+        slot = (slot + 1) & string_index->mask;
+        distance++;
+    }
+
+    string_index->slots[slot] = entry;
+}
+
+/**
+ * Replaces the slots with `capacity` empty slots and places the old entries again (the hashes are stored, so no key is read).
+ */
+static void string_index_resize(StringIndex *string_index, guint capacity) {
+    StringIndexSlot *old_slots = string_index->slots;
+    guint old_capacity = string_index->capacity;
+
+    string_index->slots = calloc(capacity, sizeof(StringIndexSlot));
+    string_index->capacity = capacity;
+    string_index->mask = capacity - 1;
+
+    for (guint i = 0; i < old_capacity; i++) {
+        if (old_slots[i].hash != 0) string_index_place(string_index, old_slots[i]);
+    }
+
+    free(old_slots);
+}
+
+StringIndex *create_string_index(StringHeap *string_heap, guint expected_count) {
+    StringIndex *string_index = malloc(sizeof(StringIndex));
+
+    string_index->capacity = compute_capacity_for(expected_count);
+    string_index->mask = string_index->capacity - 1;
+    string_index->slots = calloc(string_index->capacity, sizeof(StringIndexSlot));
+    string_index->size = 0;
+    string_index->string_heap = string_heap;
+
+    return string_index;
+}
+
+void string_index_reserve(StringIndex *string_index, guint expected_count) {
+    guint capacity = compute_capacity_for(expected_count);
+    if (capacity > string_index->capacity) string_index_resize(string_index, capacity);
+}
+
+/**
+ * Returns the slot with the key or NULL if the key is not in the index.
+ */
+static StringIndexSlot *string_index_find(StringIndex *string_index, const char *key, uint32_t hash) {
+    guint slot = hash & string_index->mask;
+    guint distance = 0;
+
+    while (TRUE) {
+        StringIndexSlot *current = &string_index->slots[slot];
+
+        // Robin Hood invariant: the key would have taken the place of an entry closer to its home slot
+        if (current->hash == 0 || probe_distance(string_index, current->hash, slot) < distance) return NULL;
+
+        if (current->hash == hash && strcmp(string_heap_get(string_index->string_heap, current->key_offset), key) == 0) {
+            return current;
+        }
+
+        slot = (slot + 1) & string_index->mask;
+        distance++;
+    }
+}
+
+uint32_t string_index_insert(StringIndex *string_index, const char *key, int id) {
+    size_t length = strlen(key);
+    uint32_t hash = hash_string(key, length);
+
+    StringIndexSlot *existing = string_index_find(string_index, key, hash);
+    if (existing != NULL) {
+        existing->id = id;
+        return existing->key_offset;
+    }
+
+    if ((guint64) (string_index->size + 1) * STRING_INDEX_LOAD_FACTOR_DENOMINATOR > (guint64) string_index->capacity * STRING_INDEX_MAX_LOAD_FACTOR) {
+        string_index_resize(string_index, string_index->capacity * 2);
+    }
+
+    StringIndexSlot entry = {hash, string_heap_append(string_index->string_heap, key, length), id};
+    string_index_place(string_index, entry);
+    string_index->size++;
+
+    return entry.key_offset;
+}
+
+int string_index_lookup(StringIndex *string_index, const char *key) {
+    return string_index_lookup_with_hash(string_index, key, string_index_hash(key));
+}
+
+uint32_t string_index_hash(const char *key) {
+    return hash_string(key, strlen(key));
+}
+
+void string_index_prefetch(StringIndex *string_index, uint32_t hash) {
+    __builtin_prefetch(&string_index->slots[hash & string_index->mask]);
+}
+
+int string_index_lookup_with_hash(StringIndex *string_index, const char *key, uint32_t hash) {
+    StringIndexSlot *slot = string_index_find(string_index, key, hash);
+    return slot != NULL ? slot->id : STRING_INDEX_NOT_FOUND;
+}
+
+guint string_index_get_size(StringIndex *string_index) {
+    return string_index->size;
+}
+
+guint string_index_get_capacity(StringIndex *string_index) {
+    return string_index->capacity;
+}
+
+void free_string_index(StringIndex *string_index) {
+    free(string_index->slots);
+    free(string_index);
+}
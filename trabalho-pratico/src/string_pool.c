@@ -0,0 +1,139 @@
+#include "string_pool.h"
+
+#include <string.h>
+
+#include "string_heap.h"
+#include "string_index.h"
+
+/**
+ * Struct that represents a string pool.
+ */
+struct StringPool {
+    StringHeap *string_heap; // Every distinct string, once
+    StringIndex *string_index; // From a string to its id, which is the offset of the string in the heap
+    guint reference_count;
+    size_t referenced_size;
+    uint32_t *snapshot_ids; // Id of each string in the last snapshot, indexed by id (NULL before writing a snapshot)
+    GMutex mutex;
+};
+
+StringPool *create_string_pool(void) {
+    StringPool *string_pool = malloc(sizeof(StringPool));
+
+    string_pool->string_heap = create_string_heap(0);
+    string_pool->string_index = create_string_index(string_pool->string_heap, 0);
+    string_pool->reference_count = 0;
+    string_pool->referenced_size = 0;
+    string_pool->snapshot_ids = NULL;
+    g_mutex_init(&string_pool->mutex);
+
+    return string_pool;
+}
+
+uint32_t string_pool_intern(StringPool *string_pool, const char *string) {
+    g_mutex_lock(&string_pool->mutex);
+
+    int string_id = string_index_lookup(string_pool->string_index, string);
+    if (string_id == STRING_INDEX_NOT_FOUND) {
+        // The key is appended at the end of the heap, so its offset is known before inserting it
+        string_id = (int) string_heap_get_size(string_pool->string_heap);
+        string_index_insert(string_pool->string_index, string, string_id);
+    }
+
+    string_pool->reference_count++;
+    string_pool->referenced_size += strlen(string) + 1;
+
+    g_mutex_unlock(&string_pool->mutex);
+
+    return (uint32_t) string_id;
+}
+
+const char *string_pool_get(StringPool *string_pool, uint32_t string_id) {
+    return string_heap_get(string_pool->string_heap, string_id);
+}
+
+guint string_pool_get_unique_count(StringPool *string_pool) {
+    return string_index_get_size(string_pool->string_index);
+}
+
+size_t string_pool_get_size(StringPool *string_pool) {
+    return string_heap_get_size(string_pool->string_heap);
+}
+
+guint string_pool_get_reference_count(StringPool *string_pool) {
+    return string_pool->reference_count;
+}
+
+size_t string_pool_get_referenced_size(StringPool *string_pool) {
+    return string_pool->referenced_size;
+}
+
+gboolean string_pool_is_valid_id(StringPool *string_pool, uint32_t string_id) {
+    // Ids are offsets of strings in the heap: the first one or the one after a null terminator
+    if (string_id >= string_heap_get_size(string_pool->string_heap)) return FALSE;
+    return string_id == 0 || *string_heap_get(string_pool->string_heap, string_id - 1) == '\0';
+}
+
+/**
+ * Function that compares two ids of the string pool by their strings, for `string_pool_write_snapshot`.
+ */
+static gint compare_string_ids_by_string(gconstpointer a, gconstpointer b, gpointer string_heap) {
+    return strcmp(string_heap_get(string_heap, *(const uint32_t *) a), string_heap_get(string_heap, *(const uint32_t *) b));
+}
+
+void string_pool_write_snapshot(StringPool *string_pool, SnapshotWriter *writer) {
+    StringHeap *string_heap = string_pool->string_heap;
+    size_t size = string_heap_get_size(string_heap);
+    guint strings_count = string_index_get_size(string_pool->string_index);
+
+    uint32_t *sorted_ids = malloc(sizeof(uint32_t) * MAX(strings_count, 1));
+    guint sorted_count = 0;
+    for (size_t offset = 0; offset < size; offset += strlen(string_heap_get(string_heap, offset)) + 1) {
+        sorted_ids[sorted_count++] = (uint32_t) offset;
+    }
+    g_qsort_with_data(sorted_ids, (gint) sorted_count, sizeof(uint32_t), compare_string_ids_by_string, string_heap);
+
+    // Restoring interns the strings in this order, so each one gets the offset it has in the sorted heap
+    free(string_pool->snapshot_ids);
+    string_pool->snapshot_ids = malloc(sizeof(uint32_t) * MAX(size, 1));
+
+    snapshot_write_uint32(writer, sorted_count);
+    uint32_t snapshot_offset = 0;
+    for (guint i = 0; i < sorted_count; i++) {
+        const char *string = string_heap_get(string_heap, sorted_ids[i]);
+        snapshot_write_string(writer, string);
+
+        string_pool->snapshot_ids[sorted_ids[i]] = snapshot_offset;
+        snapshot_offset += strlen(string) + 1;
+    }
+
+    free(sorted_ids);
+}
+
+uint32_t string_pool_get_snapshot_id(StringPool *string_pool, uint32_t string_id) {
+    return string_pool->snapshot_ids[string_id];
+}
+
+gboolean string_pool_read_snapshot(StringPool *string_pool, SnapshotReader *reader) {
+    guint strings_count = snapshot_read_uint32(reader);
+
+    for (guint i = 0; i < strings_count && !snapshot_reader_has_error(reader); i++) {
+        // Distinct strings interned in the same order get the same offsets
+        size_t expected_id = string_heap_get_size(string_pool->string_heap);
+        if (string_pool_intern(string_pool, snapshot_read_string(reader)) != expected_id) return FALSE;
+    }
+
+    // The restored entities don't intern their strings again, so there are no references to count
+    string_pool->reference_count = 0;
+    string_pool->referenced_size = 0;
+
+    return !snapshot_reader_has_error(reader);
+}
+
+void free_string_pool(StringPool *string_pool) {
+    free_string_index(string_pool->string_index);
+    free_string_heap(string_pool->string_heap);
+    free(string_pool->snapshot_ids);
+    g_mutex_clear(&string_pool->mutex);
+    free(string_pool);
+}
@@ -1,14 +1,13 @@
 #include "string_util.h"
 
+#include "delimiter_scanner.h"
 #include <ctype.h>
 #include <string.h>
 
 inline char *next_token(char **line, char delim) {
     char *start = *line;
 
-    while (**line != delim && **line != '\0') {
-        (*line)++;
-    }
+    *line = find_delimiter_or_end(*line, delim);
 
     if (**line == delim) {
         **line = '\0';
@@ -18,8 +18,8 @@ static int is_digit(char c) {
     return c >= '0' && c <= '9';
 }
 
-int parse_int_safe(char *string, int *error) {
-    int val = 0;
+int parse_int_safe_reference(char *string, int *error) {
+    int64_t val = 0; // Wider than int, so overflow can be detected before it happens
 
     gboolean negative = FALSE;
     if (*string == '-') {
@@ -33,8 +33,87 @@ int parse_int_safe(char *string, int *error) {
             return 0;
         }
         val = val * 10 + (*string++ - '0');
+        if (G_UNLIKELY(val > (int64_t) G_MAXINT + 1)) {
+            *error = 1;
+            return 0;
+        }
     }
-    return negative ? -val : val;
+
+    if (G_UNLIKELY(!negative && val > G_MAXINT)) {
+        *error = 1;
+        return 0;
+    }
+    return (int) (negative ? -val : val);
+}
+
+#define SWAR_ONES 0x0101010101010101ULL
+#define SWAR_HIGH_BITS 0x8080808080808080ULL
+#define SWAR_ASCII_ZEROS 0x3030303030303030ULL
+#define SWAR_CASE_BITS 0x2020202020202020ULL
+
+/**
+ * Loads the first 8 bytes of a NUL terminated string into a little endian word, zeroing every byte from the terminator on.
+ * Sets length to the length of the string if it is shorter than 8, or to 8 otherwise.
+ * The bytes are gathered one by one up to the terminator, as the string may end anywhere in its buffer.
+ */
+static inline uint64_t load_string_word(const char *string, int *length) {
+    uint64_t word = 0;
+
+    for (int i = 0; i < 8 && string[i] != '\0'; i++) {
+        word |= (uint64_t) (unsigned char) string[i] << (i * 8);
+    }
+
+    // Classic "has zero byte" trick: the lowest set high bit marks the first '\0'
+    uint64_t zero_bytes = (word - SWAR_ONES) & ~word & SWAR_HIGH_BITS;
+    if (zero_bytes == 0) {
+        *length = 8;
+        return word;
+    }
+
+    *length = __builtin_ctzll(zero_bytes) / 8;
+    return *length == 0 ? 0 : word & (~0ULL >> (64 - *length * 8));
+}
+
+/**
+ * Returns a word with the high bit set in every byte of `digits` (already xored with '0') that isn't a digit.
+ * Xoring with '0' maps exactly the digit characters to 0..9, without borrows between bytes.
+ * Only the bytes selected by `mask` are checked.
+ */
+static inline uint64_t swar_non_digit_bytes(uint64_t digits, uint64_t mask) {
+    // A byte is a digit if it's <= 9: adding 0x76 sets its high bit otherwise, bytes >= 0x80 already have it set
+    return ((digits + 0x7676767676767676ULL) | digits) & SWAR_HIGH_BITS & mask;
+}
+
+/**
+ * Converts 8 digit bytes (already xored with '0', most significant digit in the lowest byte) into their value.
+ */
+static inline uint32_t swar_eight_digits_value(uint64_t digits) {
+    digits = (digits * 10) + (digits >> 8); // pairs of digits
+    return (uint32_t) (((digits & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))
+                        + (((digits >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32);
+}
+
+int parse_int_safe(char *string, int *error) {
+    int length;
+    uint64_t word = load_string_word(string, &length);
+
+    // Negative numbers and numbers with 8 or more digits are rare, leave them to the reference implementation
+    // (7 digits never overflow an int)
+    if (G_UNLIKELY(length == 8 || string[0] == '-')) {
+        return parse_int_safe_reference(string, error);
+    }
+    if (length == 0) return 0;
+
+    uint64_t length_mask = ~0ULL >> (64 - length * 8);
+    uint64_t digits = (word ^ SWAR_ASCII_ZEROS) & length_mask;
+
+    if (G_UNLIKELY(swar_non_digit_bytes(digits, length_mask) != 0)) {
+        *error = 1;
+        return 0;
+    }
+
+    // Shift the digits to the top of the word, the bytes left below act as leading zeros
+    return (int) swar_eight_digits_value(digits << ((8 - length) * 8));
 }
 
 inline int parse_int_unsafe(char *string) {
@@ -92,11 +171,101 @@ double parse_double_safe(char *string, int *error) {
     return result;
 }
 
+Money parse_money_safe(char *string, int *error) {
+    // Fast path for the most common format (e.g. tips like "1.5"): one digit, a dot and one decimal digit
+    if (is_digit(string[0]) && string[1] == '.' && is_digit(string[2]) && string[3] == '\0') {
+        return (string[0] - '0') * MONEY_SCALE + (string[2] - '0') * (MONEY_SCALE / 10);
+    }
+
+    gboolean negative = FALSE;
+    if (*string == '-') {
+        negative = TRUE;
+        string++;
+    }
+
+    Money integer_part = 0;
+    while (*string && *string != '.') {
+        if (G_UNLIKELY(!is_digit(*string))) {
+            *error = 1;
+            return 0;
+        }
+        integer_part = integer_part * 10 + (*string++ - '0');
+    }
+
+    if (*string == '.') string++;
+
+    // The first 3 decimal places are kept, the 4th one rounds and the others only need to be digits
+    Money decimal_part = 0;
+    Money decimal_place_value = MONEY_SCALE / 10;
+    gboolean round_up = FALSE;
+
+    for (int decimal_place = 0; *string; decimal_place++, string++) {
+        if (G_UNLIKELY(!is_digit(*string))) {
+            *error = 1;
+            return 0;
+        }
+
+        if (decimal_place < 3) {
+            decimal_part += (*string - '0') * decimal_place_value;
+            decimal_place_value /= 10;
+        } else if (decimal_place == 3) {
+            round_up = *string >= '5';
+        }
+    }
+
+    Money result = integer_part * MONEY_SCALE + decimal_part + round_up;
+    return negative ? -result : result;
+}
+
+char *format_money(Money money, char *buffer) {
+    char digits[MONEY_STRING_BUFFER_SIZE];
+    int length = 0;
+
+    uint64_t magnitude = money < 0 ? -(uint64_t) money : (uint64_t) money;
+
+    // Digits in reverse order, at least "0.000"
+    do {
+        if (length == 3) digits[length++] = '.';
+        digits[length++] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0 || length < 5);
+
+    char *current = buffer;
+    if (money < 0) *current++ = '-';
+    while (length > 0) *current++ = digits[--length];
+    *current = '\0';
+
+    return buffer;
+}
+
+Money money_average(Money sum, int count) {
+    return (sum + count / 2) / count;
+}
+
 char *convert_date_to_string(Date date) {
-    char *string = malloc(12);
-    // This can be further modified to accept different date formats
-    sprintf(string, "%02d/%02d/%04d", date_get_day(date), date_get_month(date), date_get_year(date));
-    return string;
+    return format_date(date, malloc(DATE_STRING_BUFFER_SIZE));
+}
+
+char *format_date(Date date, char *buffer) {
+    int day = date_get_day(date);
+    int month = date_get_month(date);
+    int year = date_get_year(date);
+
+    char *current = buffer;
+    *current++ = (char) ('0' + day / 10);
+    *current++ = (char) ('0' + day % 10);
+    *current++ = '/';
+    *current++ = (char) ('0' + month / 10);
+    *current++ = (char) ('0' + month % 10);
+    *current++ = '/';
+    if (year >= 10000) *current++ = (char) ('0' + year / 10000);
+    *current++ = (char) ('0' + year / 1000 % 10);
+    *current++ = (char) ('0' + year / 100 % 10);
+    *current++ = (char) ('0' + year / 10 % 10);
+    *current++ = (char) ('0' + year % 10);
+    *current = '\0';
+
+    return buffer;
 }
 
 int is_date_valid(Date date) {
@@ -110,7 +279,7 @@ int is_date(int day, int month, int year) {
     return day >= 1 && day <= 31 && month >= 1 && month <= 12 && year >= 0;
 }
 
-Date parse_date(char *string) {
+Date parse_date_reference(char *string) {
     // 18/12/2022
     if (string[2] != '/' || string[5] != '/' || string[10] != '\0') {
         return invalid_date;
@@ -137,6 +306,45 @@ Date parse_date(char *string) {
     return create_date(day, month, year);
 }
 
+Date parse_date(char *string) {
+    // 18/12/2022, the same bytes the reference implementation reads
+    if (string[2] != '/' || string[5] != '/' || string[10] != '\0') {
+        return invalid_date;
+    }
+
+    // "dd/mm/yy" in one load and the last two digits of the year in another
+    uint64_t word;
+    uint16_t year_low_word;
+    memcpy(&word, string, sizeof(uint64_t));
+    memcpy(&year_low_word, string + 8, sizeof(uint16_t));
+
+    // Every byte but the two slashes (bytes 2 and 5) must be a digit, the slashes are zeroed so they don't carry below
+    uint64_t digits = (word ^ SWAR_ASCII_ZEROS) & 0xFFFF00FFFF00FFFFULL;
+    uint64_t year_low_digits = (uint64_t) year_low_word ^ 0x3030;
+
+    uint64_t non_digits = swar_non_digit_bytes(digits, 0xFFFF00FFFF00FFFFULL)
+                          | swar_non_digit_bytes(year_low_digits, 0xFFFF);
+    if (G_UNLIKELY(non_digits != 0)) {
+        // Signed fields are accepted by the reference implementation (e.g. a "-000" year), keep the same behaviour
+        return parse_date_reference(string);
+    }
+
+    // Byte i now holds 10 * digit i + digit i + 1
+    uint64_t pairs = digits * 10 + (digits >> 8);
+    uint64_t year_low_pair = year_low_digits * 10 + (year_low_digits >> 8);
+
+    int day = (int) (pairs & 0xFF);
+    int month = (int) ((pairs >> 24) & 0xFF);
+    int year = (int) ((pairs >> 48) & 0xFF) * 100 + (int) (year_low_pair & 0xFF);
+
+    // Branchless range check (unsigned wrap around rejects 0)
+    if (((unsigned) (day - 1) > 30) | ((unsigned) (month - 1) > 11)) {
+        return invalid_date;
+    }
+
+    return create_date(day, month, year);
+}
+
 inline Date create_date(int day, int month, int year) {
     uint32_t encoded = 0;
     encoded |= day;
@@ -165,7 +373,7 @@ inline Gender parse_gender(const char *string) {
     return (string[0] == 'F' ? F : M);
 }
 
-inline CarClass parse_car_class(char *string) {
+CarClass parse_car_class_reference(char *string) {
     str_to_upper(string);
     if (strcmp(string, "BASIC") == 0) {
         return BASIC;
@@ -178,7 +386,7 @@ inline CarClass parse_car_class(char *string) {
     }
 }
 
-inline AccountStatus parse_acc_status(char *string) {
+AccountStatus parse_acc_status_reference(char *string) {
     str_to_upper(string);
     if (strcmp(string, "ACTIVE") == 0) {
         return ACTIVE;
@@ -189,6 +397,48 @@ inline AccountStatus parse_acc_status(char *string) {
     }
 }
 
+/**
+ * Builds a little endian word with the given (lowercase) characters at compile time.
+ */
+#define SWAR_WORD_5(a, b, c, d, e) \
+    ((uint64_t) (a) | (uint64_t) (b) << 8 | (uint64_t) (c) << 16 | (uint64_t) (d) << 24 | (uint64_t) (e) << 32)
+#define SWAR_WORD_6(a, b, c, d, e, f) (SWAR_WORD_5(a, b, c, d, e) | (uint64_t) (f) << 40)
+#define SWAR_WORD_7(a, b, c, d, e, f, g) (SWAR_WORD_6(a, b, c, d, e, f) | (uint64_t) (g) << 48)
+#define SWAR_WORD_8(a, b, c, d, e, f, g, h) (SWAR_WORD_7(a, b, c, d, e, f, g) | (uint64_t) (h) << 56)
+
+/**
+ * Loads up to 8 characters of the string lowercased.
+ * Setting the case bit only lowercases letters, other characters can't become letters, so comparing
+ * the result with a lowercase word is a case insensitive compare.
+ * Returns 0 (which matches no word) if the string has more than 8 characters.
+ */
+static inline uint64_t load_lowercase_string_word(const char *string) {
+    int length;
+    uint64_t word = load_string_word(string, &length);
+
+    if (length == 8 && string[8] != '\0') return 0;
+
+    uint64_t length_mask = length == 0 ? 0 : ~0ULL >> (64 - length * 8);
+    return word | (SWAR_CASE_BITS & length_mask);
+}
+
+CarClass parse_car_class(char *string) {
+    uint64_t word = load_lowercase_string_word(string);
+
+    if (word == SWAR_WORD_5('b', 'a', 's', 'i', 'c')) return BASIC;
+    if (word == SWAR_WORD_5('g', 'r', 'e', 'e', 'n')) return GREEN;
+    if (word == SWAR_WORD_7('p', 'r', 'e', 'm', 'i', 'u', 'm')) return PREMIUM;
+    return INVALID_CAR_CLASS;
+}
+
+AccountStatus parse_acc_status(char *string) {
+    uint64_t word = load_lowercase_string_word(string);
+
+    if (word == SWAR_WORD_6('a', 'c', 't', 'i', 'v', 'e')) return ACTIVE;
+    if (word == SWAR_WORD_8('i', 'n', 'a', 'c', 't', 'i', 'v', 'e')) return INACTIVE;
+    return INVALID_ACCOUNT_STATUS;
+}
+
 inline PaymentMethod parse_pay_method(const char *string) {
     return (string[1] == 'a' ? CASH : (string[1] == 'r' ? CREDIT : DEBIT));
 }
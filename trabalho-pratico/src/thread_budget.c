@@ -0,0 +1,37 @@
+#include "thread_budget.h"
+
+/**
+ * Number of spare threads currently reserved.
+ */
+static gint reserved_spare_threads = 0;
+
+/**
+ * Number of spare threads set by `set_spare_thread_count`, or -1 for the default.
+ */
+static gint spare_thread_count = -1;
+
+int get_spare_thread_count(void) {
+    int spare_threads = g_atomic_int_get(&spare_thread_count);
+    return spare_threads >= 0 ? spare_threads : MAX((int) g_get_num_processors() - 1, 0);
+}
+
+void set_spare_thread_count(int spare_threads) {
+    g_atomic_int_set(&spare_thread_count, MAX(spare_threads, -1));
+}
+
+int reserve_spare_threads(int wanted) {
+    int spare_threads = get_spare_thread_count();
+
+    while (TRUE) {
+        int reserved = g_atomic_int_get(&reserved_spare_threads);
+        int available = spare_threads - reserved;
+        int granted = MIN(wanted, available);
+        if (granted <= 0) return 0;
+
+        if (g_atomic_int_compare_and_exchange(&reserved_spare_threads, reserved, reserved + granted)) return granted;
+    }
+}
+
+void release_spare_threads(int threads) {
+    g_atomic_int_add(&reserved_spare_threads, -threads);
+}
@@ -1,7 +1,9 @@
 #include "token_iterator.h"
 
+#include "delimiter_scanner.h"
 #include "string_util.h"
 #include <stdlib.h>
+#include <string.h>
 #include <glib.h>
 
 /**
@@ -9,10 +11,21 @@
  */
 struct TokenIterator {
     char *string;
+    /**
+     * Offsets (from the start of the line) of the end of every token, filled by the delimiter scanner.
+     * When the table is exhausted the remaining tokens are found with `next_token`.
+     */
+    const uint32_t *token_ends;
+    int token_count;
+    int current_token;
+    char *line;
+    uint32_t scanned_token_ends[DELIMITER_SCANNER_MAX_TOKENS];
 };
 
 TokenIterator *init_semicolon_separated_token_iterator(void) {
     TokenIterator *iterator = malloc(sizeof(TokenIterator));
+    iterator->token_count = 0;
+    iterator->current_token = 0;
     return iterator;
 }
 
@@ -22,9 +35,48 @@ char *token_iterator_current(TokenIterator *iterator) {
 
 void token_iterator_set_current(TokenIterator *iterator, char *string) {
     iterator->string = string;
+    iterator->token_count = 0;
+    iterator->current_token = 0;
+}
+
+void token_iterator_set_current_line(TokenIterator *iterator, char *line) {
+    int token_count = scan_csv_line(line, iterator->scanned_token_ends);
+
+    // Strip the newline (the table only holds the line end if it wasn't truncated)
+    char *line_end = token_count < DELIMITER_SCANNER_MAX_TOKENS
+                     ? line + iterator->scanned_token_ends[token_count - 1]
+                     : strchr(line + iterator->scanned_token_ends[token_count - 1], '\n');
+    if (line_end != NULL) *line_end = '\0';
+
+    token_iterator_set_current_tokens(iterator, line, iterator->scanned_token_ends, token_count);
+}
+
+void token_iterator_set_current_tokens(TokenIterator *iterator, char *line, const uint32_t *token_ends, int token_count) {
+    iterator->string = line;
+    iterator->line = line;
+    iterator->token_ends = token_ends;
+    iterator->token_count = token_count;
+    iterator->current_token = 0;
 }
 
 char *token_iterator_next(TokenIterator *iterator) {
+    if (iterator->current_token < iterator->token_count) {
+        char *start = iterator->string;
+        char *end = iterator->line + iterator->token_ends[iterator->current_token++];
+
+        if (*end == ';') {
+            *end = '\0';
+            iterator->string = end + 1;
+        } else {
+            // Line end: stay on it so the following calls return an empty token like `next_token`
+            *end = '\0';
+            iterator->string = end;
+            iterator->token_count = 0;
+        }
+
+        return start;
+    }
+
     // This can be expanded to support other delimiters and input formats.
     return next_token(&iterator->string, ';');
 }
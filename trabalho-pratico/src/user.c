@@ -7,13 +7,13 @@
  * Struct that represents a user.
  */
 struct User {
-    char *username;
-    char *name;
-    double total_spent;
+    Money total_spent;
     Date birthdate;
     Date account_create_date;
     Date most_recent_ride;
     int32_t id;
+    uint32_t username_offset; // Offset of the username in the username heap of the catalog
+    uint32_t name_id; // Id of the name in the string pool of the catalog
     u_int16_t accumulated_score;
     u_int16_t total_distance;
     u_int16_t rides_amount;
@@ -22,11 +22,11 @@ struct User {
     AccountStatus account_status;
 };
 
-User *create_user(char *username, char *name, Gender gender, Date birthdate, Date acc_creation, PaymentMethod pay_method, AccountStatus acc_status) {
-    User *user = malloc(sizeof(struct User));
+User *create_user(uint32_t name_id, Gender gender, Date birthdate, Date acc_creation, PaymentMethod pay_method, AccountStatus acc_status, Arena *arena) {
+    User *user = arena != NULL ? arena_alloc(arena, sizeof(struct User)) : malloc(sizeof(struct User));
 
-    user->username = g_strdup(username);
-    user->name = g_strdup(name);
+    user->username_offset = 0;
+    user->name_id = name_id;
     user->gender = gender;
     user->birthdate = birthdate;
     user->account_create_date = acc_creation;
@@ -42,7 +42,11 @@ User *create_user(char *username, char *name, Gender gender, Date birthdate, Dat
     return user;
 }
 
-User *parse_line_user(TokenIterator *line_iterator) {
+User *parse_line_user(TokenIterator *line_iterator, Arena *arena) {
+    return parse_line_user_detailed(line_iterator, NULL, NULL, arena);
+}
+
+User *parse_line_user_detailed(TokenIterator *line_iterator, char **parsed_username, StringPool *name_pool, Arena *arena) {
     char *username = token_iterator_next(line_iterator);
     if (IS_EMPTY(username)) return NULL;
 
@@ -69,21 +73,64 @@ User *parse_line_user(TokenIterator *line_iterator) {
     AccountStatus acc_status = parse_acc_status(acc_status_string);
     if (acc_status == INVALID_ACCOUNT_STATUS) return NULL;
 
-    return create_user(username, name, gender, birth_date, acc_creation, pay_method, acc_status);
+    if (parsed_username) *parsed_username = username;
+
+    uint32_t name_id = name_pool != NULL ? string_pool_intern(name_pool, name) : 0;
+    return create_user(name_id, gender, birth_date, acc_creation, pay_method, acc_status, arena);
 }
 
 void free_user(User *user) {
-    free(user->username);
-    free(user->name);
     free(user);
 }
 
-char *user_get_username(User *user) {
-    return g_strdup(user->username);
+void user_write_snapshot(User *user, SnapshotWriter *writer, StringPool *name_pool) {
+    snapshot_write_uint32(writer, string_pool_get_snapshot_id(name_pool, user->name_id));
+    snapshot_write_int64(writer, user->total_spent);
+    snapshot_write_uint32(writer, user->birthdate.encoded_date);
+    snapshot_write_uint32(writer, user->account_create_date.encoded_date);
+    snapshot_write_uint32(writer, user->most_recent_ride.encoded_date);
+    snapshot_write_int32(writer, user->id);
+    snapshot_write_uint16(writer, user->accumulated_score);
+    snapshot_write_uint16(writer, user->total_distance);
+    snapshot_write_uint16(writer, user->rides_amount);
+    snapshot_write_uint8(writer, user->gender);
+    snapshot_write_uint8(writer, user->payment_method);
+    snapshot_write_uint8(writer, user->account_status);
+}
+
+User *user_read_snapshot(SnapshotReader *reader, Arena *arena, StringPool *name_pool) {
+    uint32_t name_id = snapshot_read_uint32(reader);
+    if (!string_pool_is_valid_id(name_pool, name_id)) return NULL;
+
+    User *user = arena != NULL ? arena_alloc(arena, sizeof(struct User)) : malloc(sizeof(struct User));
+
+    user->username_offset = 0;
+    user->name_id = name_id;
+    user->total_spent = snapshot_read_int64(reader);
+    user->birthdate.encoded_date = snapshot_read_uint32(reader);
+    user->account_create_date.encoded_date = snapshot_read_uint32(reader);
+    user->most_recent_ride.encoded_date = snapshot_read_uint32(reader);
+    user->id = snapshot_read_int32(reader);
+    user->accumulated_score = snapshot_read_uint16(reader);
+    user->total_distance = snapshot_read_uint16(reader);
+    user->rides_amount = snapshot_read_uint16(reader);
+    user->gender = snapshot_read_uint8(reader);
+    user->payment_method = snapshot_read_uint8(reader);
+    user->account_status = snapshot_read_uint8(reader);
+
+    return user;
+}
+
+uint32_t user_get_username_offset(User *user) {
+    return user->username_offset;
 }
 
-char *user_get_name(User *user) {
-    return g_strdup(user->name);
+void user_set_username_offset(User *user, uint32_t username_offset) {
+    user->username_offset = username_offset;
+}
+
+uint32_t user_get_name_id(User *user) {
+    return user->name_id;
 }
 
 int user_get_id(User *user) {
@@ -118,11 +165,11 @@ void user_add_score(User *user, int score) {
     user->accumulated_score += score;
 }
 
-void user_add_spent(User *user, double spent) {
+void user_add_spent(User *user, Money spent) {
     user->total_spent += spent;
 }
 
-double user_get_total_spent(User *user) {
+Money user_get_total_spent(User *user) {
     return user->total_spent;
 }
 
@@ -154,7 +201,33 @@ void user_register_ride_date(User *user, Date date) {
     }
 }
 
-int compare_users_by_total_distance(const void *a, const void *b) {
+/**
+ * Bits of the date and number of bytes of the username in `user_get_total_distance_sort_key`.
+ */
+#define USER_TOTAL_DISTANCE_KEY_DATE_BITS 24
+#define USER_TOTAL_DISTANCE_KEY_USERNAME_BYTES 2
+
+uint64_t user_get_total_distance_sort_key(gconstpointer user, gpointer username_heap) {
+    const User *actual_user = user;
+
+    // Longer distances and later dates first, so both are inverted
+    uint64_t inverted_distance = UINT16_MAX - actual_user->total_distance;
+    uint64_t inverted_date = ((UINT64_C(1) << USER_TOTAL_DISTANCE_KEY_DATE_BITS) - 1) - actual_user->most_recent_ride.encoded_date;
+
+    // Unsigned bytes, like strcmp compares them, and the null terminator orders shorter usernames first
+    const unsigned char *username = (const unsigned char *) string_heap_get(username_heap, actual_user->username_offset);
+    uint64_t username_prefix = 0;
+    for (int i = 0, ended = FALSE; i < USER_TOTAL_DISTANCE_KEY_USERNAME_BYTES; i++) {
+        ended = ended || username[i] == '\0';
+        username_prefix = username_prefix << 8 | (ended ? 0 : username[i]);
+    }
+
+    return (uint64_t) actual_user->account_status << (16 + USER_TOTAL_DISTANCE_KEY_DATE_BITS + USER_TOTAL_DISTANCE_KEY_USERNAME_BYTES * 8)
+           | inverted_distance << (USER_TOTAL_DISTANCE_KEY_DATE_BITS + USER_TOTAL_DISTANCE_KEY_USERNAME_BYTES * 8)
+           | inverted_date << (USER_TOTAL_DISTANCE_KEY_USERNAME_BYTES * 8) | username_prefix;
+}
+
+int compare_users_by_total_distance(const void *a, const void *b, void *username_heap) {
     User *a_user = *((User **) a);
     User *b_user = *((User **) b);
 
@@ -179,5 +252,7 @@ int compare_users_by_total_distance(const void *a, const void *b) {
         return by_last_ride;
     }
 
-    return strcmp(a_user->username, b_user->username);
+    const char *username_a = string_heap_get(username_heap, a_user->username_offset);
+    const char *username_b = string_heap_get(username_heap, b_user->username_offset);
+    return strcmp(username_a, username_b);
 }
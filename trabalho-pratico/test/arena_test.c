@@ -0,0 +1,56 @@
+#include "arena.h"
+
+#include <glib.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Ensures allocations are aligned, don't overlap and that big allocations get their own chunk.
+ */
+void test_arena_allocations(void) {
+    Arena *arena = create_arena();
+
+    char *previous = NULL;
+    for (int i = 0; i < 100000; i++) {
+        char *allocation = arena_alloc(arena, 1 + i % 24);
+        g_assert_cmpuint((uintptr_t) allocation % ARENA_ALIGNMENT, ==, 0);
+        memset(allocation, i, 1 + i % 24); // Would be detected by valgrind/asan if out of bounds
+
+        if (previous != NULL && allocation > previous) {
+            g_assert_cmpuint(allocation - previous, >=, 1 + (i - 1) % 24);
+        }
+        previous = allocation;
+    }
+
+    char *string = arena_strdup(arena, "some string");
+    g_assert_cmpstr(string, ==, "some string");
+
+    guint chunk_count = arena_get_chunk_count(arena);
+    char *big_allocation = arena_alloc(arena, ARENA_CHUNK_SIZE * 2);
+    memset(big_allocation, 0, ARENA_CHUNK_SIZE * 2);
+    g_assert_cmpuint(arena_get_chunk_count(arena), ==, chunk_count + 1);
+    g_assert_cmpuint(arena_get_reserved_size(arena), >=, (chunk_count + 2) * (size_t) ARENA_CHUNK_SIZE);
+
+    free_arena(arena);
+}
+
+/**
+ * Ensures memory allocated in a merged arena stays valid until the arena it was merged into is freed.
+ */
+void test_arena_merge(void) {
+    Arena *arena = create_arena();
+    Arena *other = create_arena();
+
+    char *string = arena_strdup(arena, "first");
+    char *other_string = arena_strdup(other, "second");
+
+    arena_merge(arena, other);
+    g_assert_cmpuint(arena_get_chunk_count(arena), ==, 2);
+
+    char *after_merge = arena_strdup(arena, "third");
+    g_assert_cmpstr(string, ==, "first");
+    g_assert_cmpstr(other_string, ==, "second");
+    g_assert_cmpstr(after_merge, ==, "third");
+
+    free_arena(arena);
+}
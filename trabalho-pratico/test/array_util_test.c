@@ -0,0 +1,408 @@
+#include "array_util.h"
+#include "thread_budget.h"
+#include "driver.h"
+#include "user.h"
+#include "ride.h"
+
+/**
+ * Struct that represents an element sorted by `test_radix_sort_array_is_sorted_and_stable`.
+ */
+typedef struct {
+    uint64_t key;
+    guint original_index;
+} RadixSortTestElement;
+
+/**
+ * Key of a `RadixSortTestElement`.
+ */
+static uint64_t radix_sort_test_element_key(gconstpointer element, gpointer data) {
+    (void) data;
+    return ((const RadixSortTestElement *) element)->key;
+}
+
+/**
+ * Sorts keys with many repetitions (and one byte that is the same in every key) and checks
+ * the order is ascending and that elements with the same key keep their relative order.
+ */
+void test_radix_sort_array_is_sorted_and_stable(void) {
+    GRand *rand = g_rand_new_with_seed(21);
+
+    const guint length = 100000;
+    RadixSortTestElement *elements = malloc(sizeof(RadixSortTestElement) * length);
+    GPtrArray *array = g_ptr_array_sized_new(length);
+
+    for (guint i = 0; i < length; i++) {
+        // Byte 2 is constant, bytes 0, 1 and 5 vary
+        uint64_t key = (uint64_t) g_rand_int_range(rand, 0, 1000) | (uint64_t) 0x42 << 16 | (uint64_t) g_rand_int_range(rand, 0, 4) << 40;
+        elements[i] = (RadixSortTestElement){key, i};
+        g_ptr_array_add(array, &elements[i]);
+    }
+
+    radix_sort_array(array, radix_sort_test_element_key, NULL);
+
+    g_assert_cmpuint(array->len, ==, length);
+    for (guint i = 1; i < length; i++) {
+        RadixSortTestElement *previous = array->pdata[i - 1];
+        RadixSortTestElement *current = array->pdata[i];
+
+        g_assert_cmpuint(previous->key, <=, current->key);
+        if (previous->key == current->key) g_assert_cmpuint(previous->original_index, <, current->original_index);
+    }
+
+    g_ptr_array_free(array, TRUE);
+    free(elements);
+    g_rand_free(rand);
+}
+
+/**
+ * Number of buckets of the elements sorted by `test_counting_sort_array_is_sorted_and_stable`.
+ */
+#define COUNTING_SORT_TEST_BUCKETS 300
+
+/**
+ * Bucket of a `RadixSortTestElement` (its key).
+ */
+static guint counting_sort_test_element_bucket(gconstpointer element) {
+    return (guint) ((const RadixSortTestElement *) element)->key;
+}
+
+/**
+ * Counts the buckets of elements as they are added (some buckets stay empty), sorts them
+ * and checks the order is ascending and that elements in the same bucket keep their relative order.
+ */
+void test_counting_sort_array_is_sorted_and_stable(void) {
+    GRand *rand = g_rand_new_with_seed(22);
+
+    const guint length = 100000;
+    RadixSortTestElement *elements = malloc(sizeof(RadixSortTestElement) * length);
+    GPtrArray *array = g_ptr_array_sized_new(length);
+    guint *bucket_counts = calloc(COUNTING_SORT_TEST_BUCKETS, sizeof(guint));
+
+    for (guint i = 0; i < length; i++) {
+        elements[i] = (RadixSortTestElement){(uint64_t) g_rand_int_range(rand, 0, COUNTING_SORT_TEST_BUCKETS / 3) * 3, i};
+        g_ptr_array_add(array, &elements[i]);
+        bucket_counts[elements[i].key]++;
+    }
+
+    counting_sort_array(array, bucket_counts, COUNTING_SORT_TEST_BUCKETS, counting_sort_test_element_bucket);
+
+    g_assert_cmpuint(array->len, ==, length);
+    for (guint i = 1; i < length; i++) {
+        RadixSortTestElement *previous = array->pdata[i - 1];
+        RadixSortTestElement *current = array->pdata[i];
+
+        g_assert_cmpuint(previous->key, <=, current->key);
+        if (previous->key == current->key) g_assert_cmpuint(previous->original_index, <, current->original_index);
+    }
+
+    free(bucket_counts);
+    g_ptr_array_free(array, TRUE);
+    free(elements);
+    g_rand_free(rand);
+}
+
+/**
+ * Number of rides sorted by `benchmark_sorting_rides_by_date`, as many as in `data-large`.
+ */
+#define SORT_BENCHMARK_RIDES 1000000
+
+/**
+ * Ways of sorting rides by date compared by `benchmark_sorting_rides_by_date`.
+ */
+typedef enum {
+    RIDE_SORT_QSORT,
+    RIDE_SORT_RADIX,
+    RIDE_SORT_COUNTING,
+} RideSortMethod;
+
+/**
+ * Prints the time of sorting rides by date with `sort_array` (qsort) and `compare_rides_by_date`,
+ * `radix_sort_array` and `counting_sort_array` (as the catalog does, with the dates counted before, as the rides are registered).
+ * The rides are in id order with random dates, like the rides of the dataset before they are indexed.
+ */
+void benchmark_sorting_rides_by_date(void) {
+    GRand *rand = g_rand_new_with_seed(21);
+    Arena *arena = create_arena();
+
+    GPtrArray *rides = g_ptr_array_sized_new(SORT_BENCHMARK_RIDES);
+    for (int i = 0; i < SORT_BENCHMARK_RIDES; i++) {
+        Date date = create_date(g_rand_int_range(rand, 1, 29), g_rand_int_range(rand, 1, 13), g_rand_int_range(rand, 2010, 2023));
+        g_ptr_array_add(rides, create_ride(i + 1, date, 1, 0, 1, 1, 1, 0, arena));
+    }
+
+    const char *method_names[] = {"sort_array (qsort):", "radix_sort_array:", "counting_sort_array:"};
+    for (RideSortMethod method = RIDE_SORT_QSORT; method <= RIDE_SORT_COUNTING; method++) {
+        GPtrArray *copy = g_ptr_array_sized_new(rides->len);
+        guint *date_counts = calloc(RIDE_DATE_BUCKETS, sizeof(guint));
+        for (guint i = 0; i < rides->len; i++) {
+            g_ptr_array_add(copy, rides->pdata[i]);
+            date_counts[ride_get_date_bucket(rides->pdata[i])]++;
+        }
+
+        g_autofree GTimer *timer = g_timer_new();
+        g_timer_start(timer);
+        switch (method) {
+            case RIDE_SORT_QSORT:
+                sort_array(copy, compare_rides_by_date);
+                break;
+            case RIDE_SORT_RADIX:
+                radix_sort_array(copy, ride_get_date_sort_key, NULL);
+                break;
+            case RIDE_SORT_COUNTING:
+                counting_sort_array(copy, date_counts, RIDE_DATE_BUCKETS, ride_get_date_bucket);
+                break;
+        }
+        g_timer_stop(timer);
+
+        for (guint i = 1; i < copy->len; i++) {
+            g_assert_cmpint(date_compare(ride_get_date(copy->pdata[i - 1]), ride_get_date(copy->pdata[i])), <=, 0);
+        }
+
+        printf("# %-21s %8.2f ms for %d rides\n", method_names[method], g_timer_elapsed(timer, NULL) * 1000, SORT_BENCHMARK_RIDES);
+        free(date_counts);
+        g_ptr_array_free(copy, TRUE);
+    }
+
+    g_ptr_array_free(rides, TRUE);
+    free_arena(arena);
+    g_rand_free(rand);
+}
+
+/**
+ * Number of drivers sorted by `test_driver_score_sort_keys_match_compare_drivers_by_score`.
+ */
+#define DRIVER_SORT_TEST_DRIVERS 20000
+
+/**
+ * Sorts random drivers (some without rides, many with the same score or last ride date) with
+ * `driver_get_id_sort_key` and `driver_get_score_sort_key`, and checks the order is the one of `compare_drivers_by_score`.
+ */
+void test_driver_score_sort_keys_match_compare_drivers_by_score(void) {
+    GRand *rand = g_rand_new_with_seed(23);
+    Arena *arena = create_arena();
+
+    GPtrArray *drivers = g_ptr_array_new();
+    for (int i = 0; i < DRIVER_SORT_TEST_DRIVERS; i++) {
+        // Registered out of id order
+        int id = (i * 7919) % DRIVER_SORT_TEST_DRIVERS + 1;
+        AccountStatus status = g_rand_boolean(rand) ? ACTIVE : INACTIVE;
+        Driver *driver = create_driver(id, 0, create_date(1, 1, 1990), M, BASIC, "", create_date(1, 1, 2010), status, arena);
+
+        int rides = g_rand_int_range(rand, 0, 12);
+        for (int ride = 0; ride < rides; ride++) {
+            driver_increment_number_of_rides(driver);
+            driver_add_score(driver, g_rand_int_range(rand, 1, 6));
+            driver_register_ride_date(driver, create_date(g_rand_int_range(rand, 1, 3), 1, 2020));
+        }
+
+        g_ptr_array_add(drivers, driver);
+    }
+
+    GPtrArray *expected = g_ptr_array_sized_new(drivers->len);
+    for (guint i = 0; i < drivers->len; i++) g_ptr_array_add(expected, drivers->pdata[i]);
+    sort_array(expected, compare_drivers_by_score);
+
+    radix_sort_array(drivers, driver_get_id_sort_key, NULL);
+    radix_sort_array(drivers, driver_get_score_sort_key, NULL);
+
+    for (guint i = 0; i < drivers->len; i++) {
+        if (drivers->pdata[i] != expected->pdata[i]) {
+            g_test_fail_printf("Driver %u is %d, expected %d", i, driver_get_id(drivers->pdata[i]), driver_get_id(expected->pdata[i]));
+            break;
+        }
+    }
+
+    g_ptr_array_free(expected, TRUE);
+    g_ptr_array_free(drivers, TRUE);
+    free_arena(arena);
+    g_rand_free(rand);
+}
+
+/**
+ * Number of users sorted by `test_user_total_distance_sort_key_matches_compare_users_by_total_distance`.
+ */
+#define USER_SORT_TEST_USERS 20000
+
+/**
+ * Sorts random users (with usernames that often start the same, some shorter than the key prefix) with
+ * `user_get_total_distance_sort_key` and checks the order is the one of `compare_users_by_total_distance`.
+ */
+void test_user_total_distance_sort_key_matches_compare_users_by_total_distance(void) {
+    GRand *rand = g_rand_new_with_seed(23);
+    Arena *arena = create_arena();
+    StringHeap *username_heap = create_string_heap(0);
+
+    GPtrArray *users = g_ptr_array_new();
+    for (int i = 0; i < USER_SORT_TEST_USERS; i++) {
+        AccountStatus status = g_rand_boolean(rand) ? ACTIVE : INACTIVE;
+        User *user = create_user(0, M, create_date(1, 1, 1990), create_date(1, 1, 2010), CASH, status, arena);
+
+        char username[16];
+        int length = g_snprintf(username, sizeof(username), "%c%d", 'A' + g_rand_int_range(rand, 0, 3), g_rand_int_range(rand, 0, 1000));
+        user_set_username_offset(user, string_heap_append(username_heap, username, length));
+
+        int rides = g_rand_int_range(rand, 0, 3);
+        for (int ride = 0; ride < rides; ride++) {
+            user_add_total_distance(user, g_rand_int_range(rand, 1, 4));
+            user_register_ride_date(user, create_date(g_rand_int_range(rand, 1, 3), 1, 2020));
+        }
+
+        g_ptr_array_add(users, user);
+    }
+
+    GPtrArray *expected = g_ptr_array_sized_new(users->len);
+    for (guint i = 0; i < users->len; i++) g_ptr_array_add(expected, users->pdata[i]);
+    g_ptr_array_sort_with_data(expected, compare_users_by_total_distance, username_heap);
+
+    radix_sort_array_with_tie_breaker(users, user_get_total_distance_sort_key, compare_users_by_total_distance, username_heap);
+
+    for (guint i = 0; i < users->len; i++) {
+        if (compare_users_by_total_distance(&users->pdata[i], &expected->pdata[i], username_heap) != 0) {
+            g_test_fail_printf("User %u is '%s', expected '%s'", i,
+                               string_heap_get(username_heap, user_get_username_offset(users->pdata[i])),
+                               string_heap_get(username_heap, user_get_username_offset(expected->pdata[i])));
+            break;
+        }
+    }
+
+    g_ptr_array_free(expected, TRUE);
+    g_ptr_array_free(users, TRUE);
+    free_string_heap(username_heap);
+    free_arena(arena);
+    g_rand_free(rand);
+}
+
+/**
+ * Function that compares pointers to `RadixSortTestElement` by key only, so elements with the same key tie.
+ */
+static gint compare_radix_sort_test_elements_by_key(gconstpointer a, gconstpointer b, gpointer data) {
+    (void) data;
+    uint64_t a_key = (*(RadixSortTestElement **) a)->key;
+    uint64_t b_key = (*(RadixSortTestElement **) b)->key;
+    return (a_key > b_key) - (a_key < b_key);
+}
+
+/**
+ * Sorts keys with many repetitions (and a length that doesn't split evenly) with every number of threads,
+ * and checks the result is exactly the one of a serial stable sort.
+ */
+void test_parallel_sort_matches_serial_sort(void) {
+    GRand *rand = g_rand_new_with_seed(25);
+
+    const guint length = PARALLEL_SORT_THRESHOLD * 3 + 7;
+    RadixSortTestElement *elements = malloc(sizeof(RadixSortTestElement) * length);
+    gpointer *expected = malloc(sizeof(gpointer) * length);
+    gpointer *sorted = malloc(sizeof(gpointer) * length);
+
+    for (guint i = 0; i < length; i++) {
+        elements[i] = (RadixSortTestElement){(uint64_t) g_rand_int_range(rand, 0, 500), i};
+        expected[i] = &elements[i];
+    }
+    g_qsort_with_data(expected, (gint) length, sizeof(gpointer), compare_radix_sort_test_elements_by_key, NULL);
+
+    // Every sort gets the threads it asks for, whatever the processors of this machine
+    set_spare_thread_count(PARALLEL_SORT_MAX_THREADS - 1);
+
+    for (int threads = 1; threads <= PARALLEL_SORT_MAX_THREADS; threads++) {
+        for (guint i = 0; i < length; i++) sorted[i] = &elements[i];
+
+        parallel_sort(sorted, length, sizeof(gpointer), compare_radix_sort_test_elements_by_key, NULL, NULL, threads);
+
+        if (memcmp(sorted, expected, sizeof(gpointer) * length) != 0) g_test_fail_printf("Wrong order sorting with %d threads", threads);
+    }
+
+    set_spare_thread_count(-1);
+
+    free(sorted);
+    free(expected);
+    free(elements);
+    g_rand_free(rand);
+}
+
+/**
+ * Checks that the spare threads can't be reserved twice and that a parallel sort still sorts
+ * (in the calling thread) while every spare thread is reserved, like a sort started by a worker of a full thread pool.
+ */
+void test_parallel_sort_with_every_spare_thread_reserved(void) {
+    int spare_threads = get_spare_thread_count();
+    g_assert_cmpint(reserve_spare_threads(spare_threads + 1), ==, spare_threads);
+    g_assert_cmpint(reserve_spare_threads(1), ==, 0);
+
+    const guint length = PARALLEL_SORT_THRESHOLD * 2;
+    RadixSortTestElement *elements = malloc(sizeof(RadixSortTestElement) * length);
+    gpointer *sorted = malloc(sizeof(gpointer) * length);
+    for (guint i = 0; i < length; i++) {
+        elements[i] = (RadixSortTestElement){(uint64_t) (length - i) / 3, i};
+        sorted[i] = &elements[i];
+    }
+
+    g_assert_cmpint(parallel_sort(sorted, length, sizeof(gpointer), compare_radix_sort_test_elements_by_key, NULL, NULL, PARALLEL_SORT_MAX_THREADS), ==, 1);
+    for (guint i = 1; i < length; i++) g_assert_cmpint(compare_radix_sort_test_elements_by_key(&sorted[i - 1], &sorted[i], NULL), <=, 0);
+
+    // The sort gave back what it didn't take and nothing more
+    g_assert_cmpint(reserve_spare_threads(1), ==, 0);
+    release_spare_threads(spare_threads);
+    g_assert_cmpint(reserve_spare_threads(spare_threads), ==, spare_threads);
+    release_spare_threads(spare_threads);
+
+    free(sorted);
+    free(elements);
+}
+
+/**
+ * Function that compares rides with `compare_rides_by_distance`, for `parallel_sort`.
+ */
+static gint compare_rides_by_distance_with_data(gconstpointer a, gconstpointer b, gpointer data) {
+    (void) data;
+    return compare_rides_by_distance(a, b);
+}
+
+/**
+ * Prints the time of sorting rides by distance with `parallel_sort` with 1 thread (`g_qsort_with_data`) and with more threads,
+ * up to `PARALLEL_SORT_MAX_THREADS`. Thread counts above `parallel_sort_thread_budget` (the processors of this machine)
+ * are skipped, and every time is printed with the number of threads the sort actually got.
+ */
+void benchmark_parallel_sort_against_serial_sort(void) {
+    GRand *rand = g_rand_new_with_seed(25);
+    Arena *arena = create_arena();
+
+    gpointer *rides = malloc(sizeof(gpointer) * SORT_BENCHMARK_RIDES);
+    gpointer *sorted = malloc(sizeof(gpointer) * SORT_BENCHMARK_RIDES);
+    gpointer *expected = NULL;
+    for (int i = 0; i < SORT_BENCHMARK_RIDES; i++) {
+        Date date = create_date(g_rand_int_range(rand, 1, 29), g_rand_int_range(rand, 1, 13), g_rand_int_range(rand, 2010, 2023));
+        rides[i] = create_ride(i + 1, date, 1, 0, g_rand_int_range(rand, 1, 20), 1, 1, 0, arena);
+    }
+
+    int thread_budget = parallel_sort_thread_budget();
+    int thread_counts[] = {1, 2, 4, PARALLEL_SORT_MAX_THREADS};
+    for (size_t t = 0; t < G_N_ELEMENTS(thread_counts); t++) {
+        if (thread_counts[t] > thread_budget) {
+            printf("# parallel_sort (%d threads): skipped, above the %d threads of this machine\n", thread_counts[t], thread_budget);
+            continue;
+        }
+
+        memcpy(sorted, rides, sizeof(gpointer) * SORT_BENCHMARK_RIDES);
+
+        g_autofree GTimer *timer = g_timer_new();
+        int used_threads = parallel_sort(sorted, SORT_BENCHMARK_RIDES, sizeof(gpointer), compare_rides_by_distance_with_data, NULL, NULL,
+                                         thread_counts[t]);
+        double seconds = g_timer_elapsed(timer, NULL);
+
+        if (expected == NULL) {
+            expected = malloc(sizeof(gpointer) * SORT_BENCHMARK_RIDES);
+            memcpy(expected, sorted, sizeof(gpointer) * SORT_BENCHMARK_RIDES);
+        }
+        g_assert_true(memcmp(sorted, expected, sizeof(gpointer) * SORT_BENCHMARK_RIDES) == 0);
+
+        // Other threads of the program may hold part of the budget
+        printf("# parallel_sort (%d threads, %d requested): %8.2f ms for %d rides\n", used_threads, thread_counts[t], seconds * 1000,
+               SORT_BENCHMARK_RIDES);
+    }
+
+    free(expected);
+    free(sorted);
+    free(rides);
+    free_arena(arena);
+    g_rand_free(rand);
+}
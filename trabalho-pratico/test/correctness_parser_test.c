@@ -15,7 +15,7 @@ static int failed_lines = 0;
 void parse_user_and_check_for_null(void *first_arg, TokenIterator *iterator) {
     (void) first_arg;
     char *line = token_iterator_current(iterator);
-    User *user = parse_line_user(iterator);
+    User *user = parse_line_user(iterator, NULL);
     if (user != NULL) {
         fprintf(stderr, "User should've been NULL for line '%s'\n", line);
         failed_lines++;
@@ -30,7 +30,7 @@ void parse_user_and_check_for_null(void *first_arg, TokenIterator *iterator) {
 void parse_driver_and_check_for_null(void *first_arg, TokenIterator *iterator) {
     (void) first_arg;
     char *line = token_iterator_current(iterator);
-    Driver *driver = parse_line_driver(iterator);
+    Driver *driver = parse_line_driver(iterator, NULL);
     if (driver != NULL) {
         fprintf(stderr, "Driver should've been NULL for line '%s'\n", line);
         failed_lines++;
@@ -45,7 +45,7 @@ void parse_driver_and_check_for_null(void *first_arg, TokenIterator *iterator) {
 void parse_ride_and_check_for_null(void *first_arg, TokenIterator *iterator) {
     (void) first_arg;
     char *line = token_iterator_current(iterator);
-    Ride *ride = parse_line_ride(iterator);
+    Ride *ride = parse_line_ride(iterator, NULL);
     if (ride != NULL) {
         fprintf(stderr, "Ride should've been NULL for line '%s'\n", line);
         failed_lines++;
@@ -60,7 +60,7 @@ void parse_ride_and_check_for_null(void *first_arg, TokenIterator *iterator) {
 void parse_user_and_check_for_non_null(void *first_arg, TokenIterator *iterator) {
     (void) first_arg;
     char *line = token_iterator_current(iterator);
-    User *user = parse_line_user(iterator);
+    User *user = parse_line_user(iterator, NULL);
     if (user == NULL) {
         fprintf(stderr, "User should've been non-NULL for line '%s'\n", line);
         failed_lines++;
@@ -76,7 +76,7 @@ void parse_user_and_check_for_non_null(void *first_arg, TokenIterator *iterator)
 void parse_driver_and_check_for_non_null(void *first_arg, TokenIterator *iterator) {
     (void) first_arg;
     char *line = token_iterator_current(iterator);
-    Driver *driver = parse_line_driver(iterator);
+    Driver *driver = parse_line_driver(iterator, NULL);
     if (driver == NULL) {
         fprintf(stderr, "Driver should've been non-NULL for line '%s'\n", line);
         failed_lines++;
@@ -92,7 +92,7 @@ void parse_driver_and_check_for_non_null(void *first_arg, TokenIterator *iterato
 void parse_ride_and_check_for_non_null(void *first_arg, TokenIterator *iterator) {
     (void) first_arg;
     char *line = token_iterator_current(iterator);
-    Ride *ride = parse_line_ride(iterator);
+    Ride *ride = parse_line_ride(iterator, NULL);
     if (ride == NULL) {
         fprintf(stderr, "Ride should've been non-NULL for line '%s'\n", line);
         failed_lines++;
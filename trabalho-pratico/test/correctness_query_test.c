@@ -1,6 +1,7 @@
 #include "catalog.h"
 #include "catalog_loader.h"
 #include "query_manager.h"
+#include "parser.h"
 
 /**
  * Gets the index-th element of the array. If the index is out of bounds, the default value is returned.
@@ -8,22 +9,12 @@
 #define GET_INDEX_SAFE(array, index, default_value) (index < (int) array->len ? array->pdata[index] : default_value)
 
 /**
- * Loads the catalog from the given dataset folder path.
- * If lazy_loading is TRUE, the catalog is indexed lazily.
- * Executes the queries from the given queries file path.
+ * Executes the queries from the given queries file path in the given catalog.
  * Loads the expected output of the queries from the given expected query result folder path.
  * Checks if the output of the queries is the same as the expected output.
  * If not the same, prints the query, the actual and the expected output.
  */
-void load_catalog_execute_queries_and_check_expected_outputs(char *dataset_folder_path,
-                                                             char *queries_file_path,
-                                                             char *expected_query_result_folder_path,
-                                                             gboolean lazy_loading) {
-    Catalog *catalog = create_catalog();
-    catalog_load_csv_dataset(catalog, dataset_folder_path);
-
-    if (!lazy_loading) catalog_force_eager_indexing(catalog);
-
+void execute_queries_and_check_expected_outputs(Catalog *catalog, char *queries_file_path, char *expected_query_result_folder_path) {
     FILE *queries_file = open_file(queries_file_path);
 
     int current_query_id = 1;
@@ -79,6 +70,25 @@ void load_catalog_execute_queries_and_check_expected_outputs(char *dataset_folde
     }
 
     fclose(queries_file);
+}
+
+/**
+ * Loads the catalog from the given dataset folder path with the given loader options.
+ * If lazy_loading is TRUE, the catalog is indexed lazily.
+ * Checks the queries with `execute_queries_and_check_expected_outputs`.
+ */
+void load_catalog_execute_queries_and_check_expected_outputs(char *dataset_folder_path,
+                                                             char *queries_file_path,
+                                                             char *expected_query_result_folder_path,
+                                                             gboolean lazy_loading,
+                                                             CatalogLoaderOptions loader_options) {
+    Catalog *catalog = create_catalog();
+    catalog_load_csv_dataset_with_options(catalog, dataset_folder_path, loader_options);
+
+    if (!lazy_loading) catalog_force_eager_indexing(catalog);
+
+    execute_queries_and_check_expected_outputs(catalog, queries_file_path, expected_query_result_folder_path);
+
     free_catalog(catalog);
 }
 
@@ -89,7 +99,8 @@ void load_catalog_execute_queries_and_check_expected_outputs_regular_1(void) {
     load_catalog_execute_queries_and_check_expected_outputs("datasets/data-regular",
                                                             "datasets/data-regular/input1.txt",
                                                             "datasets/data-regular/expected-results-1",
-                                                            FALSE);
+                                                            FALSE,
+                                                            catalog_loader_default_options());
 }
 
 /**
@@ -99,7 +110,8 @@ void load_catalog_execute_queries_and_check_expected_outputs_regular_2(void) {
     load_catalog_execute_queries_and_check_expected_outputs("datasets/data-regular",
                                                             "datasets/data-regular/input2.txt",
                                                             "datasets/data-regular/expected-results-2",
-                                                            FALSE);
+                                                            FALSE,
+                                                            catalog_loader_default_options());
 }
 
 /**
@@ -109,7 +121,8 @@ void load_catalog_execute_queries_and_check_expected_outputs_regular_1_lazy(void
     load_catalog_execute_queries_and_check_expected_outputs("datasets/data-regular",
                                                             "datasets/data-regular/input1.txt",
                                                             "datasets/data-regular/expected-results-1",
-                                                            TRUE);
+                                                            TRUE,
+                                                            catalog_loader_default_options());
 }
 
 /**
@@ -119,5 +132,252 @@ void load_catalog_execute_queries_and_check_expected_outputs_regular_2_lazy(void
     load_catalog_execute_queries_and_check_expected_outputs("datasets/data-regular",
                                                             "datasets/data-regular/input2.txt",
                                                             "datasets/data-regular/expected-results-2",
-                                                            TRUE);
+                                                            TRUE,
+                                                            catalog_loader_default_options());
+}
+
+/**
+ * Checks if all the queries from `data-regular/input1.txt` return the expected output when the dataset is memory-mapped.
+ */
+void load_catalog_execute_queries_and_check_expected_outputs_regular_1_mmap(void) {
+    CatalogLoaderOptions loader_options = catalog_loader_default_options();
+    loader_options.io_mode = CATALOG_LOADER_IO_MMAP;
+
+    load_catalog_execute_queries_and_check_expected_outputs("datasets/data-regular",
+                                                            "datasets/data-regular/input1.txt",
+                                                            "datasets/data-regular/expected-results-1",
+                                                            TRUE,
+                                                            loader_options);
+}
+
+/**
+ * Checks if all the queries from `data-regular/input2.txt` return the expected output when the rides are parsed in parallel.
+ */
+void load_catalog_execute_queries_and_check_expected_outputs_regular_2_threads(void) {
+    CatalogLoaderOptions loader_options = catalog_loader_default_options();
+    loader_options.threads = 4;
+
+    load_catalog_execute_queries_and_check_expected_outputs("datasets/data-regular",
+                                                            "datasets/data-regular/input2.txt",
+                                                            "datasets/data-regular/expected-results-2",
+                                                            TRUE,
+                                                            loader_options);
+}
+
+/**
+ * Checks if all the queries from `data-regular/input1.txt` return the expected output
+ * while the indexes are built in background threads.
+ */
+void load_catalog_execute_queries_and_check_expected_outputs_regular_1_background(void) {
+    Catalog *catalog = create_catalog();
+    catalog_load_csv_dataset(catalog, "datasets/data-regular");
+
+    catalog_start_background_indexing(catalog, 4);
+
+    execute_queries_and_check_expected_outputs(catalog, "datasets/data-regular/input1.txt", "datasets/data-regular/expected-results-1");
+
+    free_catalog(catalog);
+}
+
+/**
+ * Size of the files of the dataset written by `test_dataset_fingerprint_changes_on_same_size_edit`,
+ * large enough to have bytes outside the samples of the fingerprint.
+ */
+#define FINGERPRINT_TEST_FILE_SIZE (512 * 1024)
+
+/**
+ * Writes a dataset of files with the same size, edits a byte of rides.csv that no sample of the fingerprint covers
+ * (keeping the size) and checks that the fingerprint changes.
+ */
+void test_dataset_fingerprint_changes_on_same_size_edit(void) {
+    gchar *dataset_path = g_build_filename(g_get_tmp_dir(), "li3-test-fingerprint", NULL);
+    g_mkdir_with_parents(dataset_path, 0755);
+
+    char *contents = malloc(FINGERPRINT_TEST_FILE_SIZE);
+    memset(contents, 'a', FINGERPRINT_TEST_FILE_SIZE);
+
+    const char *file_names[] = {"users.csv", "drivers.csv", "rides.csv"};
+    gchar *file_paths[3];
+    for (int i = 0; i < 3; i++) {
+        file_paths[i] = g_build_filename(dataset_path, file_names[i], NULL);
+        FILE *file = fopen(file_paths[i], "wb");
+        g_assert_nonnull(file);
+        fwrite(contents, 1, FINGERPRINT_TEST_FILE_SIZE, file);
+        fclose(file);
+    }
+
+    uint64_t fingerprint_before;
+    g_assert_true(compute_dataset_fingerprint(dataset_path, &fingerprint_before));
+
+    FILE *rides_file = fopen(file_paths[2], "r+b");
+    g_assert_nonnull(rides_file);
+    fseek(rides_file, FINGERPRINT_TEST_FILE_SIZE / 4, SEEK_SET);
+    fputc('b', rides_file);
+    fclose(rides_file);
+
+    uint64_t fingerprint_after;
+    g_assert_true(compute_dataset_fingerprint(dataset_path, &fingerprint_after));
+    g_assert_cmpuint(fingerprint_before, !=, fingerprint_after);
+
+    for (int i = 0; i < 3; i++) {
+        remove(file_paths[i]);
+        g_free(file_paths[i]);
+    }
+    remove(dataset_path);
+    g_free(dataset_path);
+    free(contents);
+}
+
+/**
+ * Saves a snapshot of `data-regular`, restores it into a new catalog and
+ * checks if all the queries from `data-regular/input1.txt` return the expected output.
+ * Also checks that the snapshot is rejected for another dataset.
+ */
+void load_catalog_from_snapshot_and_check_expected_outputs_regular_1(void) {
+    gchar *snapshot_path = g_build_filename(g_get_tmp_dir(), "li3-test-snapshot.bin", NULL);
+
+    Catalog *catalog = create_catalog();
+    g_assert_true(catalog_load_csv_dataset(catalog, "datasets/data-regular"));
+    g_assert_true(catalog_save_snapshot(catalog, snapshot_path, "datasets/data-regular"));
+    free_catalog(catalog);
+
+    catalog = create_catalog();
+    g_assert_true(catalog_load_snapshot(catalog, snapshot_path, "datasets/data-regular"));
+    execute_queries_and_check_expected_outputs(catalog, "datasets/data-regular/input1.txt", "datasets/data-regular/expected-results-1");
+    free_catalog(catalog);
+
+    catalog = create_catalog();
+    g_assert_false(catalog_load_snapshot(catalog, snapshot_path, "datasets/data-large"));
+    free_catalog(catalog);
+
+    remove(snapshot_path);
+    g_free(snapshot_path);
+}
+
+/**
+ * Asserts that the two snapshot files have the same bytes.
+ */
+void assert_snapshot_files_are_equal(const char *snapshot_path_a, const char *snapshot_path_b) {
+    gchar *snapshot_a;
+    gchar *snapshot_b;
+    gsize snapshot_a_size;
+    gsize snapshot_b_size;
+    g_assert_true(g_file_get_contents(snapshot_path_a, &snapshot_a, &snapshot_a_size, NULL));
+    g_assert_true(g_file_get_contents(snapshot_path_b, &snapshot_b, &snapshot_b_size, NULL));
+
+    g_assert_cmpmem(snapshot_a, snapshot_a_size, snapshot_b, snapshot_b_size);
+
+    g_free(snapshot_a);
+    g_free(snapshot_b);
+}
+
+/**
+ * Catalog and arena used by `parse_and_register_ride_unbatched`.
+ */
+typedef struct {
+    Catalog *catalog;
+    Arena *arena;
+} UnbatchedRideRegistration;
+
+/**
+ * Parses a ride and registers it right away with `catalog_register_parsed_ride`.
+ */
+void parse_and_register_ride_unbatched(void *registration_pointer, TokenIterator *line_iterator) {
+    UnbatchedRideRegistration *registration = registration_pointer;
+
+    char *city;
+    char *user_username;
+    Ride *ride = parse_line_ride_detailed(line_iterator, &city, &user_username, registration->arena);
+    if (ride == NULL) return;
+
+    catalog_register_parsed_ride(registration->catalog, ride, city, user_username);
+}
+
+/**
+ * Loads `data-regular` into a catalog, registering the rides in batches or one by one, and saves a snapshot of it.
+ */
+void load_regular_catalog_and_save_snapshot(gboolean batched, const char *snapshot_path) {
+    Catalog *catalog = create_catalog();
+
+    FILE *users_file = fopen("datasets/data-regular/users.csv", "r");
+    FILE *drivers_file = fopen("datasets/data-regular/drivers.csv", "r");
+    FILE *rides_file = fopen("datasets/data-regular/rides.csv", "r");
+    g_assert_nonnull(users_file);
+    g_assert_nonnull(drivers_file);
+    g_assert_nonnull(rides_file);
+
+    read_csv_file(users_file, parse_and_register_user, catalog);
+    read_csv_file(drivers_file, parse_and_register_driver, catalog);
+
+    if (batched) {
+        read_csv_file(rides_file, parse_and_register_ride, catalog);
+        catalog_flush_pending_rides(catalog);
+    } else {
+        UnbatchedRideRegistration registration = {catalog, create_arena()};
+        read_csv_file(rides_file, parse_and_register_ride_unbatched, &registration);
+        catalog_retain_ride_arena(catalog, registration.arena);
+    }
+
+    fclose(users_file);
+    fclose(drivers_file);
+    fclose(rides_file);
+
+    g_assert_true(catalog_save_snapshot(catalog, snapshot_path, "datasets/data-regular"));
+    free_catalog(catalog);
+}
+
+/**
+ * Checks that registering the rides in batches (flushing the last incomplete batch) produces exactly the same catalog
+ * as registering them one by one, comparing the snapshots of both catalogs.
+ */
+void test_batched_and_unbatched_ride_registration_match(void) {
+    gchar *batched_snapshot_path = g_build_filename(g_get_tmp_dir(), "li3-test-batched-snapshot.bin", NULL);
+    gchar *unbatched_snapshot_path = g_build_filename(g_get_tmp_dir(), "li3-test-unbatched-snapshot.bin", NULL);
+
+    load_regular_catalog_and_save_snapshot(TRUE, batched_snapshot_path);
+    load_regular_catalog_and_save_snapshot(FALSE, unbatched_snapshot_path);
+
+    assert_snapshot_files_are_equal(batched_snapshot_path, unbatched_snapshot_path);
+
+    remove(batched_snapshot_path);
+    remove(unbatched_snapshot_path);
+    g_free(batched_snapshot_path);
+    g_free(unbatched_snapshot_path);
+}
+
+/**
+ * Checks that the pipelined loader (where users and drivers, and so their names, are loaded by concurrent threads)
+ * gives the same snapshot as the serial loader, and that a restored catalog gives the same snapshot again.
+ */
+void test_snapshot_does_not_depend_on_loader_threads(void) {
+    gchar *serial_snapshot_path = g_build_filename(g_get_tmp_dir(), "li3-test-serial-snapshot.bin", NULL);
+    gchar *pipelined_snapshot_path = g_build_filename(g_get_tmp_dir(), "li3-test-pipelined-snapshot.bin", NULL);
+    gchar *restored_snapshot_path = g_build_filename(g_get_tmp_dir(), "li3-test-restored-snapshot.bin", NULL);
+
+    Catalog *catalog = create_catalog();
+    g_assert_true(catalog_load_csv_dataset(catalog, "datasets/data-regular"));
+    g_assert_true(catalog_save_snapshot(catalog, serial_snapshot_path, "datasets/data-regular"));
+    free_catalog(catalog);
+
+    CatalogLoaderOptions loader_options = catalog_loader_default_options();
+    loader_options.threads = 4;
+    catalog = create_catalog();
+    g_assert_true(catalog_load_csv_dataset_with_options(catalog, "datasets/data-regular", loader_options));
+    g_assert_true(catalog_save_snapshot(catalog, pipelined_snapshot_path, "datasets/data-regular"));
+    free_catalog(catalog);
+
+    catalog = create_catalog();
+    g_assert_true(catalog_load_snapshot(catalog, pipelined_snapshot_path, "datasets/data-regular"));
+    g_assert_true(catalog_save_snapshot(catalog, restored_snapshot_path, "datasets/data-regular"));
+    free_catalog(catalog);
+
+    assert_snapshot_files_are_equal(serial_snapshot_path, pipelined_snapshot_path);
+    assert_snapshot_files_are_equal(serial_snapshot_path, restored_snapshot_path);
+
+    remove(serial_snapshot_path);
+    remove(pipelined_snapshot_path);
+    remove(restored_snapshot_path);
+    g_free(serial_snapshot_path);
+    g_free(pipelined_snapshot_path);
+    g_free(restored_snapshot_path);
 }
@@ -0,0 +1,135 @@
+#include "delimiter_scanner.h"
+#include "token_iterator.h"
+
+#include <glib.h>
+#include <string.h>
+
+#define DELIMITER_SCANNER_TEST_SIZE 100000
+
+/**
+ * Scanned line recorded by `record_scanned_line`.
+ */
+typedef struct {
+    size_t start;
+    size_t length;
+    uint32_t token_ends[DELIMITER_SCANNER_MAX_TOKENS];
+    int token_count;
+} RecordedLine;
+
+/**
+ * Argument of `record_scanned_line`.
+ */
+typedef struct {
+    char *data;
+    GArray *lines;
+} RecordedLines;
+
+static void record_scanned_line(void *arg, const char *line, size_t length, const uint32_t *token_ends, int token_count) {
+    RecordedLines *recorded_lines = arg;
+
+    RecordedLine recorded_line;
+    memset(&recorded_line, 0, sizeof(RecordedLine)); // padding is compared too
+    recorded_line.start = line - recorded_lines->data;
+    recorded_line.length = length;
+    recorded_line.token_count = token_count;
+    memcpy(recorded_line.token_ends, token_ends, sizeof(uint32_t) * token_count);
+
+    g_array_append_val(recorded_lines->lines, recorded_line);
+}
+
+/**
+ * Fills the buffer with random lines, mostly short tokens but also empty tokens, empty lines and lines with more tokens than the table holds.
+ */
+static void fill_random_csv(char *buffer, size_t size, GRand *rand) {
+    const char alphabet[] = "abc01;;;\n";
+
+    for (size_t i = 0; i < size; i++) {
+        buffer[i] = g_rand_int_range(rand, 0, 50) == 0
+                    ? alphabet[g_rand_int_range(rand, 0, (int) sizeof(alphabet) - 1)]
+                    : (char) g_rand_int_range(rand, 'a', 'z' + 1);
+
+        if (g_rand_int_range(rand, 0, 4) == 0) buffer[i] = ';';
+    }
+}
+
+/**
+ * Ensures that every scanner implementation supported by this CPU finds the same lines and token tables as the scalar one,
+ * for every length near a block boundary.
+ */
+void test_delimiter_scanner_implementations_are_equivalent(void) {
+    GRand *rand = g_rand_new_with_seed(42);
+    char *buffer = g_malloc(DELIMITER_SCANNER_TEST_SIZE);
+    fill_random_csv(buffer, DELIMITER_SCANNER_TEST_SIZE, rand);
+
+    size_t lengths[] = {0, 1, 63, 64, 65, 127, 128, 1000, DELIMITER_SCANNER_TEST_SIZE - 1, DELIMITER_SCANNER_TEST_SIZE};
+
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        RecordedLines expected = {buffer, g_array_new(FALSE, FALSE, sizeof(RecordedLine))};
+        size_t expected_consumed = scan_csv_lines_with_implementation(DELIMITER_SCANNER_SCALAR, buffer, lengths[i], record_scanned_line, &expected);
+
+        size_t after_last_newline = lengths[i];
+        while (after_last_newline > 0 && buffer[after_last_newline - 1] != '\n') after_last_newline--;
+        g_assert_cmpuint(expected_consumed, ==, after_last_newline);
+
+        for (DelimiterScannerImplementation implementation = DELIMITER_SCANNER_SSE2; implementation <= DELIMITER_SCANNER_AVX2; implementation++) {
+            if (!is_delimiter_scanner_implementation_supported(implementation)) continue;
+
+            RecordedLines actual = {buffer, g_array_new(FALSE, FALSE, sizeof(RecordedLine))};
+            size_t actual_consumed = scan_csv_lines_with_implementation(implementation, buffer, lengths[i], record_scanned_line, &actual);
+
+            g_assert_cmpuint(expected_consumed, ==, actual_consumed);
+            g_assert_cmpuint(expected.lines->len, ==, actual.lines->len);
+            g_assert_cmpmem(expected.lines->data, expected.lines->len * sizeof(RecordedLine),
+                            actual.lines->data, actual.lines->len * sizeof(RecordedLine));
+
+            g_array_free(actual.lines, TRUE);
+        }
+
+        g_array_free(expected.lines, TRUE);
+    }
+
+    g_free(buffer);
+    g_rand_free(rand);
+}
+
+/**
+ * Ensures that iterating a line with the scanned token table returns the same tokens as `next_token`,
+ * wherever the line starts in its buffer.
+ */
+void test_token_iterator_with_scanned_line(void) {
+    GRand *rand = g_rand_new_with_seed(7);
+    TokenIterator *legacy_iterator = init_semicolon_separated_token_iterator();
+    TokenIterator *scanned_iterator = init_semicolon_separated_token_iterator();
+
+    for (int i = 0; i < 1000; i++) {
+        // Up to 3 times the table size, so truncated tables are also tested
+        int length = g_rand_int_range(rand, 0, DELIMITER_SCANNER_MAX_TOKENS * 6);
+        char *legacy_line = g_malloc(length + 2);
+        for (int j = 0; j < length; j++) {
+            legacy_line[j] = g_rand_boolean(rand) ? ';' : 'x';
+        }
+        legacy_line[length] = '\n';
+        legacy_line[length + 1] = '\0';
+
+        // Lines starting at every offset of an aligned chunk, in the smallest buffer allowed by `scan_csv_line`
+        int start_offset = i % DELIMITER_SCANNER_ALIGNMENT;
+        char *scanned_buffer = aligned_alloc(DELIMITER_SCANNER_ALIGNMENT, DELIMITER_SCANNER_PADDED_SIZE(start_offset + length + 2));
+        char *scanned_line = scanned_buffer + start_offset;
+        memcpy(scanned_line, legacy_line, length + 2);
+        legacy_line[length] = '\0';
+
+        token_iterator_set_current(legacy_iterator, legacy_line);
+        token_iterator_set_current_line(scanned_iterator, scanned_line);
+
+        for (int token = 0; token <= length + 1; token++) {
+            g_assert_cmpstr(token_iterator_next(legacy_iterator), ==, token_iterator_next(scanned_iterator));
+        }
+
+        g_free(legacy_line);
+        free(scanned_buffer);
+    }
+
+    token_iterator_free(legacy_iterator);
+    token_iterator_free(scanned_iterator);
+    g_rand_free(rand);
+}
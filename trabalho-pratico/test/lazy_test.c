@@ -58,3 +58,155 @@ void test_lazy_behavior_int_apply_function(void) {
 
     free_lazy(lazy, NULL);
 }
+
+/**
+ * Number of lazies whose first access is raced by `test_lazy_concurrent_first_access`.
+ */
+#define LAZY_STRESS_LAZIES 2000
+
+/**
+ * Number of threads racing for the first access of each lazy in `test_lazy_concurrent_first_access`.
+ */
+#define LAZY_STRESS_THREADS 8
+
+/**
+ * Value of a lazy in `test_lazy_concurrent_first_access`.
+ */
+typedef struct {
+    int applications; // Times the apply function ran
+    guint result; // Only set by the apply function
+} LazyStressValue;
+
+/**
+ * Apply function of `test_lazy_concurrent_first_access`, slow enough for the other threads to arrive meanwhile.
+ */
+static void apply_lazy_stress_value(void *value) {
+    LazyStressValue *stress_value = value;
+    g_atomic_int_inc(&stress_value->applications);
+
+    guint result = 0; // Unsigned, so the hash wraps around instead of overflowing
+    for (guint i = 0; i < 2000; i++) result = result * 31 + i;
+    stress_value->result = result | 1;
+}
+
+/**
+ * State shared by the threads of `test_lazy_concurrent_first_access`.
+ */
+typedef struct {
+    Lazy **lazies;
+    gint ready_threads;
+    gint failures;
+} LazyStressState;
+
+/**
+ * Gets every lazy, all the threads starting each one at the same time, and checks the value is complete.
+ */
+static gpointer lazy_stress_thread(gpointer data) {
+    LazyStressState *state = data;
+
+    for (int i = 0; i < LAZY_STRESS_LAZIES; i++) {
+        // Waits for every thread to reach this lazy, so their first accesses overlap
+        g_atomic_int_inc(&state->ready_threads);
+        while (g_atomic_int_get(&state->ready_threads) < (i + 1) * LAZY_STRESS_THREADS) g_thread_yield();
+
+        void *value;
+        if (lazy_try_get(state->lazies[i], &value) && ((LazyStressValue *) value)->result == 0)
+            g_atomic_int_inc(&state->failures);
+
+        LazyStressValue *stress_value = lazy_get_value(state->lazies[i]);
+        if (stress_value->result == 0) g_atomic_int_inc(&state->failures);
+    }
+
+    return NULL;
+}
+
+/**
+ * Ensures the apply function runs exactly once when many threads request the value of a lazy at the same time,
+ * and that every thread gets the value only after it was applied.
+ */
+void test_lazy_concurrent_first_access(void) {
+    LazyStressValue *values = calloc(LAZY_STRESS_LAZIES, sizeof(LazyStressValue));
+    Lazy **lazies = malloc(sizeof(Lazy *) * LAZY_STRESS_LAZIES);
+    for (int i = 0; i < LAZY_STRESS_LAZIES; i++) lazies[i] = lazy_of(&values[i], apply_lazy_stress_value);
+
+    LazyStressState state = {lazies, 0, 0};
+    GThread *threads[LAZY_STRESS_THREADS];
+    for (int i = 0; i < LAZY_STRESS_THREADS; i++) threads[i] = g_thread_new("lazy-stress", lazy_stress_thread, &state);
+    for (int i = 0; i < LAZY_STRESS_THREADS; i++) g_thread_join(threads[i]);
+
+    g_assert_cmpint(state.failures, ==, 0);
+    for (int i = 0; i < LAZY_STRESS_LAZIES; i++) {
+        g_assert_cmpint(values[i].applications, ==, 1);
+
+        void *value = NULL;
+        g_assert_true(lazy_try_get(lazies[i], &value));
+        g_assert_true(value == &values[i]);
+
+        free_lazy(lazies[i], NULL);
+    }
+
+    Lazy *pending = lazy_of(&values[0], apply_lazy_stress_value);
+    void *value = NULL;
+    g_assert_false(lazy_try_get(pending, &value));
+    free_lazy(pending, NULL);
+
+    free(lazies);
+    free(values);
+}
+
+/**
+ * Number of calls to `lazy_get_value` timed by `benchmark_lazy_get_value_fast_path`.
+ */
+#define LAZY_BENCHMARK_GETS 200000000
+
+/**
+ * Lazy without synchronization, as `Lazy` was before it was made thread-safe, for comparison.
+ */
+typedef struct {
+    void *value;
+    ApplyFunction function_to_apply;
+    gboolean function_applied;
+} UnsynchronizedLazy;
+
+/**
+ * `lazy_apply_function` of `UnsynchronizedLazy`. Not inlined, like the functions of `Lazy` (which are in another file).
+ */
+static __attribute__((noinline)) void unsynchronized_lazy_apply_function(UnsynchronizedLazy *lazy) {
+    if (!lazy->function_applied) {
+        if (lazy->function_to_apply != NULL) lazy->function_to_apply(lazy->value);
+        lazy->function_applied = TRUE;
+    }
+}
+
+/**
+ * `lazy_get_value` of `UnsynchronizedLazy`.
+ */
+static __attribute__((noinline)) void *unsynchronized_lazy_get_value(UnsynchronizedLazy *lazy) {
+    unsynchronized_lazy_apply_function(lazy);
+    return lazy->value;
+}
+
+/**
+ * Prints the time of getting the value of an applied lazy, against the same without synchronization.
+ */
+void benchmark_lazy_get_value_fast_path(void) {
+    int value = 0;
+    Lazy *lazy = lazy_of(&value, increase_int);
+    UnsynchronizedLazy unsynchronized_lazy = {&value, increase_int, FALSE};
+    lazy_get_value(lazy);
+    unsynchronized_lazy_get_value(&unsynchronized_lazy);
+
+    for (int synchronized = 1; synchronized >= 0; synchronized--) {
+        volatile uintptr_t checksum = 0;
+
+        g_autofree GTimer *timer = g_timer_new();
+        for (int i = 0; i < LAZY_BENCHMARK_GETS; i++) {
+            checksum += (uintptr_t) (synchronized ? lazy_get_value(lazy) : unsynchronized_lazy_get_value(&unsynchronized_lazy));
+        }
+        double seconds = g_timer_elapsed(timer, NULL);
+
+        printf("# %-15s lazy_get_value: %.2f ns/call\n", synchronized ? "once-cell" : "unsynchronized", seconds * 1e9 / LAZY_BENCHMARK_GETS);
+    }
+
+    free_lazy(lazy, NULL);
+}
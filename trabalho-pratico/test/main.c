@@ -1,10 +1,17 @@
 #include "struct_util_test.c"
 #include "lazy_test.c"
+#include "arena_test.c"
+#include "array_util_test.c"
+#include "typed_array_test.c"
+#include "ride_columns_test.c"
+#include "string_index_test.c"
 #include "correctness_parser_test.c"
 #include "correctness_query_test.c"
 #include "performance_query_test.c"
 #include "output_writer_test.c"
 #include "token_iterator_test.c"
+#include "delimiter_scanner_test.c"
+#include "performance_delimiter_scanner_test.c"
 
 #include <glib.h>
 
@@ -22,13 +29,42 @@ int main(int argc, char *argv[]) {
 #define ADD_TEST(testpath, function) g_test_add_func(testpath #function, function)
 
     ADD_TEST("/struct_utils/", assert_test_date_parse_and_encoding);
+    ADD_TEST("/struct_utils/", assert_test_date_format);
     ADD_TEST("/struct_utils/", assert_test_date_compare);
     ADD_TEST("/struct_utils/", assert_test_date_age);
+    ADD_TEST("/struct_utils/", assert_fuzz_parse_int_equals_reference);
+    ADD_TEST("/struct_utils/", assert_parse_int_rejects_overflow);
+    ADD_TEST("/struct_utils/", assert_fuzz_parse_date_equals_reference);
+    ADD_TEST("/struct_utils/", assert_fuzz_parse_enums_equals_reference);
+    ADD_TEST("/struct_utils/", assert_fuzz_money_matches_double_formatting);
+    ADD_TEST("/struct_utils/", assert_price_table_matches_compute_price);
     ADD_TEST("/lazy/", test_lazy_behavior_int_apply_function);
     ADD_TEST("/lazy/", test_lazy_behavior_null_apply_function);
+    ADD_TEST("/lazy/", test_lazy_concurrent_first_access);
+    ADD_TEST("/arena/", test_arena_allocations);
+    ADD_TEST("/arena/", test_arena_merge);
+    ADD_TEST("/array_util/", test_radix_sort_array_is_sorted_and_stable);
+    ADD_TEST("/array_util/", test_counting_sort_array_is_sorted_and_stable);
+    ADD_TEST("/array_util/", test_driver_score_sort_keys_match_compare_drivers_by_score);
+    ADD_TEST("/array_util/", test_user_total_distance_sort_key_matches_compare_users_by_total_distance);
+    ADD_TEST("/array_util/", test_parallel_sort_matches_serial_sort);
+    ADD_TEST("/array_util/", test_parallel_sort_with_every_spare_thread_reserved);
+    ADD_TEST("/typed_array/", test_typed_array_append_and_get);
+    ADD_TEST("/typed_array/", test_typed_sort_matches_qsort);
+    ADD_TEST("/typed_array/", test_typed_lower_bound_matches_linear_search);
+    ADD_TEST("/ride_columns/", test_ride_columns_date_range_sums);
+    ADD_TEST("/ride_columns/", test_extended_rides_keep_exact_values);
+    ADD_TEST("/ride_columns/", test_ride_snapshot_rejects_invalid_rides);
+    ADD_TEST("/string_index/", test_string_index_insert_and_lookup);
+    ADD_TEST("/string_index/", test_string_pool_interns_repeated_strings_once);
     ADD_TEST("/token_iterator/", test_semicolon_separated_token_iterator);
+    ADD_TEST("/token_iterator/", test_token_iterator_with_scanned_line);
+    ADD_TEST("/delimiter_scanner/", test_delimiter_scanner_implementations_are_equivalent);
     ADD_TEST("/output_writer/", test_semicolon_file_output_writer);
     ADD_TEST("/output_writer/", test_array_of_semicolon_strings_output_writer);
+    ADD_TEST("/output_writer/", test_typed_tokens_match_printf);
+    ADD_TEST("/output_writer/", test_async_output_matches_file_output_writer);
+    ADD_TEST("/output_writer/", test_output_container_round_trip);
     ADD_TEST("/correctness/parser/", assert_invalid_csv_loads_nothing_large);
     ADD_TEST("/correctness/parser/", assert_invalid_csv_loads_nothing_regular);
     ADD_TEST("/correctness/parser/", assert_valid_csv_loads_everything_regular);
@@ -36,7 +72,24 @@ int main(int argc, char *argv[]) {
     ADD_TEST("/correctness/query/", load_catalog_execute_queries_and_check_expected_outputs_regular_2);
     ADD_TEST("/correctness/query/", load_catalog_execute_queries_and_check_expected_outputs_regular_1_lazy);
     ADD_TEST("/correctness/query/", load_catalog_execute_queries_and_check_expected_outputs_regular_2_lazy);
+    ADD_TEST("/correctness/query/", load_catalog_execute_queries_and_check_expected_outputs_regular_1_mmap);
+    ADD_TEST("/correctness/query/", load_catalog_execute_queries_and_check_expected_outputs_regular_2_threads);
+    ADD_TEST("/correctness/query/", load_catalog_execute_queries_and_check_expected_outputs_regular_1_background);
+    ADD_TEST("/correctness/query/", load_catalog_from_snapshot_and_check_expected_outputs_regular_1);
+    ADD_TEST("/correctness/query/", test_dataset_fingerprint_changes_on_same_size_edit);
+    ADD_TEST("/correctness/query/", test_batched_and_unbatched_ride_registration_match);
+    ADD_TEST("/correctness/query/", test_snapshot_does_not_depend_on_loader_threads);
     ADD_TEST("/performance/", load_catalog_execute_queries_and_benchmark_regular_2);
+    ADD_TEST("/performance/", benchmark_delimiter_scanner_implementations);
+    ADD_TEST("/performance/", benchmark_string_index_against_ghashtable);
+    ADD_TEST("/performance/", benchmark_output_writer_typed_against_printf);
+    ADD_TEST("/performance/", benchmark_query_threads_throughput);
+    ADD_TEST("/performance/", benchmark_lazy_get_value_fast_path);
+    ADD_TEST("/performance/", benchmark_sorting_rides_by_date);
+    ADD_TEST("/performance/", benchmark_typed_sort_of_values_against_qsort);
+    ADD_TEST("/performance/", benchmark_sort_rides_by_distance_against_qsort);
+    ADD_TEST("/performance/", benchmark_typed_lower_bound_against_branching_search);
+    ADD_TEST("/performance/", benchmark_parallel_sort_against_serial_sort);
 
     return g_test_run();
 }
@@ -1,5 +1,9 @@
 #include <glib.h>
 
+#include "async_output.h"
+#include "file_util.h"
+#include "output_container.h"
+
 /**
  * Test if the semicolon file output writer is working properly.
  */
@@ -33,3 +37,240 @@ void test_array_of_semicolon_strings_output_writer(void) {
     g_assert_cmpstr("Hello;World\n", ==, g_ptr_array_index(array, 0));
     g_ptr_array_free(array, TRUE);
 }
+
+/**
+ * Number of commands written at the same time by `test_async_output_matches_file_output_writer`.
+ */
+#define ASYNC_OUTPUT_TEST_COMMANDS 4
+
+/**
+ * First command number used by `test_async_output_matches_file_output_writer`, far from the ones of the input files.
+ */
+#define ASYNC_OUTPUT_TEST_FIRST_COMMAND 900000
+
+/**
+ * Writes lines (spanning many chunks for some commands, none for others) to the writer and closes it.
+ */
+static void write_async_output_test_lines(OutputWriter *writer, int command_index) {
+    int lines = command_index == 0 ? 0 : command_index * 10000;
+    for (int i = 0; i < lines; i++) {
+        writer_write_int_token(writer, i, 0);
+        writer_write_string_token(writer, "Ana Silva");
+        writer_write_fixed_3_token(writer, i / 7.0);
+        writer_end_line(writer);
+    }
+    close_output_writer(writer);
+}
+
+/**
+ * Reads the whole file, from its start.
+ */
+static char *read_async_output_test_file(FILE *file, size_t *length) {
+    fseek(file, 0, SEEK_END);
+    *length = ftell(file);
+    rewind(file);
+
+    char *content = malloc(*length + 1);
+    *length = fread(content, 1, *length, file);
+    return content;
+}
+
+/**
+ * Writes the output of a command through the asynchronous output, from its own thread.
+ */
+static gpointer write_async_output_test_command(gpointer data) {
+    AsyncOutput *async_output = ((gpointer *) data)[0];
+    int command_index = GPOINTER_TO_INT(((gpointer *) data)[1]);
+
+    write_async_output_test_lines(async_output_create_command_writer(async_output, ASYNC_OUTPUT_TEST_FIRST_COMMAND + command_index), command_index);
+    return NULL;
+}
+
+/**
+ * Ensures the files written by the asynchronous output, with commands written by several threads at once,
+ * have the same content as the ones written by the file output writer.
+ */
+void test_async_output_matches_file_output_writer(void) {
+    AsyncOutput *async_output = create_async_output(NULL);
+
+    GThread *threads[ASYNC_OUTPUT_TEST_COMMANDS];
+    gpointer thread_data[ASYNC_OUTPUT_TEST_COMMANDS][2];
+    for (int i = 0; i < ASYNC_OUTPUT_TEST_COMMANDS; i++) {
+        thread_data[i][0] = async_output;
+        thread_data[i][1] = GINT_TO_POINTER(i);
+        threads[i] = g_thread_new("async-output-test", write_async_output_test_command, thread_data[i]);
+    }
+    for (int i = 0; i < ASYNC_OUTPUT_TEST_COMMANDS; i++) g_thread_join(threads[i]);
+
+    free_async_output(async_output);
+
+    for (int i = 0; i < ASYNC_OUTPUT_TEST_COMMANDS; i++) {
+        FILE *expected_file = tmpfile();
+        write_async_output_test_lines(create_semicolon_file_output_writer(expected_file), i);
+
+        char *path = g_strdup_printf(OUTPUT_FOLDER PATH_SEPARATOR OUTPUT_FILE_NAME, ASYNC_OUTPUT_TEST_FIRST_COMMAND + i);
+        FILE *actual_file = fopen(path, "r");
+        g_assert_nonnull(actual_file);
+
+        if (actual_file != NULL) {
+            size_t expected_length, actual_length;
+            char *expected = read_async_output_test_file(expected_file, &expected_length);
+            char *actual = read_async_output_test_file(actual_file, &actual_length);
+            g_assert_cmpmem(expected, expected_length, actual, actual_length);
+
+            free(expected);
+            free(actual);
+            fclose(actual_file);
+        }
+
+        fclose(expected_file);
+        remove(path);
+        g_free(path);
+    }
+}
+
+/**
+ * Ensures the output of each command is read back from the container file as written,
+ * including empty output, output split across chunks and output interleaved with the output of other commands.
+ */
+void test_output_container_round_trip(void) {
+    gchar *container_path = g_build_filename(g_get_tmp_dir(), "li3-test-output.container", NULL);
+    OutputContainerWriter *container_writer = create_output_container_writer(container_path);
+    g_assert_nonnull(container_writer);
+    if (container_writer == NULL) return;
+
+    close_output_writer(output_container_create_command_writer(container_writer, 1));
+    write_async_output_test_lines(output_container_create_command_writer(container_writer, 2), 2);
+    output_container_append(container_writer, 3, "a;b\n", 4);
+    output_container_append(container_writer, 4, "c\n", 2);
+    output_container_append(container_writer, 3, "d\n", 2);
+    g_assert_true(close_output_container_writer(container_writer));
+
+    char *output = NULL;
+    size_t size = 0;
+
+    g_assert_true(read_output_container_command(container_path, 1, &output, &size));
+    g_assert_cmpuint(size, ==, 0);
+    free(output);
+
+    FILE *expected_file = tmpfile();
+    write_async_output_test_lines(create_semicolon_file_output_writer(expected_file), 2);
+    size_t expected_size;
+    char *expected = read_async_output_test_file(expected_file, &expected_size);
+    g_assert_true(read_output_container_command(container_path, 2, &output, &size));
+    g_assert_cmpmem(expected, expected_size, output, size);
+    free(expected);
+    free(output);
+    fclose(expected_file);
+
+    g_assert_true(read_output_container_command(container_path, 3, &output, &size));
+    g_assert_cmpstr(output, ==, "a;b\nd\n");
+    free(output);
+
+    g_assert_false(read_output_container_command(container_path, 5, &output, &size));
+
+    remove(container_path);
+    g_free(container_path);
+}
+
+/**
+ * Number of random doubles and integers formatted by `test_typed_tokens_match_printf`.
+ */
+#define OUTPUT_WRITER_FUZZ_ITERATIONS 200000
+
+/**
+ * Ensures the typed tokens are formatted exactly like the printf formats they replace,
+ * including doubles that are halfway between two thousandths.
+ */
+void test_typed_tokens_match_printf(void) {
+    GPtrArray *typed = g_ptr_array_new_with_free_func(g_free);
+    GPtrArray *formatted = g_ptr_array_new_with_free_func(g_free);
+    OutputWriter *typed_writer = create_array_of_semicolon_strings_output_writer(typed);
+    OutputWriter *formatted_writer = create_array_of_semicolon_strings_output_writer(formatted);
+    GRand *rand = g_rand_new_with_seed(6);
+
+    for (int i = 0; i < OUTPUT_WRITER_FUZZ_ITERATIONS; i++) {
+        // Averages of small integers, exact ties (x.yyy5 with few bits) and arbitrary doubles
+        double value;
+        switch (i % 3) {
+            case 0: value = (double) g_rand_int_range(rand, 0, 100000) / g_rand_int_range(rand, 1, 1000); break;
+            case 1: value = (g_rand_int_range(rand, 0, 1 << 20) + 0.5) / 1024; break;
+            default: value = g_rand_double_range(rand, -1e6, 1e6); break;
+        }
+        int integer = (int) g_rand_int(rand) >> g_rand_int_range(rand, 0, 31);
+        Date date = create_date(g_rand_int_range(rand, 1, 32), g_rand_int_range(rand, 1, 13), g_rand_int_range(rand, 1900, 2100));
+        Money money = (Money) g_rand_int_range(rand, -100000000, 100000000);
+
+        char money_string[MONEY_STRING_BUFFER_SIZE];
+
+        writer_write_fixed_3_token(typed_writer, value);
+        writer_write_int_token(typed_writer, integer, 12);
+        writer_write_int_token(typed_writer, integer, 0);
+        writer_write_date_token(typed_writer, date);
+        writer_write_money_token(typed_writer, money);
+        writer_write_string_token(typed_writer, "Ana");
+        writer_end_line(typed_writer);
+
+        writer_write_output_token(formatted_writer, "%.3f", value);
+        writer_write_output_token(formatted_writer, "%012d", integer);
+        writer_write_output_token(formatted_writer, "%d", integer);
+        writer_write_output_token(formatted_writer, "%02d/%02d/%04d", date_get_day(date), date_get_month(date), date_get_year(date));
+        writer_write_output_token(formatted_writer, "%s", format_money(money, money_string));
+        writer_write_output_token_end(formatted_writer, "%s", "Ana");
+
+        if (strcmp(g_ptr_array_index(typed, i), g_ptr_array_index(formatted, i)) != 0) {
+            g_test_fail_printf("Typed tokens '%s' differ from printf '%s'", (char *) g_ptr_array_index(typed, i), (char *) g_ptr_array_index(formatted, i));
+            break;
+        }
+    }
+
+    g_rand_free(rand);
+    close_output_writer(typed_writer);
+    close_output_writer(formatted_writer);
+    g_ptr_array_free(typed, TRUE);
+    g_ptr_array_free(formatted, TRUE);
+}
+
+/**
+ * Number of query 8 like lines written by `benchmark_output_writer_typed_against_printf`.
+ */
+#define OUTPUT_WRITER_BENCHMARK_LINES 1000000
+
+/**
+ * Measures the output throughput of writing query 8 and query 2 like lines to a file
+ * with the typed tokens and with the printf-style tokens.
+ */
+void benchmark_output_writer_typed_against_printf(void) {
+    const char *names[] = {"Ana Silva", "Joao Ferreira", "Maria Santos", "Pedro Pereira"};
+
+    for (int typed = 1; typed >= 0; typed--) {
+        FILE *file = tmpfile();
+        g_autofree GTimer *timer = g_timer_new();
+
+        OutputWriter *writer = create_semicolon_file_output_writer(file);
+        for (int i = 0; i < OUTPUT_WRITER_BENCHMARK_LINES; i++) {
+            const char *name = names[i % 4];
+            double score = (double) (i % 4999) / 1000;
+            if (typed) {
+                writer_write_int_token(writer, i, 12);
+                writer_write_string_token(writer, name);
+                writer_write_string_token(writer, "AnaSilva123");
+                writer_write_fixed_3_token(writer, score);
+                writer_end_line(writer);
+            } else {
+                writer_write_output_token(writer, "%012d", i);
+                writer_write_output_token(writer, "%s", name);
+                writer_write_output_token(writer, "%s", "AnaSilva123");
+                writer_write_output_token_end(writer, "%.3f", score);
+            }
+        }
+        close_output_writer(writer);
+
+        double seconds = g_timer_elapsed(timer, NULL);
+        fseek(file, 0, SEEK_END); // The writer bypasses the position of the stdio stream
+        double megabytes = (double) ftell(file) / 1e6;
+        printf("# %-7s tokens: %.1f MB in %.3f s (%.1f MB/s)\n", typed ? "typed" : "printf", megabytes, seconds, megabytes / seconds);
+
+        fclose(file);
+    }
+}
@@ -0,0 +1,115 @@
+#include "delimiter_scanner.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define READ_CYCLE_COUNTER() __rdtsc()
+#else
+#define READ_CYCLE_COUNTER() 0
+#endif
+
+#define DELIMITER_SCANNER_BENCHMARK_SIZE (16 * 1024 * 1024)
+#define DELIMITER_SCANNER_BENCHMARK_RUNS 5
+
+/**
+ * Counts tokens and lines, so the compiler can't optimize the scans away.
+ */
+static void count_scanned_line(void *arg, const char *line, size_t length, const uint32_t *token_ends, int token_count) {
+    (void) line;
+    (void) length;
+    (void) token_ends;
+    *(size_t *) arg += token_count;
+}
+
+/**
+ * The loop used before the delimiter scanner: memchr for the line end and a byte loop for each token.
+ */
+static size_t scan_csv_lines_byte_by_byte(char *data, size_t length) {
+    size_t token_count = 0;
+    char *current = data;
+    char *end = data + length;
+
+    while (current < end) {
+        char *line_end = memchr(current, '\n', end - current);
+        if (line_end == NULL) break;
+
+        for (char *token = current; token <= line_end; token++) {
+            while (*token != ';' && *token != '\n') token++;
+            token_count++;
+        }
+
+        current = line_end + 1;
+    }
+
+    return token_count;
+}
+
+/**
+ * Fills the buffer with lines that look like the lines of rides.csv.
+ */
+static void fill_rides_like_csv(char *buffer, size_t size) {
+    const char line[] = "000000123;14/02/2019;000004521;Lisboa;JoaoSilva123;4;2;19;5.0;;\n";
+    size_t line_length = sizeof(line) - 1;
+
+    size_t i = 0;
+    for (; i + line_length <= size; i += line_length) {
+        memcpy(buffer + i, line, line_length);
+    }
+    memset(buffer + i, 'x', size - i);
+}
+
+static void print_bytes_per_cycle(const char *name, uint64_t cycles, gdouble seconds) {
+    printf("# %-14s %6.3f bytes/cycle %8.1f MB/s\n", name,
+           cycles == 0 ? 0.0 : (gdouble) DELIMITER_SCANNER_BENCHMARK_SIZE / (gdouble) cycles,
+           (gdouble) DELIMITER_SCANNER_BENCHMARK_SIZE / (1024 * 1024) / seconds);
+}
+
+/**
+ * Measures the bytes per cycle of every supported scanner implementation against the byte by byte loop.
+ * Fails if the vectorized scanners don't count the same tokens as the byte by byte loop.
+ */
+void benchmark_delimiter_scanner_implementations(void) {
+    char *buffer = g_malloc(DELIMITER_SCANNER_BENCHMARK_SIZE);
+    fill_rides_like_csv(buffer, DELIMITER_SCANNER_BENCHMARK_SIZE);
+
+    g_autofree GTimer *timer = g_timer_new();
+
+    size_t expected_token_count = 0;
+    uint64_t best_cycles = UINT64_MAX;
+    gdouble best_seconds = G_MAXDOUBLE;
+    for (int run = 0; run < DELIMITER_SCANNER_BENCHMARK_RUNS; run++) {
+        g_timer_start(timer);
+        uint64_t start = READ_CYCLE_COUNTER();
+        expected_token_count = scan_csv_lines_byte_by_byte(buffer, DELIMITER_SCANNER_BENCHMARK_SIZE);
+        best_cycles = MIN(best_cycles, READ_CYCLE_COUNTER() - start);
+        g_timer_stop(timer);
+        best_seconds = MIN(best_seconds, g_timer_elapsed(timer, NULL));
+    }
+    print_bytes_per_cycle("byte by byte", best_cycles, best_seconds);
+
+    const char *names[] = {"scalar", "sse2", "avx2"};
+    for (DelimiterScannerImplementation implementation = DELIMITER_SCANNER_SCALAR; implementation <= DELIMITER_SCANNER_AVX2; implementation++) {
+        if (!is_delimiter_scanner_implementation_supported(implementation)) continue;
+
+        best_cycles = UINT64_MAX;
+        best_seconds = G_MAXDOUBLE;
+        for (int run = 0; run < DELIMITER_SCANNER_BENCHMARK_RUNS; run++) {
+            size_t token_count = 0;
+
+            g_timer_start(timer);
+            uint64_t start = READ_CYCLE_COUNTER();
+            scan_csv_lines_with_implementation(implementation, buffer, DELIMITER_SCANNER_BENCHMARK_SIZE, count_scanned_line, &token_count);
+            best_cycles = MIN(best_cycles, READ_CYCLE_COUNTER() - start);
+            g_timer_stop(timer);
+            best_seconds = MIN(best_seconds, g_timer_elapsed(timer, NULL));
+
+            g_assert_cmpuint(token_count, ==, expected_token_count);
+        }
+        print_bytes_per_cycle(names[implementation], best_cycles, best_seconds);
+    }
+
+    g_free(buffer);
+}
@@ -41,3 +41,58 @@ void load_catalog_execute_queries_and_benchmark(char *dataset_folder_path, char
 void load_catalog_execute_queries_and_benchmark_regular_2(void) {
     load_catalog_execute_queries_and_benchmark("datasets/data-regular", "datasets/data-regular/input2.txt");
 }
+
+/**
+ * Number of times the queries of the input files are run by `benchmark_query_threads_throughput` for each thread count.
+ */
+#define QUERY_THREADS_BENCHMARK_REPETITIONS 20
+
+/**
+ * Runs a query on the catalog, discarding its output (a QueryRunner).
+ */
+static void run_query_discarding_output(void *catalog, char *query, int query_number) {
+    (void) query_number;
+
+    OutputWriter *output_writer = create_null_output_writer();
+    parse_and_run_query(catalog, output_writer, query);
+    close_output_writer(output_writer);
+}
+
+/**
+ * Prints the throughput of the queries in `datasets/data-regular/input1.txt` and `datasets/data-regular/input2.txt`
+ * run with `run_queries_longest_first` on 1, 2, 4 and 8 threads.
+ */
+void benchmark_query_threads_throughput(void) {
+    Catalog *catalog = create_catalog();
+    catalog_load_csv_dataset(catalog, "datasets/data-regular");
+
+    GPtrArray *queries = g_ptr_array_new_with_free_func(g_free);
+    char *queries_file_paths[] = {"datasets/data-regular/input1.txt", "datasets/data-regular/input2.txt"};
+    for (int repetition = 0; repetition < QUERY_THREADS_BENCHMARK_REPETITIONS; repetition++) {
+        for (int i = 0; i < 2; i++) {
+            FILE *queries_file = open_file(queries_file_paths[i]);
+
+            char buffer[1024];
+            while (fgets(buffer, 1024, queries_file) != NULL) {
+                format_input_line(buffer);
+                g_ptr_array_add(queries, g_strdup(buffer));
+            }
+
+            fclose(queries_file);
+        }
+    }
+
+    // Indexes the catalog first, so every thread count runs the same work
+    run_queries_longest_first(queries, 1, run_query_discarding_output, catalog);
+
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        g_autofree GTimer *timer = g_timer_new();
+        run_queries_longest_first(queries, threads, run_query_discarding_output, catalog);
+        double seconds = g_timer_elapsed(timer, NULL);
+
+        printf("# %d query threads: %u queries in %.3f s (%.0f queries/s)\n", threads, queries->len, seconds, queries->len / seconds);
+    }
+
+    g_ptr_array_free(queries, TRUE);
+    free_catalog(catalog);
+}
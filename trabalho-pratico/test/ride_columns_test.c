@@ -0,0 +1,161 @@
+#include "ride_columns.h"
+#include "price_util.h"
+#include "delimiter_scanner.h"
+#include "token_iterator.h"
+#include "snapshot.h"
+
+#include <glib.h>
+
+/**
+ * Ensures the date bounds and the sums of the columnar store match a linear scan of the rides.
+ */
+void test_ride_columns_date_range_sums(void) {
+    GPtrArray *rides = g_ptr_array_new();
+
+    // 5 rides per day, from 1/1/2020 to 20/1/2020, already sorted by date
+    for (int i = 0; i < 100; i++) {
+        Ride *ride = create_ride(i, create_date(1 + i / 5, 1, 2020), 1, 0, 1 + i % 10, 5, 5, i % 3 == 0 ? 1000 : 0, NULL);
+        ride_set_car_class(ride, (CarClass) (i % 3));
+        g_ptr_array_add(rides, ride);
+    }
+
+    RideColumns *columns = create_ride_columns(rides, RIDE_COLUMN_DATE | RIDE_COLUMN_PRICE | RIDE_COLUMN_DISTANCE);
+    g_assert_cmpuint(ride_columns_get_length(columns), ==, 100);
+
+    guint first_row = ride_columns_find_date_lower_bound(columns, create_date(3, 1, 2020));
+    guint end_row = ride_columns_find_date_upper_bound(columns, create_date(5, 1, 2020));
+    g_assert_cmpuint(first_row, ==, 10);
+    g_assert_cmpuint(end_row, ==, 25);
+
+    Money expected_price_sum = 0;
+    int64_t expected_distance_sum = 0;
+    for (guint row = first_row; row < end_row; row++) {
+        Ride *ride = g_ptr_array_index(rides, row);
+        g_assert_cmpint(date_compare(ride_columns_get_date(columns, row), ride_get_date(ride)), ==, 0);
+        expected_price_sum += ride_get_price(ride);
+        expected_distance_sum += ride_get_distance(ride);
+    }
+    g_assert_cmpint(ride_columns_sum_prices(columns, first_row, end_row), ==, expected_price_sum);
+    g_assert_cmpint(ride_columns_sum_distances(columns, first_row, end_row), ==, expected_distance_sum);
+
+    // Dates outside the stored range
+    g_assert_cmpuint(ride_columns_find_date_lower_bound(columns, create_date(1, 2, 2020)), ==, 100);
+    g_assert_cmpuint(ride_columns_find_date_upper_bound(columns, create_date(31, 12, 2019)), ==, 0);
+
+    free_ride_columns(columns);
+    for (guint i = 0; i < rides->len; i++) free_ride(g_ptr_array_index(rides, i));
+    g_ptr_array_free(rides, TRUE);
+}
+
+/**
+ * Parses rides with values that don't fit in a packed ride (and extends a packed one when its ids are set)
+ * and ensures every value, the date order and the columns are exact.
+ */
+void test_extended_rides_keep_exact_values(void) {
+    _Alignas(DELIMITER_SCANNER_ALIGNMENT) char lines[][64] = {
+            "16777216;01/01/1960;16777300;User;Braga;300;9;8;70.5;",
+            "3;15/06/2020;1;User;Braga;5;2;3;1.5;",
+            "2;31/12/2150;1;User;Braga;1;1;1;0;",
+    };
+
+    TokenIterator *iterator = init_semicolon_separated_token_iterator();
+    GPtrArray *rides = g_ptr_array_new();
+    for (size_t i = 0; i < G_N_ELEMENTS(lines); i++) {
+        token_iterator_set_current_line(iterator, lines[i]);
+        Ride *ride = parse_line_ride(iterator, NULL);
+        g_assert_nonnull(ride);
+        g_ptr_array_add(rides, ride);
+    }
+    token_iterator_free(iterator);
+
+    Ride *old_ride = g_ptr_array_index(rides, 0);
+    g_assert_cmpint(ride_get_id(old_ride), ==, 16777216);
+    g_assert_cmpint(ride_get_driver_id(old_ride), ==, 16777300);
+    g_assert_cmpint(date_compare(ride_get_date(old_ride), create_date(1, 1, 1960)), ==, 0);
+    g_assert_cmpint(ride_get_distance(old_ride), ==, 300);
+    g_assert_cmpint(ride_get_score_user(old_ride), ==, 9);
+    g_assert_cmpint(ride_get_score_driver(old_ride), ==, 8);
+    g_assert_cmpint(ride_get_tip(old_ride), ==, 70500);
+    g_assert_cmpint(ride_get_price(old_ride), ==, compute_price(300, BASIC));
+    g_assert_cmpuint(ride_get_date_bucket(old_ride), ==, RIDE_DATE_BUCKET_BEFORE_RANGE);
+    g_assert_cmpuint(ride_get_date_bucket(g_ptr_array_index(rides, 2)), ==, RIDE_DATE_BUCKET_AFTER_RANGE);
+
+    // Ids set at registration that don't fit extend the packed ride, keeping its other values
+    Ride *packed_ride = g_ptr_array_index(rides, 1);
+    ride_set_car_class(packed_ride, PREMIUM);
+    ride_set_user_id(packed_ride, 1 << 25, NULL);
+    ride_set_city_id(packed_ride, 300, NULL);
+    g_assert_cmpint(ride_get_user_id(packed_ride), ==, 1 << 25);
+    g_assert_cmpint(ride_get_city_id(packed_ride), ==, 300);
+    g_assert_cmpint(ride_get_id(packed_ride), ==, 3);
+    g_assert_cmpint(date_compare(ride_get_date(packed_ride), create_date(15, 6, 2020)), ==, 0);
+    g_assert_cmpint(ride_get_distance(packed_ride), ==, 5);
+    g_assert_cmpint(ride_get_score_user(packed_ride), ==, 2);
+    g_assert_cmpint(ride_get_score_driver(packed_ride), ==, 3);
+    g_assert_cmpint(ride_get_tip(packed_ride), ==, 1500);
+    g_assert_cmpint(ride_get_price(packed_ride), ==, compute_price(5, PREMIUM));
+
+    // Already in date order
+    for (guint i = 1; i < rides->len; i++) g_assert_cmpint(compare_rides_by_date(&rides->pdata[i - 1], &rides->pdata[i]), <, 0);
+
+    RideColumns *columns = create_ride_columns(rides, RIDE_COLUMNS_ALL);
+    Money expected_price_sum = 0;
+    for (guint row = 0; row < rides->len; row++) {
+        Ride *ride = g_ptr_array_index(rides, row);
+        g_assert_cmpint(ride_columns_get_tip(columns, row), ==, ride_get_tip(ride));
+        g_assert_cmpint(ride_columns_get_distance(columns, row), ==, ride_get_distance(ride));
+        g_assert_cmpint(ride_columns_get_city_id(columns, row), ==, ride_get_city_id(ride));
+        expected_price_sum += ride_get_price(ride);
+    }
+    g_assert_cmpint(ride_columns_sum_prices(columns, 0, rides->len), ==, expected_price_sum);
+    g_assert_cmpint(ride_columns_sum_distances(columns, 0, rides->len), ==, 306);
+    g_assert_cmpint(ride_columns_sum_distances(columns, 1, rides->len), ==, 6);
+    g_assert_cmpuint(ride_columns_find_date_lower_bound(columns, create_date(1, 1, 2000)), ==, 1);
+
+    free_ride_columns(columns);
+    for (guint i = 0; i < rides->len; i++) free_ride(g_ptr_array_index(rides, i));
+    g_ptr_array_free(rides, TRUE);
+}
+
+/**
+ * Writes a packed ride with the given distance and car class to a snapshot and reads it back.
+ * Returns TRUE if the snapshot reader accepted the ride.
+ */
+static gboolean packed_ride_snapshot_is_accepted(uint8_t distance, uint8_t car_class) {
+    gchar *snapshot_path = g_build_filename(g_get_tmp_dir(), "li3-test-ride-snapshot.bin", NULL);
+
+    SnapshotWriter *writer = create_snapshot_writer();
+    snapshot_write_uint8(writer, FALSE); // Not extended
+    snapshot_write_uint32(writer, 1); // id
+    snapshot_write_uint32(writer, 2); // user id
+    snapshot_write_uint32(writer, 3); // driver id
+    snapshot_write_uint16(writer, 0); // packed date
+    snapshot_write_uint16(writer, 0); // tip
+    snapshot_write_uint8(writer, distance);
+    snapshot_write_uint8(writer, 0); // city id
+    snapshot_write_uint8(writer, 5); // score user
+    snapshot_write_uint8(writer, 5); // score driver
+    snapshot_write_uint8(writer, car_class);
+    g_assert_true(snapshot_writer_save(writer, snapshot_path, 1));
+    free_snapshot_writer(writer);
+
+    SnapshotReader *reader = open_snapshot_reader(snapshot_path, 1);
+    g_assert_nonnull(reader);
+    free_ride(ride_read_snapshot(reader, NULL));
+    gboolean accepted = !snapshot_reader_has_error(reader);
+    free_snapshot_reader(reader);
+
+    remove(snapshot_path);
+    g_free(snapshot_path);
+    return accepted;
+}
+
+/**
+ * Ensures that snapshot rides that can't be valid (a distance of 0 or an unknown car class) fail the snapshot
+ * instead of being silently changed.
+ */
+void test_ride_snapshot_rejects_invalid_rides(void) {
+    g_assert_true(packed_ride_snapshot_is_accepted(10, BASIC));
+    g_assert_false(packed_ride_snapshot_is_accepted(0, BASIC));
+    g_assert_false(packed_ride_snapshot_is_accepted(10, CAR_CLASS_COUNT));
+}
@@ -0,0 +1,131 @@
+#include "string_index.h"
+#include "string_pool.h"
+
+#include <glib.h>
+#include <stdio.h>
+
+#define STRING_INDEX_TEST_KEYS 100000
+#define STRING_INDEX_BENCHMARK_RUNS 5
+
+/**
+ * Fills the buffer with a username like the ones in users.csv, unique for each i.
+ */
+static void format_test_username(char *buffer, int i) {
+    static const char *first_names[] = {"Ana", "Joao", "Maria", "Pedro", "Sofia", "Tiago", "Rita", "Rui"};
+    static const char *last_names[] = {"Silva", "Ferreira", "Santos", "Pereira", "Costa", "Oliveira"};
+
+    sprintf(buffer, "%s%s%d", first_names[i % 8], last_names[(i / 8) % 6], i * 7919 % 100000000);
+}
+
+/**
+ * Ensures the index finds every inserted key (also after growing), replaces repeated keys and misses absent keys.
+ */
+void test_string_index_insert_and_lookup(void) {
+    StringHeap *string_heap = create_string_heap(0);
+    StringIndex *string_index = create_string_index(string_heap, 0); // Grows many times
+    char username[64];
+
+    for (int i = 0; i < STRING_INDEX_TEST_KEYS; i++) {
+        format_test_username(username, i);
+        string_index_insert(string_index, username, i);
+    }
+    g_assert_cmpuint(string_index_get_size(string_index), ==, STRING_INDEX_TEST_KEYS);
+    g_assert_cmpuint(string_index_get_capacity(string_index) & (string_index_get_capacity(string_index) - 1), ==, 0);
+
+    for (int i = 0; i < STRING_INDEX_TEST_KEYS; i++) {
+        format_test_username(username, i);
+        g_assert_cmpint(string_index_lookup(string_index, username), ==, i);
+    }
+
+    // Replacing doesn't copy the key again
+    size_t heap_size = string_heap_get_size(string_heap);
+    format_test_username(username, 42);
+    string_index_insert(string_index, username, STRING_INDEX_TEST_KEYS + 42);
+    g_assert_cmpint(string_index_lookup(string_index, username), ==, STRING_INDEX_TEST_KEYS + 42);
+    g_assert_cmpuint(string_heap_get_size(string_heap), ==, heap_size);
+    g_assert_cmpuint(string_index_get_size(string_index), ==, STRING_INDEX_TEST_KEYS);
+
+    g_assert_cmpint(string_index_lookup(string_index, "NotAUser"), ==, STRING_INDEX_NOT_FOUND);
+    g_assert_cmpint(string_index_lookup(string_index, ""), ==, STRING_INDEX_NOT_FOUND);
+    format_test_username(username, STRING_INDEX_TEST_KEYS);
+    g_assert_cmpint(string_index_lookup(string_index, username), ==, STRING_INDEX_NOT_FOUND);
+
+    free_string_index(string_index);
+    free_string_heap(string_heap);
+}
+
+/**
+ * Ensures the pool stores repeated strings once and gives them the same id.
+ */
+void test_string_pool_interns_repeated_strings_once(void) {
+    StringPool *string_pool = create_string_pool();
+
+    uint32_t ana_id = string_pool_intern(string_pool, "Ana Silva");
+    uint32_t rui_id = string_pool_intern(string_pool, "Rui Costa");
+    g_assert_cmpuint(string_pool_intern(string_pool, "Ana Silva"), ==, ana_id);
+    g_assert_cmpuint(ana_id, !=, rui_id);
+
+    g_assert_cmpstr(string_pool_get(string_pool, ana_id), ==, "Ana Silva");
+    g_assert_cmpstr(string_pool_get(string_pool, rui_id), ==, "Rui Costa");
+
+    g_assert_cmpuint(string_pool_get_unique_count(string_pool), ==, 2);
+    g_assert_cmpuint(string_pool_get_reference_count(string_pool), ==, 3);
+    g_assert_cmpuint(string_pool_get_size(string_pool), ==, 2 * sizeof("Ana Silva"));
+    g_assert_cmpuint(string_pool_get_referenced_size(string_pool), ==, 3 * sizeof("Ana Silva"));
+
+    free_string_pool(string_pool);
+}
+
+/**
+ * Measures building and looking up usernames (as in the ride ingest) with the string index and with a GHashTable
+ * with duplicated keys, as the catalog used before.
+ */
+void benchmark_string_index_against_ghashtable(void) {
+    char **usernames = malloc(sizeof(char *) * STRING_INDEX_TEST_KEYS);
+    char username[64];
+    for (int i = 0; i < STRING_INDEX_TEST_KEYS; i++) {
+        format_test_username(username, i);
+        usernames[i] = g_strdup(username);
+    }
+
+    // 10 lookups per key, in a scattered order like the users of the rides
+    int lookups = STRING_INDEX_TEST_KEYS * 10;
+    g_autofree GTimer *timer = g_timer_new();
+
+    gdouble best_index_seconds[2] = {G_MAXDOUBLE, G_MAXDOUBLE};
+    gdouble best_hashtable_seconds[2] = {G_MAXDOUBLE, G_MAXDOUBLE};
+    for (int run = 0; run < STRING_INDEX_BENCHMARK_RUNS; run++) {
+        int64_t index_sum = 0, hashtable_sum = 0;
+
+        g_timer_start(timer);
+        StringHeap *string_heap = create_string_heap(0);
+        StringIndex *string_index = create_string_index(string_heap, STRING_INDEX_TEST_KEYS);
+        for (int i = 0; i < STRING_INDEX_TEST_KEYS; i++) string_index_insert(string_index, usernames[i], i);
+        best_index_seconds[0] = MIN(best_index_seconds[0], g_timer_elapsed(timer, NULL));
+
+        g_timer_start(timer);
+        for (int i = 0; i < lookups; i++) index_sum += string_index_lookup(string_index, usernames[(int) ((int64_t) i * 48271 % STRING_INDEX_TEST_KEYS)]);
+        best_index_seconds[1] = MIN(best_index_seconds[1], g_timer_elapsed(timer, NULL));
+
+        g_timer_start(timer);
+        GHashTable *hashtable = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+        for (int i = 0; i < STRING_INDEX_TEST_KEYS; i++) g_hash_table_insert(hashtable, g_strdup(usernames[i]), GINT_TO_POINTER(i));
+        best_hashtable_seconds[0] = MIN(best_hashtable_seconds[0], g_timer_elapsed(timer, NULL));
+
+        g_timer_start(timer);
+        for (int i = 0; i < lookups; i++) hashtable_sum += GPOINTER_TO_INT(g_hash_table_lookup(hashtable, usernames[(int) ((int64_t) i * 48271 % STRING_INDEX_TEST_KEYS)]));
+        best_hashtable_seconds[1] = MIN(best_hashtable_seconds[1], g_timer_elapsed(timer, NULL));
+
+        g_assert_cmpint(index_sum, ==, hashtable_sum);
+
+        free_string_index(string_index);
+        free_string_heap(string_heap);
+        g_hash_table_destroy(hashtable);
+    }
+
+    printf("# %-12s build %7.3f ms, %6.1f ns/lookup\n", "string index", best_index_seconds[0] * 1000, best_index_seconds[1] * 1e9 / lookups);
+    printf("# %-12s build %7.3f ms, %6.1f ns/lookup\n", "GHashTable", best_hashtable_seconds[0] * 1000, best_hashtable_seconds[1] * 1e9 / lookups);
+
+    for (int i = 0; i < STRING_INDEX_TEST_KEYS; i++) g_free(usernames[i]);
+    free(usernames);
+}
@@ -1,6 +1,10 @@
 #include "struct_util.h"
+#include "price_util.h"
 
+#include <ctype.h>
 #include <glib.h>
+#include <stdio.h>
+#include <string.h>
 
 /**
  * Tests if parsing and encoding/decoding of the date is done correctly.
@@ -33,6 +37,16 @@ void assert_test_date_parse_and_encoding(void) {
     }
 }
 
+/**
+ * Tests if dates are formatted on the stack like the "%02d/%02d/%04d" format.
+ */
+void assert_test_date_format(void) {
+    char date_string[DATE_STRING_BUFFER_SIZE];
+    g_assert_cmpstr(format_date(create_date(1, 2, 2022), date_string), ==, "01/02/2022");
+    g_assert_cmpstr(format_date(create_date(31, 12, 987), date_string), ==, "31/12/0987");
+    g_assert_cmpstr(format_date(create_date(9, 10, 12345), date_string), ==, "09/10/12345");
+}
+
 /**
  * Tests if the date comparison works correctly.
  */
@@ -82,3 +96,214 @@ void assert_test_date_age(void) {
         g_test_fail_printf("Age should've been 1 for date4 (09/10/2021) but is %d", get_age(date4));
     }
 }
+
+#define FUZZ_ITERATIONS 200000
+#define FUZZ_PAGE_SIZE 4096
+
+/**
+ * Copies the string into a page sized area so that it ends a few bytes before the end of a page,
+ * exercising the loads that must not cross page boundaries.
+ * Returns the copy, which lives inside `page_area` (at least 2 pages long).
+ */
+static char *place_near_page_end(char *page_area, const char *string, GRand *rand) {
+    char *page_end = (char *) (((uintptr_t) page_area + FUZZ_PAGE_SIZE) & ~(uintptr_t) (FUZZ_PAGE_SIZE - 1)) + FUZZ_PAGE_SIZE;
+    size_t size = strlen(string) + 1;
+    char *copy = page_end - size - g_rand_int_range(rand, 0, 12);
+    memcpy(copy, string, size);
+    return copy;
+}
+
+/**
+ * Fills buffer with a random string of up to max_length characters of the given alphabet.
+ */
+static void random_string(char *buffer, int max_length, const char *alphabet, GRand *rand) {
+    int length = g_rand_int_range(rand, 0, max_length + 1);
+    int alphabet_length = (int) strlen(alphabet);
+
+    for (int i = 0; i < length; i++) {
+        buffer[i] = alphabet[g_rand_int_range(rand, 0, alphabet_length)];
+    }
+    buffer[length] = '\0';
+}
+
+/**
+ * Ensures that the SWAR integer parser returns the same value and error as the scalar reference.
+ */
+void assert_fuzz_parse_int_equals_reference(void) {
+    GRand *rand = g_rand_new_with_seed(1);
+    char *page_area = g_malloc(FUZZ_PAGE_SIZE * 3);
+    char string[32];
+
+    for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+        if (i % 2 == 0) {
+            random_string(string, 10, "00123456789-+ a/", rand);
+        } else {
+            sprintf(string, "%d", g_rand_int_range(rand, -1000, 100000000));
+        }
+
+        char *tested = i % 3 == 0 ? place_near_page_end(page_area, string, rand) : string;
+
+        int expected_error = 0, error = 0;
+        int expected = parse_int_safe_reference(string, &expected_error);
+        int actual = parse_int_safe(tested, &error);
+
+        if (expected != actual || expected_error != error) {
+            g_test_fail_printf("parse_int_safe('%s') = %d (error %d), expected %d (error %d)", string, actual, error, expected, expected_error);
+            break;
+        }
+    }
+
+    g_free(page_area);
+    g_rand_free(rand);
+}
+
+/**
+ * Ensures that integers that don't fit in an int are rejected and that the limits are still accepted.
+ */
+void assert_parse_int_rejects_overflow(void) {
+    char *overflowing[] = {"2147483648", "-2147483649", "9999999999", "99999999999999999999999"};
+    for (size_t i = 0; i < G_N_ELEMENTS(overflowing); i++) {
+        int error = 0;
+        parse_int_safe(overflowing[i], &error);
+        if (!error) g_test_fail_printf("parse_int_safe('%s') should have failed", overflowing[i]);
+    }
+
+    int error = 0;
+    g_assert_cmpint(parse_int_safe("2147483647", &error), ==, G_MAXINT);
+    g_assert_cmpint(parse_int_safe("-2147483648", &error), ==, G_MININT);
+    g_assert_cmpint(error, ==, 0);
+}
+
+/**
+ * Ensures that the SWAR date parser accepts and rejects the same dates as the scalar reference.
+ * Starts from valid dates and mutates some of their characters.
+ */
+void assert_fuzz_parse_date_equals_reference(void) {
+    GRand *rand = g_rand_new_with_seed(3);
+    const char mutations[] = "0123456789/-a ";
+
+    for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+        // Zero padded, as the reference reads up to the 11th byte
+        char string[16] = {0};
+        sprintf(string, "%02d/%02d/%04d", g_rand_int_range(rand, 0, 40), g_rand_int_range(rand, 0, 15), g_rand_int_range(rand, 0, 10000));
+
+        int mutation_count = g_rand_int_range(rand, 0, 3);
+        for (int j = 0; j < mutation_count; j++) {
+            int position = g_rand_int_range(rand, 0, 11);
+            string[position] = g_rand_int_range(rand, 0, 20) == 0 ? '\0' : mutations[g_rand_int_range(rand, 0, (int) sizeof(mutations) - 1)];
+        }
+
+        char reference_string[16];
+        memcpy(reference_string, string, sizeof(string));
+
+        Date expected = parse_date_reference(reference_string);
+        Date actual = parse_date(string);
+
+        if (expected.encoded_date != actual.encoded_date) {
+            g_test_fail_printf("parse_date('%s') = %u, expected %u", string, actual.encoded_date, expected.encoded_date);
+            break;
+        }
+    }
+
+    g_rand_free(rand);
+}
+
+/**
+ * Ensures that the masked word compares of the enum parsers are equivalent to the uppercase + strcmp reference.
+ * Uses the valid words with random case, truncations, extensions and replaced characters.
+ */
+void assert_fuzz_parse_enums_equals_reference(void) {
+    GRand *rand = g_rand_new_with_seed(4);
+    char *page_area = g_malloc(FUZZ_PAGE_SIZE * 3);
+    const char *words[] = {"basic", "green", "premium", "active", "inactive", "", "x"};
+    const char replacements[] = "aAeE@`{[ \x01\xe1";
+
+    for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+        char string[16] = {0};
+        strcpy(string, words[g_rand_int_range(rand, 0, sizeof(words) / sizeof(words[0]))]);
+        int length = (int) strlen(string);
+
+        for (int j = 0; j < length; j++) {
+            if (g_rand_boolean(rand)) string[j] = (char) toupper(string[j]);
+            if (g_rand_int_range(rand, 0, 30) == 0) string[j] = replacements[g_rand_int_range(rand, 0, (int) sizeof(replacements) - 1)];
+        }
+
+        int change = g_rand_int_range(rand, 0, 10);
+        if (change == 0 && length > 0) string[length - 1] = '\0';
+        if (change == 1) string[length] = 'e';
+
+        char *tested = i % 3 == 0 ? place_near_page_end(page_area, string, rand) : string;
+
+        char reference_string[16];
+        memcpy(reference_string, string, sizeof(string));
+        CarClass expected_car_class = parse_car_class_reference(reference_string);
+        memcpy(reference_string, string, sizeof(string));
+        AccountStatus expected_acc_status = parse_acc_status_reference(reference_string);
+
+        if (parse_car_class(tested) != expected_car_class || parse_acc_status(tested) != expected_acc_status) {
+            g_test_fail_printf("Enum parsers disagree with the reference for '%s'", string);
+            break;
+        }
+    }
+
+    g_free(page_area);
+    g_rand_free(rand);
+}
+
+/**
+ * Ensures that Money is parsed and formatted like the double based "%.3f" output it replaces.
+ * Only strings with up to 3 decimal places are used, as those are exact in fixed-point.
+ */
+void assert_fuzz_money_matches_double_formatting(void) {
+    GRand *rand = g_rand_new_with_seed(5);
+    char string[32];
+    char reference_string[32];
+    char expected[64];
+    char actual[MONEY_STRING_BUFFER_SIZE];
+
+    for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+        sprintf(string, "%d.%0*d", g_rand_int_range(rand, 0, 100000), g_rand_int_range(rand, 1, 4), g_rand_int_range(rand, 0, 10));
+        if (i % 4 == 0) random_string(string, 6, "0123456789..-x", rand);
+
+        char *dot = strchr(string, '.');
+        if (dot != NULL && strlen(dot) > 4) dot[4] = '\0'; // more decimal places round differently in binary
+
+        strcpy(reference_string, string);
+
+        int expected_error = 0, error = 0;
+        double expected_value = parse_double_safe(reference_string, &expected_error);
+        Money money = parse_money_safe(string, &error);
+
+        if (expected_error != error) {
+            g_test_fail_printf("parse_money_safe('%s') error %d, expected %d", string, error, expected_error);
+            break;
+        }
+        if (error) continue;
+
+        sprintf(expected, "%.3f", expected_value);
+        format_money(money, actual);
+
+        if (strcmp(expected, actual) != 0 && !(expected_value == 0 && strcmp(expected, "-0.000") == 0)) {
+            g_test_fail_printf("Money for '%s' formatted as '%s', expected '%s'", string, actual, expected);
+            break;
+        }
+    }
+
+    g_assert_cmpstr(format_money(-1500, actual), ==, "-1.500");
+    g_assert_cmpstr(format_money(7, actual), ==, "0.007");
+    g_assert_cmpint(money_average(2001, 2), ==, 1001);
+    g_assert_cmpint(money_average(2002, 3), ==, 667);
+
+    g_rand_free(rand);
+}
+
+/**
+ * Ensures the price table has the same prices as `compute_price`.
+ */
+void assert_price_table_matches_compute_price(void) {
+    for (int car_class = BASIC; car_class <= PREMIUM; car_class++) {
+        for (int distance = 0; distance <= PRICE_TABLE_MAX_DISTANCE; distance++) {
+            g_assert_cmpint(price_table[car_class][distance], ==, compute_price(distance, car_class));
+        }
+    }
+}
@@ -0,0 +1,292 @@
+#include "typed_array.h"
+#include "ride.h"
+
+/**
+ * Returns TRUE if the first int is less than the second.
+ */
+static inline gboolean int_is_less(const int *a, const int *b) {
+    return *a < *b;
+}
+
+/**
+ * Returns TRUE if the int is less than the key.
+ */
+static inline gboolean int_is_before_key(const int *item, int key) {
+    return *item < key;
+}
+
+DEFINE_TYPED_ARRAY(TestIntArray, test_int_array, int)
+DEFINE_TYPED_SORT(test_ints, int, int_is_less)
+DEFINE_TYPED_LOWER_BOUND(test_ints_lower_bound, int, int, int_is_before_key)
+
+/**
+ * Function that compares ints, for qsort.
+ */
+static int compare_ints(const void *a, const void *b) {
+    return (*(const int *) a > *(const int *) b) - (*(const int *) a < *(const int *) b);
+}
+
+/**
+ * Appends elements to a typed array and checks they are all there, in order.
+ */
+void test_typed_array_append_and_get(void) {
+    TestIntArray *array = create_test_int_array(0);
+
+    for (int i = 0; i < 1000; i++) test_int_array_append(array, i * 3);
+
+    g_assert_cmpuint(array->len, ==, 1000);
+    for (guint i = 0; i < array->len; i++) g_assert_cmpint(*test_int_array_get(array, i), ==, (int) i * 3);
+
+    free_test_int_array(array);
+}
+
+/**
+ * Kinds of input of `test_typed_sort_matches_qsort`.
+ */
+typedef enum {
+    TYPED_SORT_TEST_RANDOM,
+    TYPED_SORT_TEST_FEW_VALUES,
+    TYPED_SORT_TEST_SORTED,
+    TYPED_SORT_TEST_REVERSED,
+    TYPED_SORT_TEST_ORGAN_PIPE,
+    TYPED_SORT_TEST_INPUT_KINDS,
+} TypedSortTestInput;
+
+/**
+ * Sorts different kinds and sizes of input with the generated introsort (and its heapsort fallback)
+ * and checks the result is the one of qsort.
+ */
+void test_typed_sort_matches_qsort(void) {
+    GRand *rand = g_rand_new_with_seed(24);
+    const size_t lengths[] = {0, 1, 2, 3, 16, 17, 100, 1000, 100000};
+
+    for (size_t l = 0; l < G_N_ELEMENTS(lengths); l++) {
+        size_t length = lengths[l];
+        int *items = malloc(sizeof(int) * MAX(length, 1));
+        int *heap_sorted = malloc(sizeof(int) * MAX(length, 1));
+        int *expected = malloc(sizeof(int) * MAX(length, 1));
+
+        for (TypedSortTestInput input = 0; input < TYPED_SORT_TEST_INPUT_KINDS; input++) {
+            for (size_t i = 0; i < length; i++) {
+                switch (input) {
+                    case TYPED_SORT_TEST_RANDOM:
+                        items[i] = (int) g_rand_int(rand);
+                        break;
+                    case TYPED_SORT_TEST_FEW_VALUES:
+                        items[i] = g_rand_int_range(rand, 0, 4);
+                        break;
+                    case TYPED_SORT_TEST_SORTED:
+                        items[i] = (int) i;
+                        break;
+                    case TYPED_SORT_TEST_REVERSED:
+                        items[i] = (int) (length - i);
+                        break;
+                    default:
+                        items[i] = (int) MIN(i, length - i);
+                        break;
+                }
+            }
+            memcpy(heap_sorted, items, sizeof(int) * length);
+            memcpy(expected, items, sizeof(int) * length);
+
+            test_ints_sort(items, length);
+            test_ints_heap_sort(heap_sorted, length);
+            qsort(expected, length, sizeof(int), compare_ints);
+
+            if (memcmp(items, expected, sizeof(int) * length) != 0 || memcmp(heap_sorted, expected, sizeof(int) * length) != 0)
+                g_test_fail_printf("Wrong order sorting %zu items of input kind %d", length, input);
+        }
+
+        free(items);
+        free(heap_sorted);
+        free(expected);
+    }
+
+    g_rand_free(rand);
+}
+
+/**
+ * Checks the generated lower bound against a linear search, for keys in, between and outside the items.
+ */
+void test_typed_lower_bound_matches_linear_search(void) {
+    int items[] = {1, 3, 3, 3, 7, 8, 8, 12};
+    size_t length = G_N_ELEMENTS(items);
+
+    for (int key = -1; key <= 14; key++) {
+        size_t expected = 0;
+        while (expected < length && items[expected] < key) expected++;
+
+        g_assert_cmpuint(test_ints_lower_bound(items, length, key), ==, expected);
+        for (size_t prefix = 0; prefix < length; prefix++) {
+            size_t expected_in_prefix = MIN(expected, prefix);
+            g_assert_cmpuint(test_ints_lower_bound(items, prefix, key), ==, expected_in_prefix);
+        }
+    }
+}
+
+/**
+ * Number of elements sorted by the sort benchmarks, as many as the rides in `data-large`.
+ */
+#define TYPED_SORT_BENCHMARK_ELEMENTS 1000000
+
+/**
+ * Element with the layout of the entries of the query 8 index (a ride and two account creation dates).
+ */
+typedef struct {
+    int id;
+    Date driver_account_creation_date;
+    Date user_account_creation_date;
+} TypedSortBenchmarkEntry;
+
+/**
+ * Function that compares TypedSortBenchmarkEntry like the query 8 index compares its entries.
+ */
+static inline int compare_typed_sort_benchmark_entries(const void *a, const void *b) {
+    const TypedSortBenchmarkEntry *a_entry = a;
+    const TypedSortBenchmarkEntry *b_entry = b;
+
+    int by_driver = date_compare(a_entry->driver_account_creation_date, b_entry->driver_account_creation_date);
+    if (by_driver != 0) return by_driver;
+
+    int by_user = date_compare(a_entry->user_account_creation_date, b_entry->user_account_creation_date);
+    if (by_user != 0) return by_user;
+
+    return a_entry->id - b_entry->id;
+}
+
+/**
+ * Returns TRUE if the first TypedSortBenchmarkEntry goes before the second.
+ */
+static inline gboolean typed_sort_benchmark_entry_is_before(const TypedSortBenchmarkEntry *a, const TypedSortBenchmarkEntry *b) {
+    return compare_typed_sort_benchmark_entries(a, b) < 0;
+}
+
+DEFINE_TYPED_SORT(typed_sort_benchmark_entries, TypedSortBenchmarkEntry, typed_sort_benchmark_entry_is_before)
+
+/**
+ * Prints the time of sorting values like the entries of the query 8 index with a `DEFINE_TYPED_SORT` sort, against qsort.
+ */
+void benchmark_typed_sort_of_values_against_qsort(void) {
+    GRand *rand = g_rand_new_with_seed(24);
+
+    TypedSortBenchmarkEntry *entries = malloc(sizeof(TypedSortBenchmarkEntry) * TYPED_SORT_BENCHMARK_ELEMENTS);
+    TypedSortBenchmarkEntry *expected = malloc(sizeof(TypedSortBenchmarkEntry) * TYPED_SORT_BENCHMARK_ELEMENTS);
+    for (int i = 0; i < TYPED_SORT_BENCHMARK_ELEMENTS; i++) {
+        entries[i].id = i + 1;
+        entries[i].driver_account_creation_date = create_date(g_rand_int_range(rand, 1, 29), g_rand_int_range(rand, 1, 13), g_rand_int_range(rand, 2010, 2023));
+        entries[i].user_account_creation_date = create_date(g_rand_int_range(rand, 1, 29), g_rand_int_range(rand, 1, 13), g_rand_int_range(rand, 2010, 2023));
+    }
+    memcpy(expected, entries, sizeof(TypedSortBenchmarkEntry) * TYPED_SORT_BENCHMARK_ELEMENTS);
+
+    g_autofree GTimer *timer = g_timer_new();
+    qsort(expected, TYPED_SORT_BENCHMARK_ELEMENTS, sizeof(TypedSortBenchmarkEntry), compare_typed_sort_benchmark_entries);
+    double qsort_seconds = g_timer_elapsed(timer, NULL);
+
+    g_timer_start(timer);
+    typed_sort_benchmark_entries_sort(entries, TYPED_SORT_BENCHMARK_ELEMENTS);
+    double typed_seconds = g_timer_elapsed(timer, NULL);
+
+    g_assert_true(memcmp(entries, expected, sizeof(TypedSortBenchmarkEntry) * TYPED_SORT_BENCHMARK_ELEMENTS) == 0);
+
+    printf("# %-22s %8.2f ms for %d values\n", "qsort:", qsort_seconds * 1000, TYPED_SORT_BENCHMARK_ELEMENTS);
+    printf("# %-22s %8.2f ms for %d values\n", "DEFINE_TYPED_SORT:", typed_seconds * 1000, TYPED_SORT_BENCHMARK_ELEMENTS);
+
+    free(expected);
+    free(entries);
+    g_rand_free(rand);
+}
+
+/**
+ * Prints the time of sorting rides with `sort_rides_by_distance`, against `sort_array` with `compare_rides_by_distance`.
+ */
+void benchmark_sort_rides_by_distance_against_qsort(void) {
+    GRand *rand = g_rand_new_with_seed(24);
+    Arena *arena = create_arena();
+
+    GPtrArray *rides = g_ptr_array_sized_new(TYPED_SORT_BENCHMARK_ELEMENTS);
+    GPtrArray *expected = g_ptr_array_sized_new(TYPED_SORT_BENCHMARK_ELEMENTS);
+    for (int i = 0; i < TYPED_SORT_BENCHMARK_ELEMENTS; i++) {
+        Date date = create_date(g_rand_int_range(rand, 1, 29), g_rand_int_range(rand, 1, 13), g_rand_int_range(rand, 2010, 2023));
+        Ride *ride = create_ride(i + 1, date, 1, 0, g_rand_int_range(rand, 1, 20), 1, 1, 0, arena);
+        g_ptr_array_add(rides, ride);
+        g_ptr_array_add(expected, ride);
+    }
+
+    g_autofree GTimer *timer = g_timer_new();
+    sort_array(expected, compare_rides_by_distance);
+    double qsort_seconds = g_timer_elapsed(timer, NULL);
+
+    g_timer_start(timer);
+    sort_rides_by_distance(rides);
+    double typed_seconds = g_timer_elapsed(timer, NULL);
+
+    g_assert_true(memcmp(rides->pdata, expected->pdata, sizeof(gpointer) * rides->len) == 0);
+
+    printf("# %-22s %8.2f ms for %d rides\n", "sort_array (qsort):", qsort_seconds * 1000, TYPED_SORT_BENCHMARK_ELEMENTS);
+    printf("# %-22s %8.2f ms for %d rides\n", "sort_rides_by_distance:", typed_seconds * 1000, TYPED_SORT_BENCHMARK_ELEMENTS);
+
+    g_ptr_array_free(expected, TRUE);
+    g_ptr_array_free(rides, TRUE);
+    free_arena(arena);
+    g_rand_free(rand);
+}
+
+/**
+ * Number of searches timed by `benchmark_typed_lower_bound_against_branching_search`.
+ */
+#define LOWER_BOUND_BENCHMARK_SEARCHES 5000000
+
+/**
+ * Lower bound of a key in sorted ints, with a branch on each comparison (as the date columns searched before).
+ */
+static __attribute__((noinline)) size_t branching_lower_bound(const int *items, size_t length, int key) {
+    size_t low = 0;
+    size_t high = length;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+
+        if (items[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Prints the time of searching random keys in a sorted array as large as the date column of `data-large`,
+ * with a `DEFINE_TYPED_LOWER_BOUND` search, against a search that branches on each comparison.
+ */
+void benchmark_typed_lower_bound_against_branching_search(void) {
+    GRand *rand = g_rand_new_with_seed(24);
+
+    int *items = malloc(sizeof(int) * TYPED_SORT_BENCHMARK_ELEMENTS);
+    for (int i = 0; i < TYPED_SORT_BENCHMARK_ELEMENTS; i++) items[i] = g_rand_int_range(rand, 0, 5000);
+    test_ints_sort(items, TYPED_SORT_BENCHMARK_ELEMENTS);
+
+    int *keys = malloc(sizeof(int) * LOWER_BOUND_BENCHMARK_SEARCHES);
+    for (int i = 0; i < LOWER_BOUND_BENCHMARK_SEARCHES; i++) keys[i] = g_rand_int_range(rand, -10, 5010);
+
+    for (int typed = 0; typed <= 1; typed++) {
+        volatile size_t checksum = 0;
+
+        g_autofree GTimer *timer = g_timer_new();
+        for (int i = 0; i < LOWER_BOUND_BENCHMARK_SEARCHES; i++) {
+            checksum += typed ? test_ints_lower_bound(items, TYPED_SORT_BENCHMARK_ELEMENTS, keys[i])
+                              : branching_lower_bound(items, TYPED_SORT_BENCHMARK_ELEMENTS, keys[i]);
+        }
+        double seconds = g_timer_elapsed(timer, NULL);
+
+        printf("# %-25s %6.1f ns/search\n", typed ? "DEFINE_TYPED_LOWER_BOUND:" : "branching lower bound:", seconds * 1e9 / LOWER_BOUND_BENCHMARK_SEARCHES);
+    }
+
+    for (int i = 0; i < 1000; i++)
+        g_assert_cmpuint(test_ints_lower_bound(items, TYPED_SORT_BENCHMARK_ELEMENTS, keys[i]), ==, branching_lower_bound(items, TYPED_SORT_BENCHMARK_ELEMENTS, keys[i]));
+
+    free(keys);
+    free(items);
+    g_rand_free(rand);
+}